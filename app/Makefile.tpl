@@ -1,16 +1,16 @@
 # file: Makefile.tpl		G. Moody	  23 May 2000
-#				Last revised:	 24 April 2020
+#				Last revised:	18 October 2026
 # This section of the Makefile should not need to be changed.
 
 CFILES = ann2rr.c bxb.c calsig.c ecgeval.c epicmp.c fir.c gqfuse.c gqpost.c \
- gqrs.c hrstats.c ihr.c mfilt.c mrgann.c mxm.c nguess.c nst.c plotstm.c \
- pscgen.c pschart.c psfd.c rdann.c rdsamp.c rr2ann.c rxr.c sampfreq.c sigamp.c \
- sigavg.c signame.c signum.c skewedit.c snip.c sortann.c sqrs.c sqrs125.c \
- stepdet.c sumann.c sumstats.c tach.c time2sec.c wabp.c wfdb-config.c \
- wfdbcat.c wfdbcollate.c wfdbdesc.c wfdbmap.c wfdbsignals.c wfdbtime.c \
- wfdbwhich.c wqrs.c wrann.c wrsamp.c xform.c
+ gqrs.c hrreport.c hrstats.c ihr.c mfilt.c mrgann.c mxm.c nguess.c nst.c \
+ plotstm.c pscgen.c pschart.c psfd.c rdann.c rdsamp.c rr2ann.c rxr.c \
+ sampfreq.c sigamp.c sigavg.c sigenv.c signame.c signum.c skewedit.c snip.c \
+ sortann.c sqrs.c sqrs125.c stepdet.c sumann.c sumstats.c tach.c time2sec.c \
+ wabp.c wfdb-config.c wfdbcat.c wfdbcollate.c wfdbdesc.c wfdbmap.c \
+ wfdbsignals.c wfdbtime.c wfdbwhich.c wqrs.c wrann.c wrsamp.c xform.c
 CFFILES = gqrs.conf
-HFILES = signal-colors.h
+HFILES = ecgeval.h signal-colors.h
 XFILES = \
  ann2rr$(EXEEXT) \
  bxb$(EXEEXT) \
@@ -21,6 +21,7 @@ XFILES = \
  gqfuse$(EXEEXT) \
  gqpost$(EXEEXT) \
  gqrs$(EXEEXT) \
+ hrreport$(EXEEXT) \
  hrstats$(EXEEXT) \
  ihr$(EXEEXT) \
  mfilt$(EXEEXT) \
@@ -39,6 +40,7 @@ XFILES = \
  sampfreq$(EXEEXT) \
  sigamp$(EXEEXT) \
  sigavg$(EXEEXT) \
+ sigenv$(EXEEXT) \
  signame$(EXEEXT) \
  signum$(EXEEXT) \
  skewedit$(EXEEXT) \
@@ -126,10 +128,11 @@ listing:
 
 bxb$(EXEEXT):		bxb.c
 	$(CC) $(CFLAGS) bxb.c -o $@ $(LDFLAGS) -lm
-ihr$(EXEEXT):		ihr.c
-	$(CC) $(CFLAGS) ihr.c -o $@ $(LDFLAGS) -lm
-hrstats$(EXEEXT):	hrstats.c
-	$(CC) $(CFLAGS) hrstats.c -o $@ $(LDFLAGS) -lm
+ecgeval$(EXEEXT):	ecgeval.c ecgeval.h bxb.c epicmp.c mxm.c rxr.c
+	$(CC) $(CFLAGS) -DECGEVAL ecgeval.c bxb.c epicmp.c mxm.c rxr.c -o $@ \
+	  $(LDFLAGS) -lm
+fir$(EXEEXT):		fir.c
+	$(CC) $(CFLAGS) fir.c -o $@ $(LDFLAGS) -lm
 mxm$(EXEEXT):		mxm.c
 	$(CC) $(CFLAGS) mxm.c -o $@ $(LDFLAGS) -lm
 nguess$(EXEEXT):	nguess.c
@@ -145,7 +148,13 @@ psfd$(EXEEXT):
 	$(CC) $(CFLAGS) -DPROLOG=\"$(PSPDIR)/psfd.pro\" psfd.c -o $@ $(LDFLAGS)
 sigamp$(EXEEXT):	sigamp.c
 	$(CC) $(CFLAGS) sigamp.c -o $@ $(LDFLAGS) -lm
+sortann$(EXEEXT):	sortann.c
+	$(CC) $(CFLAGS) sortann.c -o $@ $(LDFLAGS) -lpthread
 wfdbmap$(EXEEXT):	wfdbmap.c signal-colors.h
 	$(CC) $(CFLAGS) wfdbmap.c -o $@ $(LDFLAGS)
 wqrs$(EXEEXT):		wqrs.c
 	$(CC) $(CFLAGS) wqrs.c -o $@ $(LDFLAGS) -lm
+wrsamp$(EXEEXT):	wrsamp.c
+	$(CC) $(CFLAGS) wrsamp.c -o $@ $(LDFLAGS) -lpthread
+xform$(EXEEXT):		xform.c
+	$(CC) $(CFLAGS) xform.c -o $@ $(LDFLAGS) -lpthread
@@ -1,5 +1,5 @@
 /* file: bxb.c		G. Moody	14 December 1987
-			Last revised:	  27 April 2020
+			Last revised:	  18 October 2026
 
 -------------------------------------------------------------------------------
 bxb: ANSI/AAMI-standard beat-by-beat annotation file comparator
@@ -72,16 +72,26 @@ static WFDB_Time T, Tprime;	/* times of the current & next reference annotations
 static WFDB_Time t, tprime;	/* times of the current & next test annotations */
 
 static int amap(int a);
+static void genxcmp(void);
+static void getref(void);
+static void gettest(void);
+static int rpann(WFDB_Time t);
+static int tpann(WFDB_Time t);
+static void init(int argc, char *argv[]);
+static void pair(int ref, int test);
+static void print_results(int fflag);
+static void help(void);
+static char *prog_name(char *s);
+void bxb_headings(FILE *fp, int fflag, int sd);
+
+#ifdef ECGEVAL		/* linked into ecgeval, which calls bxb_main() */
+#include "ecgeval.h"
+#define main bxb_main
+#define exit(status) ecgeval_exit(status)
+#endif
 
 int main(int argc, char *argv[])
 {
-    void genxcmp(void);
-    void getref(void);
-    void gettest(void);
-    void init(int, char **);
-    void pair(int, int);
-    void print_results(int);
-
     /* Read and interpret command-line arguments. */
     init(argc, argv);
 
@@ -250,7 +260,7 @@ static WFDB_Time pvfonref = -1L;	/* start of previous reference VF */
 static WFDB_Time pvfoffref = -1L;	/* end of previous reference VF */
 static WFDB_Annotation ref_annot;
 
-void getref(void)	/* get next reference beat annotation */
+static void getref(void)	/* get next reference beat annotation */
 {
     static WFDB_Time TT;    /* time of previous reference beat annotation */
     static WFDB_Annotation annot;
@@ -353,7 +363,7 @@ static WFDB_Time pvfontest = -1L;	/* start of previous test VF */
 static WFDB_Time pvfofftest = -1L;	/* end of previous test VF */
 static WFDB_Annotation test_annot;
 
-void gettest(void)	/* get next test annotation */
+static void gettest(void)	/* get next test annotation */
 {
     static WFDB_Time tt;	/* time of previous test beat annotation */
     static WFDB_Annotation annot;
@@ -437,7 +447,7 @@ void gettest(void)	/* get next test annotation */
    beat labels, since they depend on getref() and gettest() to locate the two
    most recent VF and shutdown periods and have no information about earlier
    or later VF or shutdown periods. */
-int rpann(WFDB_Time t)
+static int rpann(WFDB_Time t)
 {
     if ((vfonref!=-1L && vfonref<=t && (t<=vfoffref || vfoffref==-1L)) ||
 	(pvfonref!=-1L && pvfonref<=t && t<=pvfoffref))
@@ -453,7 +463,7 @@ int rpann(WFDB_Time t)
 			   O pseudo-beat labels */
 }
 
-int tpann(WFDB_Time t)
+static int tpann(WFDB_Time t)
 {
     /* no special treatment for reference beat labels during test-marked VF */
     if ((sdontest!=-1L && sdontest<=t && (t<=sdofftest || sdofftest==-1L)) ||
@@ -479,7 +489,7 @@ static int verbose = 0;	/* if non-zero, describe all mismatches */
 static long nrre = 0;		/* number of RR errors tallied in ssrre */
 static double ssrre = 0.;	/* sum of squares of RR errors */
 
-void pair(int ref, int test)	/* count a beat label pair */
+static void pair(int ref, int test)	/* count a beat label pair */
 {
     switch (ref) {
 	case 'N': switch (test) {
@@ -657,11 +667,9 @@ static void sstat(char *s, char *f, long a, long b)
 }
 
 /* Read and interpret command-line arguments. */
-void init(int argc, char *argv[])
+static void init(int argc, char *argv[])
 {
     int i;
-    char *prog_name(char *);
-    void help(void);
 
     pname = prog_name(argv[0]);
     for (i = 1; i < argc; i++) {
@@ -852,7 +860,42 @@ void init(int argc, char *argv[])
     if (annopen(record, an, 2 + oflag) < 0) exit(2);
 }
 
-void print_results(int fflag)
+/* Write the column headings for line-format output (fflag = 2 or 5) to fp,
+   for the beat-by-beat statistics if sd is zero, or for the shutdown
+   statistics otherwise.  (This function is also used by ecgeval.) */
+void bxb_headings(FILE *fp, int fflag, int sd)
+{
+    if (sd == 0) {
+	if (fflag == 2) {
+	    (void)fprintf(fp,
+			  "Record Nn' Vn' Fn' On'  Nv   Vv  Fv' Ov' No'");
+	    (void)fprintf(fp,
+			  " Vo' Fo'  Q Se   Q +P   V Se   V +P  V FPR\n");
+	}
+	else if (fflag == 5) {
+	    (void)fprintf(fp,
+			  "Record Nn' Sn' Vn' Fn' On'  Ns  Ss  Vs  Fs'");
+	    (void)fprintf(fp,
+			  " Os' Nv  Sv   Vv  Fv' Ov' No' So' Vo' Fo'");
+	    (void)fprintf(fp,
+		      "  Q Se   Q +P   V Se   V +P   S Se   S +P RR err\n");
+	}
+    }
+    else if (fflag == 2) {
+	(void)fprintf(fp, "Record Nx   Vx   Fx   Qx  %% beats  %% N    ");
+	(void)fprintf(fp, "%% V    %% F   Total Shutdown\n");
+	(void)fprintf(fp, "                           missed missed ");
+	(void)fprintf(fp, "missed missed      Time\n");
+    }
+    else if (fflag == 5) {
+	(void)fprintf(fp, "Record Nx   Sx   Vx   Fx   Qx  %% beats  %% N    ");
+	(void)fprintf(fp, "%% S    %% V    %% F   Total Shutdown\n");
+	(void)fprintf(fp, "                                missed missed ");
+	(void)fprintf(fp, "missed missed missed      Time\n");
+    }
+}
+
+static void print_results(int fflag)
 {
     long QTP, QFN, QFP, STP, SFN, SFP, VTP, VFN, VTN, VFP;
 
@@ -864,20 +907,7 @@ void print_results(int fflag)
 		(void)fprintf(stderr, "%s: can't create %s\n", pname, ofname);
 		exit(3);
 	    }
-	    if (fflag == 2) {
-		(void)fprintf(ofile,
-			      "Record Nn' Vn' Fn' On'  Nv   Vv  Fv' Ov' No'");
-		(void)fprintf(ofile,
-			      " Vo' Fo'  Q Se   Q +P   V Se   V +P  V FPR\n");
-	    }
-	    else if (fflag == 5) {
-		(void)fprintf(ofile,
-			      "Record Nn' Sn' Vn' Fn' On'  Ns  Ss  Vs  Fs'");
-		(void)fprintf(ofile,
-			      " Os' Nv  Sv   Vv  Fv' Ov' No' So' Vo' Fo'");
-		(void)fprintf(ofile,
-		      "  Q Se   Q +P   V Se   V +P   S Se   S +P RR err\n");
-	    }
+	    bxb_headings(ofile, fflag, 0);
 	}
 	else {
 	    (void)fclose(ofile);
@@ -896,23 +926,7 @@ void print_results(int fflag)
 				  "%s: can't create %s\n", pname, sfname);
 		    exit(3);
 		}
-		if (fflag == 2) {
-		    (void)fprintf(sfile,
-			    "Record Nx   Vx   Fx   Qx  %% beats  %% N    ");
-		    (void)fprintf(sfile, "%% V    %% F   Total Shutdown\n");
-		    (void)fprintf(sfile,
-			    "                           missed missed ");
-		    (void)fprintf(sfile, "missed missed      Time\n");
-		}
-		else {
-		    (void)fprintf(sfile,
-			  "Record Nx   Sx   Vx   Fx   Qx  %% beats  %% N    ");
-		    (void)fprintf(sfile,
-				  "%% S    %% V    %% F   Total Shutdown\n");
-		    (void)fprintf(sfile,
-			    "                                missed missed ");
-		    (void)fprintf(sfile, "missed missed missed      Time\n");
-		}
+		bxb_headings(sfile, fflag, 1);
 	    }
 	    else {
 		(void)fclose(sfile);
@@ -1111,7 +1125,7 @@ static char *help_strings[] = {
  NULL
 };
 
-void help()
+static void help(void)
 {
     int i;
 
@@ -1120,7 +1134,7 @@ void help()
 	(void)fprintf(stderr, "%s\n", help_strings[i]);
 }
 
-char *prog_name(char *s)
+static char *prog_name(char *s)
 {
     char *p = s + strlen(s);
 
@@ -1142,7 +1156,7 @@ char *prog_name(char *s)
 /* Function `genxcmp' is used only when generating an expanded output
    annotation file. */
 
-void genxcmp()
+static void genxcmp(void)
 {
     int alen;
     static char mstring[550], *p, nullaux[1];
@@ -1,5 +1,5 @@
 /* file: ecgeval.c	G. Moody	22 March 1992
-			Last revised:  4 November 2020		wfdb 10.7.0
+			Last revised:  18 October 2026		wfdb 10.7.1
 
 -------------------------------------------------------------------------------
 ecgeval: Generate and run a script of commands to compare sets of annotations
@@ -26,17 +26,57 @@ Note: versions prior to 10.5.21 included code that was conditionally compiled
 if MSDOS was defined.  This code truncated file names to 8.3 format.  If you
 need to run ecgeval on an ancient OS that cannot handle longer filenames, use
 an archived version (available on PhysioNet).
+
+If command-line arguments are given, ecgeval runs non-interactively:  rather
+than generating a script, it runs the comparison programs itself, for up to
+-j N records at once.  bxb, rxr, mxm, and epicmp are linked into ecgeval (see
+ecgeval.h), and each record is evaluated by a separate process, which calls
+them in turn, with their line-format output redirected to temporary files.
+When all of the records have been evaluated, the temporary files are appended
+in record order to the intermediate summary files, so that these are identical
+to those produced by the script, and sumstats and plotstm are run to produce
+the report.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include <time.h>
+#include <setjmp.h>
 #include <wfdb/wfdb.h>
+#include "ecgeval.h"
+
+/* Records are evaluated by separate processes.  Where fork() is unavailable,
+   commands (including the comparison programs) are run using system(), one
+   record at a time. */
+#if defined(MSDOS) || defined(_WIN32)
+#define NOFORK
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
 
 #define NDBMAX	50	/* maximum number of databases in `dblist' */
 #define ECHONOTHING "echo >>%s\n"
 
 char buf[256];
 
+/* Evaluation parameters (set interactively, or by command-line options). */
+static int nhr = 1, evalsv = 1, evalvf = 1, evalaf = 1, evalst = 1, evalst2 = 1;
+static char rhrname[20], tname[20], reportname[36], *epicmpSoption = " -S ";
+static char bxbfile1[40] = "bxb.out", bxbfile2[40] = "sd.out",
+	    rxrfile1[40] = "vruns.out", rxrfile2[40] = "sruns.out",
+	    mxmfile[40] = "hr%d.out", epicmpaffile[40] = "af.out",
+	    epicmpvffile[40] = "vf.out", epicmpstfile1[40] = "st.out",
+	    epicmpstfile2[40] = "stm.out", plotstmfile[40] = "stm.ps";
+static char *rname = "atr";
+
+static int batch(int argc, char **argv);
+
 void getans(char *p, int n)
 {
     int l;
@@ -106,22 +146,17 @@ char *month_name[12] = {
     "January", "February", "March", "April", "May", "June",
     "July", "August", "September", "October", "November", "December" };
 
-main()
+int main(int argc, char **argv)
 {
     FILE *dbf, *rfile = NULL, *sfile = NULL;
-    int dbi = -1, i, nhr = 1;
-    int evalsv = 1, evalvf = 1, evalaf = 1, evalst = 1, evalst2 = 1;
+    int dbi = -1, i;
     struct tm *now;
-    static char rhrname[20], tname[20], tans[20], *dbfn, dbtn[5],
-        reportname[36], scriptname[30], *epicmpSoption, evalcommand[35];
+    static char tans[20], *dbfn, dbtn[5], scriptname[30], evalcommand[35];
     static char bxbcommand[256], rxrcommand[256], mxmcommand[256],
 		epicmpcommand[256];
-    static char bxbfile1[40] = "bxb.out", bxbfile2[40] = "sd.out",
-	        rxrfile1[40] = "vruns.out", rxrfile2[40] = "sruns.out",
-		mxmfile[40] = "hr%d.out", epicmpaffile[40] = "af.out",
-		epicmpvffile[40] = "vf.out", epicmpstfile1[40] = "st.out",
-		epicmpstfile2[40] = "stm.out", plotstmfile[40] = "stm.ps";
-    static char *rname = "atr";
+
+    if (argc > 1)
+	exit(batch(argc, argv));
 
 #ifdef __STDC__
     time_t t;
@@ -644,3 +679,565 @@ main()
     }
     exit(0);	/*NOTREACHED*/
 }
+
+/* Non-interactive evaluation. */
+
+/* Output file slots.  For each record, the line-format output that would be
+   appended to slot k's intermediate summary file is first written to a
+   temporary file. */
+#define BXB1	0
+#define BXB2	1
+#define RXR1	2
+#define RXR2	3
+#define VF	4
+#define AF	5
+#define ST1	6
+#define ST2	7
+#define HR0	8	/* slots HR0 ... HR0+nhr-1 are for mxm */
+
+static char *pname, **record, **ofname, tmpdir[32];
+static int nrec, nslot;
+
+static char *tmpname(int r, int k)
+{
+    static char tfname[64];
+
+    (void)sprintf(tfname, "%s/%d.%d", tmpdir, r, k);
+    return (tfname);
+}
+
+/* Run a command, with its standard output appended to outfile unless outfile
+   is NULL.  Returns the exit status of the command. */
+static int run(char **args, char *outfile)
+{
+#ifndef NOFORK
+    int stat;
+    pid_t pid;
+
+    (void)fflush(stdout);
+    if ((pid = fork()) == 0) {
+	if (outfile) {
+	    int fd = open(outfile, O_WRONLY|O_CREAT|O_APPEND, 0644);
+
+	    if (fd < 0 || dup2(fd, 1) < 0) _exit(127);
+	    (void)close(fd);
+	}
+	(void)execvp(args[0], args);
+	(void)fprintf(stderr, "%s: can't run %s\n", pname, args[0]);
+	_exit(127);
+    }
+    else if (pid < 0 || waitpid(pid, &stat, 0) < 0)
+	return (-1);
+    return (stat);
+#else
+    char command[1024];
+    int i;
+
+    for (i = 0, command[0] = '\0'; args[i]; i++) {
+	if (i) (void)strcat(command, " ");
+	(void)strcat(command, args[i]);
+    }
+    if (outfile) {
+	(void)strcat(command, " >>");
+	(void)strcat(command, outfile);
+    }
+    return (system(command));
+#endif
+}
+
+static jmp_buf cmpenv;	/* where ecgeval_exit returns */
+static int cmpstat;	/* exit status of the comparison program */
+
+/* The comparison programs call this function (via their exit() macro) when
+   they finish. */
+void ecgeval_exit(int status)
+{
+    cmpstat = status;
+    longjmp(cmpenv, 1);
+}
+
+/* Run a comparison program, given the main function that was linked from it
+   and its arguments.  Returns the exit status of the program.  The program
+   runs within the calling process, which must be a child that evaluates a
+   single record, since the comparison programs do not reset all of their
+   state when they start.  Where fork() is unavailable, the program is run
+   by run() instead. */
+static int compare(int (*cmpmain)(int, char **), char **args)
+{
+#ifndef NOFORK
+    int argc;
+
+    for (argc = 0; args[argc]; argc++)
+	;
+    cmpstat = 0;
+    if (setjmp(cmpenv) == 0)
+	cmpstat = (*cmpmain)(argc, args);
+    (void)fflush(NULL);
+    wfdbquit();
+    return (cmpstat);
+#else
+    return (run(args, NULL));
+#endif
+}
+
+/* Evaluate record r, writing results to temporary files.  Each temporary
+   file that a comparison program creates begins with its column headings. */
+static int evalrecord(int r)
+{
+    char *args[20], mbuf[20], tf[HR0+128][64];
+    int i, k, n, stat = 0;
+
+    for (k = 0; k < nslot; k++)
+	if (ofname[k]) (void)strcpy(tf[k], tmpname(r, k));
+
+    n = 0;
+    args[n++] = "bxb"; args[n++] = "-r"; args[n++] = record[r];
+    args[n++] = "-a"; args[n++] = rname; args[n++] = tname;
+    args[n++] = evalsv ? "-L" : "-l"; args[n++] = tf[BXB1];
+    args[n++] = tf[BXB2]; args[n] = NULL;
+    if (compare(bxb_main, args)) stat = 1;
+
+    n = 0;
+    args[n++] = "rxr"; args[n++] = "-r"; args[n++] = record[r];
+    args[n++] = "-a"; args[n++] = rname; args[n++] = tname;
+    args[n++] = evalsv ? "-L" : "-l"; args[n++] = tf[RXR1];
+    if (evalsv) args[n++] = tf[RXR2];
+    args[n] = NULL;
+    if (compare(rxr_main, args)) stat = 1;
+
+    for (i = 0; i < nhr; i++) {
+	(void)sprintf(mbuf, "%d", i);
+	n = 0;
+	args[n++] = "mxm"; args[n++] = "-r"; args[n++] = record[r];
+	args[n++] = "-a"; args[n++] = rhrname; args[n++] = tname;
+	args[n++] = "-L"; args[n++] = tf[HR0+i];
+	args[n++] = "-m"; args[n++] = mbuf; args[n] = NULL;
+	if (compare(mxm_main, args)) stat = 1;
+    }
+
+    if (evalaf || evalvf || evalst) {
+	n = 0;
+	args[n++] = "epicmp"; args[n++] = "-r"; args[n++] = record[r];
+	args[n++] = "-a"; args[n++] = rname; args[n++] = tname;
+	args[n++] = "-L";
+	if (evalaf) { args[n++] = "-A"; args[n++] = tf[AF]; }
+	if (evalvf) { args[n++] = "-V"; args[n++] = tf[VF]; }
+	if (evalst) {
+	    args[n++] = evalst2 ? "-S" : "-S0";
+	    args[n++] = tf[ST1]; args[n++] = tf[ST2];
+	}
+	args[n] = NULL;
+	if (compare(epicmp_main, args)) stat = 1;
+    }
+    return (stat);
+}
+
+/* Return the number of lines of column headings at the beginning of the
+   line-format output for slot k. */
+static int headlines(int k)
+{
+    int c, n = 0;
+    FILE *fp;
+
+    if ((fp = tmpfile()) == NULL) {
+	(void)fprintf(stderr, "%s: can't create a temporary file\n", pname);
+	exit(3);
+    }
+    switch (k) {
+      case BXB1: bxb_headings(fp, evalsv ? 5 : 2, 0); break;
+      case BXB2: bxb_headings(fp, evalsv ? 5 : 2, 1); break;
+      case RXR1: rxr_headings(fp, 0); break;
+      case RXR2: rxr_headings(fp, 1); break;
+      case VF:   epicmp_headings(fp, 1); break;
+      case AF:   epicmp_headings(fp, 0); break;
+      case ST1:  epicmp_headings(fp, evalst2 ? 4 : 2); break;
+      case ST2:  epicmp_stheadings(fp); break;
+      default:   mxm_headings(fp, k - HR0); break;
+    }
+    rewind(fp);
+    while ((c = getc(fp)) != EOF)
+	if (c == '\n') n++;
+    (void)fclose(fp);
+    return (n);
+}
+
+/* Append the contents of file src, after skipping its first skip lines (if
+   anything remains), to file dst. */
+static void append(char *dst, char *src, int skip)
+{
+    FILE *ifp, *ofp;
+    int c;
+    size_t n;
+
+    if ((ifp = fopen(src, "rb")) == NULL) return;
+    while (skip > 0 && (c = getc(ifp)) != EOF)
+	if (c == '\n') skip--;
+    if ((n = fread(buf, 1, sizeof(buf), ifp)) == 0) {
+	(void)fclose(ifp);
+	return;
+    }
+    if ((ofp = fopen(dst, "ab")) == NULL) {
+	(void)fprintf(stderr, "%s: can't modify %s\n", pname, dst);
+	exit(3);
+    }
+    do {
+	(void)fwrite(buf, 1, n, ofp);
+    } while ((n = fread(buf, 1, sizeof(buf), ifp)) > 0);
+    (void)fclose(ifp);
+    (void)fclose(ofp);
+}
+
+/* Append a section heading and the output of sumstats for file f to the
+   report. */
+static void summarize(char *heading, char *f)
+{
+    char *args[3];
+    FILE *rfile;
+
+    if ((rfile = fopen(reportname, "a")) == NULL) {
+	(void)fprintf(stderr, "%s: can't modify %s\n", pname, reportname);
+	exit(3);
+    }
+    (void)fprintf(rfile, "%s\n\n", heading);
+    (void)fclose(rfile);
+    args[0] = "sumstats"; args[1] = f; args[2] = NULL;
+    (void)run(args, reportname);
+    if ((rfile = fopen(reportname, "a")) != NULL) {
+	(void)fprintf(rfile, "\n");
+	(void)fclose(rfile);
+    }
+}
+
+static char *help_strings[] = {
+ "usage: %s -a TEST -d DB [OPTIONS ...]\n",
+ "where TEST is the test annotator name, DB is the name of a database listed",
+ "in `dblist' (or its first word, or the name of a file listing records),",
+ "and OPTIONS may include any of:",
+ " -h         print this usage summary",
+ " -j N       evaluate up to N records at once (default: 1)",
+ " -m N       evaluate N types of heart rate measurement (default: 1 if -r",
+ "             is given, 0 otherwise)",
+ " -o REPORT  write the evaluation report to REPORT (default: TEST-DB-evaluation)",
+ " -r RHR     use RHR as the reference heart rate annotator",
+ " -S0        define ST episodes using signal 0 only",
+ " -x LIST    skip the evaluations specified in LIST, which may include any",
+ "             of `a' (AF), `s' (SVEB), `t' (ST), and `v' (VF)",
+ "Intermediate summary files (bxb.out, sd.out, etc.) are created or appended",
+ "to in the current directory, as by the interactive evaluation script.",
+ "Run without options to generate an evaluation script interactively.",
+NULL
+};
+
+/* copyname copies a name given on the command line into a buffer of the
+   given size, or prints an error message and returns -1 if it is too long
+   to fit. */
+static int copyname(char *buf, size_t size, char *name, char *what)
+{
+    if (strlen(name) >= size) {
+	(void)fprintf(stderr, "%s: %s name `%s' is too long (maximum %d "
+		      "characters)\n", pname, what, name, (int)size - 1);
+	return (-1);
+    }
+    (void)strcpy(buf, name);
+    return (0);
+}
+
+static int batch(int argc, char **argv)
+{
+    char *dbarg = NULL, *dbfn, *dbdesc1, *p;
+    int dbi, i, k, njobs = 1, status = 0;
+    struct tm *now;
+    FILE *dbf, *rfile;
+#ifdef __STDC__
+    time_t t;
+
+    t = time((time_t *)NULL);
+#else
+    long t;
+
+    t = time((long *)NULL);
+#endif
+    now = localtime(&t);
+
+    pname = argv[0];
+    nhr = -1;
+    for (i = 1; i < argc; i++) {
+	if (*argv[i] == '-') switch (*(argv[i]+1)) {
+	  case 'a':
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: test annotator name must follow -a\n",
+			      pname);
+		return (1);
+	    }
+	    if (copyname(tname, sizeof(tname), argv[i], "test annotator"))
+		return (1);
+	    break;
+	  case 'd':
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: database name must follow -d\n",
+			      pname);
+		return (1);
+	    }
+	    dbarg = argv[i];
+	    break;
+	  case 'h':
+	    for (i = 0; help_strings[i]; i++)
+		(void)fprintf(stderr, i ? "%s\n" : help_strings[0],
+			      i ? help_strings[i] : pname);
+	    return (0);
+	  case 'j':
+	    if (++i >= argc || (njobs = atoi(argv[i])) < 1) {
+		(void)fprintf(stderr, "%s: number of processes must follow -j\n",
+			      pname);
+		return (1);
+	    }
+	    break;
+	  case 'm':
+	    if (++i >= argc || (nhr = atoi(argv[i])) < 0 || nhr > 127) {
+		(void)fprintf(stderr,
+	      "%s: number of heart rate measurement types must follow -m\n",
+			      pname);
+		return (1);
+	    }
+	    break;
+	  case 'o':
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: report name must follow -o\n", pname);
+		return (1);
+	    }
+	    if (copyname(reportname, sizeof(reportname), argv[i], "report"))
+		return (1);
+	    break;
+	  case 'r':
+	    if (++i >= argc) {
+		(void)fprintf(stderr,
+		      "%s: reference heart rate annotator name must follow -r\n",
+			      pname);
+		return (1);
+	    }
+	    if (copyname(rhrname, sizeof(rhrname), argv[i],
+			 "reference heart rate annotator"))
+		return (1);
+	    break;
+	  case 'S':
+	    evalst2 = (*(argv[i]+2) != '0');
+	    break;
+	  case 'x':
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: list of evaluations must follow -x\n",
+			      pname);
+		return (1);
+	    }
+	    for (p = argv[i]; *p; p++)
+		switch (*p) {
+		  case 'a': evalaf = 0; break;
+		  case 's': evalsv = 0; break;
+		  case 't': evalst = 0; break;
+		  case 'v': evalvf = 0; break;
+		}
+	    break;
+	  default:
+	    (void)fprintf(stderr, "%s: unrecognized option %s\n", pname,
+			  argv[i]);
+	    return (1);
+	}
+	else {
+	    (void)fprintf(stderr, "%s: unrecognized argument %s\n", pname,
+			  argv[i]);
+	    return (1);
+	}
+    }
+    if (tname[0] == '\0' || dbarg == NULL) {
+	(void)fprintf(stderr, help_strings[0], pname);
+	return (1);
+    }
+    if (nhr < 0) nhr = rhrname[0] ? 1 : 0;
+    if (nhr > 0 && rhrname[0] == '\0') {
+	(void)fprintf(stderr,
+	      "%s: reference heart rate annotator (-r) must be specified\n",
+		      pname);
+	return (1);
+    }
+
+    /* Find the list of records. */
+    if (getdblists() < 0) ndb = 0;
+    for (dbi = 0; dbi < ndb; dbi++) {
+	if (strcmp(dbarg, dbname[dbi]) == 0)
+	    break;
+	for (i = 0; dbarg[i] && tolower(dbarg[i]) == tolower(dbname[dbi][i]);
+	     i++)
+	    ;
+	if (dbarg[i] == '\0' && dbname[dbi][i] == ' ')
+	    break;
+    }
+    if (dbi < ndb) {
+	dbfn = wfdbfile(dbfname[dbi], (char *)NULL);
+	dbdesc1 = dbdesc[dbi];
+	dbarg = dbname[dbi];
+    }
+    else {
+	dbfn = wfdbfile(dbarg, (char *)NULL);
+	dbdesc1 = dbarg;
+    }
+    if (dbfn == NULL || (dbf = fopen(dbfn, "r")) == NULL) {
+	(void)fprintf(stderr, "%s: can't find the list of records for %s\n",
+		      pname, dbarg);
+	return (2);
+    }
+    while (fgets(buf, 256, dbf)) {
+	char *r = strtok(buf, " \t\n\r");
+
+	if (r == NULL || *r == '#')
+	    continue;	/* comment or empty line -- ignore */
+	if ((int)strlen(r) > WFDB_MAXRNL) {
+	    (void)fprintf(stderr,
+		    "Illegal record name, `%s', found in `%s' (ignored).\n",
+			  r, dbfn);
+	    continue;
+	}
+	if ((record = realloc(record, (nrec+1) * sizeof(char *))) == NULL ||
+	    (record[nrec] = malloc(strlen(r)+1)) == NULL) {
+	    (void)fprintf(stderr, "insufficient memory\n");
+	    exit(2);
+	}
+	(void)strcpy(record[nrec++], r);
+    }
+    (void)fclose(dbf);
+
+    /* Name the output files. */
+    nslot = HR0 + nhr;
+    if ((ofname = calloc(nslot, sizeof(char *))) == NULL) {
+	(void)fprintf(stderr, "insufficient memory\n");
+	exit(2);
+    }
+    ofname[BXB1] = bxbfile1; ofname[BXB2] = bxbfile2;
+    ofname[RXR1] = rxrfile1;
+    if (evalsv) ofname[RXR2] = rxrfile2;
+    if (evalvf) ofname[VF] = epicmpvffile;
+    if (evalaf) ofname[AF] = epicmpaffile;
+    if (evalst) { ofname[ST1] = epicmpstfile1; ofname[ST2] = epicmpstfile2; }
+    for (i = 0; i < nhr; i++) {
+	if ((ofname[HR0+i] = malloc(strlen(mxmfile)+4)) == NULL) {
+	    (void)fprintf(stderr, "insufficient memory\n");
+	    exit(2);
+	}
+	(void)sprintf(ofname[HR0+i], mxmfile, i);
+    }
+    if (reportname[0] == '\0') {
+	char dbtn[5];
+
+	for (i = 0; i < 4 && dbarg[i] && dbarg[i] != ' '; i++)
+	    dbtn[i] = tolower(dbarg[i]);
+	dbtn[i] = '\0';
+	(void)sprintf(reportname, "%s-%s-evaluation", tname, dbtn);
+    }
+
+    /* Generate report file header. */
+    if ((rfile = fopen(reportname, "w")) == NULL) {
+	(void)fprintf(stderr, "%s: can't create %s\n", pname, reportname);
+	return (3);
+    }
+    (void)fprintf(rfile, "file: %s\tecgeval\t\t%d %s %d\n", reportname,
+	    now->tm_mday, month_name[now->tm_mon], now->tm_year+1900);
+    (void)fprintf(rfile, "Evaluation of `%s' on the %s\n\n", tname, dbdesc1);
+    (void)fclose(rfile);
+
+    /* Evaluate the records. */
+    (void)strcpy(tmpdir, "ecgevalXXXXXX");
+#ifndef NOFORK
+    if (mkdtemp(tmpdir) == NULL) {
+#else
+    if (mktemp(tmpdir) == NULL || mkdir(tmpdir) < 0) {
+#endif
+	(void)fprintf(stderr, "%s: can't create a temporary directory\n",
+		      pname);
+	return (3);
+    }
+    for (i = 0; i < nrec; i++) {
+#ifndef NOFORK
+	pid_t pid;
+	int stat;
+
+	if (i >= njobs && wait(&stat) > 0 && stat != 0) status = 1;
+	(void)fflush(stdout);
+	if ((pid = fork()) == 0)
+	    _exit(evalrecord(i));
+	else if (pid < 0) {
+	    (void)fprintf(stderr, "%s: can't create process for record %s\n",
+			  pname, record[i]);
+	    status = 1;
+	}
+#else
+	if (evalrecord(i)) status = 1;
+#endif
+    }
+#ifndef NOFORK
+    {
+	int stat;
+
+	while (wait(&stat) > 0)
+	    if (stat != 0) status = 1;
+    }
+#endif
+
+    /* Collect the results in record order.  The column headings at the
+       beginning of each temporary file are kept only if the intermediate
+       summary file does not exist yet (as when the comparison program
+       succeeds for the first record, and the summary file has not been
+       created by an earlier evaluation). */
+    for (k = 0; k < nslot; k++) {
+	FILE *fp;
+	int exists, skip;
+
+	if (ofname[k] == NULL) continue;
+	skip = headlines(k);
+	if ((exists = ((fp = fopen(ofname[k], "r")) != NULL)))
+	    (void)fclose(fp);
+	for (i = 0; i < nrec; i++) {
+	    if ((fp = fopen(tmpname(i, k), "r")) == NULL)
+		continue;	/* the comparison program failed */
+	    (void)fclose(fp);
+	    append(ofname[k], tmpname(i, k), exists ? skip : 0);
+	    (void)remove(tmpname(i, k));
+	    if (!exists && (fp = fopen(ofname[k], "r"))) {
+		(void)fclose(fp);
+		exists = 1;
+	    }
+	}
+    }
+    (void)remove(tmpdir);
+
+    /* Generate summary report. */
+    summarize("Beat detection and classification performance", bxbfile1);
+    summarize("Analysis shutdowns", bxbfile2);
+    summarize("Ventricular ectopic run detection performance", rxrfile1);
+    if (evalsv)
+	summarize("Supraventricular ectopic run detection performance",
+		  rxrfile2);
+    for (i = 0; i < nhr; i++) {
+	(void)sprintf(buf, "Heart rate measurement number %d performance", i);
+	summarize(buf, ofname[HR0+i]);
+    }
+    if (evalvf)
+	summarize("Ventricular fibrillation detection performance",
+		  epicmpvffile);
+    if (evalaf)
+	summarize("Atrial fibrillation detection performance", epicmpaffile);
+    if (evalst) {
+	char *args[3];
+
+	summarize("Ischemic ST detection performance", epicmpstfile1);
+	(void)remove(plotstmfile);
+	args[0] = "plotstm"; args[1] = epicmpstfile2; args[2] = NULL;
+	(void)run(args, plotstmfile);
+    }
+
+    (void)printf("The evaluation is complete. Print text file %s\n",
+		 reportname);
+    if (evalst)
+	(void)printf("and PostScript file %s to get the results.\n",
+		     plotstmfile);
+    else
+	(void)printf("to get the results.\n");
+    return (status);
+}
@@ -0,0 +1,45 @@
+/* file: ecgeval.h	WFDB contributors	18 October 2026
+Declarations shared by ecgeval and the comparison programs linked into it
+
+-------------------------------------------------------------------------------
+ecgeval: Generate and run a script of commands to compare sets of annotations
+Copyright (C) 2026 WFDB contributors
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author by e-mail (wfdb@physionet.org) or postal mail
+(MIT Room E25-505A, Cambridge, MA 02139 USA).  For updates to this software,
+please visit PhysioNet (http://www.physionet.org/).
+_______________________________________________________________________________
+
+When bxb.c, epicmp.c, mxm.c, and rxr.c are compiled with ECGEVAL defined, as
+they are when ecgeval is built, their main functions are renamed as below,
+and each call to exit() within them becomes a call to ecgeval_exit(), which
+returns control to ecgeval rather than ending the process.  The column
+headings that these programs write at the beginning of their line-format
+output files are produced by the *_headings functions, which ecgeval also
+uses.
+*/
+
+extern int bxb_main(int argc, char *argv[]);
+extern int epicmp_main(int argc, char *argv[]);
+extern int mxm_main(int argc, char *argv[]);
+extern int rxr_main(int argc, char *argv[]);
+
+extern void ecgeval_exit(int status);
+
+extern void bxb_headings(FILE *fp, int fflag, int sd);
+extern void epicmp_headings(FILE *fp, int type);
+extern void epicmp_stheadings(FILE *fp);
+extern void mxm_headings(FILE *fp, int mtype);
+extern void rxr_headings(FILE *fp, int type);
@@ -1,5 +1,5 @@
 /* file: epicmp.c	G. Moody       3 March 1992
-			Last revised:  24 April 2020
+			Last revised:  18 October 2026
 
 -------------------------------------------------------------------------------
 epicmp: ANSI/AAMI-standard episode-by-episode annotation file comparator
@@ -61,13 +61,33 @@ understanding of algorithm errors.
 #define MAXEXCL	100	/* maximum number of intervals excluded from
 			   comparison */
 
-int aflag, sflag, s0flag, s1flag, vflag, xflag;
-char *lzmstimstr(WFDB_Time), *zmstimstr(WFDB_Time);
+static int aflag, sflag, s0flag, s1flag, vflag, xflag;
+
+static void epicmp(unsigned int stat, unsigned int type);
+static void find_episode(unsigned int annotator, unsigned int type);
+static void find_exclusions(unsigned int stat, unsigned int type);
+static WFDB_Time find_overlap(unsigned int annotator, unsigned int type);
+static int find_reference_extremum(int mode);
+static void stdc(int mode);
+static void pstat(char *s, long a, long b);
+static void tstat(char *s, WFDB_Time a, WFDB_Time b);
+static char *lzmstimstr(WFDB_Time t);
+static char *zmstimstr(WFDB_Time t);
+static void print_results(int type);
+static void init(int argc, char *argv[]);
+static void help(void);
+static char *prog_name(char *s);
+void epicmp_headings(FILE *fp, int type);
+void epicmp_stheadings(FILE *fp);
+
+#ifdef ECGEVAL		/* linked into ecgeval, which calls epicmp_main() */
+#include "ecgeval.h"
+#define main epicmp_main
+#define exit(status) ecgeval_exit(status)
+#endif
 
 int main(int argc, char *argv[])
 {
-    void epicmp(unsigned int, unsigned int), init(int, char **), print_results(int), stdc(int);
-
     /* Read and interpret command-line arguments. */
     init(argc, argv);
 
@@ -120,12 +140,11 @@ static long STP, FN, PTP, FP;
 static WFDB_Anninfo an[2];
 
 /* Perform an episode-by-episode comparison. */
-void epicmp(unsigned int stat, unsigned int type)
+static void epicmp(unsigned int stat, unsigned int type)
 {
     int i;
     unsigned int a, b;
-    WFDB_Time duration, overlap, find_overlap(unsigned int, unsigned int);
-    void find_episode(unsigned int, unsigned int), find_exclusions(unsigned int, unsigned int);
+    WFDB_Time duration, overlap;
 
     /* Find and mark any intervals to be excluded from the comparison. */
     if (xflag)
@@ -286,7 +305,7 @@ void epicmp(unsigned int stat, unsigned int type)
 
 static int lflag;
 
-void find_episode(unsigned int annotator, unsigned int type)
+static void find_episode(unsigned int annotator, unsigned int type)
 {
     int stat, stcount = 0;
     WFDB_Time tt;
@@ -410,7 +429,7 @@ void find_episode(unsigned int annotator, unsigned int type)
    positive predictivity comparisons, from which intervals of reference-marked
    atrial flutter are excluded. */
 
-void find_exclusions(unsigned int stat, unsigned int type)
+static void find_exclusions(unsigned int stat, unsigned int type)
 {
     nexcl = 0;
     if (stat == 1 && type == AFE) {
@@ -449,7 +468,7 @@ void find_exclusions(unsigned int stat, unsigned int type)
    overlap_ex0 and overlap_ex1 if the period of overlap includes the times
    ep_ex0[1-annotator] and ep_ex1[1-annotator]. */
 
-WFDB_Time find_overlap(unsigned int annotator, unsigned int type)
+static WFDB_Time find_overlap(unsigned int annotator, unsigned int type)
 {
     WFDB_Time overlap = 0L, o_start, o_end;
 
@@ -518,15 +537,15 @@ WFDB_Time find_overlap(unsigned int annotator, unsigned int type)
     return (overlap);
 }	
 
-FILE *ofile;
-WFDB_Time tref;		/* time of the most recent reference ST extremum */
-int sigref, stref;	/* signal number and ST deviation for the most recent
-			   reference ST extremum */
+static FILE *ofile;
+static WFDB_Time tref;	/* time of the most recent reference ST extremum */
+static int sigref, stref;	/* signal number and ST deviation for the most
+				   recent reference ST extremum */
 
 /* This function finds the next reference ST extremum annotation and sets the
    variables tref, sigref, and stref appropriately. */
 
-int find_reference_extremum(int mode) /* 0: signal 0 only, 1: signal 1 only, 2: both signals */
+static int find_reference_extremum(int mode) /* 0: signal 0 only, 1: signal 1 only, 2: both signals */
 {
     WFDB_Annotation refann;
 
@@ -565,14 +584,14 @@ int find_reference_extremum(int mode) /* 0: signal 0 only, 1: signal 1 only, 2:
     return (0);
 }
 
-char *sd0fname, *sd1fname, *sdfname;
+static char *sd0fname, *sd1fname, *sdfname;
 
 /* This function compares ST measurements.  Since reference measurements are
    only available at the extremum of each episode, stdc finds the test
    measurement that is nearest in time to each reference measurement.
    Each pair of measurements is recorded in the output file. */
 
-void stdc(int mode) /* 0: signal 0 only, 1: signal 1 only, 2: both signals */
+static void stdc(int mode) /* 0: signal 0 only, 1: signal 1 only, 2: both signals */
 {
     char *ofname;
     WFDB_Annotation testann;
@@ -596,8 +615,7 @@ void stdc(int mode) /* 0: signal 0 only, 1: signal 1 only, 2: both signals */
 			      pname, ofname);
 		exit(3);
 	    }
-	    (void)fprintf(ofile, "(ST measurements)\n");
-	    (void)fprintf(ofile, "Record     Time  Signal  Reference  Test\n");
+	    epicmp_stheadings(ofile);
 	}
 	else {
 	    (void)fclose(ofile);
@@ -647,7 +665,7 @@ void stdc(int mode) /* 0: signal 0 only, 1: signal 1 only, 2: both signals */
 /* `pstat' prints a statistic described by s, defined as the quotient of a and
    b expressed in percentage units.  Undefined values are indicated by `-'. */
 
-void pstat(char *s, long a, long b)
+static void pstat(char *s, long a, long b)
 {
     if (!lflag) {
 	(void)fprintf(ofile, "%s:", s);
@@ -663,7 +681,7 @@ void pstat(char *s, long a, long b)
 /* `tstat' prints a statistic as above, but prints the numerator and
    denominator as times. */
 
-void tstat(char *s, WFDB_Time a, WFDB_Time b)
+static void tstat(char *s, WFDB_Time a, WFDB_Time b)
 {
     if (!lflag) {
 	(void)fprintf(ofile, "%s:", s);
@@ -676,7 +694,7 @@ void tstat(char *s, WFDB_Time a, WFDB_Time b)
     else (void)fprintf(ofile, " %3d", (int)((100.*a)/b + 0.5));
 }
 
-char *lzmstimstr(WFDB_Time t)
+static char *lzmstimstr(WFDB_Time t)
 {
     char *p = zmstimstr(t);
 
@@ -685,12 +703,46 @@ char *lzmstimstr(WFDB_Time t)
     return (p);
 }
 
-char *zmstimstr(WFDB_Time t)
+static char *zmstimstr(WFDB_Time t)
 {
     return (t ? mstimstr(t) : "       0.000");
 }
 
-void print_results(int type)
+/* Write the column headings for line-format output of episode statistics of
+   the given type (0: AF, 1: VF, 2: ST in signal 0, 3: ST in signal 1, 4: ST
+   in either signal) to fp.  (This function is also used by ecgeval.) */
+void epicmp_headings(FILE *fp, int type)
+{
+    switch (type) {
+      case AFE:
+	(void)fprintf(fp, "(AF detection)\n");
+	break;
+      case VFE:
+	(void)fprintf(fp, "(VF detection)\n");
+	break;
+      case ST0E:
+	(void)fprintf(fp, "(Ischemic ST detection, signal 0)\n");
+	break;
+      case ST1E:
+	(void)fprintf(fp, "(Ischemic ST detection, signal 1)\n");
+	break;
+      case STE:
+	(void)fprintf(fp, "(Ischemic ST detection, both signals)\n");
+	break;
+    }
+    (void)fprintf(fp, "Record  TPs   FN  TPp   FP");
+    (void)fprintf(fp, "  ESe E+P DSe D+P  Ref duration  Test duration \n");
+}
+
+/* Write the column headings for ST measurement output to fp.  (This function
+   is also used by ecgeval.) */
+void epicmp_stheadings(FILE *fp)
+{
+    (void)fprintf(fp, "(ST measurements)\n");
+    (void)fprintf(fp, "Record     Time  Signal  Reference  Test\n");
+}
+
+static void print_results(int type)
 {
     char *ofname;
 
@@ -711,29 +763,8 @@ void print_results(int type)
 			      pname, ofname);
 		exit(3);
 	    }
-	    if (lflag) {
-		switch (type) {
-		  case AFE:
-		    (void)fprintf(ofile, "(AF detection)\n");
-		    break;
-		  case VFE:
-		    (void)fprintf(ofile, "(VF detection)\n");
-		    break;
-		  case ST0E:
-		    (void)fprintf(ofile,"(Ischemic ST detection, signal 0)\n");
-		    break;
-		  case ST1E:
-		    (void)fprintf(ofile,"(Ischemic ST detection, signal 1)\n");
-		    break;
-		  case STE:
-		    (void)fprintf(ofile,
-				  "(Ischemic ST detection, both signals)\n");
-		    break;
-		}
-		(void)fprintf(ofile, "Record  TPs   FN  TPp   FP");
-		(void)fprintf(ofile,
-			  "  ESe E+P DSe D+P  Ref duration  Test duration \n");
-	    }
+	    if (lflag)
+		epicmp_headings(ofile, type);
 	}
 	else {
 	    (void)fclose(ofile);
@@ -799,11 +830,9 @@ void print_results(int type)
 	(void)fclose(ofile);
 }
 
-void init(int argc, char *argv[])
+static void init(int argc, char *argv[])
 {
     int i;
-    char *prog_name(char *);
-    void help();
 
     pname = prog_name(argv[0]);
     for (i = 1; i < argc; i++) {
@@ -995,7 +1024,7 @@ static char *help_strings[] = {
 NULL
 };
 
-void help()
+static void help(void)
 {
     int i;
 
@@ -1004,7 +1033,7 @@ void help()
 	(void)fprintf(stderr, "%s\n", help_strings[i]);
 }
 
-char *prog_name(char *s)
+static char *prog_name(char *s)
 {
     char *p = s + strlen(s);
 
@@ -1,5 +1,5 @@
 /* file: fir.c		G. Moody	5 January 1987
-			Last revised:    24 April 2020
+			Last revised:    18 October 2026
 
 -------------------------------------------------------------------------------
 fir: General-purpose FIR filter for database records
@@ -22,6 +22,21 @@ You may contact the author by e-mail (wfdb@physionet.org) or postal mail
 please visit PhysioNet (http://www.physionet.org/).
 _______________________________________________________________________________
 
+Input frames are read in blocks and kept, one signal per row, in linear
+(planar) buffers that begin with the last flen-1 input samples of the previous
+block, so that the inner loops run over contiguous memory without any modulo
+indexing.  Short filters are applied directly; the inner loop runs over a
+fixed-length block of outputs for each coefficient, which allows the compiler
+to vectorize it.  Long filters are applied by overlap-save convolution:  each
+block is transformed by a radix-2 FFT, multiplied by the transform of the
+impulse response, and transformed back.  Since the impulse response is real,
+two signals are filtered by each complex transform (one as the real part and
+the other as the imaginary part of the input).
+
+Both methods accumulate each output sample in double precision and convert it
+to an integer only once, so that they produce identical output for filters with
+integer coefficients (and results that differ only in rare rounding cases
+otherwise).
 */
 
 #include <stdio.h>
@@ -36,37 +51,54 @@ static double *c;	/* pointer to array of filter coefficients */
 static int flen;	/* number of coefficients (filter length) */
 static int nsig;	/* number of signals to be filtered */
 static int ri, ro;	/* rectify input/output if non-zero */
-static int **vin;	/* pointers to input vectors */
+static int *vin;		/* pointer to input vector */
 static int *vout;	/* pointer to output vector */
 static WFDB_Time nsamp; /* number of samples to be processed */
 
+/* Filtering methods */
+#define FIR_AUTO	0	/* choose according to filter length */
+#define FIR_DIRECT	1	/* direct convolution */
+#define FIR_FFT		2	/* FFT-based overlap-save convolution */
+
+#ifndef PI
+#define PI	3.14159265358979323846
+#endif
+
+#define FFTMINLEN	64	/* shortest filter for which FIR_AUTO uses FFTs */
+#define DBLKSIZE	256	/* frames per block in FIR_DIRECT mode */
+
+static int method = FIR_AUTO;
+static int blksize;	/* number of frames per block */
+static double **x;	/* x[s]: history followed by current block of signal s */
+static double **y;	/* y[s]: filtered current block of signal s */
+
+/* Variables used in FIR_FFT mode */
+static int nfft;	/* transform length (a power of 2) */
+static int *brev;	/* bit-reversal permutation of 0 ... nfft-1 */
+static double *wre, *wim;	/* twiddle factors */
+static double *hre, *him;	/* transform of the impulse response */
+static double *zre, *zim;	/* work arrays */
+
 static char *prog_name(char *s);
 static void help(void);
 static void init(int argc, char *argv[]);
 static void memerr(void);
+static int getblock(void);
+static int putblock(int n);
+static void direct_filter(void);
+static void fft_init(void);
+static void fft(double *re, double *im, int inverse);
+static void fft_filter(void);
 
 int main(int argc, char *argv[])
 {
-    int f, i = 0, j, s;
+    int n;
 
     init(argc, argv);	/* read and interpret command line */
-    while ((nsamp == -1L || nsamp-- > 0L) && getvec(vin[i]) >= 0) {
-	if (ri) {
-	    for (s = 0; s < nsig; s++)
-		if (vin[i][s] < 0) vin[i][s] = -vin[i][s];
-	}
-	if (++i >= flen)
-	    i = 0;
-	for (s = 0, j = i; s < nsig; s++)
-	    for (f = vout[s] = 0; f < flen; f++) {
-		vout[s] += c[f]*vin[j][s];
-		if (++j >= flen) j = 0;
-	    }
-	if (ro) {
-	    for (s = 0; s < nsig; s++)
-		if (vout[s] < 0) vout[s] = -vout[s];
-	}
-	if (putvec(vout) < 0) break;
+    while ((n = getblock()) > 0) {
+	if (method == FIR_FFT) fft_filter();
+	else direct_filter();
+	if (putblock(n) < n || n < blksize) break;
     }
     if (nrec) (void)newheader(nrec);
     wfdbquit();
@@ -74,11 +106,164 @@ int main(int argc, char *argv[])
     return 0;
 }
 
+/* Convert an output sample to an integer.  Values within a rounding error of
+   an integer are taken to be that integer (otherwise an FFT result such as
+   4.9999999999 would be truncated to 4);  all others are truncated toward
+   zero, as in earlier versions of this program. */
+static int toint(double v)
+{
+    double r = floor(v + 0.5);
+
+    if (fabs(v - r) < 1e-6) return ((int)r);
+    return ((int)v);
+}
+
+/* Read the next block of input frames into x, following the flen-1 samples of
+   history saved from the previous block.  The unused part of a short final
+   block is zero-filled.  The number of frames read is returned. */
+static int getblock(void)
+{
+    int h = flen - 1, n, s;
+    static int first = 1;
+
+    if (first) first = 0;
+    else if (h > 0)
+	for (s = 0; s < nsig; s++)
+	    memmove(x[s], x[s] + blksize, h * sizeof(double));
+    for (n = 0; n < blksize && (nsamp == -1L || nsamp > 0L) &&
+	     getvec(vin) >= 0; n++) {
+	if (nsamp > 0L) nsamp--;
+	for (s = 0; s < nsig; s++)
+	    x[s][h+n] = (ri && vin[s] < 0) ? -vin[s] : vin[s];
+    }
+    if (n < blksize)
+	for (s = 0; s < nsig; s++)
+	    memset(x[s] + h + n, 0, (blksize - n) * sizeof(double));
+    return (n);
+}
+
+/* Write the first n filtered frames of the current block.  The number of
+   frames written successfully is returned. */
+static int putblock(int n)
+{
+    int i, s;
+
+    for (i = 0; i < n; i++) {
+	for (s = 0; s < nsig; s++) {
+	    vout[s] = toint(y[s][i]);
+	    if (ro && vout[s] < 0) vout[s] = -vout[s];
+	}
+	if (putvec(vout) < 0) break;
+    }
+    return (i);
+}
+
+/* Apply the filter to the current block by direct convolution.  The last
+   coefficient is applied to the most recent input sample. */
+static void direct_filter(void)
+{
+    int f, n, s;
+
+    for (s = 0; s < nsig; s++) {
+	double *restrict acc = y[s];
+
+	for (n = 0; n < DBLKSIZE; n++)
+	    acc[n] = 0.0;
+	for (f = 0; f < flen; f++) {
+	    const double cf = c[f], *restrict xp = x[s] + f;
+
+	    for (n = 0; n < DBLKSIZE; n++)
+		acc[n] += cf * xp[n];
+	}
+    }
+}
+
+/* Prepare the tables needed in FIR_FFT mode, including the transform of the
+   impulse response (the coefficients in reverse order, zero-padded). */
+static void fft_init(void)
+{
+    int i, j, k, lg;
+
+    for (nfft = 512, lg = 9; nfft < 4*flen; nfft <<= 1, lg++)
+	;
+    if ((brev = (int *)malloc(nfft * sizeof(int))) == NULL ||
+	(wre = (double *)malloc(nfft/2 * sizeof(double))) == NULL ||
+	(wim = (double *)malloc(nfft/2 * sizeof(double))) == NULL ||
+	(hre = (double *)calloc(nfft, sizeof(double))) == NULL ||
+	(him = (double *)calloc(nfft, sizeof(double))) == NULL ||
+	(zre = (double *)malloc(nfft * sizeof(double))) == NULL ||
+	(zim = (double *)malloc(nfft * sizeof(double))) == NULL)
+	memerr();
+    for (i = 0; i < nfft; i++) {
+	for (j = k = 0; j < lg; j++)
+	    k |= ((i >> j) & 1) << (lg - 1 - j);
+	brev[i] = k;
+    }
+    for (i = 0; i < nfft/2; i++) {
+	wre[i] = cos(2.0*PI*i/nfft);
+	wim[i] = -sin(2.0*PI*i/nfft);
+    }
+    for (i = 0; i < flen; i++)
+	hre[i] = c[flen-1-i];
+    fft(hre, him, 0);
+}
+
+/* In-place iterative radix-2 complex FFT of length nfft.  The inverse
+   transform is not normalized. */
+static void fft(double *re, double *im, int inverse)
+{
+    int half, i, j, k, step;
+    double tr, ti, ur, ui;
+
+    for (i = 0; i < nfft; i++)
+	if (i < (j = brev[i])) {
+	    tr = re[i]; re[i] = re[j]; re[j] = tr;
+	    ti = im[i]; im[i] = im[j]; im[j] = ti;
+	}
+    for (half = 1, step = nfft/2; half < nfft; half <<= 1, step >>= 1)
+	for (i = 0; i < nfft; i += 2*half)
+	    for (j = i, k = 0; j < i + half; j++, k += step) {
+		ur = wre[k]; ui = inverse ? -wim[k] : wim[k];
+		tr = re[j+half]*ur - im[j+half]*ui;
+		ti = re[j+half]*ui + im[j+half]*ur;
+		re[j+half] = re[j] - tr; im[j+half] = im[j] - ti;
+		re[j] += tr; im[j] += ti;
+	    }
+}
+
+/* Apply the filter to the current block by overlap-save convolution, two
+   signals per transform.  The first flen-1 points of each inverse transform
+   are corrupted by circular wraparound and are discarded. */
+static void fft_filter(void)
+{
+    int h = flen - 1, k, s;
+    double tr, scale = 1.0/nfft;
+
+    for (s = 0; s < nsig; s += 2) {
+	memcpy(zre, x[s], nfft * sizeof(double));
+	if (s+1 < nsig) memcpy(zim, x[s+1], nfft * sizeof(double));
+	else memset(zim, 0, nfft * sizeof(double));
+	fft(zre, zim, 0);
+	for (k = 0; k < nfft; k++) {
+	    tr = zre[k]*hre[k] - zim[k]*him[k];
+	    zim[k] = zre[k]*him[k] + zim[k]*hre[k];
+	    zre[k] = tr;
+	}
+	fft(zre, zim, 1);
+	for (k = 0; k < blksize; k++)
+	    y[s][k] = zre[h+k] * scale;
+	if (s+1 < nsig)
+	    for (k = 0; k < blksize; k++)
+		y[s+1][k] = zim[h+k] * scale;
+    }
+}
+
 static void init(int argc, char *argv[])
 {
     char *irec = "16", *orec = "16", *p;
     double *tc = NULL;
     int i, n = 128, s;
+    WFDB_Time k;
     WFDB_Time from = 0L, shift = 0L, to = 0L;
     static int gvmode = 0;
     static WFDB_Siginfo *chin, *chout;
@@ -89,6 +274,7 @@ static void init(int argc, char *argv[])
 	if (*argv[i] == '-') switch (*(argv[i]+1)) {
 	  case 'c':	/* filter coefficients follow */
 	    flen = argc - (++i);
+	    if (flen < 1) break;
 	    if ((c=tc=(double *)calloc((unsigned)flen,sizeof(double))) == NULL)
 		memerr();
 	    while (i < argc)
@@ -114,6 +300,12 @@ static void init(int argc, char *argv[])
 		}
 	    (void)fclose(ifile);
 	    break;
+	  case 'D':	/* use direct convolution */
+	    method = FIR_DIRECT;
+	    break;
+	  case 'F':	/* use FFT-based convolution */
+	    method = FIR_FFT;
+	    break;
 	  case 'f':	/* starting time */
 	    if (++i >= argc) {
 		(void)fprintf(stderr, "%s: time must follow -f\n", pname);
@@ -236,23 +428,57 @@ static void init(int argc, char *argv[])
 	if (to < (WFDB_Time)0) to = -to;
     }
     nsamp = (to > 0L) ? to - from : -1L;
+
+    if (method == FIR_AUTO)
+	method = (flen >= FFTMINLEN) ? FIR_FFT : FIR_DIRECT;
+    if (method == FIR_FFT) {
+	fft_init();
+	blksize = nfft - (flen - 1);
+    }
+    else
+	blksize = DBLKSIZE;
     if ((vout = (int *)calloc((unsigned)nsig, sizeof(int))) == NULL ||
-	(vin = (int **)calloc((unsigned)flen, sizeof(int *))) == NULL)
+	(vin = (int *)calloc((unsigned)nsig, sizeof(int))) == NULL ||
+	(x = (double **)calloc((unsigned)nsig, sizeof(double *))) == NULL ||
+	(y = (double **)calloc((unsigned)nsig, sizeof(double *))) == NULL)
 	memerr();
-    for (i = 0; i < flen; i++)
-	if ((vin[i] = (int *)calloc((unsigned)nsig, sizeof(int))) == NULL)
+    for (s = 0; s < nsig; s++)
+	if ((x[s] = (double *)calloc((unsigned)(flen - 1 + blksize),
+				     sizeof(double))) == NULL ||
+	    (y[s] = (double *)calloc((unsigned)blksize,
+				     sizeof(double))) == NULL)
 	    memerr();
+
+    /* Fill the history with the last flen-1 samples read while correcting
+       for phase shift.  x[s][k % (flen-1)] receives the k-th of these samples,
+       and the history is rotated into order afterwards. */
     if (shift > 0) {
 	shift = strtim(argv[shift]);
-	i = flen - (shift % flen);
-	while (shift-- > 0) {
-	    if (i >= flen) i = 0;
-	    (void)getvec(vin[i]);
-	    if (ri) {
+	for (k = 0; k < shift; k++) {
+	    (void)getvec(vin);
+	    if (flen > 1)
 		for (s = 0; s < nsig; s++)
-		    if (vin[i][s] < 0) vin[i][s] = -vin[i][s];
+		    x[s][k % (flen-1)] = (ri && vin[s] < 0) ? -vin[s] : vin[s];
+	}
+	if (flen > 1 && shift >= flen - 1 && (i = shift % (flen-1)) > 0) {
+	    double *t;
+
+	    if ((t = (double *)malloc(i * sizeof(double))) == NULL)
+		memerr();
+	    for (s = 0; s < nsig; s++) {
+		memcpy(t, x[s], i * sizeof(double));
+		memmove(x[s], x[s] + i, (flen-1-i) * sizeof(double));
+		memcpy(x[s] + flen-1-i, t, i * sizeof(double));
+	    }
+	    free(t);
+	}
+	else if (flen > 1 && shift < flen - 1) {
+	    /* fewer samples than the history holds:  right-justify them */
+	    i = (int)shift;
+	    for (s = 0; s < nsig; s++) {
+		memmove(x[s] + flen-1-i, x[s], i * sizeof(double));
+		memset(x[s], 0, (flen-1-i) * sizeof(double));
 	    }
-	    i++;
 	}
     }
 }
@@ -288,7 +514,10 @@ static char *help_strings[] = {
  " -c A1 [A2 ...]  filter using coefficients A1, A2, ... (must be the last",
  "              option; -c marks the beginning of the coefficient list)",
  " -C file     filter using coefficients read from the specified FILE",
+ " -D          filter by direct convolution (default for short filters)",
  " -f TIME     begin at specified time",
+ " -F          filter by FFT-based convolution (default for filters with",
+ "              64 or more coefficients)",
  " -h          print this usage summary",
  " -H          read multifrequency signals in high resolution mode",
  " -i IREC     read signals from record IREC (default: 16)",
@@ -1,5 +1,5 @@
 /* file: gqfuse.c		G. Moody	6 May 2012
-				Last revised:   8 March 2019
+				Last revised:  18 October 2026
 -------------------------------------------------------------------------------
 gqfuse: combine QRS annotation files
 Copyright (C) 2012 George B. Moody
@@ -32,6 +32,11 @@ the input to be switched once per minute, the policy for resolving ties (within
 2 beats) favors not switching if the previously chosen input is one of those
 belonging to the tie.
 
+Each pass reads all of the input annotation files together, using the WFDB
+library's annmerge and getmergedann functions.  The first pass counts beats per
+minute for each input, and the second copies the annotations of each chosen
+input within its segments.
+
 One way to use this program is to combine input annotation files for each
 available ECG signal in a record, made using a single detector such as gqrs.
 Another is to combine input annotation files made using a variety of QRS
@@ -68,14 +73,15 @@ int icomp(const void *a, const void *b)
 main(int argc, char **argv)
 {
     char *oaname = "gqf";
-    double HR;
+    double HR = 0.0;
     FILE *config = NULL;
-    int a0 = 0, a1 = 0, **count, dn, i, ibest, ichosen = 0, j, *mbuf,
-	n, niann = 0, nseg, tdn;
+    int a0 = 0, a1 = 0, *chosen, **count, dn, i, ibest, ichosen = 0, j, *mbuf,
+	niann = 0, nseg, tdn;
     WFDB_Anninfo *a;
     WFDB_Annotation annot;
+    WFDB_Annotator an;
     WFDB_Frequency sps, spm;
-    WFDB_Time t0, tf;
+    WFDB_Time seg;
 
     pname = prog_name(argv[0]);
 
@@ -194,21 +200,16 @@ main(int argc, char **argv)
     spm = 60.0 * sps;		    /* annotation ticks per minute */
 
     /* Pass 1: Load the HR arrays. */
-    for (i = 0; i < niann; i++) {
-	for (tf = spm, j = 0; j < nseg+1; tf += spm, j++) {
-	    n = 0;
-	    while (getann(i, &annot) == 0 && annot.time < tf)
-		if (isqrs(annot.anntyp)) n++;
-	    count[i][j] = n;
-	}
+    if (annmerge(NULL, 0) < 0) cleanup(2);
+    while (getmergedann(&an, &annot) == 0) {
+	if ((seg = annot.time / spm) > nseg) break;
+	if (seg >= 0 && isqrs(annot.anntyp)) count[an][seg]++;
     }
     wfdbquit();
 
-    /* Pass 2: Select the input annotations to be copied, and copy them. */
-    if (sampfreq(record) != sps)
-	setifreq(sps);
-    if (annopen(record, a, niann+1) < 0) cleanup(2);
-    for (j = 0, t0 = 0, tf = spm; j < nseg+1; j++, t0 = tf, tf += spm) {
+    /* Select the input to be copied in each segment. */
+    chosen = gcalloc(sizeof(int), nseg + 1);
+    for (j = 0; j < nseg+1; j++) {
 	for (i = 0; i < niann; i++)
 	    mbuf[i] = count[i][j];
 	/* Note that the last element, mbuf[niann], is the previous median. */
@@ -231,16 +232,18 @@ main(int argc, char **argv)
 	    if (tdn < 0) tdn = -tdn;
 	    if (tdn < dn + 3) ibest = ichosen;
 	}
-	ichosen = ibest;
-	/* Copy the chosen annotations for this one-minute segment. */
-	n = 0;
-	while (getann(ichosen, &annot) == 0 && n <= count[ichosen][j]) {
-	    if (annot.time >= t0 && isqrs(annot.anntyp)) {
-		putann(0, &annot);
-		n++;
-	    }
-	}
-	ungetann(ichosen, &annot);
+	chosen[j] = ichosen = ibest;
+    }
+
+    /* Pass 2: Copy the annotations of the chosen input in each segment. */
+    if (sampfreq(record) != sps)
+	setifreq(sps);
+    if (annopen(record, a, niann+1) < 0) cleanup(2);
+    if (annmerge(NULL, 0) < 0) cleanup(2);
+    while (getmergedann(&an, &annot) == 0) {
+	if ((seg = annot.time / spm) > nseg) break;
+	if (seg >= 0 && (int)an == chosen[seg] && isqrs(annot.anntyp))
+	    putann(0, &annot);
     }
     cleanup(0);
 }
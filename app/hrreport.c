@@ -0,0 +1,308 @@
+/* file: hrreport.c	WFDB contributors	18 October 2026
+
+-------------------------------------------------------------------------------
+hrreport: Heart rate and heart rate variability reports from an annotation file
+Copyright (C) 2026 WFDB contributors
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author by e-mail (wfdb@physionet.org) or postal mail
+(MIT Room E25-505A, Cambridge, MA 02139 USA).  For updates to this software,
+please visit PhysioNet (http://www.physionet.org/).
+_______________________________________________________________________________
+
+This program reads an annotation file once, and produces the reports that
+would otherwise require running ann2rr, ihr, hrstats, and tach separately,
+together with standard time-domain heart rate variability measures.  The
+measurements are made by the WFDB library's heart rate statistics functions
+(see newhrstats).  A summary is written to the standard output;  with the -o
+option, the RR interval series, instantaneous heart rate, HR histogram, and
+evenly sampled heart rate are also written to files.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wfdb/wfdb.h>
+
+static char *pname;
+
+static char *prog_name(char *s);
+static FILE *ofopen(char *prefix, char *suffix);
+static void help(void);
+
+int main(int argc, char *argv[])
+{
+    char *aname = NULL, *endp = NULL, *prefix = NULL, *record = NULL,
+	*startp = NULL;
+    double k = 1., ofreq = 2., sps, tol = 10.;
+    int i, Oflag = 0, stat = 1, xflag = 0;
+    FILE *hfile = NULL, *ifile = NULL, *rfile = NULL, *tfile = NULL;
+    WFDB_Anninfo ai;
+    WFDB_Annotation annot;
+    WFDB_Hrstats *h;
+    WFDB_Siginfo si;
+    WFDB_Time from = 0L, to = 0L;
+
+    pname = prog_name(argv[0]);
+
+    /* Interpret command-line options. */
+    for (i = 1; i < argc; i++) {
+	if (*argv[i] == '-') switch (*(argv[i]+1)) {
+	  case 'a':	/* annotator follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: annotator must follow -a\n",
+			      pname);
+		exit(1);
+	    }
+	    aname = argv[i];
+	    break;
+	  case 'd':	/* tolerance for instantaneous HR (bpm) follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: tolerance must follow -d\n",
+			      pname);
+		exit(1);
+	    }
+	    tol = atof(argv[i]);
+	    break;
+	  case 'f':	/* starting time follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: starting time must follow -f\n",
+			      pname);
+		exit(1);
+	    }
+	    startp = argv[i];
+	    break;
+	  case 'F':	/* tach output sampling frequency follows */
+	    if (++i >= argc || (ofreq = atof(argv[i])) <= 0.) {
+		(void)fprintf(stderr,
+		      "%s: output sampling frequency (> 0) must follow -F\n",
+			      pname);
+		exit(1);
+	    }
+	    break;
+	  case 'h':	/* print usage summary and quit */
+	    help();
+	    exit(0);
+	    break;
+	  case 'o':	/* output file name prefix follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: output prefix must follow -o\n",
+			      pname);
+		exit(1);
+	    }
+	    prefix = argv[i];
+	    break;
+	  case 'O':	/* disable tach outlier rejection */
+	    Oflag = 1;
+	    break;
+	  case 'r':	/* input record name follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: input record name must follow -r\n",
+			      pname);
+		exit(1);
+	    }
+	    record = argv[i];
+	    break;
+	  case 's':	/* tach smoothing constant follows */
+	    if (++i >= argc || (k = atof(argv[i])) <= 0.) {
+		(void)fprintf(stderr,
+		       "%s: smoothing constant (> 0) must follow -s\n", pname);
+		exit(1);
+	    }
+	    break;
+	  case 't':	/* ending time follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: end time must follow -t\n", pname);
+		exit(1);
+	    }
+	    endp = argv[i];
+	    break;
+	  case 'x':	/* exclude intervals following those adjacent to
+			   excluded beats from instantaneous HR */
+	    xflag = 1;
+	    break;
+	  default:
+	    (void)fprintf(stderr, "%s: unrecognized option %s\n",
+			  pname, argv[i]);
+	    exit(1);
+	}
+	else {
+	    (void)fprintf(stderr, "%s: unrecognized argument %s\n",
+			  pname, argv[i]);
+	    exit(1);
+	}
+    }
+    if (record == NULL || aname == NULL) {
+	help();
+	exit(1);
+    }
+
+    if ((sps = sampfreq(record)) <= 0.)
+	(void)setsampfreq(sps = WFDB_DEFFREQ);
+
+    ai.name = aname;
+    ai.stat = WFDB_READ;
+    if (annopen(record, &ai, 1) < 0)	/* open annotation file */
+	exit(2);
+
+    if (startp && (from = strtim(startp)) < 0L)
+	from = -from;
+    if (endp) {
+	if ((to = strtim(endp)) < 0L)
+	    to = -to;
+	if (to > 0L && to <= from) {
+	    (void)fprintf(stderr, "%s: improper interval specified\n", pname);
+	    exit(1);
+	}
+    }
+    else if (isigopen(record, &si, -1) > 0) /* check header for length */
+	to = si.nsamp;
+    if (from > 0L && iannsettime(from) < 0) exit(2);
+
+    if (newhrstats(sps, &h) < 0)
+	exit(2);
+    h->from = from;
+    h->to = to;
+    h->ihrtol = tol;
+    h->ihrx = xflag;
+    h->tachfreq = ofreq;
+    h->tachk = k;
+    h->tachreject = !Oflag;
+
+    if (prefix) {
+	rfile = ofopen(prefix, "rr");
+	ifile = ofopen(prefix, "ihr");
+	tfile = ofopen(prefix, "tach");
+	hfile = ofopen(prefix, "hist");
+    }
+
+    /* Read the annotations until no more are needed. */
+    while (stat > 0 && getann(0, &annot) == 0 &&
+	   (stat = hrstatsann(h, &annot)) >= 0) {
+	if (prefix == NULL)
+	    continue;
+	if (h->beat && h->rr > 0)
+	    (void)fprintf(rfile, "%.3f\t%.3f\t%d\n", annot.time/sps, h->rr/sps,
+			  h->nn);
+	if (h->ihrok) {
+	    (void)fprintf(ifile, "%.3f\t", h->ihrstart/sps);
+	    if (xflag) (void)fprintf(ifile, "%g\n", h->ihr);
+	    else (void)fprintf(ifile, "%g\t%d\n", h->ihr, h->ihrgap);
+	}
+	for (i = 0; i < h->ntach; i++)
+	    (void)fprintf(tfile, "%g\n", h->tach[i]);
+    }
+    if (stat < 0) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    endhrstats(h);
+
+    if (hfile) {
+	if (h->nhr > 0)
+	    for (i = h->hrlow; i <= h->hrhigh; i++)
+		(void)fprintf(hfile, "%d\t%ld\n", i, h->hrhist[i]);
+	(void)fclose(hfile);
+	(void)fclose(rfile);
+	(void)fclose(ifile);
+	(void)fclose(tfile);
+    }
+
+    /* Write the summary. */
+    if (h->nhr > 0)
+	(void)printf(" <HR>: %d|%d/%d/%d|%d +-%.2g bpm [%s]\n",
+		     h->hrlow, h->hr5, h->hrmean, h->hr95, h->hrhigh, h->hrsd,
+		     aname);
+    else
+	(void)printf(" <HR>: no HR data [%s]\n", aname);
+    (void)printf("Beats:    %ld\n", h->nbeats);
+    (void)printf("NN/RR:    %ld/%ld\n", h->nnn, h->nrr);
+    (void)printf("AVNN:     %.5f s\n", h->avnn);
+    (void)printf("SDNN:     %.5f s\n", h->sdnn);
+    (void)printf("SDANN:    %.5f s\n", h->sdann);
+    (void)printf("SDNNIDX:  %.5f s\n", h->sdnnidx);
+    (void)printf("rMSSD:    %.5f s\n", h->rmssd);
+    (void)printf("pNN50:    %.3f %%\n", h->pnn50);
+
+    freehrstats(h);
+    wfdbquit();
+    exit(0);
+}
+
+/* ofopen opens PREFIX.SUFFIX for writing, or exits if it can't be opened. */
+static FILE *ofopen(char *prefix, char *suffix)
+{
+    char *name;
+    FILE *f;
+
+    if ((name = malloc(strlen(prefix) + strlen(suffix) + 2)) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    (void)sprintf(name, "%s.%s", prefix, suffix);
+    if ((f = fopen(name, "wt")) == NULL) {
+	(void)fprintf(stderr, "%s: can't write %s\n", pname, name);
+	exit(3);
+    }
+    free(name);
+    return (f);
+}
+
+static char *prog_name(char *s)
+{
+    char *p = s + strlen(s);
+
+#ifdef MSDOS
+    while (p >= s && *p != '\\' && *p != ':') {
+	if (*p == '.')
+	    *p = '\0';		/* strip off extension */
+	if ('A' <= *p && *p <= 'Z')
+	    *p += 'a' - 'A';	/* convert to lower case */
+	p--;
+    }
+#else
+    while (p >= s && *p != '/')
+	p--;
+#endif
+    return (p+1);
+}
+
+static char *help_strings[] = {
+ "usage: %s -r RECORD -a ANNOTATOR [OPTIONS ...]\n",
+ "where RECORD and ANNOTATOR specify the input; OPTIONS may include any of:",
+" -d TOL        reject beat-to-beat instantaneous HR changes > TOL bpm",
+"                (default: 10)",
+" -f TIME       begin at specified time",
+" -F FREQUENCY  sample the smoothed HR at FREQUENCY Hz (default: 2)",
+" -h            print this usage summary",
+" -o PREFIX     write PREFIX.rr (RR intervals), PREFIX.ihr (instantaneous HR),",
+"                PREFIX.hist (HR histogram), and PREFIX.tach (smoothed HR)",
+" -O            disable outlier rejection in the smoothed HR",
+" -s SMOOTHING  set smoothing constant for smoothed HR (default: 1)",
+" -t TIME       stop at specified time (default: end of record)",
+" -x            exclude instantaneous HR in intervals adjacent to abnormal",
+"                beats",
+"A summary of heart rate and heart rate variability is written to the standard",
+"output.",
+NULL
+};
+
+static void help(void)
+{
+    int i;
+
+    (void)fprintf(stderr, help_strings[0], pname);
+    for (i = 1; help_strings[i] != NULL; i++)
+	(void)fprintf(stderr, "%s\n", help_strings[i]);
+}
@@ -1,5 +1,5 @@
 /* file: hrstats.c		G. Moody	 18 March 2012
-				Last revised:	4 November 2020
+				Last revised:  18 October 2026
 -------------------------------------------------------------------------------
 hrstats: Collect and summarize heart rate statistics
 Copyright (C) 1985-2012 George B. Moody
@@ -59,40 +59,32 @@ columns separated by a tab.  The second column contains the number of
 measurements of heart rate falling within 0.5 bpm of the heart rate in the
 first column.  The histogram includes only heart rates between the extreme
 low and extreme high heart rates inclusive.
+
+The measurements are made by the WFDB library's heart rate statistics
+functions (see newhrstats), which also underlie ihr, tach, and hrreport.
 */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
 #include <wfdb/wfdb.h>
-#include <wfdb/ecgmap.h>
-
-#define HRMAX	 500	/* maximum heart rate (bpm) */
-#define TBMAX	 128	/* length of ix[] and tb[] (must be a power of 2) */
-
-/* Note that iexcl() and tbeat() must be usable as lvalues! */
-#define iexcl(A) (ix[(A)&(TBMAX-1)])	/* exclude interval A if non-zero */
-#define tbeat(A) (tb[(A)&(TBMAX-1)])	/* time of beat following interval A */
 
 static char *irec, *aname, *ofname, *pname;
-static int hrhist[HRMAX+1], ix[TBMAX], tot, wexcl;
-static WFDB_Anninfo ai;
-static WFDB_Time tb[TBMAX];
 
 static char *prog_name(char *s);
-static void cleanup(void);
 static void help(void);
-static WFDB_Time getbeat(void);
 
 int main(int argc, char **argv)
 {
-    double dt, left, right, rr, rrcnt, rrmin, rrmax, sps, t;
-    int i, hr;
-    long max = 0, min = 0, n;
-    WFDB_Time tmaxb, tminb;
+    char hrbuf[100];
+    double sps;
+    int i, stat = 1;
+    WFDB_Anninfo ai;
+    WFDB_Annotation annot;
+    WFDB_Hrstats *h;
 
     pname = prog_name(argv[0]);
+    ai.name = NULL;
 
     /* Interpret command-line options. */
     for (i = 1; i < argc; i++) {
@@ -149,84 +141,30 @@ int main(int argc, char **argv)
 		"(assuming %g Hz)\n",
 		pname, irec, sps);
     }
-    dt = 3 * sps;	/* window half-width */
-    rrmax = 3 * sps;	/* maximum valid RR interval */
-    rrmin = 0.2 * sps;	/* minimum valid RR interval */
-    tbeat(-1) = -1;	/* avoid division by zero if tbeat(0) is 0 */
 
     ai.stat = WFDB_READ;
     if (annopen(irec, &ai, 1) < 0)	/* open annotation file */
 	exit(2);
+    if (newhrstats(sps, &h) < 0)
+	exit(2);
+    h->tachfreq = 0.;	/* only the HR histogram is needed */
 
-    /* Start with the left edge of the window at the time of the first beat,
-       then read and process the remainder of the annotations. */
-    for (tbeat(min) = getbeat(), t = tbeat(min)+dt; max-min < TBMAX; t += sps) {
-	/* Reset the window limits. */
-	left = t - dt; right = t + dt;
-
-	/* read additional beats as needed to fill the window */
-	while ((tmaxb = tbeat(max)) <= right) {
-	    tbeat(++max) = getbeat();
-	    rr = tbeat(max) - tbeat(max-1);
-	    /* interval is invalid if not in bounds */
-	    iexcl(max) = !(rrmin < rr && rr < rrmax);
-	    /* window is invalid if it includes any invalid intervals */
-	    wexcl += iexcl(max);
-	}
-	
-	/* advance min as needed until tbeat(min) is in the window */
-	while ((tminb = tbeat(min)) <= left)
-	    wexcl -= iexcl(min++);
-	if (wexcl == 0) { /* all intervals in the window are valid */
-	    /* get the whole and fractional number of intervals in the window */
-	    rrcnt = max - min + (tminb - left)  / (tminb - tbeat(min-1))
-			      - (tmaxb - right) / (tmaxb - tbeat(max-1));
-	    hr = (int)(10 * rrcnt + 0.5);  /* multiply beats in 6 seconds by
-					      10 to get beats per minute */
-	    if (hr > HRMAX) hr = HRMAX;
-	    hrhist[hr]++;
-	    tot++;
-	}
-    }
-    if (max >= min + TBMAX) {
-	fprintf(stderr, "%s: annotation buffer overflow\n", pname);
-	cleanup();
-    }
-}
-
-static WFDB_Time getbeat()
-{
-    int stat;
-    WFDB_Annotation annot;
-
-    while ((stat = getann(0, &annot)) >= 0 && !isqrs(annot.anntyp))
+    /* Read and process the annotations. */
+    while (getann(0, &annot) >= 0 && (stat = hrstatsann(h, &annot)) > 0)
 	;
-    if (stat < 0)
-	cleanup();
-    return (annot.time);
-}
-
-static void cleanup()
-{
-    char hrbuf[100];
-    double mean, sampdev, ssum, sum, target;
-    int extreme_high, extreme_low, i, imean, max95, min5, n, outliers;
-
+    if (stat < 0) {
+	fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
     wfdbquit();
 
-    /* derive statistics from histograms */
-    for (i = 0; i <= HRMAX; i++)
-	if (hrhist[i]) break;
-    if (i > HRMAX) {
+    /* derive statistics from the histogram */
+    endhrstats(h);
+    if (h->nhr == 0) {
 	fprintf(stderr, "%s: no HR data for record %s, annotator %s\n",
 		pname, irec, aname);
 	exit(1);
     }
-    extreme_low = i;
-
-    for (i = HRMAX; i >= extreme_low; i--)
-	if (hrhist[i]) break;
-    extreme_high = i;
 
     /* if requested, write histogram to specified file */
     if (ofname) {
@@ -236,41 +174,17 @@ static void cleanup()
 	    fprintf(stderr, "%s: can't write %s\n", pname, ofname);
 	}
 	else {
-	    for (i = extreme_low; i <= extreme_high; i++)
-		fprintf(ofile, "%d\t%d\n", i, hrhist[i]);
+	    for (i = h->hrlow; i <= h->hrhigh; i++)
+		fprintf(ofile, "%d\t%ld\n", i, h->hrhist[i]);
 	    fclose(ofile);
 	}
     }
 
-    for (i = extreme_low, n = 0, target = 0.05 * tot; n <= target; i++)
-	n += hrhist[i];
-    /* Adjust the count in the 5th percentile bin so that exactly 5% of
-       the lowest values are excluded from the mean. */
-    hrhist[--i] = n - target;
-    min5 = i;	/* 5th percentile */
-
-    for (i = extreme_high, n = 0; n <= target; i--)
-	n += hrhist[i];
-    /* Adjust the count in the 95th percentile bin so that exactly 5% of
-       the highest values are excluded from the mean. */
-    hrhist[++i] = n - target;
-    max95 = i;	/* 95th percentile */
-
-    for (i = min5, n = sum = 0; i <= max95; i++) {
-	n += hrhist[i];
-	sum += hrhist[i]*i;
-    }
-    mean = sum / n;
-    imean = (int)(mean + 0.5);
-
-    for (i = min5, ssum = 0; i <= max95; i++)
-	ssum += hrhist[i] * (i - mean) * (i - mean);
-    sampdev = sqrt(ssum / n);
-
     /* write statistics to standard output */
     sprintf(hrbuf, " <HR>: %d|%d/%d/%d|%d +-%.2g bpm [%s]",
-	   extreme_low, min5, imean, max95, extreme_high, sampdev, aname);
+	    h->hrlow, h->hr5, h->hrmean, h->hr95, h->hrhigh, h->hrsd, aname);
     printf("%s\n", hrbuf);
+    freehrstats(h);
     setinfo(irec);
     putinfo(hrbuf);
     exit(0);
@@ -303,7 +217,7 @@ static char *help_strings[] = {
 NULL
 };
 
-static void help()
+static void help(void)
 {
     int i;
 
@@ -1,5 +1,5 @@
 /* file ihr.c		G. Moody      12 November 1992
-			Last revised:   24 April 2020
+			Last revised:  18 October 2026
 
 -------------------------------------------------------------------------------
 ihr: Generate instantaneous heart rate data from annotation file
@@ -22,6 +22,8 @@ You may contact the author by e-mail (wfdb@physionet.org) or postal mail
 please visit PhysioNet (http://www.physionet.org/).
 _______________________________________________________________________________
 
+The instantaneous heart rate is determined by the WFDB library's heart rate
+statistics functions (see newhrstats).
 */
 
 #include <stdio.h>
@@ -35,7 +37,6 @@ extern void exit();
 #define mamap
 #define annpos
 #include <wfdb/ecgmap.h>
-#include <math.h>
 
 static char *pname;
 
@@ -45,13 +46,13 @@ static void help(void);
 int main(int argc, char *argv[])
 {
     char *record = NULL;
-    double dmhr,  ihr, ihrlast, mhr = 70.0, sph, spm, sps, tol = 10.0;
-    int i, j, lastann = NOTQRS, last2ann = NOTQRS, tformat = 1, vflag = 1,
-	xflag = 0, lastint = 1, thisint = 0;
-    WFDB_Time from = 0L, to = 0L, lasttime = -9999L;
+    double sph, spm, sps, tol = 10.0;
+    int i, j, stat = 1, tformat = 1, vflag = 1, xflag = 0;
+    WFDB_Time from = 0L, to = 0L;
     static char flag[ACMAX+1];
     static WFDB_Anninfo ai;
     WFDB_Annotation annot;
+    WFDB_Hrstats *h;
 
     pname = prog_name(argv[0]);
     flag[0] = 1;
@@ -176,43 +177,32 @@ int main(int argc, char *argv[])
 	for (j = 0; j <= ACMAX; j++)
 	    flag[j] = (map1(j) == NORMAL);
 
-    while (getann(0, &annot) == 0 && (to == 0L || annot.time <= to)) {
-	if (flag[annot.anntyp]) {
-	    ihr = sps*60./(annot.time - lasttime);
-	    dmhr = (ihr - mhr)/10.;
-	    /* The next two lines of code were added in March 2004.  They limit
-	       the magnitude of dmhr (the increment to be applied to the
-	       predictor mhr) in order to limit the influence on mhr of any
-	       single observation.  This helps to keep mhr reasonably close to
-	       the recent mean heart rate even when the input contains gross
-	       QRS detection errors.  Given error-free input and a reasonable
-	       value for tol, these lines have no significant effect. */
-	    if (dmhr > tol) dmhr = tol;
-	    else if (dmhr < -tol) dmhr = -tol;
-	    mhr += dmhr;
-	    if (flag[lastann] && fabs(ihr-ihrlast)<tol && fabs(ihr-mhr)<tol) {
-		if (flag[last2ann] || !xflag) {
-		    WFDB_Time tt = (vflag > 0) ? lasttime : annot.time;
-		    switch (tformat) {
-		      case 0: (void)printf("%"WFDB_Pd_TIME"\t", tt); break;
-		      default:
-		      case 1: (void)printf("%.3lf\t", tt/sps); break;
-		      case 2: (void)printf("%.5lf\t", tt/spm); break;
-		      case 3: (void)printf("%.7lf\t", tt/sph); break;
-		    }
-		    if (xflag) (void)printf("%g\n", ihr);
-		    else (void)printf("%g\t%d\n", ihr, lastint);
-		    thisint = 0;
-		}
+    if (newhrstats(sps, &h) < 0)
+	exit(2);
+    for (j = 0; j <= ACMAX; j++)
+	h->ihrflag[j] = flag[j];
+    h->ihrtol = tol;
+    h->ihrx = xflag;
+    h->to = to;
+    h->tachfreq = 0.;
+
+    while (getann(0, &annot) == 0 && (stat = hrstatsann(h, &annot)) > 0) {
+	if (h->ihrok) {
+	    WFDB_Time tt = (vflag > 0) ? h->ihrstart : annot.time;
+	    switch (tformat) {
+	      case 0: (void)printf("%"WFDB_Pd_TIME"\t", tt); break;
+	      default:
+	      case 1: (void)printf("%.3lf\t", tt/sps); break;
+	      case 2: (void)printf("%.5lf\t", tt/spm); break;
+	      case 3: (void)printf("%.7lf\t", tt/sph); break;
 	    }
-	    ihrlast = ihr;
+	    if (xflag) (void)printf("%g\n", h->ihr);
+	    else (void)printf("%g\t%d\n", h->ihr, h->ihrgap);
 	}
-	else if (!isqrs(annot.anntyp)) continue;
-	last2ann = lastann;
-	lastann = annot.anntyp;
-	lasttime = annot.time;
-	lastint = thisint;
-	thisint = 1;
+    }
+    if (stat < 0) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
     }
     exit(0);
     return 0;
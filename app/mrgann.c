@@ -1,5 +1,5 @@
 /* file mrgann.c		G. Moody	28 May 1995
-				Last revised:  3 November 2017
+				Last revised:  18 October 2026
 
 -------------------------------------------------------------------------------
 mrgann: Merge annotation files by segments
@@ -22,93 +22,146 @@ You may contact the author by e-mail (wfdb@physionet.org) or postal mail
 please visit PhysioNet (http://www.physionet.org/).
 _______________________________________________________________________________
 
-This program reads two annotation files and creates a third.  Command-line
-arguments divide the annotation files into segments.  Within each segment,
-the annotations copied to the output annotation file may be any of the
+This program reads two or more annotation files and creates another.
+Command-line arguments divide the annotation files into segments.  Within each
+segment, the annotations copied to the output annotation file may be any of the
 following:
  - none (selected by -m0)
  - all annotations from the first input file (selected by -m1)
  - all annotations from the second input file (selected by -m2)
- - all annotations from both input files (default; selected by -m3)
+ - all annotations from both input files (selected by -m3)
+ - all annotations from all input files (default; selected by -ma)
+More generally, the digits following -m are a decimal number in which bit k-1
+is set to select the k-th input file (so that, for example, -m5 selects the
+first and third input files).
 
-Optionally, mrgann can remap the `chan' field in each annotation from one or
-both input files to a value that can be specified separately (using -c or -C)
-for each input annotation file.  This feature may be useful, for example, to
-merge annotations for independent signals, where there may be occasional
-simultaneous input annotations.  By remapping only the `chan' fields from one
-input file, it is possible in two or more passes to merge three or more
-annotation files in this way.
+Optionally, mrgann can remap the `chan' field in each annotation from any of
+the input files to a value that can be specified separately (using -c, -C, or
+-cK) for each input annotation file.  This feature may be useful, for example,
+to merge annotations for independent signals, where there may be occasional
+simultaneous input annotations.
 
-When in `-m3' mode, if simultaneous annotations with the same `chan' field
-(after any remapping has been done) are present, only the annotation from the
-first annotator is copied, and a warning message is written to the standard
-output.  */
+All of the input files are read in a single pass using the WFDB library's
+annmerge and getmergedann functions, which return the next annotation from
+any of the inputs in O(log N) time when merging N inputs.
+
+If simultaneous annotations with the same `chan' field (after any remapping
+has been done) are present in two or more of the selected inputs, only the
+annotation from the first of these annotators is copied, and (in verbose mode)
+a warning message is written to the standard error output if the annotations
+differ in type.  The remaining simultaneous annotations are written in `chan'
+order.  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <string.h>
 #include <wfdb/wfdb.h>
 
 /* mode definitions */
-#define UNINITIALIZED	(-1)
-#define DISCARD_ALL	0
-#define COPY_0		1
-#define COPY_1		2
-#define MERGE		3
-
-static char *pname, *record = NULL;
-static int ateof[2], map0 = -1, map1 = -1, vflag;
+#define DISCARD_ALL	0L
+#define COPY_0		1L
+#define COPY_1		2L
+#define MERGE_ALL	(-1L)	/* all bits set */
+#define MAXIANN		((int)sizeof(long)*CHAR_BIT - 1)  /* max -i inputs */
+
+static char *pname, *record = NULL, *oaname = NULL, **ianame;
+static int vflag;
+static int niann;		/* number of input annotators */
+static int *map, nmap;		/* map[i]: `chan' for input i, or -1 */
 static WFDB_Frequency sfreq, ffreq, afreq = 0;
-static WFDB_Anninfo ai[3];
-static WFDB_Annotation annot[2];
+
+/* Segments are defined by -m options.  Segment i (i > 0) begins at time
+   tseg[i] (or at the end of the record, if tseg[i] < 0), and annotations from
+   input k are copied within it if bit k of mseg[i] is set.  The `chan'
+   mappings in effect within segment i are those that were specified before
+   the -m option that ends it;  smap[i] and nsmap[i] are copies of map and
+   nmap. */
+static int nseg, maxseg;
+static long *mseg;
+static WFDB_Time *tseg;
+static char **sarg;		/* time arguments for each segment */
+static int **smap, *nsmap;
+
+/* Simultaneous annotations are collected in a group before being written. */
+static struct gann {
+    WFDB_Annotation annot;
+    unsigned an;		/* input annotator number */
+    int seq;			/* order of arrival within the group */
+    int drop;			/* non-zero if matched by an earlier input */
+    int match;			/* last input with an annotation dropped as a
+				   match for this one, or -1 */
+    unsigned char aux[258];	/* copy of annot.aux */
+} *group;
+static int ngroup, maxgroup;
 
 static void help(void);
 static void init(void);
-static void mergeann(int mode, WFDB_Time tf);
+static void flushgroup(void);
+static void savemap(int seg);
+static void *gmalloc(void *p, size_t n);
 
 int main(int argc, char *argv[])
 {
     char *prog_name(char *s);
-    WFDB_Time tf = (WFDB_Time)(-1);
-    int i, mode = UNINITIALIZED, next_mode = MERGE;
+    int i, j, seg;
+    long mode;
+    WFDB_Annotation annot;
+    WFDB_Annotator an;
 
     pname = prog_name(argv[0]);
 
+    /* Segment 0 begins at the beginning of the record, in MERGE_ALL mode. */
+    mseg = gmalloc(NULL, (maxseg = 8) * sizeof(long));
+    tseg = gmalloc(NULL, maxseg * sizeof(WFDB_Time));
+    sarg = gmalloc(NULL, maxseg * sizeof(char *));
+    smap = gmalloc(NULL, maxseg * sizeof(int *));
+    nsmap = gmalloc(NULL, maxseg * sizeof(int));
+    mseg[0] = MERGE_ALL; tseg[0] = 0L; sarg[0] = NULL;
+    nseg = 1;
+
     /* Interpret command-line options. */
     for (i = 1; i < argc; i++) {
 	if (*argv[i] == '-') switch (*(argv[i]+1)) {
-	  case 'c':	/* map0 follows */
-	    if (++i >= argc) {
+	  case 'c':	/* -c: map for input 1; -cK: map for input K */
+	  case 'C':	/* map for input 2 */
+	    j = (*(argv[i]+1) == 'C') ? 2 :
+		(*(argv[i]+2) ? atoi(argv[i]+2) : 1);
+	    if (++i >= argc || j < 1) {
 		(void)fprintf(stderr,
-		     "%s: `chan' mapping for first annotator must follow -c\n",
-			      pname);
+		     "%s: `chan' mapping for annotator %d must follow %s\n",
+			      pname, j, argv[i-1]);
 		exit(1);
 	    }
-	    map0 = atoi(argv[i]);
-	    if (map0 < -1 || map0 > 255) map0 = -1;
-	    break;
-	  case 'C':	/* map1 follows */
-	    if (++i >= argc) {
-		(void)fprintf(stderr,
-		    "%s: `chan' mapping for second annotator must follow -C\n",
-			      pname);
-		exit(1);
+	    if (j > nmap) {
+		map = gmalloc(map, j * sizeof(int));
+		while (nmap < j)
+		    map[nmap++] = -1;
 	    }
-	    map1 = atoi(argv[i]);
-	    if (map1 < -1 || map1 > 255) map1 = -1;
+	    map[j-1] = atoi(argv[i]);
+	    if (map[j-1] < -1 || map[j-1] > 255) map[j-1] = -1;
 	    break;
 	  case 'h':	/* print usage summary and quit */
 	    help();
 	    exit(0);
 	    break;
 	  case 'i':	/* input annotators follow */
-	    if (++i >= argc-1) {
-		(void)fprintf(stderr, "%s: input annotators must follow -i\n",
+	    for (j = i+1; j < argc && *argv[j] != '-'; j++)
+		;
+	    if ((niann = j - (i+1)) < 2) {
+		(void)fprintf(stderr,
+			      "%s: two or more input annotators must follow -i\n",
 			      pname);
 		exit(1);
 	    }
-	    ai[0].name = argv[i]; ai[0].stat = WFDB_READ;
-	    ai[1].name = argv[++i]; ai[1].stat = WFDB_READ;
+	    if (niann > MAXIANN) {
+		(void)fprintf(stderr,
+			      "%s: too many input annotators (no more than %d)\n",
+			      pname, MAXIANN);
+		exit(1);
+	    }
+	    ianame = argv + i + 1;
+	    i += niann;
 	    break;
 	  case 'm':	/* time to switch modes follows */
 	    if (++i >= argc) {
@@ -117,26 +170,27 @@ int main(int argc, char *argv[])
 			      pname, argv[i-1]);
 		exit(1);
 	    }
-	    if (mode == UNINITIALIZED) {
-		mode = MERGE;
-	    }
-	    tf = strtim(argv[i]);
-	    if (tf < (WFDB_Time)0) tf = -tf;
-	    if (argv[i][0] == 'e') tf = (WFDB_Time)(-1);
-	    else tf = (tf * afreq / sfreq) + 0.5;
-	    mergeann(mode, tf);
-	    switch (*(argv[i-1]+2)) {
-	      case '0': mode = DISCARD_ALL; break;
-	      case '1': mode = COPY_0; break;
-	      case '2': mode = COPY_1; break;
-	      case '3': mode = MERGE; break;
-	      default:
+	    if (*(argv[i-1]+2) == 'a')
+		mode = MERGE_ALL;
+	    else if ('0' <= *(argv[i-1]+2) && *(argv[i-1]+2) <= '9')
+		mode = atol(argv[i-1]+2);
+	    else {
 		fprintf(stderr,
-			"%s: unrecognized mode `%c' -> 3\n",
-			pname, *(argv[i]+2));
-		mode = MERGE;
-		break;
+			"%s: unrecognized mode `%s' -> a\n",
+			pname, argv[i-1]+2);
+		mode = MERGE_ALL;
+	    }
+	    if (nseg >= maxseg) {
+		maxseg *= 2;
+		mseg = gmalloc(mseg, maxseg * sizeof(long));
+		tseg = gmalloc(tseg, maxseg * sizeof(WFDB_Time));
+		sarg = gmalloc(sarg, maxseg * sizeof(char *));
+		smap = gmalloc(smap, maxseg * sizeof(int *));
+		nsmap = gmalloc(nsmap, maxseg * sizeof(int));
 	    }
+	    savemap(nseg-1);
+	    mseg[nseg] = mode;
+	    sarg[nseg++] = argv[i];
 	    break;
 	  case 'o':	/* output annotator follows */
 	    if (++i >= argc) {
@@ -144,7 +198,7 @@ int main(int argc, char *argv[])
 			      pname);
 		exit(1);
 	    }
-	    ai[2].name = argv[i]; ai[2].stat = WFDB_WRITE;
+	    oaname = argv[i];
 	    break;
 	  case 'r':	/* input record name follows */
 	    if (++i >= argc) {
@@ -168,123 +222,166 @@ int main(int argc, char *argv[])
 			  pname, argv[i]);
     }
 
-    if (mode == UNINITIALIZED) {
-	init();
-	mode = MERGE;
+    savemap(nseg-1);
+    init();
+
+    /* Copy the selected annotations in a single pass. */
+    seg = 0;
+    while (getmergedann(&an, &annot) == 0) {
+	while (seg+1 < nseg && tseg[seg+1] >= 0L && annot.time >= tseg[seg+1])
+	    seg++;
+	if (!(mseg[seg] & (1L << an)))
+	    continue;
+	if (ngroup > 0 && annot.time != group[0].annot.time)
+	    flushgroup();
+	if (ngroup >= maxgroup) {
+	    maxgroup += 16;
+	    group = gmalloc(group, maxgroup * sizeof(struct gann));
+	}
+	group[ngroup].annot = annot;
+	group[ngroup].an = an;
+	group[ngroup].seq = ngroup;
+	if (annot.aux) {
+	    memcpy(group[ngroup].aux, annot.aux, *annot.aux + 2);
+	    group[ngroup].annot.aux = group[ngroup].aux;
+	}
+	if ((int)an < nsmap[seg] && smap[seg][an] >= 0)
+	    group[ngroup].annot.chan = smap[seg][an];
+	ngroup++;
     }
-    mergeann(mode, (WFDB_Time)(-1));
+    flushgroup();
 
     wfdbquit();
     exit(0);
     return 0;
 }
 
+/* Save a copy of the current `chan' mappings for use in segment seg. */
+static void savemap(int seg)
+{
+    smap[seg] = NULL;
+    if ((nsmap[seg] = nmap) > 0) {
+	smap[seg] = gmalloc(NULL, nmap * sizeof(int));
+	memcpy(smap[seg], map, nmap * sizeof(int));
+    }
+}
+
 static void init(void)
 {
-    WFDB_Frequency af1, af2;
-    if (record == NULL || ai[0].name == NULL ||
-	ai[1].name == NULL || ai[2].name == NULL) {
+    WFDB_Anninfo *ai;
+    WFDB_Frequency f;
+    int i;
+
+    if (record == NULL || niann < 2 || oaname == NULL) {
 	help();
 	exit(1);
     }
+    ai = gmalloc(NULL, (niann+1) * sizeof(WFDB_Anninfo));
+    ai[0].name = oaname; ai[0].stat = WFDB_WRITE;
+    for (i = 0; i < niann; i++) {
+	ai[i+1].name = ianame[i]; ai[i+1].stat = WFDB_READ;
+    }
     if ((sfreq = sampfreq(record)) < 0.)
 	(void)setsampfreq(sfreq = WFDB_DEFFREQ);
     ffreq = sfreq / getspf();
 
-    if (annopen(record, ai, 3) < 0)
+    /* ai[0] describes the output annotator, and ai[1] ... ai[niann] describe
+       input annotators 0 ... niann-1. */
+    if (annopen(record, ai, niann+1) < 0)
 	exit(2);
-    af1 = getiaorigfreq(0);
-    af2 = getiaorigfreq(1);
-    if (af1 > 0 && af2 > 0)
-	setafreq(afreq = (af1 > af2 ? af1 : af2));
-    else if (af1 > 0)
-	setafreq(afreq = (af1 > ffreq ? af1 : ffreq));
-    else if (af2 > 0)
-	setafreq(afreq = (af2 > ffreq ? af2 : ffreq));
+    for (i = 0; i < niann; i++)
+	if ((f = getiaorigfreq(i)) > afreq)
+	    afreq = f;
+    if (afreq > 0) {
+	if (afreq < ffreq) afreq = ffreq;
+	setafreq(afreq);
+    }
     else
 	afreq = ffreq;
-    setiafreq(0, afreq);
-    setiafreq(1, afreq);
+    for (i = 0; i < niann; i++)
+	setiafreq(i, afreq);
 
-    ateof[0] = getann(0, &annot[0]);
-    ateof[1] = getann(1, &annot[1]);
+    /* Convert the segment boundaries to annotation time units. */
+    for (i = 1; i < nseg; i++) {
+	if (sarg[i][0] == 'e')
+	    tseg[i] = (WFDB_Time)(-1);
+	else {
+	    tseg[i] = strtim(sarg[i]);
+	    if (tseg[i] < (WFDB_Time)0) tseg[i] = -tseg[i];
+	    tseg[i] = (tseg[i] * afreq / sfreq) + 0.5;
+	}
+    }
+
+    if (annmerge(NULL, 0) < 0) {
+	wfdbquit();
+	exit(2);
+    }
 }
 
-void mergeann(int mode, WFDB_Time tf)
+/* acmp orders the annotations in a group by input annotator, and gcmp orders
+   them for output (by chan, then num, then input annotator).  Annotations
+   that are otherwise equal remain in their order of arrival. */
+static int acmp(const void *p1, const void *p2)
 {
-    switch (mode) {
-      case DISCARD_ALL:
-	while (!ateof[0] && (tf < 0L || annot[0].time < tf))
-	    ateof[0] = getann(0, &annot[0]);
-	while (!ateof[1] && (tf < 0L || annot[1].time < tf))
-	    ateof[1] = getann(1, &annot[1]);
-	break;
-      case COPY_0:
-	while (!ateof[0] && (tf < 0L || annot[0].time < tf)) {
-	    if (map0 >= 0) annot[0].chan = map0;
-	    putann(0, &annot[0]);
-	    ateof[0] = getann(0, &annot[0]);
-	}
-	while (!ateof[1] && (tf < 0L || annot[1].time < tf))
-	    ateof[1] = getann(1, &annot[1]);
-	break;
-      case COPY_1:
-	while (!ateof[0] && (tf < 0L || annot[0].time < tf))
-	    ateof[0] = getann(0, &annot[0]);
-	while (!ateof[1] && (tf < 0L || annot[1].time < tf)) {
-	    if (map1 >= 0) annot[1].chan = map1;
-	    putann(0, &annot[1]);
-	    ateof[1] = getann(1, &annot[1]);
-	}
-	break;
-      case MERGE:
-	while (!ateof[0] && !ateof[1] &&
-	       (tf < 0L || annot[0].time < tf || annot[1].time < tf)) {
-	    if (annot[0].time < annot[1].time) {
-		if (map0 >= 0) annot[0].chan = map0;
-		putann(0, &annot[0]);
-		ateof[0] = getann(0, &annot[0]);
-	    }
-	    else if (annot[0].time > annot[1].time) {
-		if (map1 >= 0) annot[1].chan = map1;
-		putann(0, &annot[1]);
-		ateof[1] = getann(1, &annot[1]);
-	    }
-	    else {
-		if (map0 >= 0) annot[0].chan = map0;
-		if (map1 >= 0) annot[1].chan = map1;
-		if (annot[0].chan < annot[1].chan) {
-		    putann(0, &annot[0]);
-		    putann(0, &annot[1]);
-		}
-		else if (annot[0].chan > annot[1].chan) {
-		    putann(0, &annot[1]);
-		    putann(0, &annot[0]);
-		}
-		else {
-		    putann(0, &annot[0]);
-		    if (vflag && annot[0].anntyp != annot[1].anntyp)
-			fprintf(stderr, "%s: %s written, %s discarded\n",
-				mstimstr(annot[0].time),
-				annstr(annot[0].anntyp),
-				annstr(annot[1].anntyp));
-		}
-		ateof[0] = getann(0, &annot[0]);
-		ateof[1] = getann(1, &annot[1]);
+    const struct gann *a = p1, *b = p2;
+
+    if (a->an != b->an) return (a->an < b->an ? -1 : 1);
+    return (a->seq - b->seq);
+}
+
+static int gcmp(const void *p1, const void *p2)
+{
+    const struct gann *a = p1, *b = p2;
+
+    if (a->annot.chan != b->annot.chan) return (a->annot.chan-b->annot.chan);
+    if (a->annot.num != b->annot.num) return (a->annot.num - b->annot.num);
+    if (a->an != b->an) return (a->an < b->an ? -1 : 1);
+    return (a->seq - b->seq);
+}
+
+/* Write the annotations in the current group (which are simultaneous),
+   discarding any that match the chan of a kept annotation from an earlier
+   input.  Each kept annotation is matched by no more than one annotation from
+   each later input, as when two inputs are merged pairwise. */
+static void flushgroup(void)
+{
+    int i, j;
+
+    if (ngroup > 1)
+	qsort(group, ngroup, sizeof(struct gann), acmp);
+    for (i = 0; i < ngroup; i++) {
+	group[i].drop = 0;
+	group[i].match = -1;
+	for (j = 0; j < i && group[j].an < group[i].an; j++)
+	    if (!group[j].drop && group[j].match != (int)group[i].an &&
+		group[j].annot.chan == group[i].annot.chan) {
+		if (vflag && group[i].annot.anntyp != group[j].annot.anntyp)
+		    fprintf(stderr, "%s: %s written, %s discarded\n",
+			    mstimstr(group[i].annot.time),
+			    annstr(group[j].annot.anntyp),
+			    annstr(group[i].annot.anntyp));
+		group[i].drop = 1;
+		group[j].match = group[i].an;
+		break;
 	    }
-	}
-	while (!ateof[0] && ateof[1] && (tf < 0L || annot[0].time < tf)) {
-	    if (map0 >= 0) annot[0].chan = map0;
-	    putann(0, &annot[0]);
-	    ateof[0] = getann(0, &annot[0]);
-	}
-	while (ateof[0] && !ateof[1] && (tf < 0L || annot[1].time < tf)) {
-	    if (map1 >= 0) annot[1].chan = map1;
-	    putann(0, &annot[1]);
-	    ateof[1] = getann(1, &annot[1]);
-	}
-	break;
     }
+    if (ngroup > 1)
+	qsort(group, ngroup, sizeof(struct gann), gcmp);
+    for (i = 0; i < ngroup; i++) {
+	if (group[i].drop) continue;
+	if (group[i].annot.aux) group[i].annot.aux = group[i].aux;
+	putann(0, &group[i].annot);
+    }
+    ngroup = 0;
+}
+
+static void *gmalloc(void *p, size_t n)
+{
+    if ((p = realloc(p, n)) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    return (p);
 }
 
 char *prog_name(char *s)
@@ -307,19 +404,23 @@ char *prog_name(char *s)
 }
 
 static const char *help_strings[] = {
- "usage: %s -r RECORD -i ANNOTATOR1 ANNOTATOR2 -o ANNOTATOR3 [OPTIONS ...]\n",
- "where RECORD, ANNOTATOR1, and ANNOTATOR2 specify the input, ANNOTATOR3",
+ "usage: %s -r RECORD -i ANNOTATOR1 ANNOTATOR2 ... -o OUTANN [OPTIONS ...]\n",
+ "where RECORD and the two or more input ANNOTATORs specify the input, OUTANN",
  "specifies an output annotation file for RECORD, and OPTIONS may include:",
  " -h       print this usage summary",
  " -mX TIME change mode to X at specified TIME, where X is one of:",
  "   0      discard all annotations beginning at TIME",
- "   1      copy ANNOTATOR1 annotations and discard ANNOTATOR2 annotations",
- "   2      copy ANNOTATOR2 annotations and discard ANNOTATOR1 annotations",
- "   3      merge ANNOTATOR1 and ANNOTATOR2 annotations (default)",
+ "   1      copy ANNOTATOR1 annotations and discard all others",
+ "   2      copy ANNOTATOR2 annotations and discard all others",
+ "   3      merge ANNOTATOR1 and ANNOTATOR2 annotations",
+ "   N      merge annotations from inputs K for which bit K-1 of N is set",
+ "   a      merge annotations from all inputs (default)",
  " -v       verbose mode (warn about simultaneous annotations)",
  " -c N     map `chan' fields of ANNOTATOR1 annotations to N (-1 <= N <= 255)",
  " -C N     map `chan' fields of ANNOTATOR2 annotations to N (-1 <= N <= 255)",
- "Specifying N as -1 disables `chan' mapping (default).",
+ " -cK N    map `chan' fields of input K annotations to N (-1 <= N <= 255)",
+ "Specifying N as -1 disables `chan' mapping (default).  Mappings apply until",
+ "the time given by the next -mX option.",
 NULL
 };
 
@@ -330,4 +431,4 @@ void help(void)
     (void)fprintf(stderr, help_strings[0], pname);
     for (i = 1; help_strings[i] != NULL; i++)
 	(void)fprintf(stderr, "%s\n", help_strings[i]);
-}
\ No newline at end of file
+}
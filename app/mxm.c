@@ -1,5 +1,5 @@
 /* file: mxm.c		G. Moody	20 March 1992
-			Last revised:   24 April 2020
+			Last revised:   18 October 2026
 
 -------------------------------------------------------------------------------
 mxm: ANSI/AAMI-standard measurement-by-measurement annotation file comparator
@@ -68,6 +68,13 @@ static void pair(double ref, double test);
 static void print_results(int fflag);
 static void help(void);
 static char *prog_name(char *s);
+void mxm_headings(FILE *fp, int mtype);
+
+#ifdef ECGEVAL		/* linked into ecgeval, which calls mxm_main() */
+#include "ecgeval.h"
+#define main mxm_main
+#define exit(status) ecgeval_exit(status)
+#endif
 
 int main(int argc, char *argv[])
 {
@@ -129,9 +136,9 @@ int main(int argc, char *argv[])
     return 0;
 }
 
-long nrmeas = 0L;
+static long nrmeas = 0L;
 
-void getref(void)	/* get next reference MEASURE annotation with subtyp = mtype */
+static void getref(void)	/* get next reference MEASURE annotation with subtyp = mtype */
 {
     static WFDB_Annotation annot;
 
@@ -150,9 +157,9 @@ void getref(void)	/* get next reference MEASURE annotation with subtyp = mtype *
     Tnext = huge_time;
 }
 
-long ntmeas = 0L;
+static long ntmeas = 0L;
 
-void gettest(void)	/* get next test MEASURE annotation with subtyp = mtype */
+static void gettest(void)	/* get next test MEASURE annotation with subtyp = mtype */
 {
     static WFDB_Annotation annot;
 
@@ -171,26 +178,36 @@ void gettest(void)	/* get next test MEASURE annotation with subtyp = mtype */
     t = huge_time;
 }
 
-double errsum = 0.0, refsum = 0.0;
+static double errsum = 0.0, refsum = 0.0;
 
-void pair(double ref, double test)	/* count a measurement pair */
+static void pair(double ref, double test)	/* count a measurement pair */
 {
 
     refsum += ref;
     errsum += (ref-test)*(ref-test);
 }
 
-FILE *ofile;			/* output file */
-char *ofname = "-";		/* filename for reports */
-char *record;			/* record name */
-int uflag;			/* if non-zero, don't normalize */
-WFDB_Anninfo an[2];
+static FILE *ofile;		/* output file */
+static char *ofname = "-";	/* filename for reports */
+static char *record;		/* record name */
+static int uflag;		/* if non-zero, don't normalize */
+static WFDB_Anninfo an[2];
 
 /* Read and interpret command-line arguments. */
-void init(int argc, char *argv[])
+static void init(int argc, char *argv[])
 {
     int i;
 
+    /* Reset the comparison state, which is not fresh if this is not the
+       first comparison made by this process (as in ecgeval). */
+    A = Anext = a = errsum = refsum = 0.0;
+    fflag = mtype = uflag = 0;
+    start = end_time = T = t = 0L;
+    Tnext = -1L;
+    nrmeas = ntmeas = 0L;
+    ofname = "-";
+    record = NULL;
+    an[0].name = an[1].name = NULL;
     pname = prog_name(argv[0]);
     for (i = 1; i < argc; i++) {
 	if (*argv[i] == '-') switch (*(argv[i]+1)) {
@@ -319,7 +336,15 @@ void init(int argc, char *argv[])
     if (annopen(record, an, 2) < 0) exit(2);
 }
 
-void print_results(int fflag)
+/* Write the column headings for line-format output to fp.  (This function
+   is also used by ecgeval.) */
+void mxm_headings(FILE *fp, int mtype)
+{
+    (void)fprintf(fp, "(Measurement errors)\nMeasurement %d\n", mtype);
+    (void)fprintf(fp, "Record\tRMS error (%%)\tMean reference measurement\n");
+}
+
+static void print_results(int fflag)
 {
     if (nrmeas == 0L && ntmeas == 0L) {
 	(void)fprintf(stderr,
@@ -356,12 +381,8 @@ void print_results(int fflag)
 		(void)fprintf(stderr, "%s: can't create %s\n", pname, ofname);
 		exit(3);
 	    }
-	    if (fflag == 1) {
-		(void)fprintf(ofile,
-			      "(Measurement errors)\nMeasurement %d\n", mtype);
-		(void)fprintf(ofile,
-		    "Record\tRMS error (%%)\tMean reference measurement\n");
-	    }
+	    if (fflag == 1)
+		mxm_headings(ofile, mtype);
 	}
 	else {
 	    (void)fclose(ofile);
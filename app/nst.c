@@ -1,5 +1,5 @@
 /* file: nst.c		G. Moody	8 December 1983
-			Last revised:    24 April 2020
+			Last revised:  18 October 2026
 -------------------------------------------------------------------------------
 nst: Noise stress test
 Copyright (C) 1983-2009 George B. Moody
@@ -24,14 +24,33 @@ _______________________________________________________________________________
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>	/* declarations of pow(), sqrt() */
 #include <wfdb/wfdb.h>
 #include <wfdb/ecgcodes.h>
+#define isqrs
+#define map2
+#define ammap
+#define mamap
+#define annpos
+#include <wfdb/ecgmap.h>
 
 #ifdef NOMKSTEMP
 #define mkstemp mktemp
 #endif
 
+/* Records are processed in parallel by separate processes, since the WFDB
+   library is not reentrant.  Where fork() is unavailable, they are processed
+   one at a time. */
+#if defined(MSDOS) || defined(_WIN32)
+#define NOFORK
+#else
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
 /* Define the WFDB path component separator (OS-dependent). */
 #ifdef MSDOS		/* for MS-DOS, OS/2, etc. */
 # define PSEP	';'
@@ -43,28 +62,30 @@ _______________________________________________________________________________
 #endif
 #endif
 
+#define NAMP	300	/* maximum number of amplitude measurements per signal */
 
 static char *prog_name(char *s);
 static void help(void);
-static void nst(char *irec, char *nrec, char *protocol,
-		 char *orec, double snr);
-
-static char *pname;
-static double *gn;
-static int format = 16, nisig, nnsig, *nse, *vin, *vout, *z, *zz;
-static WFDB_Siginfo *si;
+static char *noiserec(char *irec, char *nrec);
+static int donst(char *irec, char *nrec, char *nnrec, char *obase);
+static void nst(char *irec, char *nrec, char *protocol, char *tfname,
+		char **orec);
+static double *qrsamp(char *record, char *aname, int nsig);
+static double *noiseamp(char *record, int nsig);
+static double trimmean(double *amp, int n);
+static void *nmalloc(size_t n);
+
+static char *pname, *protocol, refaname[10];
+static double *snr, *scale;
+static int format = 16, nisig, nnsig, nsnr;
 
 int main(int argc, char *argv[])
 {
-    static char answer[20], buf[256], *wfdbp, irec[10], nrec[21], nnrec[20],
-        orec[10], refaname[10], *protocol, tfname[20], *p, *s;
-    double *anoise, *asig, *g, nsf = 0.0, nsr, *r, snr = -999999.0, ssf = 0.0;
-    FILE *ifile;
-    int i;
-    WFDB_Time t, t0, tf, dt;
+    static char irecbuf[10], nrec[21], orec[10], *wfdbp;
+    char **irec = NULL, *irec1[1], **nnrec;
+    int i, j, njobs = 1, nirec = 0, status = 0;
     WFDB_Anninfo ai;
-    static WFDB_Annotation annot;
-    
+
     pname = prog_name(argv[0]);
     for (i = 1; i < argc; i++) {
 	if (*argv[i] == '-') switch (*(argv[i]+1)) {
@@ -75,7 +96,7 @@ int main(int argc, char *argv[])
 			      pname);
 		exit(1);
 	    }
-	    (void)strncpy(refaname, argv[++i], 10);
+	    (void)strncpy(refaname, argv[++i], 9);
 	    break;
 	  case 'F':	/* format follows */
 	    if (i >= argc-1) {
@@ -91,16 +112,28 @@ int main(int argc, char *argv[])
 	    exit(0);
 	    break;
 	  case 'i':	/* input record names follow */
-	    if (i >= argc-2) {
+	    for (j = i+1; j < argc && *argv[j] != '-'; j++)
+		;
+	    if (j - i < 3) {
 		(void)fprintf(stderr,
 		       "%s: input ECG and noise record names must follow -i\n",
 			      pname);
 		exit(1);
 	    }
-	    (void)strncpy(irec, argv[++i], 10);
-	    (void)strncpy(nrec+1, argv[++i], 10);
+	    irec = argv + i + 1;
+	    nirec = j - i - 2;
+	    i = j - 1;
+	    (void)strncpy(nrec+1, argv[i], 10);
 	    nrec[0] = '+';
 	    break;
+	  case 'j':	/* number of records to process in parallel follows */
+	    if (i >= argc-1 || (njobs = atoi(argv[++i])) < 1) {
+		(void)fprintf(stderr,
+			      "%s: number of processes must follow -j\n",
+			      pname);
+		exit(1);
+	    }
+	    break;
 	  case 'o':	/* output record name follows */
 	    if (i >= argc-1) {
 		(void)fprintf(stderr,
@@ -108,7 +141,7 @@ int main(int argc, char *argv[])
 			      pname);
 		exit(1);
 	    }
-	    (void)strncpy(orec, argv[++i], 10);
+	    (void)strncpy(orec, argv[++i], 9);
 	    break;
 	  case 'p':	/* protocol annotator name follows */
 	    if (i >= argc-1) {
@@ -126,7 +159,11 @@ int main(int argc, char *argv[])
 			      pname);
 		exit(1);
 	    }
-	    snr = atof(argv[++i]);
+	    if ((snr = realloc(snr, (nsnr+1) * sizeof(double))) == NULL) {
+		(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+		exit(2);
+	    }
+	    snr[nsnr++] = atof(argv[++i]);
 	    break;
 	  default:
 	    (void)fprintf(stderr, "%s: unrecognized option %s\n", pname,
@@ -156,30 +193,26 @@ int main(int argc, char *argv[])
 	setwfdb(nwfdbp);
     }
 
-    /* Generate a temporary file name for use below. */
-    (void)strcpy(tfname, "nsXXXXXX");
-    (void)mkstemp(tfname);
-
     /* Set the reference annotator name if it was not specified with -a. */
     if (refaname[0] == '\0')
 	(void)strcpy(refaname, "atr");
 
     /* Get input record names if they were not specified with -i. */
-    if (irec[0] == '\0' || nrec[0] == '\0') {
+    if (nirec == 0) {
 	(void)fprintf(stderr,
 	   "Enter the name of the existing ECG record (or `?' for help): ");
-	(void)fgets(irec, 10, stdin);
-	irec[strlen(irec)-1] = '\0';
-	if (strcmp(irec, "?") == 0) {
+	(void)fgets(irecbuf, 10, stdin);
+	irecbuf[strlen(irecbuf)-1] = '\0';
+	if (strcmp(irecbuf, "?") == 0) {
 	    help();
 	    exit(1);
 	}
 	ai.name = refaname; ai.stat = WFDB_READ;
 	wfdbquiet();
-	while (annopen(irec, &ai, 1) < 0) {
+	while (annopen(irecbuf, &ai, 1) < 0) {
 	    (void)fprintf(stderr,
 			  "Can't read annotator `%s' for record `%s'\n",
-			  ai.name, irec);
+			  ai.name, irecbuf);
 	    (void)fprintf(stderr,
 			  "Enter the name of the reference annotator: ");
 	    (void)fgets(refaname, 10, stdin);
@@ -191,65 +224,257 @@ int main(int argc, char *argv[])
 	nrec[0] = '+';
 	(void)fgets(nrec+1, 10, stdin);
 	nrec[strlen(nrec)-1] = '\0';
+	irec1[0] = irecbuf;
+	irec = irec1;
+	nirec = 1;
     }
 
     /* Get the output record name if it was not specified using -o. */
     if (orec[0] == '\0') {
-	(void)fprintf(stderr, "Enter the name of the record to be created: ");
+	if (nirec > 1)
+	    (void)fprintf(stderr,
+	       "Enter the suffix for the names of the records to be created: ");
+	else
+	    (void)fprintf(stderr,
+			  "Enter the name of the record to be created: ");
 	(void)fgets(orec, 10, stdin);
 	orec[strlen(orec)-1] = '\0';
     }
 
+    /* Get the SNR if it was not specified using -s, unless a protocol was
+       specified.  Noise gains for each SNR after the first are obtained by
+       scaling those for the first SNR. */
+    if (nsnr == 0 && protocol == NULL) {
+	char answer[20];
+
+	snr = nmalloc(sizeof(double));
+	(void)fprintf(stderr, "Enter the desired signal-to-noise ratio in dB: ");
+	(void)fgets(answer, 10, stdin);
+	if (sscanf(answer, "%lf", &snr[0]) == 1)
+	    nsnr = 1;
+    }
+    scale = nmalloc((nsnr > 0 ? nsnr : 1) * sizeof(double));
+    scale[0] = 1.0;
+    for (i = 1; i < nsnr; i++)
+	scale[i] = pow(10., (snr[0] - snr[i])/20.);
+
+    /* Find the noise record to be used with each clean record, resampling
+       the noise record if necessary.  This is done before any clean records
+       are processed in parallel, so that each resampled noise record is
+       generated only once. */
+    nnrec = nmalloc(nirec * sizeof(char *));
+    for (i = 0; i < nirec; i++)
+	nnrec[i] = noiserec(irec[i], nrec);
+
+    /* Generate the output records for each clean record.  With -j, up to
+       njobs clean records are processed at once, each in its own process. */
+    for (i = 0; i < nirec; i++) {
+	char *obase = orec;
+
+	if (nirec > 1) {
+	    obase = nmalloc(strlen(irec[i]) + strlen(orec) + 1);
+	    (void)sprintf(obase, "%s%s", irec[i], orec);
+	}
+#ifndef NOFORK
+	if (njobs > 1 && nirec > 1) {
+	    pid_t pid;
+	    int stat;
+
+	    if (i >= njobs) {
+		if (wait(&stat) > 0 && stat != 0) status = 1;
+	    }
+	    if ((pid = fork()) == 0)
+		exit(donst(irec[i], nrec, nnrec[i], obase));
+	    else if (pid < 0) {
+		(void)fprintf(stderr, "%s: can't create process for record %s\n",
+			      pname, irec[i]);
+		status = 1;
+	    }
+	    continue;
+	}
+#endif
+	if (donst(irec[i], nrec, nnrec[i], obase) != 0) status = 1;
+    }
+#ifndef NOFORK
+    if (njobs > 1 && nirec > 1) {
+	int stat;
+
+	while (wait(&stat) > 0)
+	    if (stat != 0) status = 1;
+    }
+#endif
+
+    exit(status);	/*NOTREACHED*/
+}
+
+/* noiserec returns the name (preceded by '+') of the noise record to be
+   used with clean record irec.  This is nrec (also preceded by '+'), unless
+   the sampling frequencies of the two records differ significantly;  in that
+   case, it is the name of a noise record with the sampling frequency of
+   irec, which is generated by resampling nrec unless it exists already.  If
+   a protocol was specified, it is copied to the substituted noise record. */
+static char *noiserec(char *irec, char *nrec)
+{
+    static char **done;
+    static int ndone;
+    char buf[256], *nnrec, *p, *s, tfname[20];
+    double nsf, ssf;
+    int i, n;
+    WFDB_Anninfo ai;
+    WFDB_Annotation annot;
+    WFDB_Siginfo *si;
+
+    wfdbquiet();
+    if ((ssf = sampfreq(irec)) <= 0.) ssf = WFDB_DEFFREQ;
+    (void)setsampfreq(0.);
+    if ((nsf = sampfreq(nrec+1)) <= 0.) nsf = WFDB_DEFFREQ;
+    (void)setsampfreq(0.);
+    wfdbverbose();
+    if (0.9*ssf <= nsf && nsf <= 1.1*ssf)
+	return (nrec);
+
+    nnrec = nmalloc(strlen(nrec) + 24);
+    p = nnrec;
+    *p++ = '+';
+    s = nrec+1;
+    while (*s != '\0' && *s != '_')
+	*p++ = *s++;
+    (void)sprintf(p, "_%d", (int)ssf);
+
+    /* Each substituted noise record is prepared only once. */
+    for (i = 0; i < ndone; i++)
+	if (strcmp(done[i], nnrec) == 0) {
+	    free(nnrec);
+	    return (done[i]);
+	}
+    if ((done = realloc(done, (ndone+1) * sizeof(char *))) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    done[ndone++] = nnrec;
+
+    (void)fprintf(stderr,
+	"Sampling frequencies of records `%s' and `%s' differ significantly\n",
+		  irec, nrec+1);
+    wfdbquiet();
+    nsf = sampfreq(nnrec+1);
+    (void)setsampfreq(0.);
+    if (0.9*ssf <= nsf && nsf <= 1.1*ssf) {
+	(void)fprintf(stderr, " ... substituting record `%s' for `%s'\n",
+		      nnrec+1, nrec+1);
+	if (protocol) {
+	    ai.name = protocol; ai.stat = WFDB_WRITE;
+	    if (annopen(nnrec+1, &ai, 1) < 0) exit(2);
+	    ai.stat = WFDB_READ;
+	    if (annopen(nrec, &ai, 1) < 0) exit(2);
+	    while (getann(0, &annot) == 0)
+		(void)putann(0, &annot);
+	    wfdbquit();
+	}
+    }
+    else {
+	/* Generate a temporary name for the header of the resampled record,
+	   as in donst. */
+	(void)strcpy(tfname, "nsXXXXXX");
+	(void)mkstemp(tfname);
+	(void)unlink(tfname);
+	if ((n = isigopen(nrec+1, NULL, 0)) < 1) exit(2);
+	si = nmalloc(n * sizeof(WFDB_Siginfo));
+	if (isigopen(nrec+1, si, -n) != n) {
+	    (void)fprintf(stderr, "\n%s: can't read record %s\n", pname,
+			  nrec+1);
+	    exit(2);
+	}
+	(void)setsampfreq(ssf);
+	(void)sprintf(buf, "%s.dat", nnrec+1);
+	for (i = 0; i < n; i++)
+	    si[i].fname = buf;
+	(void)setheader(tfname, si, (unsigned)n);
+	wfdbquit();
+	free(si);
+	(void)sprintf(buf, "xform -i %s -o %s -N %s", nrec+1, tfname, nnrec+1);
+	if (protocol)
+	    (void)sprintf(buf+strlen(buf), " -a %s", protocol);
+	(void)fprintf(stderr, " ... resampling record `%s' ...", nrec+1);
+	if (system(buf) != 0) exit(1);
+	(void)unlink(wfdbfile("header", tfname));
+	(void)fprintf(stderr,
+		      "Resampled noise record `%s' has been generated.\n",
+		      nnrec+1);
+    }
+    wfdbverbose();
+    return (nnrec);
+}
+
+/* donst generates the output record(s) for clean record irec using noise
+   record nnrec (preceded by '+'), which is nrec (also preceded by '+'), or a
+   resampled version of it (see noiserec).  The names of the output records
+   are obase, if a single SNR was specified, or obase followed by each SNR
+   otherwise. */
+static int donst(char *irec, char *nrec, char *nnrec, char *obase)
+{
+    static char answer[20], buf[256], tfname[20];
+    char **orec, *p;
+    double *anoise, *asig, *g, nsr, *r;
+    int i, k, nout = nsnr > 1 ? nsnr : 1;
+    WFDB_Time t, t0, tf, dt;
+    WFDB_Anninfo ai;
+    static WFDB_Annotation annot;
+
+    /* Generate a temporary name for use below.  Only the name is needed, so
+       the file created by mkstemp is removed at once. */
+    (void)strcpy(tfname, "nsXXXXXX");
+    (void)mkstemp(tfname);
+    (void)unlink(tfname);
+
+    /* Name the output records.  If there is more than one SNR, each name
+       has a suffix formed from the SNR, as in the names of the nstdb records
+       (e.g., 118e24, 118e00, 118e_6). */
+    orec = nmalloc(nout * sizeof(char *));
+    for (k = 0; k < nout; k++) {
+	orec[k] = nmalloc(strlen(obase) + 24);
+	if (nsnr <= 1)
+	    (void)strcpy(orec[k], obase);
+	else if (snr[k] == (int)snr[k] && snr[k] > -100. && snr[k] < 100.)
+	    (void)sprintf(orec[k], snr[k] < 0 ? "%s_%d" : "%s%02d", obase,
+			  abs((int)snr[k]));
+	else {
+	    (void)sprintf(orec[k], "%s%g", obase, snr[k]);
+	    for (p = orec[k] + strlen(obase); *p; p++)
+		if (*p == '-' || *p == '.') *p = '_';
+	}
+	for (i = 0; i < k; i++)
+	    if (strcmp(orec[i], orec[k]) == 0) {
+		(void)fprintf(stderr, "%s: SNRs %g and %g both yield record %s\n",
+			      pname, snr[i], snr[k], orec[k]);
+		exit(1);
+	    }
+    }
+
     /* Count the input signals. */
     if ((nisig = isigopen(irec, NULL, 0)) < 1) exit(2);
     wfdbquiet();   /* suppress warning if sampling frequencies don't match */
-    if ((nnsig = isigopen(nrec, NULL, 0)) < 1) {
-	(void)fprintf(stderr, "%s: can't read record %s\n", pname, nrec+1);
+    if ((nnsig = isigopen(nnrec, NULL, 0)) < 1) {
+	(void)fprintf(stderr, "%s: can't read record %s\n", pname, nnrec+1);
 	exit(2);
     }
     wfdbverbose();
 
     /* Allocate storage. */
-    if ((si = malloc((nisig+nnsig) * sizeof(WFDB_Siginfo))) == NULL ||
-	(anoise = malloc(nnsig * sizeof(double))) == NULL ||
-	(asig = malloc(nisig * sizeof(double))) == NULL ||
-	(r = malloc(nisig * sizeof(double))) == NULL ||
-	(g = malloc(nisig * sizeof(double))) == NULL ||
-	(gn = malloc(nisig * sizeof(double))) == NULL ||
-	(nse = malloc(nisig * sizeof(int))) == NULL ||
-	(vin = malloc((nisig+nnsig) * sizeof(int))) == NULL ||
-	(vout = calloc(nisig, sizeof(int))) == NULL ||
-	(z = calloc(nisig, sizeof(int))) == NULL ||
-	(zz = calloc(nisig, sizeof(int))) == NULL) {
-	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
-	exit(2);
-    }
+    r = nmalloc(nisig * sizeof(double));
+    g = nmalloc(nisig * sizeof(double));
     for (i = 0; i < nisig; i++)
 	g[i] = 0.;
 
     /* If the protocol was unspecified, generate one. */
     if (protocol == (char*)NULL) {
-	/* Get the SNR if it was not specified using -s. */
-	if (snr == -999999.0) {
-	    (void)fprintf(stderr,
-			  "Enter the desired signal-to-noise ratio in dB: ");
-	    (void)fgets(answer, 10, stdin);
-	    (void)sscanf(answer, "%lf", &snr);
-	}
 	/* Convert SNR in dB to nsr (RMS noise / p-p signal amplitude ratio) */
-	nsr = pow(10., snr/-20.)*sqrt(2.0)/4.0;
-	(void)sprintf(buf, "sigamp -r %s >%s", nrec+1, tfname);
+	nsr = pow(10., snr[0]/-20.)*sqrt(2.0)/4.0;
 	(void)fprintf(stderr,
 		      "Checking RMS amplitude of record `%s' ...", nrec+1);
-	if (system(buf) != 0) exit(1);
+	if ((anoise = noiseamp(nrec+1, nnsig)) == NULL) exit(1);
 	(void)fprintf(stderr, " done\n");
-	if ((ifile = fopen(tfname, "r")) == NULL ||
-	    fscanf(ifile, "%lf", &anoise[0]) < 1 || anoise[0] == 0.0) {
-	    (void)fprintf(stderr,
-			  "%s: can't read temporary file %s\n", pname, tfname);
-	    exit(1);
-	}
-	for (i = 1; fscanf(ifile, "%lf", &anoise[i]) == 1; i++) {
+	for (i = 0; i < nnsig; i++) {
 	    if (anoise[i] == 0.0) {
 		(void)fprintf(stderr,
 		 "%s: noise signal %d amplitude is zero -- can't normalize\n",
@@ -257,20 +482,12 @@ int main(int argc, char *argv[])
 		exit(2);
 	    }
 	}
-	(void)unlink(tfname);
-	(void)sprintf(buf, "sigamp -a %s -r %s >%s", refaname, irec, tfname);
 	(void)fprintf(stderr,
 		      "Checking normal QRS amplitude of record `%s' ...",
 		      irec);
-	if (system(buf) != 0) exit(1);
+	if ((asig = qrsamp(irec, refaname, nisig)) == NULL) exit(1);
 	(void)fprintf(stderr, " done\n");
-	if ((ifile = fopen(tfname, "r")) == NULL ||
-	    fscanf(ifile, "%lf", &asig[0]) < 1 || asig[0] == 0.0) {
-	    (void)fprintf(stderr, "%s: can't read temporary file %s\n", pname,
-			  tfname);
-	    exit(1);
-	}
-	for (i = 1; fscanf(ifile, "%lf", &asig[i]) == 1; i++) {
+	for (i = 0; i < nisig; i++) {
 	    if (asig[i] == 0.0) {
 		(void)fprintf(stderr,
 		    "%s: ECG signal %d amplitude is zero -- can't normalize\n",
@@ -278,16 +495,18 @@ int main(int argc, char *argv[])
 		exit(2);
 	    }
 	}
-	(void)fclose(ifile);
-	(void)unlink(tfname);
 
 	/* Determine gains for noisy segments. */
 	for (i = 0; i < nisig; i++) {
 	    r[i] = nsr*asig[i]/anoise[i % nnsig];
-	    (void)fprintf(stderr,
+	    for (k = 0; k < nout; k++)
+		(void)fprintf(stderr,
 	       "[rec %s, sig %d] = [rec %s, sig %d] + %g * [rec %s, sig %d]\n",
-			  orec, i, irec, i, r[i], nrec+1, i % nnsig);
+			      orec[k], i, irec, i, r[i]*scale[k], nrec+1,
+			      i % nnsig);
 	}
+	free(anoise);
+	free(asig);
 
 	/* Determine the length of the test. */
 	if (sampfreq(irec) <= 0.) {
@@ -313,9 +532,9 @@ int main(int argc, char *argv[])
 		break;
 	    }
 #endif
-	ai.name = protocol = tfname;
+	ai.name = tfname;
 	ai.stat = WFDB_WRITE;
-	if (annopen(nrec+1, &ai, 1) < 0)
+	if (annopen(nnrec+1, &ai, 1) < 0)
 	    exit(3);
 	annot.anntyp = NOTE;
 	annot.aux = buf;
@@ -340,92 +559,73 @@ int main(int argc, char *argv[])
 	wfdbquit();
 	(void)fprintf(stderr, " done\n");
 	(void)fprintf(stderr, "The protocol annotation file is `%s'.\n",
-		      wfdbfile(tfname, nrec+1));
+		      wfdbfile(tfname, nnrec+1));
     }
+    free(r);
+    free(g);
 
-    /* Check sampling frequencies of input records. */
-    wfdbquiet();
-    if ((ssf = sampfreq(irec)) <= 0.) ssf = WFDB_DEFFREQ;
-    (void)setsampfreq(0.);
-    if ((nsf = sampfreq(nrec+1)) <= 0.) nsf = WFDB_DEFFREQ;
-    (void)setsampfreq(0.);
-    if (0.9*ssf > nsf || nsf > 1.1*ssf) {
-	(void)fprintf(stderr,
-	"Sampling frequencies of records `%s' and `%s' differ significantly\n",
-		      irec, nrec+1);
-	p = nnrec;
-	s = nrec+1;
-	while (*s != '\0' && *s != '_')
-	    *p++ = *s++;
-	(void)sprintf(p, "_%d", (int)ssf);
-	nsf = sampfreq(nnrec);
-	(void)setsampfreq(0.);
-	if (0.9*ssf <= nsf && nsf <= 1.1*ssf) {
-	    (void)fprintf(stderr, " ... substituting record `%s' for `%s'\n",
-			  nnrec, nrec+1);
-	    ai.name = protocol; ai.stat = WFDB_WRITE;
-	    if (annopen(nnrec, &ai, 1) < 0) exit(2);
-	    ai.stat = WFDB_READ;
-	    if (annopen(nrec, &ai, 1) < 0) exit(2);
-	    while (getann(0, &annot) == 0)
-		(void)putann(0, &annot);
-	    wfdbquit();
-	    (void)unlink(wfdbfile(protocol, nrec+1));
-	    (void)strcpy(nrec+1, nnrec);
-	}
-	else {
-	    if (isigopen(nrec+1, si, -nnsig) != nnsig) {
-		(void)fprintf(stderr, "\n%s: can't read record %s\n", pname,
-			      nrec+1);
-		exit(2);
-	    }
-	    (void)setsampfreq(ssf);
-	    (void)sprintf(buf, "%s.dat", nnrec);
-	    for (i = 0; i < nnsig; i++)
-		si[i].fname = buf;
-	    (void)setheader(tfname, si, (unsigned)nnsig);
-	    wfdbquit();
-	    (void)sprintf(buf, "xform -i %s -o %s -N %s -a %s",
-			  nrec+1, tfname, nnrec, protocol);
-	    (void)fprintf(stderr, " ... resampling record `%s' ...", nrec+1);
-	    if (system(buf) != 0) exit(1);
-	    (void)unlink(wfdbfile(protocol, nrec+1));
-	    (void)unlink(wfdbfile("header", tfname));
-	    (void)fprintf(stderr,
-			  "Resampled noise record `%s' has been generated.\n",
-			  nnrec);
-	    (void)strcpy(nrec+1, nnrec);
-	}
-    }
-    wfdbverbose();
-
-    (void)fprintf(stderr, "Generating record `%s' ...", orec);
-    nst(irec, nrec, protocol, orec, snr);
+    if (nout > 1)
+	(void)fprintf(stderr, "Generating records `%s' to `%s' ...", orec[0],
+		      orec[nout-1]);
+    else
+	(void)fprintf(stderr, "Generating record `%s' ...", orec[0]);
+    nst(irec, nnrec, protocol ? protocol : tfname, tfname, orec);
     (void)fprintf(stderr, " done\n");
 
     ai.name = refaname; ai.stat = WFDB_READ;
     if (annopen(irec, &ai, 1) < 0) exit(2);
     ai.stat = WFDB_WRITE;
-    (void)sprintf(buf, "+%s", orec);
-    if (annopen(buf, &ai, 1) < 0) exit(2);
+    for (k = 0; k < nout; k++) {
+	(void)sprintf(buf, "+%s", orec[k]);
+	if (annopen(buf, &ai, 1) < 0) exit(2);
+    }
     (void)fprintf(stderr,
 		  "Copying reference annotations for record `%s' to `%s' ...",
-		  irec, orec);
+		  irec, nout > 1 ? obase : orec[0]);
     while (getann(0, &annot) == 0)
-	(void)putann(0, &annot);
+	for (k = 0; k < nout; k++)
+	    (void)putann(k, &annot);
     wfdbquit();
     (void)fprintf(stderr, " done\n");
 
-    exit(0);	/*NOTREACHED*/
+    for (k = 0; k < nout; k++)
+	free(orec[k]);
+    free(orec);
+    return (0);
 }
 
-static void nst(char *irec, char *nrec, char *protocol, char *orec, double snr)
+/* nst generates the output records named in orec[], one for each SNR (or
+   a single record, if no more than one SNR was specified), in a single pass
+   through the input records.  Signal i of output record k is written to
+   signal group k;  its noise gains are those from the protocol, multiplied
+   by scale[k]. */
+static void nst(char *irec, char *nrec, char *protocol, char *tfname,
+		char **orec)
 {
-    char buf[80], ofname[20], *p;
-    int errct = 0, i;
+    char buf[256], **ofname, *p;
+    double *gn, gp;
+    int errct = 0, i, j, k, nout = nsnr > 1 ? nsnr : 1, nosig, *nse,
+	*vin, *vout, *vx, *z, *zz;
     WFDB_Time nlen, nend, t = 0L, dt, next_tick;
     WFDB_Annotation annot;
     WFDB_Anninfo ai;
+    WFDB_Siginfo *si, *so;
+
+    nosig = nout * nisig;
+    si = nmalloc((nisig+nnsig) * sizeof(WFDB_Siginfo));
+    so = nmalloc(nosig * sizeof(WFDB_Siginfo));
+    ofname = nmalloc(nout * sizeof(char *));
+    gn = nmalloc(nosig * sizeof(double));
+    nse = nmalloc(nisig * sizeof(int));
+    vout = nmalloc(nosig * sizeof(int));
+    vx = nmalloc(nosig * sizeof(int));
+    z = nmalloc(nosig * sizeof(int));
+    vin = nmalloc((nisig+nnsig) * sizeof(int));
+    zz = nmalloc(nisig * sizeof(int));
+    for (j = 0; j < nosig; j++)
+	vout[j] = vx[j] = z[j] = 0;
+    for (i = 0; i < nisig+nnsig; i++)
+	vin[i] = 0;
 
     /* Open ECG signals. */
     if (isigopen(irec, si, nisig) != nisig) exit(2);
@@ -442,20 +642,27 @@ static void nst(char *irec, char *nrec, char *protocol, char *orec, double snr)
     ai.name = protocol;  ai.stat = WFDB_READ;
     if (annopen(nrec, &ai, 1) < 0) exit(2);
 
-    /* Open the output signal file. */
-    (void)sprintf(ofname, "%s.dat", orec);  /* name for output signal file */
+    /* Open the output signal files. */
     for (i = 0; i < nisig; i++) {
-	si[i].fname = ofname;
-	si[i].group = 0;
 	zz[i] = si[i].adczero;		/* any offset will be removed */
-	si[i].adczero = 0;
-	si[i].fmt = format;
-	si[i].spf = 1;
-	gn[i] = 0.0;
 	nse[i] = nisig + (i % nnsig);	/* signal number of noise signal to be
 					   added to ECG signal i */
     }
-    if (osigfopen(si, (unsigned)nisig) < nisig) exit(2);
+    for (k = 0; k < nout; k++) {
+	ofname[k] = nmalloc(strlen(orec[k]) + 5);
+	(void)sprintf(ofname[k], "%s.dat", orec[k]); /* output signal file */
+	for (i = 0; i < nisig; i++) {
+	    j = k*nisig + i;
+	    so[j] = si[i];
+	    so[j].fname = ofname[k];
+	    so[j].group = k;
+	    so[j].adczero = 0;
+	    so[j].fmt = format;
+	    so[j].spf = 1;
+	    gn[j] = 0.0;
+	}
+    }
+    if (osigfopen(so, (unsigned)nosig) < nosig) exit(2);
     setsampfreq(sampfreq(NULL));
 
     if ((nend = strtim("e")) <= 0L)
@@ -467,7 +674,8 @@ static void nst(char *irec, char *nrec, char *protocol, char *orec, double snr)
     /* Output section.  On each iteration of the outer loop, an annotation
        from the protocol annotation file is read.  The time of that annotation
        indicates the time at which the program's state variables must be 
-       changed next. */
+       changed next.  For each output signal j, vx[j] is the input sample
+       (less any offset) from which vout[j] was computed. */
     while (errct == 0 & getann(0, &annot) >= 0) {
 	/* Skip any protocol annotations that aren't NOTE annotations, or
 	   that don't have `aux' fields. */
@@ -494,24 +702,29 @@ static void nst(char *irec, char *nrec, char *protocol, char *orec, double snr)
 		if (getvec(vin) < 0)
 		    errct++;
 		/* Adjust offsets to avoid discontinuities. */
-		for (i = 0; i < nisig; i++)
+		for (j = 0; j < nosig; j++) {
+		    i = j % nisig;
 		    if (vin[i] != WFDB_INVALID_SAMPLE &&
 			vin[nse[i]] != WFDB_INVALID_SAMPLE &&
-			vout[i] != WFDB_INVALID_SAMPLE)
-			z[i] = vin[i] + gn[i]*vin[nse[i]] - vout[i];
+			vout[j] != WFDB_INVALID_SAMPLE)
+			z[j] = vin[i] + gn[j]*vin[nse[i]] - vout[j];
+		}
 	    }
 	    else
 		if (getvec(vin) < 0)
 		    errct++;
-	    for (i = 0; i < nisig; i++) {
+	    for (j = 0; j < nosig; j++) {
+		i = j % nisig;
 		if (vin[i] != WFDB_INVALID_SAMPLE &&
 		    vin[nse[i]] != WFDB_INVALID_SAMPLE &&
-		    vout[i] != WFDB_INVALID_SAMPLE) {
-		    vin[i] -= zz[i];	/* remove any offset first */
-		    vout[i] = vin[i] + gn[i]*vin[nse[i]] - z[i];
+		    vout[j] != WFDB_INVALID_SAMPLE) {
+		    vx[j] = vin[i] - zz[i];	/* remove any offset first */
+		    vout[j] = vx[j] + gn[j]*vin[nse[i]] - z[j];
+		}
+		else {
+		    vx[j] = vin[i];
+		    vout[j] = WFDB_INVALID_SAMPLE;
 		}
-		else
-		    vout[i] = WFDB_INVALID_SAMPLE;
 	    }
 	    if (putvec(vout) < 0)
 		errct++;
@@ -521,26 +734,208 @@ static void nst(char *irec, char *nrec, char *protocol, char *orec, double snr)
 	   reached, reset the state variables.  The `aux' string contains
 	   noise gains. */
 	for (i = 0, p = annot.aux+1; i < nisig && *p; i++) {
-	    (void)sscanf(p, "%lf", &gn[i]);
-	    z[i] = vin[i] + gn[i]*vin[nse[i]] - vout[i];
+	    (void)sscanf(p, "%lf", &gp);
+	    for (k = 0; k < nout; k++) {
+		j = k*nisig + i;
+		gn[j] = gp*scale[k];
+		z[j] = vx[j] + gn[j]*vin[nse[i]] - vout[j];
+	    }
 	    while (*p && *(p++) != ' ')
 		;
 	}
     }
 
-    /* Cleanup section. */
+    /* Cleanup section.  A single header is written for all of the output
+       signals, and then split into one header per output record. */
   cleanup:
-    (void)newheader(orec);
-    if (snr == -999999.0)
-	(void)sprintf(buf,
+    if (nout > 1) {
+	(void)newheader(tfname);
+	wfdbquit();
+	if (isigopen(tfname, so, -nosig) != nosig) exit(2);
+	(void)unlink(wfdbfile("header", tfname));
+    }
+    for (k = 0; k < nout; k++) {
+	if (nout > 1)
+	    (void)setheader(orec[k], so + k*nisig, (unsigned)nisig);
+	else
+	    (void)newheader(orec[k]);
+	if (nsnr == 0)
+	    (void)sprintf(buf,
 	       " Created by `%s' from records %s and %s, using protocol %s",
-		pname, irec, nrec+1, protocol);
-    else
-	(void)sprintf(buf,
-		" Created by `%s' from records %s and %s (SNR = %g dB)",
-		pname, irec, nrec+1, snr);
-    (void)putinfo(buf);
+			  pname, irec, nrec+1, protocol);
+	else
+	    (void)sprintf(buf,
+			" Created by `%s' from records %s and %s (SNR = %g dB)",
+			  pname, irec, nrec+1, snr[k]);
+	(void)putinfo(buf);
+    }
     wfdbquit();
+    for (k = 0; k < nout; k++)
+	free(ofname[k]);
+    free(ofname); free(si); free(so); free(gn); free(nse);
+    free(vout); free(vx); free(z); free(vin); free(zz);
+}
+
+/* qrsamp returns the estimated peak-to-peak amplitudes of normal QRS
+   complexes in each signal of record, measured as by `sigamp -a aname'
+   (in windows from 50 ms before to 50 ms after each of the first NAMP normal
+   QRS annotations). */
+static double *qrsamp(char *record, char *aname, int nsig)
+{
+    double **amp, *a;
+    int gvmode = getgvmode(), i, namp = 0, *v, *vmax, *vmin;
+    WFDB_Anninfo ai;
+    WFDB_Annotation annot;
+    WFDB_Siginfo *si = nmalloc(nsig * sizeof(WFDB_Siginfo));
+    WFDB_Time dt1, dt2, tt;
+
+    amp = nmalloc(nsig * sizeof(double *));
+    for (i = 0; i < nsig; i++)
+	amp[i] = nmalloc(NAMP * sizeof(double));
+    v = nmalloc(nsig * sizeof(int));
+    vmax = nmalloc(nsig * sizeof(int));
+    vmin = nmalloc(nsig * sizeof(int));
+    setgvmode(gvmode|WFDB_GVPAD);
+    ai.name = aname; ai.stat = WFDB_READ;
+    if (isigopen(record, si, nsig) != nsig || annopen(record, &ai, 1) < 0)
+	namp = -1;
+    else {
+	dt1 = -(dt2 = strtim("0.05"));
+	if (dt1 == dt2) dt2++;
+	while (namp < NAMP && getann(0, &annot) == 0) {
+	    if (map1(annot.anntyp) != NORMAL) continue;
+	    if (isigsettime(annot.time + dt1) < 0 || getvec(vmin) < nsig)
+		break;
+	    for (i = 0; i < nsig; i++)
+		vmax[i] = vmin[i];
+	    for (tt = dt1; tt < dt2; tt++) {
+		if (getvec(v) < nsig) break;
+		for (i = 0; i < nsig; i++) {
+		    if (v[i] < vmin[i]) vmin[i] = v[i];
+		    else if (v[i] > vmax[i]) vmax[i] = v[i];
+		}
+	    }
+	    if (tt < dt2) break;
+	    for (i = 0; i < nsig; i++)
+		amp[i][namp] = vmax[i] - vmin[i];
+	    namp++;
+	}
+    }
+    wfdbquit();
+    setgvmode(gvmode);
+    if (namp > 0) {
+	a = nmalloc(nsig * sizeof(double));
+	for (i = 0; i < nsig; i++)
+	    a[i] = trimmean(amp[i], namp);
+    }
+    else {
+	if (namp == 0)
+	    (void)fprintf(stderr,
+			  "\n%s: no normal QRS annotations in record %s\n",
+			  pname, record);
+	a = NULL;
+    }
+    for (i = 0; i < nsig; i++)
+	free(amp[i]);
+    free(amp); free(v); free(vmax); free(vmin); free(si);
+    return (a);
+}
+
+/* noiseamp returns the estimated RMS amplitudes of the signals of record,
+   measured as by `sigamp' (in each of the first NAMP one-second windows, the
+   RMS difference between the signal and its mean within the window).  Each
+   window is buffered so that the record is read only once. */
+static double *noiseamp(char *record, int nsig)
+{
+    double **amp, *a, *vmean, *vsum;
+    int gvmode = getgvmode(), i, namp = 0, v, *vbuf;
+    WFDB_Siginfo *si = nmalloc(nsig * sizeof(WFDB_Siginfo));
+    WFDB_Time dtw, tt;
+
+    amp = nmalloc(nsig * sizeof(double *));
+    for (i = 0; i < nsig; i++)
+	amp[i] = nmalloc(NAMP * sizeof(double));
+    vmean = nmalloc(nsig * sizeof(double));
+    vsum = nmalloc(nsig * sizeof(double));
+    setgvmode(gvmode|WFDB_GVPAD);
+    if (isigopen(record, si, nsig) != nsig)
+	namp = -1;
+    else {
+	if ((dtw = strtim("1")) <= 0L) dtw = 1;
+	vbuf = nmalloc(dtw * nsig * sizeof(int));
+	for ( ; namp < NAMP; namp++) {
+	    for (tt = 0; tt < dtw; tt++)
+		if (getvec(vbuf + tt*nsig) < nsig) break;
+	    if (tt < dtw) break;
+	    for (i = 0; i < nsig; i++) {
+		vmean[i] = vsum[i] = 0.0;
+		for (tt = 0; tt < dtw; tt++)
+		    vmean[i] += vbuf[tt*nsig + i];
+		vmean[i] /= dtw;
+		for (tt = 0; tt < dtw; tt++) {
+		    v = vbuf[tt*nsig + i] - vmean[i];
+		    vsum[i] += (double)v*v;
+		}
+		amp[i][namp] = sqrt(vsum[i]/dtw);
+	    }
+	}
+	free(vbuf);
+    }
+    wfdbquit();
+    setgvmode(gvmode);
+    if (namp > 0) {
+	a = nmalloc(nsig * sizeof(double));
+	for (i = 0; i < nsig; i++)
+	    a[i] = trimmean(amp[i], namp);
+    }
+    else {
+	if (namp == 0)
+	    (void)fprintf(stderr, "\n%s: record %s is too short\n",
+			  pname, record);
+	a = NULL;
+    }
+    for (i = 0; i < nsig; i++)
+	free(amp[i]);
+    free(amp); free(vmean); free(vsum); free(si);
+    return (a);
+}
+
+static int dcmp(const void *p1, const void *p2)
+{
+    double d1 = *(const double *)p1, d2 = *(const double *)p2;
+
+    if (d1 > d2) return (1);
+    else if (d1 == d2) return (0);
+    else return (-1);
+}
+
+/* trimmean returns the mean of the n values in amp, excluding the largest 5%
+   and the smallest 5%.  The result is rounded to the precision used by
+   sigamp, so that gains are identical to those obtained by earlier versions
+   of nst (which read them from the output of sigamp). */
+static double trimmean(double *amp, int n)
+{
+    char buf[32];
+    double a;
+    int j, jlow = n/20, jhigh = n - jlow;
+
+    qsort(amp, n, sizeof(double), dcmp);
+    for (a = 0.0, j = jlow; j < jhigh; j++)
+	a += amp[j];
+    a /= jhigh - jlow;
+    (void)sprintf(buf, "%g", a);
+    return (atof(buf));
+}
+
+static void *nmalloc(size_t n)
+{
+    void *p;
+
+    if ((p = malloc(n ? n : 1)) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    return (p);
 }
 
 static char *prog_name(char *s)
@@ -572,6 +967,9 @@ static char *help_strings[] = {
  " -F N          write output signals in format N (default: 16)",
  " -h            print this usage summary",
  " -i SREC NREC  read signals from record SREC, and noise from record NREC",
+ "                (if several clean records SREC ... are given, OREC is a",
+ "                suffix appended to each of their names)",
+ " -j N          generate output records for up to N clean records at once",
  " -o OREC       generate output record OREC",
  " -p PROTOCOL   use the specified PROTOCOL (in an annotation file with",
  "                annotator name PROTOCOL and record name NREC);  if this",
@@ -579,7 +977,10 @@ static char *help_strings[] = {
  "                using scale factors that may be set using -s",
  " -s SNR        set scale factors for noise such that the signal-to-noise",
  "                ratio during noisy segments is SNR (in dB);  this option",
- "                is ignored if a protocol is specified using -p",
+ "                may be repeated to generate one output record for each SNR",
+ "                in a single pass (the name of each is OREC followed by the",
+ "                SNR, as in 118e24 or 118e_6);  if a protocol is specified",
+ "                using -p, its gains are taken to be those for the first SNR",
 NULL
 };
 
@@ -1,5 +1,5 @@
 /* file: pschart.c	G. Moody       15 March 1988
-			Last revised: 4 November 2020
+			Last revised: 18 October 2026
 
 -------------------------------------------------------------------------------
 pschart: Produce annotated `chart recordings' on a PostScript device
@@ -41,6 +41,16 @@ will be correct even if `dpi' is incorrect, however.
 #include <wfdb/wfdb.h>
 #include <wfdb/ecgcodes.h>
 
+/* With -j, pages are rendered by several processes (see startjobs, below),
+   since the WFDB library is not reentrant. */
+#if defined(MSDOS) || defined(_WIN32)
+#define NOFORK
+#else
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
 /* PROLOG is the pathname of the accompanying prolog file, `pschart.pro', which
    should normally be accessible to this program at run-time.  In most cases,
    PROLOG should be an absolute pathname (beginning from the root directory),
@@ -91,6 +101,7 @@ static double footer_y;		/* distance from page bottom to footer (mm) */
 static double imargin;			/* inside margin (mm) */
 static double omargin;			/* outside margin (mm) */
 static FILE *infofile;			/* file to print instead of title */
+static char *infoname;			/* name of infofile */
 /* User-settable parameters */
 static char aname[41] = "atr";		/* annotator name */
 static char aname2[41] = "";		/* second annotator name */
@@ -110,6 +121,7 @@ static int lflag = 0;			/* if non-zero, label signals */
 static int Lflag = 0;			/* if non-zero, use landscape orientation */
 static double lwmm = LWMM;		/* line width (mm); 0 is narrowest possible */
 static int mflag = 0;			/* if non-zero, margins specified using -m */
+static int njobs = 1;			/* number of processes rendering pages */
 static int Mflag = 0;			/* annotation/marker bar mode (0: do not print
 				   bars, print mnemonics at center; 1: print
 				   bars across all signals, mnemonics at
@@ -129,6 +141,8 @@ static int pflag = 0;			/* if non-zero, pack strips side-by-side */
 static int rflag = 0;			/* if non-zero, print record names */
 static int Rflag = 0;			/* if non-zero, print record name in header */
 static int sflag = 0;			/* if non-zero, a signal list was specified */
+static int skip = 0;			/* if non-zero, the current page is rendered
+				   by another process (see startjobs) */
 static int *siglist;			/* list of signals to be printed */
 static int smode = 1;			/* scale mode (0: no scales; 1: mm/unit in
 				   footers; 2: units/tick in footers; 3:
@@ -197,8 +211,20 @@ static void setitalic(double size);
 static void setmargins(void);
 static void setrgbcolor(struct pscolor *color);
 static void setroman(double size);
+static void setskip(int p);
 static void smaller(void);
 static void tlabel(const char *s);
+#ifndef NOFORK
+static int job = -1;		/* worker number (-1 if -j was not used) */
+static FILE **jobout;		/* pages rendered by each worker */
+static FILE **jobidx;		/* offsets of the ends of those pages */
+static FILE *nullout;		/* output of pages rendered by other workers */
+static void setjobpage(int p);
+static void startjobs(int argc, char *argv[]);
+#define ownpage(P)	(job < 0 || ((P)-1) % njobs == job)
+#else
+#define ownpage(P)	1
+#endif
 
 int main(int argc, char *argv[])
 {
@@ -227,7 +253,7 @@ int main(int argc, char *argv[])
     (void)sprintf(copyright, COPYR, now->tm_year + 1900);
 
     /* Set the default page dimensions and margins. */
-    (void)setpagedim(NULL);
+    (void)setpagedim(ptype);
     setmargins();
     
     /* Set other defaults (see descriptions above). */
@@ -251,6 +277,11 @@ int main(int argc, char *argv[])
     if (getenv("TRANSCRIPTBUG")) uflag = 1;
 
     for (i = 1; i < argc; i++) {
+#ifndef NOFORK
+	/* With -j, start the workers before reading the first script. */
+	if (njobs > 1 && job < 0 && (*argv[i] != '-' || *(argv[i]+1) == '\0'))
+	    startjobs(argc - i, argv + i);
+#endif
 	if (*argv[i] == '-') switch (*(argv[i]+1)) {
 	  case 'a':	/* specify annotator */
 	    if (++i >= argc) {
@@ -362,6 +393,14 @@ int main(int argc, char *argv[])
 			      pname);
 		exit(1);
 	    }
+	    infoname = argv[i];
+	    break;
+	  case 'j':	/* specify number of processes rendering pages */
+	    if (++i >= argc || (njobs = atoi(argv[i])) < 1) {
+		(void)fprintf(stderr,
+			      "%s: number of jobs must follow -j\n", pname);
+		exit(1);
+	    }
 	    break;
 	  case 'l':	/* enable signal labelling */
 	    lflag = 1;
@@ -531,7 +570,8 @@ int main(int argc, char *argv[])
 	    break;
 	}
 	else if ((cfile = fopen(argv[i], "r")) == NULL) {
-	    (void)fprintf(stderr, "%s: can't read %s\n", pname, argv[i]);
+	    if (!skip)
+		(void)fprintf(stderr, "%s: can't read %s\n", pname, argv[i]);
 	    exit(1);
 	}
 	else {
@@ -544,6 +584,9 @@ int main(int argc, char *argv[])
 	exit(1);
     }
     ejectpage();
+#ifndef NOFORK
+    setjobpage(pages_written + 1);	/* the trailer follows the last page */
+#endif
     if (!uflag) {
 	(void)printf("%%%%Trailer\n");
 	(void)printf("%%%%Pages: %d\n", pages_written);
@@ -562,6 +605,13 @@ int *uncal;		/* if non-zero, signal is uncalibrated */
 int *accept, *buflen, *v, *vbase, **vbuf, *vmax, *vmin;
 double *vsum;
 
+/* If there are at least ENVMIN samples per pixel, printstrip plots the
+   envelope of each signal (the range of its samples in each pixel column),
+   obtained from getenvelope, rather than the samples themselves. */
+#define ENVMIN	16
+WFDB_Envelope *env;	/* envelopes (allocated by printstrip()) */
+int envlen;		/* number of WFDB_Envelope structures in env */
+
 /* Derived parameters */
 double dpmm;		/* pixels per millimeter */
 double dppt;		/* pixels per PostScript "printer's point" (PostScript
@@ -602,13 +652,16 @@ static void process(FILE *cfile)
 	    static int warned;
 
 	    if (!warned) {
-		(void)fprintf(stderr,
-		    "Warning: printed scales will not be correct if\n");
-		(void)fprintf(stderr,
-		    "%s output is resized by an embedding document!\n", pname);
-		(void)fprintf(stderr,
-		    "You may wish to rerun %s with option `-S %d %d'\n",
+		if (!skip) {	/* with -j, only one worker warns */
+		    (void)fprintf(stderr,
+			"Warning: printed scales will not be correct if\n");
+		    (void)fprintf(stderr,
+			"%s output is resized by an embedding document!\n",
+			pname);
+		    (void)fprintf(stderr,
+			"You may wish to rerun %s with option `-S %d %d'\n",
 			pname, smode+1, tsmode);
+		}
 		warned = 1;
 	    }
 	}
@@ -652,9 +705,10 @@ static void process(FILE *cfile)
 	    else {
 		for (i = 0; i < nosig; i++) {
 		    if ((siglist[i] = findsig(snstr[i])) < 0) {
-			(void)fprintf(stderr,
+			if (!skip)
+			    (void)fprintf(stderr,
 				      "record %s doesn't have a signal '%s'\n",
-				      record, snstr[i]);
+					  record, snstr[i]);
 			wfdbquit();
 			return;
 		    }
@@ -736,6 +790,13 @@ double dpadu;	/* pixels per adu.  This quantity must be recalculated for each
 double s_top = -9999., s_bot, s_left = -9999., s_right, s_height, s_width;
 double t_height;	/* height (mm) of space alloted per trace */
 
+/* Return non-zero if all n samples of a strip beginning at sample t can be
+   read, by reading only the last of them. */
+static int fullstrip(WFDB_Time t, WFDB_Time n)
+{
+    return (isigsettime(t + n - 1) >= 0 && getvec(v) >= 0);
+}
+
 /* Print a strip beginning at sample t0, ending at sample t1-1.  This function
    returns 2 if completely successful, 1 if the signals were plotted but not
    the annotations, or 0 if nothing was printed. */
@@ -745,7 +806,8 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1, char *record, char *title)
     char *ts;
     double curr_s_top;
     int i, j;
-    int jmax, tm_y, *vp, x0, y0, ya[2];
+    int jmax, npts = 0, tm_y, *vp, x0, y0, ya[2];
+    WFDB_Time tend;
 
     /* Allocate buffers for the samples to be plotted, and initialize the
        range variables. */
@@ -762,9 +824,70 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1, char *record, char *title)
 	}
     }
 
-    if ((jmax = (int)(t1 - t0)) > nsamp) jmax = nsamp;
     if (nosig > 0) {
-	/* Fill the buffers. */
+	/* Determine the height of the strip.  Allow the greater of 4 mV or 20
+	   mm per trace if possible.  If n strips won't fit on the page (even
+	   if the allowance per trace is decreased moderately), the allowance
+	   is adjusted so that n-1 strips fill the page (for n = 2, 3, and
+	   4). */
+	if (vscale >= 5.) s_height = 4. * vscale * nosig;
+	else s_height = 20. * nosig;
+	if (1.5 * (s_height+v_sep) > p_height - (tmargin+bmargin))
+	    s_height = p_height - (tmargin+bmargin+v_sep);
+	else if (2.5 * (s_height+v_sep) > p_height - (tmargin+bmargin))
+	    s_height = (p_height - (tmargin+bmargin+2*v_sep))/2; 
+	else if (3.5 * (s_height+v_sep) > p_height - (tmargin+bmargin))
+	    s_height = (p_height - (tmargin+bmargin+3*v_sep))/3;
+	t_height = s_height / nosig;
+
+	/* The height does not depend on the samples, so it is known here
+	   whether the strip will begin a new page (see below), and therefore
+	   whether it will be rendered by this process.  If not (see
+	   startjobs), its samples and annotations are not read. */
+	if (s_top != -9999. && s_top - s_height < bmargin)
+	    setskip(pages_written + 2);
+	else
+	    setskip(pages_written + 1);
+    }
+
+    if ((jmax = (int)(t1 - t0)) > nsamp) jmax = nsamp;
+    if (nosig > 0 && !xflag && dpsi * ENVMIN <= 1.0 &&
+	(tend = strtim("e")) > 0L) {
+	/* Get the envelopes, one per pixel column. */
+	if (t0 >= tend) return (0);
+	if (t0 + jmax > tend) jmax = (int)(tend - t0);
+	if ((npts = si(jmax)) < 1) npts = 1;
+	if (!skip && npts * nisig > envlen) {
+	    if ((env = realloc(env, npts * nisig * sizeof(WFDB_Envelope))) ==
+		NULL) {
+		envlen = 0;
+		(void)fprintf(stderr, "insufficient memory\n");
+		return (0);
+	    }
+	    envlen = npts * nisig;
+	}
+	if (skip) npts = 0;
+	else if ((npts = getenvelope(t0, t0 + jmax, npts, env)) <= 0)
+	    return (0);
+	for (j = 0; j < npts; j++) {
+	    for (i = 0; i < nosig; i++) {
+		WFDB_Envelope *e = &env[j*nisig + siglist[i]];
+
+		if (e->nvalid > 0) {
+		    if (e->max > vmax[i] || vmax[i] == WFDB_INVALID_SAMPLE)
+			vmax[i] = e->max;
+		    if (e->min < vmin[i] || vmin[i] == WFDB_INVALID_SAMPLE)
+			vmin[i] = e->min;
+		    vsum[i] += e->mean * e->nvalid;
+		    accept[i] += e->nvalid;
+		}
+	    }
+	}
+    }
+    else if (nosig > 0 && (!skip || !fullstrip(t0, jmax))) {
+	/* Fill the buffers.  (If the strip is rendered by another process,
+	   this is needed only if the strip is at the end of the record, to
+	   find its length.) */
 	if (isigsettime(t0) < 0) return (0);
 	for (j = 0; j < jmax && getvec(v) >= 0; j++) {
 	    for (i = 0; i < nosig; i++) {
@@ -785,7 +908,8 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1, char *record, char *title)
 	}
 	if (j == 0) return (0);
 	jmax = j;
-
+    }
+    if (nosig > 0) {
 	/* Calculate the midranges. */
 	for (i = 0; i < nosig; i++) {
 	    int vb, vm, vs;
@@ -806,22 +930,8 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1, char *record, char *title)
 	}
 	t1 = t0 + jmax;
     
-	/* Determine the width and height of the strip.  Allow the greater of 4
-           mV or 20 mm per trace if possible.  If n strips won't fit on the
-           page (even if the allowance per trace is decreased moderately), the
-           allowance is adjusted so that n-1 strips fill the page (for n = 2,
-           3, and 4). */
+	/* Determine the width of the strip. */
 	s_width = jmax * tscale / sps;
-	if (vscale >= 5.) s_height = 4. * vscale * nosig;
-	else s_height = 20. * nosig;
-	if (1.5 * (s_height+v_sep) > p_height - (tmargin+bmargin))
-	    s_height = p_height - (tmargin+bmargin+v_sep);
-	else if (2.5 * (s_height+v_sep) > p_height - (tmargin+bmargin))
-	    s_height = (p_height - (tmargin+bmargin+2*v_sep))/2; 
-	else if (3.5 * (s_height+v_sep) > p_height - (tmargin+bmargin))
-	    s_height = (p_height - (tmargin+bmargin+3*v_sep))/3;
-	if (nosig == 0) t_height = s_height;
-	else t_height = s_height / nosig;
 
 	/* Decide where to put the strip.  Usually, this is directly below the
            previous strip, and s_top will have been set correctly after the
@@ -889,7 +999,7 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1, char *record, char *title)
 		move(mm(s_left + l_sep), tm_y);
 		label(ts);
 	    }
-	    if (vflag)
+	    if (vflag && !skip)
 		(void)fprintf(stderr, "%s %s-", record, ts);
 	    ts = mstimstr(t1);
 	    while (*ts == ' ') ts++;
@@ -903,7 +1013,7 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1, char *record, char *title)
 		move(mm(s_right - l_sep), tm_y);
 		rlabel(ts);
 	    }
-	    if (vflag)
+	    if (vflag && !skip)
 		(void)fprintf(stderr, "%s %s\n",
 			      ts, (title != NULL) ? title : "");
 	}
@@ -928,7 +1038,7 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1, char *record, char *title)
 		move(mm(s_left + l_sep), tm_y);
 		label(ts);
 	    }
-	    if (vflag)
+	    if (vflag && !skip)
 		(void)fprintf(stderr, "%s %s-", record, ts);
 	    ts = mstimstr(-t1);
 	    while (*ts == ' ') ts++;
@@ -947,7 +1057,7 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1, char *record, char *title)
 		move(mm(s_right - l_sep), tm_y);
 		rlabel(ts);
 	    }
-	    if (vflag)
+	    if (vflag && !skip)
 		(void)fprintf(stderr, "%s %s\n",
 			      ts, (title != NULL) ? title : "");
 	}
@@ -1040,6 +1150,38 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1, char *record, char *title)
 	    }
 	    y0 -= adu(vbase[i]);
 	    setrgbcolor(&sc);
+	    if (skip) continue;
+	    if (npts > 0) {
+		/* Draw each envelope as a vertical line, joined to the previous
+		   one at the nearer end. */
+		int x, ya, yb, ylast = 0;
+
+		for (j = last_sample_valid = 0; j < npts; j++) {
+		    WFDB_Envelope *e = &env[j*nisig + sig];
+
+		    if (e->nvalid == 0) {
+			last_sample_valid = 0;
+			continue;
+		    }
+		    x = x0 + si((double)jmax * j / npts);
+		    ya = y0 + adu(e->min);
+		    yb = y0 + adu(e->max);
+		    if (last_sample_valid && abs(yb - ylast) < abs(ya - ylast)) {
+			int yt = ya;
+
+			ya = yb; yb = yt;
+		    }
+		    if (last_sample_valid)
+			cont(x, ya);
+		    else {
+			move(x, ya);
+			last_sample_valid = 1;
+		    }
+		    cont(x, yb);
+		    ylast = yb;
+		}
+		continue;
+	    }
 	    for (j = last_sample_valid = 0, vp = vbuf[i]; j < jmax; j++, vp++){
 		if (*vp == WFDB_INVALID_SAMPLE)
 		    last_sample_valid = 0;
@@ -1117,11 +1259,10 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1, char *record, char *title)
 	if (iannsettime(t0) < 0 && nann == 1) return (1);
 	setrgbcolor(&ac);
 	setroman(fs_ann);
-	for (ia = 0; ia < nann; ia++) {
+	for (ia = 0; ia < nann && !skip; ia++) {
+	    c = -1;
 	    if (Mflag <= 2)
 		(void)printf("%d Ay\n", y = ya[ia]);
-	    else
-		c = -1;
 	    while (getann(ia, &annot) >= 0 && annot.time < t1) {
 	      if (annot.time == 0) continue;
 		if (Mflag >= 2 && annot.chan != c) {
@@ -1378,6 +1519,9 @@ static void newpage()
     double cox, coy, pnx, pny;
     void sendprolog(void);
 
+#ifndef NOFORK
+    setjobpage(pages_written + 1);
+#endif
     lmargin = rhpage() ? imargin + boff : omargin - boff;
     rmargin = rhpage() ? omargin - boff : imargin + boff;
     if (uflag)
@@ -1433,7 +1577,7 @@ static void newpage()
 	(void)printf("( %s) %g %g prco\n", copyright, cox, coy);
     }
     (void)printf("ss\n");
-    if (vflag)
+    if (vflag && !skip)
 	(void)fprintf(stderr, " --- Page %d ---\n", page);
 }
 
@@ -1754,6 +1898,134 @@ static void flush_cont(void)
 #endif
 }
 
+/* Set skip if page p is rendered by another process.  Only the process that
+   renders a page reports errors while reading the records on it, so that
+   they are not repeated by every worker. */
+static void setskip(int p)
+{
+    if (skip == !ownpage(p))
+	return;
+    if ((skip = !skip)) wfdbquiet();
+    else wfdbverbose();
+}
+
+#ifndef NOFORK
+/* Page-parallel rendering (-j).  Before the first script is read, startjobs
+   starts njobs worker processes.  Each of them reads the scripts and lays out
+   every page, but worker j reads the samples and annotations for, and renders,
+   only those pages p for which (p-1) % njobs == j, writing them to a
+   temporary file;  the output of the other pages is discarded.  Since page
+   layout does not depend on the samples, all of the workers agree on it.  The
+   parent process waits for the workers, then copies their pages to the
+   standard output in order, and exits.  The arguments of startjobs are the
+   command-line arguments that remain to be processed. */
+static void startjobs(int argc, char *argv[])
+{
+    char buf[BUFSIZ], *ibuf = NULL;
+    int i, stat, status = 0;
+    long end, *pos;
+    size_t k, n = 0;
+    FILE *tf;
+    pid_t pid;
+
+    /* If commands are to be read from the standard input, read them now, so
+       that each worker can be given a copy. */
+    for (i = 0; i < argc; i++)
+	if (strcmp(argv[i], "-") == 0) {
+	    while ((k = fread(buf, 1, sizeof(buf), stdin)) > 0) {
+		if ((ibuf = realloc(ibuf, n + k)) == NULL) {
+		    (void)fprintf(stderr, "%s: insufficient memory\n", pname);
+		    exit(2);
+		}
+		memcpy(ibuf + n, buf, k);
+		n += k;
+	    }
+	    break;
+	}
+    if ((jobout = calloc(njobs, sizeof(FILE *))) == NULL ||
+	(jobidx = calloc(njobs, sizeof(FILE *))) == NULL ||
+	(pos = calloc(njobs, sizeof(long))) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    for (i = 0; i < njobs; i++)
+	if ((jobout[i] = tmpfile()) == NULL || (jobidx[i] = tmpfile()) == NULL) {
+	    (void)fprintf(stderr, "%s: can't create temporary files\n", pname);
+	    exit(2);
+	}
+    if ((nullout = fopen("/dev/null", "w")) == NULL) {
+	(void)fprintf(stderr, "%s: can't open /dev/null\n", pname);
+	exit(2);
+    }
+
+    (void)fflush(stdout);
+    for (i = 0; i < njobs; i++) {
+	if ((pid = fork()) == 0) {
+	    job = i;
+	    if (ibuf) {	/* replace the standard input with a private copy */
+		if ((tf = tmpfile()) == NULL ||
+		    fwrite(ibuf, 1, n, tf) != n || fflush(tf) ||
+		    dup2(fileno(tf), 0) < 0 || lseek(0, 0L, SEEK_SET) < 0) {
+		    (void)fprintf(stderr, "%s: can't copy standard input\n",
+				  pname);
+		    exit(2);
+		}
+		(void)fclose(tf);
+		clearerr(stdin);
+	    }
+	    if (infofile)	/* don't share the file offset with other workers */
+		infofile = freopen(infoname, "rt", infofile);
+	    /* Anything written before the first page belongs to worker 0. */
+	    skip = (job != 0);
+	    if (skip) wfdbquiet();
+	    (void)dup2(fileno(skip ? nullout : jobout[job]), 1);
+	    return;
+	}
+	else if (pid < 0) {
+	    (void)fprintf(stderr, "%s: can't start worker process\n", pname);
+	    status = 2;
+	    break;
+	}
+    }
+    while (wait(&stat) > 0)
+	if (stat != 0 && status == 0)
+	    status = WIFEXITED(stat) ? WEXITSTATUS(stat) : 2;
+    if (status != 0)
+	exit(status);
+
+    /* Copy the pages in order, followed by anything after the last page. */
+    for (i = 0; i < njobs; i++) {
+	rewind(jobout[i]);
+	rewind(jobidx[i]);
+    }
+    for (i = 0; fscanf(jobidx[i], "%ld", &end) == 1; i = (i+1) % njobs)
+	for ( ; pos[i] < end && (k = fread(buf, 1, end - pos[i] < BUFSIZ ?
+				       end - pos[i] : BUFSIZ, jobout[i])) > 0;
+	      pos[i] += k)
+	    (void)fwrite(buf, 1, k, stdout);
+    for (i = 0; i < njobs; i++)
+	while ((k = fread(buf, 1, sizeof(buf), jobout[i])) > 0)
+	    (void)fwrite(buf, 1, k, stdout);
+    exit(0);
+}
+
+/* Direct the output of page p to this worker's temporary file if it renders
+   the page, or to /dev/null otherwise, after recording where its previous
+   page ended. */
+static void setjobpage(int p)
+{
+    static int jobpage;		/* page being written */
+
+    if (job < 0) return;
+    (void)fflush(stdout);
+    if (jobpage > 0 && ownpage(jobpage))
+	(void)fprintf(jobidx[job], "%ld\n", (long)lseek(1, 0L, SEEK_CUR));
+    setskip(p);
+    (void)dup2(fileno(skip ? nullout : jobout[job]), 1);
+    jobpage = p;
+}
+#endif
+
 static char *prog_name(char *s)
 {
     char *p = s + strlen(s);
@@ -1793,6 +2065,7 @@ static char *help_strings[] = {
  " -h        print this usage summary",
  " -H        use high-resolution mode for multi-frequency records",
  " -i FILE   print (as text) contents of FILE in title area of first page",
+ " -j N      render pages using N processes",
  " -l        print signal labels",
  " -L        use landscape orientation",
  " -m IN OUT TOP BOTTOM   set margins in mm",
@@ -1,5 +1,5 @@
 /* file: psfd.c		G. Moody         9 August 1988
-               		Last revised:	4 November 2020
+               		Last revised:	18 October 2026
 
 -------------------------------------------------------------------------------
 psfd: Produces annotated full-disclosure ECG plots on a PostScript device
@@ -48,6 +48,16 @@ out of memory.
 #include <wfdb/wfdb.h>
 #include <wfdb/ecgcodes.h>
 
+/* With -j, pages are rendered by several processes (see startjobs, below),
+   since the WFDB library is not reentrant. */
+#if defined(MSDOS) || defined(_WIN32)
+#define NOFORK
+#else
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
 /* PROLOG is the pathname of the accompanying prolog file, `psfd.pro', which
    should normally be accessible to this program at run-time.  In most cases,
    PROLOG should be an absolute pathname (beginning from the root directory),
@@ -109,6 +119,7 @@ static int lflag = 0;			/* if non-zero, label signals */
 static int Lflag = 0;			/* if non-zero, use landscape orientation */
 static double lwmm = LWMM;		/* line width (mm); 0 is narrowest possible */
 static int mflag = 0;			/* if non-zero, margins specified using -m */
+static int njobs = 1;			/* number of processes rendering pages */
 static int Mflag = 0;			/* annotation/marker bar mode (0: do not print
 				   bars, print mnemonics at center; 1: print
 				   bars across all signals, mnemonics at
@@ -126,6 +137,8 @@ static char *pagetitle = NULL;		/* if not null, title for page header */
 static char *pname;			/* the name by which this program is invoked */
 static int rflag = 0;			/* if non-zero, print record names */
 static int sflag = 0;			/* if non-zero, a signal list was specified */
+static int skip = 0;			/* if non-zero, the current page is rendered
+				   by another process (see startjobs) */
 static int *siglist;			/* list of signals to be printed */
 static int smode = 1;			/* scale mode (0: no scales; 1: mm/unit in
 				   footers; 2: units/tick in footers) */
@@ -185,8 +198,20 @@ static void setmargins();
 static void setroman(double size);
 static void setrgbcolor(struct pscolor *color);
 static void setsans(double size); 
+static void setskip(int p);
 static void smaller(); 
 static void tlabel(char *s);
+#ifndef NOFORK
+static int job = -1;		/* worker number (-1 if -j was not used) */
+static FILE **jobout;		/* pages rendered by each worker */
+static FILE **jobidx;		/* offsets of the ends of those pages */
+static FILE *nullout;		/* output of pages rendered by other workers */
+static void setjobpage(int p);
+static void startjobs(int argc, char *argv[]);
+#define ownpage(P)	(job < 0 || ((P)-1) % njobs == job)
+#else
+#define ownpage(P)	1
+#endif
 
 int main(int argc, char *argv[])
 {
@@ -234,6 +259,11 @@ int main(int argc, char *argv[])
     if (getenv("TRANSCRIPTBUG")) uflag = 1;
 
     for (i = 1; i < argc; i++) {
+#ifndef NOFORK
+	/* With -j, start the workers before reading the first script. */
+	if (njobs > 1 && job < 0 && (*argv[i] != '-' || *(argv[i]+1) == '\0'))
+	    startjobs(argc - i, argv + i);
+#endif
 	if (*argv[i] == '-') switch (*(argv[i]+1)) {
 	  case 'a':	/* specify annotator */
 	    if (++i >= argc) {
@@ -342,6 +372,13 @@ int main(int argc, char *argv[])
 		exit(1);
 	    }
 	    break;
+	  case 'j':	/* specify number of processes rendering pages */
+	    if (++i >= argc || (njobs = atoi(argv[i])) < 1) {
+		(void)fprintf(stderr,
+			      "%s: number of jobs must follow -j\n", argv[0]);
+		exit(1);
+	    }
+	    break;
 	  case 'l':	/* enable signal labelling */
 	    lflag = 1;
 	    break;
@@ -504,7 +541,8 @@ int main(int argc, char *argv[])
 	    break;
 	}
 	else if ((cfile = fopen(argv[i], "r")) == NULL) {
-	    (void)fprintf(stderr, "%s: can't read %s\n", argv[0], argv[i]);
+	    if (!skip)
+		(void)fprintf(stderr, "%s: can't read %s\n", argv[0],argv[i]);
 	    exit(1);
 	}
 	else {
@@ -517,6 +555,9 @@ int main(int argc, char *argv[])
 	exit(1);
     }
     ejectpage();
+#ifndef NOFORK
+    setjobpage(pages_written + 1);	/* the trailer follows the last page */
+#endif
     if (!uflag) {
 	(void)printf("%%%%Trailer\n");
 	(void)printf("%%%%Pages: %d\n", pages_written);
@@ -535,6 +576,13 @@ int *uncal;		/* if non-zero, signal is uncalibrated */
 int *accept, *buflen, *v, *vbase, **vbuf, *vmax, *vmin, *vn;
 double *vs, *vsum;
 
+/* If the decimation factor is at least ENVMIN, printstrip obtains the
+   averages of each group of input samples from getenvelope, which can
+   summarize long intervals without reading all of the samples. */
+#define ENVMIN	16
+WFDB_Envelope *env;	/* envelopes (allocated by printstrip()) */
+int envlen;		/* number of WFDB_Envelope structures in env */
+
 /* Derived parameters */
 WFDB_Time decf; 	/* decimation factor (input samples/output sample) */
 double dpmm;		/* pixels per millimeter */
@@ -581,13 +629,16 @@ static void process(FILE *cfile)
 	    static int warned;
 
 	    if (!warned) {
-		(void)fprintf(stderr,
-		    "Warning: printed scales will not be correct if\n");
-		(void)fprintf(stderr,
-		    "%s output is resized by an embedding document!\n", pname);
-		(void)fprintf(stderr,
-		    "You may wish to rerun %s with option `-S %d %d'\n",
+		if (!skip) {	/* with -j, only one worker warns */
+		    (void)fprintf(stderr,
+			"Warning: printed scales will not be correct if\n");
+		    (void)fprintf(stderr,
+			"%s output is resized by an embedding document!\n",
+			pname);
+		    (void)fprintf(stderr,
+			"You may wish to rerun %s with option `-S %d %d'\n",
 			pname, smode+1, tsmode);
+		}
 		warned = 1;
 	    }
 	}
@@ -599,7 +650,7 @@ static void process(FILE *cfile)
     lmargin = rhpage() ? imargin + boff : omargin - boff;
     rmargin = rhpage() ? omargin - boff : imargin + boff;
     while (fgets(combuf, 256, cfile)) {	/* read a command */
-	if (vflag) (void)fprintf(stderr, "%s", combuf);
+	if (vflag && !skip) (void)fprintf(stderr, "%s", combuf);
 	if (*combuf == '\n') {
 	    if (pages_written > 0) ejectpage();
 	}
@@ -631,9 +682,10 @@ static void process(FILE *cfile)
 	    else {
 		for (i = 0; i < nosig; i++) {
 		    if ((siglist[i] = findsig(snstr[i])) < 0) {
-			(void)fprintf(stderr,
+			if (!skip)
+			    (void)fprintf(stderr,
 				      "record %s doesn't have a signal '%s'\n",
-				      record, snstr[i]);
+					  record, snstr[i]);
 			wfdbquit();
 			return;
 		    }
@@ -711,7 +763,7 @@ static void process(FILE *cfile)
 		    break;
 		}
 		if (printstrip(t0, tt) == 0) break;
-		if (((t0 += nisamp) < t1 || t1 == 0L) && vflag)
+		if (((t0 += nisamp) < t1 || t1 == 0L) && vflag && !skip)
 		    (void)fprintf(stderr, " %s\n", timstr(t0));
 	    }
 	    wfdbquit();
@@ -750,6 +802,13 @@ static char *timcstr(WFDB_Time t)
 double s_top = -9999., s_bot, s_left, s_right, s_height, s_width;
 double t_height;	/* height (mm) of space actually alloted per trace */
 
+/* Return non-zero if all n samples of a strip beginning at sample t can be
+   read, by reading only the last of them. */
+static int fullstrip(WFDB_Time t, WFDB_Time n)
+{
+    return (isigsettime(t + n - 1) >= 0 && getvec(v) >= 0);
+}
+
 /* Print a strip beginning at sample t0, ending at sample t1-1.  This function
    returns 2 if completely successful, 1 if the signals were plotted but not
    the annotations, or 0 if nothing was printed. */
@@ -759,7 +818,7 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1)
     char *ts;
     double curr_s_top;
     int i, k;
-    WFDB_Time j, jmax;
+    WFDB_Time j, jmax, tend;
     int nstrips, tm_y, tt, ttmax, *vp, x0, y0, ya[2];
 
     /* Allocate buffers for the samples to be plotted, and initialize the
@@ -777,8 +836,74 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1)
 	}
     }
 
-    if ((jmax = t1 - t0) > nisamp) jmax = nisamp;
     if (nosig > 0) {
+	/* Determine the height of the strip.  The calculation of nstrips
+	   allots roughly t_hideal (7.5 by default) mm per trace.  The formula
+	   is derived from the desired results: 30 for nosig = 1, 15 for nosig
+	   = 2, 10 for nosig = 3, 8 for nosig = 4, 6 for nosig = 5, etc., given
+	   the default paper size and margins. */
+	nstrips = (nosig<=16) ?
+	    (int)((p_height-tmargin-bmargin)/(t_hideal*nosig)+0.45) : 1;
+	s_height = (p_height - (tmargin+bmargin)) / nstrips;
+	if (nosig > 2 || nann > 1) s_height -= s_height / (nosig+1);
+	t_height = s_height / nosig;
+
+	/* The height does not depend on the samples, so it is known here
+	   whether the strip will begin a new page (see below), and therefore
+	   whether it will be rendered by this process.  If not (see
+	   startjobs), its samples and annotations are not read. */
+	if (s_top != -9999. && s_top - s_height < bmargin - 2.0)
+	    setskip(pages_written + 2);
+	else
+	    setskip(pages_written + 1);
+    }
+
+    if ((jmax = t1 - t0) > nisamp) jmax = nisamp;
+    if (nosig > 0 && decf >= ENVMIN && (tend = strtim("e")) > 0L) {
+	/* Fill the buffers with the means from the envelopes. */
+	if (t0 >= tend) return (0);
+	if (t0 + jmax > tend) jmax = tend - t0;
+	ttmax = jmax / decf;
+	if (!skip && ttmax * nisig > envlen) {
+	    if ((env = realloc(env, ttmax * nisig * sizeof(WFDB_Envelope))) ==
+		NULL) {
+		envlen = 0;
+		(void)fprintf(stderr, "insufficient memory\n");
+		return (0);
+	    }
+	    envlen = ttmax * nisig;
+	}
+	if (skip)
+	    ttmax = 0;
+	else if (ttmax > 0 &&
+	    (ttmax = getenvelope(t0, t0 + ttmax*decf, ttmax, env)) < 0)
+	    return (0);
+	for (tt = 0; tt < ttmax; tt++) {
+	    for (i = 0; i < nosig; i++) {
+		WFDB_Envelope *e = &env[tt*nisig + siglist[i]];
+		int vtmp;
+
+		if (e->nvalid > 0) {
+		    vsum[i] += vbuf[i][tt] = vtmp = e->mean;
+		    if (vtmp > vmax[i] || vmax[i] == WFDB_INVALID_SAMPLE)
+			vmax[i] = vtmp;
+		    else if (vtmp<vmin[i] || vmin[i]==WFDB_INVALID_SAMPLE)
+			vmin[i] = vtmp;
+		    accept[i]++;
+		}
+		else
+		    vbuf[i][tt] = WFDB_INVALID_SAMPLE;
+	    }
+	}
+	j = jmax;
+    }
+    else if (nosig > 0 && skip && fullstrip(t0, jmax)) {
+	/* The strip is rendered by another process, and it does not reach
+	   the end of the record, so only its length is needed. */
+	j = jmax;
+	ttmax = 0;
+    }
+    else if (nosig > 0) {
 	/* Fill the buffers. */
 	if (isigsettime(t0) < 0) return (0);
 
@@ -818,8 +943,10 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1)
 	if (j == 0L) return (0);
 	if (j == jmax - 1) j++;
 	/* reached end of record exactly at end of strip -- adjust j */
-	t1 = t0 + j;
 	ttmax = tt;
+    }
+    if (nosig > 0) {
+	t1 = t0 + j;
 	if (nticks < j/sps) nticks = j/sps;
 	
 	/* Calculate the midranges. */
@@ -841,17 +968,8 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1)
 		vbase[i] = 0;
 	}
 
-	/* Determine the width and height of the strip. */
+	/* Determine the width of the strip. */
 	s_width = j*tscale/sps;
-	/* The calculation of nstrips allots roughly t_hideal (7.5 by default)
-	   mm per trace.  The formula is derived from the desired results: 30
-	   for nosig = 1, 15 for nosig = 2, 10 for nosig = 3, 8 for nosig = 4,
-	   6 for nosig = 5, etc., given the default paper size and margins. */
-	nstrips = (nosig<=16) ?
-	    (int)((p_height-tmargin-bmargin)/(t_hideal*nosig)+0.45) : 1;
-	s_height = (p_height - (tmargin+bmargin)) / nstrips;
-	if (nosig > 2 || nann > 1) s_height -= s_height / (nosig+1);
-	t_height = s_height / nosig;
 	
 	/* Decide where to put the strip.  Usually, this is directly below the
 	   previous strip, and s_top will have been set correctly after the
@@ -1037,11 +1155,10 @@ static int printstrip(WFDB_Time t0, WFDB_Time t1)
 	if (iannsettime(t0) < 0 && nann == 1) return (1);
 	setrgbcolor(&ac);
 	setsans(fs_ann);
-	for (ia = 0; ia < nann; ia++) {
+	for (ia = 0; ia < nann && !skip; ia++) {
+	    c = -1;
 	    if (Mflag <= 2)
 		(void)printf("%d Ay\n", y = ya[ia]);
-	    else
-		c = -1;
 	    while (getann(ia, &annot) >= 0 && annot.time < t1) {
 		if (Mflag >= 2 && annot.chan != c) {
 		    int i;
@@ -1270,6 +1387,9 @@ static void newpage()
     double cox, coy, pnx, pny;
     void sendprolog();
 
+#ifndef NOFORK
+    setjobpage(pages_written + 1);
+#endif
     lmargin = rhpage() ? imargin + boff : omargin - boff;
     rmargin = rhpage() ? omargin - boff : imargin + boff;
     if (uflag)
@@ -1324,7 +1444,7 @@ static void newpage()
 	(void)printf("( %s) %g %g prco\n", copyright, cox, coy);
     }
     (void)printf("ss\n");
-    if (vflag)
+    if (vflag && !skip)
 	(void)fprintf(stderr, " --- Page %d ---\n", page);
 }
 
@@ -1631,6 +1751,132 @@ static void flush_cont()
     }
 }
 
+/* Set skip if page p is rendered by another process.  Only the process that
+   renders a page reports errors while reading the records on it, so that
+   they are not repeated by every worker. */
+static void setskip(int p)
+{
+    if (skip == !ownpage(p))
+	return;
+    if ((skip = !skip)) wfdbquiet();
+    else wfdbverbose();
+}
+
+#ifndef NOFORK
+/* Page-parallel rendering (-j).  Before the first script is read, startjobs
+   starts njobs worker processes.  Each of them reads the scripts and lays out
+   every page, but worker j reads the samples and annotations for, and renders,
+   only those pages p for which (p-1) % njobs == j, writing them to a
+   temporary file;  the output of the other pages is discarded.  Since page
+   layout does not depend on the samples, all of the workers agree on it.  The
+   parent process waits for the workers, then copies their pages to the
+   standard output in order, and exits.  The arguments of startjobs are the
+   command-line arguments that remain to be processed. */
+static void startjobs(int argc, char *argv[])
+{
+    char buf[BUFSIZ], *ibuf = NULL;
+    int i, stat, status = 0;
+    long end, *pos;
+    size_t k, n = 0;
+    FILE *tf;
+    pid_t pid;
+
+    /* If commands are to be read from the standard input, read them now, so
+       that each worker can be given a copy. */
+    for (i = 0; i < argc; i++)
+	if (strcmp(argv[i], "-") == 0) {
+	    while ((k = fread(buf, 1, sizeof(buf), stdin)) > 0) {
+		if ((ibuf = realloc(ibuf, n + k)) == NULL) {
+		    (void)fprintf(stderr, "%s: insufficient memory\n", pname);
+		    exit(2);
+		}
+		memcpy(ibuf + n, buf, k);
+		n += k;
+	    }
+	    break;
+	}
+    if ((jobout = calloc(njobs, sizeof(FILE *))) == NULL ||
+	(jobidx = calloc(njobs, sizeof(FILE *))) == NULL ||
+	(pos = calloc(njobs, sizeof(long))) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    for (i = 0; i < njobs; i++)
+	if ((jobout[i] = tmpfile()) == NULL || (jobidx[i] = tmpfile()) == NULL) {
+	    (void)fprintf(stderr, "%s: can't create temporary files\n", pname);
+	    exit(2);
+	}
+    if ((nullout = fopen("/dev/null", "w")) == NULL) {
+	(void)fprintf(stderr, "%s: can't open /dev/null\n", pname);
+	exit(2);
+    }
+
+    (void)fflush(stdout);
+    for (i = 0; i < njobs; i++) {
+	if ((pid = fork()) == 0) {
+	    job = i;
+	    if (ibuf) {	/* replace the standard input with a private copy */
+		if ((tf = tmpfile()) == NULL ||
+		    fwrite(ibuf, 1, n, tf) != n || fflush(tf) ||
+		    dup2(fileno(tf), 0) < 0 || lseek(0, 0L, SEEK_SET) < 0) {
+		    (void)fprintf(stderr, "%s: can't copy standard input\n",
+				  pname);
+		    exit(2);
+		}
+		(void)fclose(tf);
+		clearerr(stdin);
+	    }
+	    /* Anything written before the first page belongs to worker 0. */
+	    skip = (job != 0);
+	    if (skip) wfdbquiet();
+	    (void)dup2(fileno(skip ? nullout : jobout[job]), 1);
+	    return;
+	}
+	else if (pid < 0) {
+	    (void)fprintf(stderr, "%s: can't start worker process\n", pname);
+	    status = 2;
+	    break;
+	}
+    }
+    while (wait(&stat) > 0)
+	if (stat != 0 && status == 0)
+	    status = WIFEXITED(stat) ? WEXITSTATUS(stat) : 2;
+    if (status != 0)
+	exit(status);
+
+    /* Copy the pages in order, followed by anything after the last page. */
+    for (i = 0; i < njobs; i++) {
+	rewind(jobout[i]);
+	rewind(jobidx[i]);
+    }
+    for (i = 0; fscanf(jobidx[i], "%ld", &end) == 1; i = (i+1) % njobs)
+	for ( ; pos[i] < end && (k = fread(buf, 1, end - pos[i] < BUFSIZ ?
+				       end - pos[i] : BUFSIZ, jobout[i])) > 0;
+	      pos[i] += k)
+	    (void)fwrite(buf, 1, k, stdout);
+    for (i = 0; i < njobs; i++)
+	while ((k = fread(buf, 1, sizeof(buf), jobout[i])) > 0)
+	    (void)fwrite(buf, 1, k, stdout);
+    exit(0);
+}
+
+/* Direct the output of page p to this worker's temporary file if it renders
+   the page, or to /dev/null otherwise, after recording where its previous
+   page ended. */
+static void setjobpage(int p)
+{
+    static int jobpage;		/* page being written */
+
+    if (job < 0) return;
+    (void)fflush(stdout);
+    if (jobpage > 0 && ownpage(jobpage))
+	(void)fprintf(jobidx[job], "%ld\n", (long)lseek(1, 0L, SEEK_CUR));
+    setskip(p);
+    (void)dup2(fileno(skip ? nullout : jobout[job]), 1);
+    jobpage = p;
+}
+#endif
+
 static char *prog_name(char *s)
 {
     char *p = s + strlen(s);
@@ -1669,6 +1915,7 @@ static char *help_strings[] = {
  " -G        print grids with 1-minute tick intervals",
  " -h        print this usage summary",
  " -H N      set trace height in mm (default: 7.5)",
+ " -j N      render pages using N processes",
  " -l        print signal labels",
  " -L        use landscape orientation",
  " -m IN OUT TOP BOTTOM   set margins in mm",
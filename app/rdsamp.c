@@ -1,5 +1,5 @@
 /* file: rdsamp.c	G. Moody	 23 June 1983
-			Last revised:     18 May 2022
+			Last revised:  18 October 2026
 
 -------------------------------------------------------------------------------
 rdsamp: Print an arbitrary number of samples from each signal
@@ -25,6 +25,8 @@ _______________________________________________________________________________
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <wfdb/wfdb.h>
 
 /* values for timeunits */
@@ -37,6 +39,19 @@ _______________________________________________________________________________
 #define HHMMSS	    7
 #define SAMPLES     8
 
+/* values for binary output types (see -b and -B) */
+#define BIN_I16	    1
+#define BIN_I32	    2
+#define BIN_F32	    3
+
+/* Samples are formatted into obuf and written to the standard output in
+   blocks of about OBUFSIZE bytes.  OBUFSLACK is the space that must remain
+   free before a single time or sample value is formatted;  it is large enough
+   for the longest value that snprintf can produce for any of the formats
+   used below. */
+#define OBUFSIZE    65536
+#define OBUFSLACK   512
+
 #define WFDBXMLPROLOG  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
  "<?xml-stylesheet type=\"text/xsl\"" \
  " href=\"wfdb.xsl\"?>\n" \
@@ -44,8 +59,16 @@ _______________________________________________________________________________
  " \"http://physionet.org/physiobank/database/XML/wfdb.dtd\">\n"
 
 static char *pname;
+static char obuf[OBUFSIZE+OBUFSLACK], *obp = obuf;
 static char *prog_name(char *s);
 static char *escapify(char *s);
+static char *putint(char *p, WFDB_Time n, int width);
+static char *putfixed(char *p, double t, int prec, int width);
+static void oflush(void);
+static char *putbin(char *p, WFDB_Sample v, int btype, int baseline,
+		    double sc);
+static void binout(WFDB_Sample *v, int *sig, int nsig, WFDB_Siginfo *si,
+		   WFDB_Time from, WFDB_Time to, int btype, int planar);
 static void help(void);
 
 int main(int argc, char *argv[])
@@ -53,8 +76,9 @@ int main(int argc, char *argv[])
     char *record = NULL, *search = NULL;
     char *invalid, *snfmt, *tfmt, *tnfmt, *tufmt, *vfmt, speriod[16],
 	tustr[21];
-    int cflag = 0, highres = 0, i, isiglist, nsig, nosig = 0, pflag = 0, s,
-	*sig = NULL, timeunits = SECONDS, vflag = 0, xflag = 0;
+    int btype = 0, cflag = 0, highres = 0, i, isiglist, nsig, nosig = 0,
+	pflag = 0, planar = 0, s, *sig = NULL, timeunits = SECONDS, vflag = 0,
+	xflag = 0;
     WFDB_Frequency freq;
     WFDB_Sample *v;
     WFDB_Siginfo *si;
@@ -63,6 +87,23 @@ int main(int argc, char *argv[])
     pname = prog_name(argv[0]);
     for (i = 1 ; i < argc; i++) {
 	if (*argv[i] == '-') switch (*(argv[i]+1)) {
+	  case 'B':	/* binary output, one signal after another */
+	    planar = 1;	/* (fall through to case 'b') */
+	  case 'b':	/* binary output, samples interleaved by frame */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: output type must follow %s\n",
+			      pname, argv[i-1]);
+		exit(1);
+	    }
+	    if (strcmp(argv[i], "i16") == 0) btype = BIN_I16;
+	    else if (strcmp(argv[i], "i32") == 0) btype = BIN_I32;
+	    else if (strcmp(argv[i], "f32") == 0) btype = BIN_F32;
+	    else {
+		(void)fprintf(stderr,
+			"%s: output type must be i16, i32, or f32\n", pname);
+		exit(1);
+	    }
+	    break;
 	  case 'c':	/* output in CSV format */
 	    cflag = 1;
 	    break;
@@ -212,6 +253,13 @@ int main(int argc, char *argv[])
     if (maxl && (to == 0L || to > from + maxl))
 	to = from + maxl;
 
+    /* Binary output does not use any of the text formats below. */
+    if (btype) {
+	binout(v, sig, nsig, si, from, to, btype, planar);
+	wfdbquit();
+	exit(0);
+    }
+
     /* Adjust timeunits if starting time or date is undefined. */
     if (timeunits == TIMSTR) {
 	char *p = timstr(0L);
@@ -254,8 +302,6 @@ int main(int argc, char *argv[])
 	}
 	else {	/* output in raw units */
 	    tnfmt = "'sample #'";
-	    tfmt = "%"WFDB_Pd_TIME;
-	    vfmt = ",%d";
 	}
     }
     else {	/* output in tab-separated columns selected */
@@ -296,8 +342,6 @@ int main(int argc, char *argv[])
 	else {	/* output in raw units */
 	    snfmt = "\t%7s";
 	    tnfmt = "       sample #";
-	    tfmt = "%15"WFDB_Pd_TIME;
-	    vfmt = "\t%7d";
 	}
     }
 
@@ -347,8 +391,9 @@ int main(int argc, char *argv[])
 
     /* Print data in physical units if '-p' option selected. */
     if (pflag) {
-	char *p;
-
+	char *p, *q, sep;
+	double p10, *sc, tsc;
+	int tprec, vprec, vwidth;
 
 	/* Print units as a second line of column headers if '-v' selected. */
 	if (vflag) {
@@ -382,19 +427,56 @@ int main(int argc, char *argv[])
 	}
 
 	if (xflag) (void)printf("<samplevectors>\n");
+	fflush(stdout);
+
+	/* Values are formatted by putfixed, with precision vprec, from
+	   sample values scaled by sc[i] = 10^vprec / gain.  putfixed
+	   declines values that it cannot round exactly as printf would;
+	   those are formatted by snprintf using the conventional
+	   ((double)v - baseline)/gain, so that output is unchanged. */
+	vprec = pflag > 1 ? 8 : 3;
+	vwidth = cflag ? 0 : (pflag > 1 ? 15 : 7);
+	sep = cflag ? ',' : '\t';
+	vfmt++;		/* skip the separator, which is written separately */
+	invalid++;
+	for (p10 = 1.0, i = 0; i < vprec; i++)
+	    p10 *= 10.0;
+	if ((sc = malloc(nsig * sizeof(double))) == NULL) {
+	    (void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	    exit(2);
+	}
+	for (i = 0; i < nsig; i++)
+	    sc[i] = p10/si[sig[i]].gain;
+	switch (timeunits) {
+	  default:
+	  case SECONDS: tprec = 3; break;
+	  case MINUTES: tprec = 5; break;
+	  case HOURS:   tprec = 7; break;
+	}
+	for (tsc = 1.0, i = 0; i < tprec; i++)
+	    tsc *= 10.0;
+	tsc /= freq;
+	tfmt = cflag ? (tprec == 3 ? "%.3lf" : tprec == 5 ? "%.5lf" : "%.7lf") :
+	    (tprec == 3 ? "%15.3lf" : tprec == 5 ? "%15.5lf" : "%15.7lf");
+
 	while ((to == 0L || from < to) && getvec(v) >= 0) {
+	    if (obp >= obuf + OBUFSIZE) oflush();
 	    if (cflag == 0) {
 	      switch (timeunits) {
-	        case TIMSTR:   (void)printf("%s", timstr(-from)); break;
+	        case TIMSTR:   obp += sprintf(obp, "%s", timstr(-from)); break;
 	        case SHORTTIMSTR:
-	        case MSTIMSTR: (void)printf("%s", mstimstr(-from)); break;
-	        case HHMMSS:   (void)printf("%15s", from == 0L ?
+	        case MSTIMSTR: obp += sprintf(obp, "%s", mstimstr(-from)); break;
+	        case HHMMSS:   obp += sprintf(obp, "%15s", from == 0L ?
 					    "0:00.000" : mstimstr(from)); break;
-	        case SAMPLES:  (void)printf("%15"WFDB_Pd_TIME, from); break;
+	        case SAMPLES:  obp = putint(obp, from, 15); break;
 	        default:
-	        case SECONDS:  (void)printf("%15.3lf",(double)from/freq); break;
-	        case MINUTES:  (void)printf("%15.5lf",(double)from/freq); break;
-	        case HOURS:    (void)printf("%15.7lf",(double)from/freq); break;
+	        case SECONDS:
+	        case MINUTES:
+	        case HOURS:
+		    if ((q = putfixed(obp, from*tsc, tprec, 15)) == NULL)
+			q = obp + sprintf(obp, tfmt, (double)from/freq);
+		    obp = q;
+		    break;
 	      }
 	    }
 	    else {
@@ -402,48 +484,71 @@ int main(int argc, char *argv[])
 	        case TIMSTR:
 		    for (p = timstr(-from); *p == ' '; p++)
 			;
-		    (void)printf("'%s'", p); break;
+		    obp += sprintf(obp, "'%s'", p); break;
 	        case SHORTTIMSTR:
 	        case MSTIMSTR:
 		    for (p = mstimstr(-from); *p == ' '; p++)
 			;
-		    (void)printf("'%s'", p); break;
+		    obp += sprintf(obp, "'%s'", p); break;
 	        case HHMMSS:
-		    if (from == 0L) printf("'0:00.000'");
+		    if (from == 0L) obp += sprintf(obp, "'0:00.000'");
 		    else {
 			for (p = mstimstr(from); *p == ' '; p++)
 			    ;
-			(void)printf("'%s'", p); break;
+			obp += sprintf(obp, "'%s'", p); break;
 		    }
 		    break;
-	        case SAMPLES:  (void)printf("%"WFDB_Pd_TIME, from); break;
+	        case SAMPLES:  obp = putint(obp, from, 0); break;
 	        default:
-	        case SECONDS:  (void)printf("%.3lf",(double)from/freq); break;
-	        case MINUTES:  (void)printf("%.5lf",(double)from/freq); break;
-	        case HOURS:    (void)printf("%.7lf",(double)from/freq); break;
+	        case SECONDS:
+	        case MINUTES:
+	        case HOURS:
+		    if ((q = putfixed(obp, from*tsc, tprec, 0)) == NULL)
+			q = obp + sprintf(obp, tfmt, (double)from/freq);
+		    obp = q;
+		    break;
 	      }
 	    }
 
 	    from++;
 	    for (i = 0; i < nsig; i++) {
-		if (v[sig[i]] != WFDB_INVALID_SAMPLE)
-		    (void)printf(vfmt,
-		     ((double)v[sig[i]] - si[sig[i]].baseline)/si[sig[i]].gain);
+		WFDB_Sample vi = v[sig[i]];
+
+		if (obp >= obuf + OBUFSIZE) oflush();
+		*obp++ = sep;
+		if (vi != WFDB_INVALID_SAMPLE) {
+		    double d = (double)vi - si[sig[i]].baseline;
+
+		    if ((q = putfixed(obp, d*sc[i], vprec, vwidth)) == NULL)
+			q = obp + sprintf(obp, vfmt, d/si[sig[i]].gain);
+		    obp = q;
+		}
 		else
-		    (void)printf("%s", invalid);
+		    for (p = invalid; *p; )
+			*obp++ = *p++;
 	    }
-	    (void)printf("\n");
+	    *obp++ = '\n';
 	}
+	oflush();
     }
 
     else {	/* output in raw units */
+	int twidth = cflag ? 0 : 15, vwidth = cflag ? 0 : 7;
+	char sep = cflag ? ',' : '\t';
+
 	if (xflag) (void)printf("<samplevectors>\n");
+	fflush(stdout);
 	while ((to == 0L || from < to) && getvec(v) >= 0) {
-	    (void)printf(tfmt, from++);
-	    for (i = 0; i < nsig; i++)
-		(void)printf(vfmt, v[sig[i]]);
-	    (void)printf("\n");
+	    if (obp >= obuf + OBUFSIZE) oflush();
+	    obp = putint(obp, from++, twidth);
+	    for (i = 0; i < nsig; i++) {
+		if (obp >= obuf + OBUFSIZE) oflush();
+		*obp++ = sep;
+		obp = putint(obp, v[sig[i]], vwidth);
+	    }
+	    *obp++ = '\n';
 	}
+	oflush();
     }
 
     if (xflag)		/* print trailer if WFDB-XML output was selected */
@@ -474,6 +579,186 @@ static char *escapify(char *s)
     return (q);
 }
 
+/* Write n in decimal at p, right-justified in a field of the given width
+   (as printf("%*lld", width, n) would), and return a pointer to the byte
+   following the last one written. */
+static char *putint(char *p, WFDB_Time n, int width)
+{
+    char buf[24], *q = buf + sizeof(buf);
+    unsigned long long u = n < 0 ? -(unsigned long long)n : n;
+
+    do {
+	*--q = '0' + u % 10;
+    } while (u /= 10);
+    if (n < 0) *--q = '-';
+    for (width -= buf + sizeof(buf) - q; width > 0; width--)
+	*p++ = ' ';
+    while (q < buf + sizeof(buf))
+	*p++ = *q++;
+    return (p);
+}
+
+/* Write t/10^prec at p with prec digits after the decimal point,
+   right-justified in a field of the given width, as printf("%*.*f") would do
+   for the unscaled value.  The scaled value t may differ from the exact
+   product of the unscaled value and 10^prec by a few units in its last
+   place;  if that could change the rounded result (because t lies very
+   close to a rounding boundary), or if t is too large, putfixed writes
+   nothing and returns NULL, and the caller must format the value using
+   printf.  Otherwise, it returns a pointer to the byte following the last
+   one written. */
+static char *putfixed(char *p, double t, int prec, int width)
+{
+    static const unsigned long long p10[] = { 1ULL, 10ULL, 100ULL, 1000ULL,
+	10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL };
+    char buf[32], *q = buf + sizeof(buf);
+    double a, f, margin;
+    int i, neg;
+    unsigned long long n, ip, fp;
+
+    neg = (t < 0.0 || (t == 0.0 && 1.0/t < 0.0));	/* includes -0.0 */
+    a = neg ? -t : t;
+    if (!(a < 1.0e13))	/* too large (or NaN) */
+	return (NULL);
+    n = (unsigned long long)a;
+    f = a - (double)n;
+    margin = 1.0e-9 + a * 4.0e-15;
+    if (f > 0.5 - margin && f < 0.5 + margin)
+	return (NULL);
+    if (f > 0.5) n++;
+    ip = n / p10[prec];
+    fp = n % p10[prec];
+    for (i = 0; i < prec; i++) {
+	*--q = '0' + fp % 10;
+	fp /= 10;
+    }
+    if (prec > 0) *--q = '.';
+    do {
+	*--q = '0' + ip % 10;
+    } while (ip /= 10);
+    if (neg) *--q = '-';
+    for (width -= buf + sizeof(buf) - q; width > 0; width--)
+	*p++ = ' ';
+    while (q < buf + sizeof(buf))
+	*p++ = *q++;
+    return (p);
+}
+
+/* Write the contents of obuf to the standard output. */
+static void oflush(void)
+{
+    if (obp > obuf && fwrite(obuf, 1, obp - obuf, stdout) != obp - obuf) {
+	perror(pname);
+	exit(3);
+    }
+    obp = obuf;
+}
+
+/* Write a sample in little-endian binary format at p, and return a pointer
+   to the byte following the last one written.  For BIN_F32, samples are
+   converted to physical units using the scale factor sc = 1/gain;  for
+   BIN_I16, samples outside of the range of a 16-bit integer are clipped. */
+static char *putbin(char *p, WFDB_Sample v, int btype, int baseline, double sc)
+{
+    unsigned long u;
+
+    switch (btype) {
+      case BIN_I16:
+	if (v > 32767) v = 32767;
+	else if (v < -32768) v = -32768;
+	*p++ = v & 0xff;
+	*p++ = (v >> 8) & 0xff;
+	break;
+      case BIN_I32:
+	*p++ = v & 0xff;
+	*p++ = (v >> 8) & 0xff;
+	*p++ = (v >> 16) & 0xff;
+	*p++ = (v >> 24) & 0xff;
+	break;
+      case BIN_F32:
+	{
+	    union { float f; unsigned int i; } x;
+
+	    if (v == WFDB_INVALID_SAMPLE)
+		x.i = 0x7fc00000;	/* quiet NaN */
+	    else
+		x.f = (float)(((double)v - baseline) * sc);
+	    u = x.i;
+	    *p++ = u & 0xff;
+	    *p++ = (u >> 8) & 0xff;
+	    *p++ = (u >> 16) & 0xff;
+	    *p++ = (u >> 24) & 0xff;
+	}
+	break;
+    }
+    return (p);
+}
+
+/* Write samples from 'from' to 'to' (or the end of the record, if to is 0)
+   in binary format.  If planar is zero, the output is frame-interleaved
+   (as in a format 16 signal file);  otherwise, all of the samples of the
+   first selected signal are written first, then those of the second signal,
+   etc.  Planar output is assembled in one temporary file per signal, so
+   that the input is read only once. */
+static void binout(WFDB_Sample *v, int *sig, int nsig, WFDB_Siginfo *si,
+		   WFDB_Time from, WFDB_Time to, int btype, int planar)
+{
+    char *p;
+    double *sc;
+    FILE **tf = NULL;
+    int i;
+    size_t n;
+
+    if ((sc = malloc(nsig * sizeof(double))) == NULL ||
+	(planar && (tf = calloc(nsig, sizeof(FILE *))) == NULL)) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    for (i = 0; i < nsig; i++) {
+	sc[i] = 1.0/si[sig[i]].gain;
+	if (planar && (tf[i] = tmpfile()) == NULL) {
+	    (void)fprintf(stderr, "%s: can't create temporary file\n", pname);
+	    exit(2);
+	}
+    }
+    fflush(stdout);
+    while ((to == 0L || from < to) && getvec(v) >= 0) {
+	from++;
+	if (planar) {
+	    char b[4];
+
+	    for (i = 0; i < nsig; i++) {
+		p = putbin(b, v[sig[i]], btype, si[sig[i]].baseline, sc[i]);
+		(void)fwrite(b, 1, p - b, tf[i]);
+	    }
+	}
+	else {
+	    for (i = 0; i < nsig; i++) {
+		if (obp >= obuf + OBUFSIZE) oflush();
+		obp = putbin(obp, v[sig[i]], btype, si[sig[i]].baseline,sc[i]);
+	    }
+	}
+    }
+    if (planar) {
+	for (i = 0; i < nsig; i++) {
+	    if (ferror(tf[i])) {
+		(void)fprintf(stderr, "%s: error writing temporary file\n",
+			      pname);
+		exit(3);
+	    }
+	    rewind(tf[i]);
+	    while ((n = fread(obuf, 1, OBUFSIZE, tf[i])) > 0) {
+		obp = obuf + n;
+		oflush();
+	    }
+	    fclose(tf[i]);
+	}
+	free(tf);
+    }
+    oflush();
+    free(sc);
+}
+
 static char *prog_name(char *s)
 {
     char *p = s + strlen(s);
@@ -496,6 +781,9 @@ static char *prog_name(char *s)
 static char *help_strings[] = {
  "usage: %s -r RECORD [OPTIONS ...]\n",
  "where RECORD is the name of the input record, and OPTIONS may include:",
+ " -b TYPE     write samples in binary format (TYPE is i16, i32, or f32);",
+ "              samples are written frame by frame, without sample numbers",
+ " -B TYPE     same as -b, but write all samples of each signal in turn",
  " -c          use CSV (comma-separated value) output format",
  " -f TIME     begin at specified time",
  " -h          print this usage summary",
@@ -1,5 +1,5 @@
 /* file: rxr.c		G. Moody	16 August 1989
-			Last revised:    24 April 2020
+			Last revised:    18 October 2026
 
 -------------------------------------------------------------------------------
 rxr: ANSI/AAMI-standard run-by-run annotation file comparator
@@ -48,22 +48,31 @@ extern void exit();
 #include <wfdb/wfdb.h>
 #include <wfdb/ecgcodes.h>
 
-char *pname;		/* name by which this program was invoked */
-char *record;
-WFDB_Anninfo an[2];
-WFDB_Annotation annot[2], tempann;
-int fflag = 3;
-FILE *ofile, *sfile;
-WFDB_Time start, end_time, match_dt;
-int verbose;
-long s[2][7][7];
+static char *pname;	/* name by which this program was invoked */
+static char *record;
+static WFDB_Anninfo an[2];
+static WFDB_Annotation annot[2], tempann;
+static int fflag = 3;
+static FILE *ofile, *sfile;
+static WFDB_Time start, end_time, match_dt;
+static int verbose;
+static long s[2][7][7];
 
 static void init(int argc, char *argv[]);
 static void print_results(int stat);
 static void rxr(int stat, int type);
+static int amap(WFDB_Annotation annot, unsigned int i);
+static void initamap(void);
 static int find_longest_run(unsigned int a, WFDB_Time t0, WFDB_Time t1, int type);
 static void help(void);
 static char *prog_name(char *s);
+void rxr_headings(FILE *fp, int type);
+
+#ifdef ECGEVAL		/* linked into ecgeval, which calls rxr_main() */
+#include "ecgeval.h"
+#define main rxr_main
+#define exit(status) ecgeval_exit(status)
+#endif
 
 int main(int argc, char *argv[])
 {
@@ -91,7 +100,6 @@ static void rxr(int stat, int type)
     int run_length[2];
     unsigned int a, b;
     WFDB_Time run_start, run_end;
-    void initamap();
 
     if (iannsettime(0L) < 0) exit(2);
 
@@ -296,9 +304,9 @@ static void pstat(char *s, long a, long b)
      `C'	end of unreadable segment
  */
 
-int inaf[2], invf[2], unreadable[2];	/* state variables for amap */
+static int inaf[2], invf[2], unreadable[2];	/* state variables for amap */
 
-int amap(WFDB_Annotation annot, unsigned int i)
+static int amap(WFDB_Annotation annot, unsigned int i)
 {
     switch (annot.anntyp) {
 	case NORMAL:
@@ -418,7 +426,7 @@ int amap(WFDB_Annotation annot, unsigned int i)
 }
 
 
-void initamap()		/* initialize state variables for amap() */
+static void initamap(void)	/* initialize state variables for amap() */
 {
     inaf[0] = inaf[1] = invf[0] = invf[1] = unreadable[0] = unreadable[1] = 0;
 }
@@ -553,8 +561,7 @@ static int find_longest_run(unsigned int a, WFDB_Time t0, WFDB_Time t1, int type
     return (len > len0 ? len : len0);
 }
 
-char *ofname = "-", *sfname;	/* filenames for reports */
-char *record;			/* record name */
+static char *ofname = "-", *sfname;	/* filenames for reports */
 
 static void init(int argc, char *argv[])
 {
@@ -723,6 +730,17 @@ static void init(int argc, char *argv[])
     if (annopen(record, an, 2) < 0) exit(2);
 }
 
+/* Write the column headings for line-format output of VE (type 0) or SVE
+   (type 1) run statistics to fp.  (This function is also used by ecgeval.) */
+void rxr_headings(FILE *fp, int type)
+{
+    if (type == 1)
+	(void)fprintf(fp, "(SVE run detection)\n");
+    (void)fprintf(fp,
+		  "Record CTs CFN CTp CFP STs SFN STp SFP LTs LFN LTp LFP");
+    (void)fprintf(fp, "  CSe C+P SSe S+P LSe L+P\n");
+}
+
 static void print_results(int type)	/* 0: VE; 1: SVE */
 {
     int i;
@@ -738,11 +756,8 @@ static void print_results(int type)	/* 0: VE; 1: SVE */
 				  pname, ofname);
 		    exit(3);
 		}
-		if (fflag == 2 || fflag == 5) {
-		    (void)fprintf(ofile,
-		     "Record CTs CFN CTp CFP STs SFN STp SFP LTs LFN LTp LFP");
-		    (void)fprintf(ofile, "  CSe C+P SSe S+P LSe L+P\n");
-		}
+		if (fflag == 2 || fflag == 5)
+		    rxr_headings(ofile, 0);
 	    }
 	    else {
 		(void)fclose(ofile);
@@ -765,11 +780,7 @@ static void print_results(int type)	/* 0: VE; 1: SVE */
 				  "%s: can't create %s\n", pname, sfname);
 		    exit(3);
 		}
-		(void)fprintf(ofile, "(SVE run detection)\n");
-		(void)fprintf(ofile,
-		     "Record CTs CFN CTp CFP STs SFN STp SFP LTs LFN LTp LFP");
-		(void)fprintf(ofile,
-			      "  CSe C+P SSe S+P LSe L+P\n");
+		rxr_headings(ofile, 1);
 	    }
 	    else {
 		(void)fclose(ofile);
@@ -1,5 +1,5 @@
 /* file: sigavg.c		G. Moody		25 November 2002
-
+			Last revised:	18 October 2026
 -------------------------------------------------------------------------------
 sigavg: Calculate averages of annotated waveforms
 Copyright (C) 2002 George B. Moody
@@ -28,13 +28,23 @@ This program is based on Example 9 in the WFDB Programmer's Guide.
 #include <wfdb/wfdb.h>
 #include <wfdb/ecgmap.h>
 
+#define MAXGAP	65536	/* seek over gaps of more than MAXGAP samples between
+			   windows; read through shorter gaps */
+
+struct window {		/* averaging window */
+    WFDB_Time t0;	/* time of the baseline sample preceding the window */
+    int type;		/* annotation type */
+};
+
 char *irec;	/* input record name */
 char *pname;	/* name by which this program was invoked */
 double sps;	/* sampling frequency (Hz) */
-double **sum;
-int dt1 = 0, dt2 = 0, flag[ACMAX+1], Hflag, nsig, vflag = 0, zflag = 0;
+double *sum[ACMAX+1];	/* sums for each annotation type (sum[0] if !cflag) */
+int cflag, dt1 = 0, dt2 = 0, flag[ACMAX+1], Hflag, nsig, vflag = 0, zflag = 0;
+int nw;		/* number of samples per signal in a window (dt2-dt1+1) */
+long nbeats[ACMAX+1];	/* number of beats in each average */
 WFDB_Anninfo ai;
-WFDB_Sample *v, *vb;
+WFDB_Sample *ring;	/* the most recent nw+1 frames, stored twice */
 WFDB_Siginfo *s;
 WFDB_Time from = 0L, to = 0L;
 
@@ -42,37 +52,132 @@ static char *prog_name(char *s);
 static void help(void);
 static void init(int argc, char *argv[]);
 static void memerr(void);
+static int wcmp(const void *a, const void *b);
+static void accumulate(double *sp, const WFDB_Sample *w, int n);
+static void print_average(int type);
 
 int main(int argc, char *argv[])
 {
-    int i, j, nbeats = 0;
+    int i, j, n, stat;
+    long k, maxw = 0L, nwin = 0L;
+    struct window *w = NULL;
     WFDB_Annotation annot;
+    WFDB_Time eof = -1L, t, tnext;
 
     init(argc, argv);	/* read and interpret command line */
 
-    while (getann(0, &annot) == 0 && annot.time < from)
+    /* Collect the averaging windows. */
+    while ((stat = getann(0, &annot)) == 0 && annot.time < from)
         ;
-    do {
+    if (stat == 0) do {
         if (flag[annot.anntyp] == 0) continue;
-        isigsettime(annot.time + dt1 - 1);
-        getvec(vb);
-        for (j = dt1; j <= dt2  && getvec(v) > 0; j++) {
-	    if (zflag)
-		for (i = 0; i < nsig; i++)
-		    sum[i][j-dt1] += v[i] - vb[i];
-	    else
-		for (i = 0; i < nsig; i++)
-		    sum[i][j-dt1] += v[i];
+	if (nwin >= maxw) {
+	    maxw = maxw ? 2*maxw : 1024;
+	    if ((w = realloc(w, maxw * sizeof(struct window))) == NULL)
+		memerr();
 	}
-        nbeats++;
+	/* A negative baseline time is treated as the corresponding positive
+	   time, as isigsettime does. */
+	if ((w[nwin].t0 = annot.time + dt1 - 1) < 0L) w[nwin].t0 = -w[nwin].t0;
+	w[nwin].type = annot.anntyp;
+	nbeats[cflag ? annot.anntyp : 0]++;
+	nwin++;
     } while (getann(0, &annot) == 0 &&
              (to == 0L || annot.time < to));
-    if (nbeats < 1) {
+    if (nwin < 1) {
         fprintf(stderr, "%s: no beats found\n", pname);
         exit(4);
     }
+    for (i = 0; i <= ACMAX; i++)
+	if (nbeats[i] > 0 &&
+	    (sum[i] = (double *)calloc(nw * nsig, sizeof(double))) == NULL) {
+	    wfdbquit();
+	    memerr();
+	}
+
+    /* Read the record once, in order of window time.  Each frame is stored in
+       the ring twice (at t % (nw+1) and nw+1 frames later), so that each window
+       is a contiguous block of the ring, beginning with its baseline frame. */
+    qsort(w, nwin, sizeof(struct window), wcmp);
+    n = nw + 1;
+    for (k = 0, t = tnext = -1L; k < nwin; k++) {
+	WFDB_Time t0 = w[k].t0, t1 = t0 + nw;
+
+	if (eof < 0L) {
+	    if (t < 0L || t0 > t + MAXGAP) {
+		if (isigsettime(t0) < 0) eof = t0;
+		t = t0;
+	    }
+	    for ( ; eof < 0L && t <= t1; t++) {
+		WFDB_Sample *v = ring + (t % n) * nsig;
+
+		if (getvec(v) < 0) eof = t;
+		else memcpy(v + n*nsig, v, nsig * sizeof(WFDB_Sample));
+	    }
+	}
+	/* If the window extends beyond the end of the record, average as
+	   much of it as is available. */
+	if (eof >= 0L && t1 >= eof) {
+	    if (t0 >= eof) continue;
+	    j = eof - t0 - 1;
+	}
+	else
+	    j = nw;
+	accumulate(sum[cflag ? w[k].type : 0], ring + (t0 % n) * nsig, j);
+    }
+    free(w);
+
+    if (cflag) {
+	for (i = 1, j = 0; i <= ACMAX; i++)
+	    if (nbeats[i] > 0) {
+		if (j++) printf("\n");
+		print_average(i);
+	    }
+    }
+    else
+	print_average(0);
+    exit(0);
+}
+
+/* wcmp compares averaging windows by time, for qsort. */
+static int wcmp(const void *a, const void *b)
+{
+    WFDB_Time ta = ((const struct window *)a)->t0,
+	tb = ((const struct window *)b)->t0;
+
+    return ((ta > tb) - (ta < tb));
+}
+
+/* accumulate adds n frames of a window to the sums at sp, which are stored
+   in frame order (sp[j*nsig + i] for sample j of signal i).  The window
+   begins at w with its baseline frame, which is subtracted if zflag is set;
+   the samples to be added follow it. */
+static void accumulate(double *sp, const WFDB_Sample *w, int n)
+{
+    int i, j;
+    const WFDB_Sample *v = w + nsig;
+
+    if (zflag)
+	for (j = 0; j < n; j++, sp += nsig, v += nsig)
+	    for (i = 0; i < nsig; i++)
+		sp[i] += v[i] - w[i];
+    else
+	for (j = n*nsig, i = 0; i < j; i++)
+	    sp[i] += v[i];
+}
+
+/* print_average prints the average of the beats of the specified type (or
+   of all selected beats, if type is 0). */
+static void print_average(int type)
+{
+    int i, j;
+    double *sp = sum[type];
+
+    if (cflag)
+	printf("# Average of %ld %s beats:\n", nbeats[type], annstr(type));
+    else if (vflag)
+	printf("# Average of %ld beats:\n", nbeats[type]);
     if (vflag) {
-	printf("# Average of %d beats:\n", nbeats);
 	printf("#     Time\t");
 	for (i = 0; i < nsig; i++)
 	    printf("%10s%c", s[i].desc, (i == nsig-1) ? '\n' : '\t');
@@ -82,18 +187,17 @@ int main(int argc, char *argv[])
 	    printf("%10s%c", s[i].units, (i == nsig-1) ? '\n' : '\t');
 	}
     }
-    for (j = dt1; j < dt2; j++) {
+    for (j = dt1; j < dt2; j++, sp += nsig) {
 	printf("%10.5lf\t", (double)j/sps);
         for (i = 0; i < nsig; i++) {
 	    double m;
 
-	    m = sum[i][j-dt1]/nbeats;
+	    m = sp[i]/nbeats[type];
 	    if (!zflag) m -= s[i].baseline;
 	    m /= s[i].gain;
             printf("%10.5lf%c", m, (i == nsig-1) ? '\n' : '\t');
 	}
     }
-    exit(0);
 }
 
 static void init(int argc, char **argv)
@@ -114,6 +218,9 @@ static void init(int argc, char **argv)
 	    ai.name = argv[i];
 	    ai.stat = WFDB_READ;
 	    break;
+	  case 'c':	/* calculate an average for each annotation type */
+	    cflag = 1;
+	    break;
 	  case 'd':
 	    if (++i >= argc-1) {
 		(void)fprintf(stderr, "%s: window offsets must follow -w\n",
@@ -198,11 +305,7 @@ static void init(int argc, char **argv)
 	setgvmode(WFDB_HIGHRES);
     if ((nsig = isigopen(irec, NULL, 0)) <= 0)
 	exit(2);
-    s = malloc((size_t)nsig * sizeof(WFDB_Siginfo));
-    v = (WFDB_Sample *)malloc((size_t)nsig * sizeof(WFDB_Sample));
-    vb = (WFDB_Sample *)malloc((size_t)nsig * sizeof(WFDB_Sample));
-    sum = (double **)malloc(nsig * sizeof(double *));
-    if (s == NULL || v == NULL || vb == NULL || sum == NULL)
+    if ((s = malloc((size_t)nsig * sizeof(WFDB_Siginfo))) == NULL)
 	memerr();
     if (wfdbinit(irec, &ai, 1, s, nsig) != nsig)
 	exit(2);
@@ -215,15 +318,15 @@ static void init(int argc, char **argv)
     }
     else if (dt1 == dt2)
 	dt2 += strtim(".1");
-    for (i = 0; i < nsig; i++)
-        if ((sum[i]=(double *)calloc(dt2-dt1+1,sizeof(double))) == NULL) {
-	    wfdbquit();
-	    memerr();
-        }
+    nw = dt2 - dt1 + 1;
+    if ((ring = (WFDB_Sample *)malloc(2 * (size_t)(nw+1) * nsig *
+				      sizeof(WFDB_Sample))) == NULL) {
+	wfdbquit();
+	memerr();
+    }
     if (from > 0L) {
 	from = strtim(argv[from]);
 	if (from < (WFDB_Time)0) from = -from;
-	(void)isigsettime(from);
     }
     if (to > 0L) {
 	to = strtim(argv[to]);
@@ -259,6 +362,7 @@ static char *prog_name(char *s)
 static char *help_strings[] = {
  "usage: %s -r RECORD -a ANNOTATOR [OPTIONS ...]\n",
  "where RECORD and ANNOTATOR specify the input, and OPTIONS may include:",
+ " -c                  calculate a separate average for each annotation type",
  " -d DT1 DT2          calculate the average over a window defined by offsets",
  "                      DT1 and DT2 from the input annotations (defaults:",
  "                      DT1 = -0.05, DT2 = 0.05 (seconds from annotations)",
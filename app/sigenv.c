@@ -0,0 +1,200 @@
+/* file: sigenv.c	WFDB contributors	18 October 2026
+
+-------------------------------------------------------------------------------
+sigenv: Summarize signals as envelopes (extremes and means over intervals)
+Copyright (C) 2026 WFDB contributors
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author by e-mail (wfdb@physionet.org) or postal mail
+(MIT Room E25-505A, Cambridge, MA 02139 USA).  For updates to this software,
+please visit PhysioNet (http://www.physionet.org/).
+_______________________________________________________________________________
+
+This program divides a segment of a record into N equal intervals, and prints
+the minimum, maximum, and mean of each signal in each interval, using the WFDB
+library's getenvelope function.  With the -w option, it writes the envelope
+file that getenvelope uses to summarize long intervals without reading the
+signals.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wfdb/wfdb.h>
+
+char *pname;
+
+static char *prog_name(char *s);
+static void help(void);
+
+int main(int argc, char *argv[])
+{
+    char *endp = NULL, *record = NULL, *startp = "0";
+    int i, n = 10, nsig, s, wflag = 0;
+    WFDB_Envelope *env;
+    WFDB_Siginfo *si;
+    WFDB_Time from, to;
+
+    pname = prog_name(argv[0]);
+    for (i = 1; i < argc; i++) {
+	if (*argv[i] == '-') switch (*(argv[i]+1)) {
+	  case 'f':	/* starting time */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: time must follow -f\n", pname);
+		exit(1);
+	    }
+	    startp = argv[i];
+	    break;
+	  case 'h':	/* help requested */
+	    help();
+	    exit(0);
+	    break;
+	  case 'H':	/* open the record in high resolution mode */
+	    setgvmode(WFDB_HIGHRES);
+	    break;
+	  case 'n':	/* number of intervals */
+	    if (++i >= argc || (n = atoi(argv[i])) < 1) {
+		(void)fprintf(stderr,
+			      "%s: positive integer must follow -n\n", pname);
+		exit(1);
+	    }
+	    break;
+	  case 'r':	/* record name */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: record name must follow -r\n",
+			      pname);
+		exit(1);
+	    }
+	    record = argv[i];
+	    break;
+	  case 't':	/* end time */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: time must follow -t\n", pname);
+		exit(1);
+	    }
+	    endp = argv[i];
+	    break;
+	  case 'w':	/* write the envelope file */
+	    wflag = 1;
+	    break;
+	  default:
+	    (void)fprintf(stderr, "%s: unrecognized option %s\n", pname,
+			  argv[i]);
+	    exit(1);
+	}
+	else {
+	    (void)fprintf(stderr, "%s: unrecognized argument %s\n", pname,
+			  argv[i]);
+	    exit(1);
+	}
+    }
+    if (record == NULL) {
+	help();
+	exit(1);
+    }
+
+    if ((nsig = isigopen(record, NULL, 0)) <= 0) exit(2);
+    if ((si = malloc(nsig * sizeof(WFDB_Siginfo))) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    if ((nsig = isigopen(record, si, nsig)) <= 0) exit(2);
+
+    if (wflag) {
+	if (putenvelope() < 0) exit(2);
+	wfdbquit();
+	exit(0);
+    }
+
+    if ((from = strtim(startp)) < 0L) from = -from;
+    if (endp == NULL) to = strtim("e");
+    else if ((to = strtim(endp)) < 0L) to = -to;
+    if (to <= from) {
+	if (to == 0L)
+	    (void)fprintf(stderr, "%s: record length unknown, use -t\n", pname);
+	else
+	    (void)fprintf(stderr, "%s: improper time interval\n", pname);
+	exit(1);
+    }
+
+    if ((env = malloc(n * nsig * sizeof(WFDB_Envelope))) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    if ((n = getenvelope(from, to, n, env)) < 0) exit(2);
+
+    (void)printf("    sample");
+    for (s = 0; s < nsig; s++)
+	(void)printf("\t%s (min, max, mean)", si[s].desc);
+    (void)printf("\n");
+    for (i = 0; i < n; i++) {
+	(void)printf("%10"WFDB_Pd_TIME, from + (to - from) * i / n);
+	for (s = 0; s < nsig; s++) {
+	    WFDB_Envelope *e = &env[i*nsig + s];
+
+	    if (e->nvalid > 0)
+		(void)printf("\t%6d %6d %8.2f", e->min, e->max, e->mean);
+	    else
+		(void)printf("\t     -      -        -");
+	    if (e->ninvalid > 0)
+		(void)printf(" (%ld invalid)", e->ninvalid);
+	}
+	(void)printf("\n");
+    }
+
+    wfdbquit();
+    exit(0);
+}
+
+static char *prog_name(char *s)
+{
+    char *p = s + strlen(s);
+
+#ifdef MSDOS
+    while (p >= s && *p != '\\' && *p != ':') {
+	if (*p == '.')
+	    *p = '\0';		/* strip off extension */
+	if ('A' <= *p && *p <= 'Z')
+	    *p += 'a' - 'A';	/* convert to lower case */
+	p--;
+    }
+#else
+    while (p >= s && *p != '/')
+	p--;
+#endif
+    return (p+1);
+}
+
+static char *help_strings[] = {
+ "usage: %s -r RECORD [OPTIONS ...]\n",
+ "where RECORD is the name of the input record, and OPTIONS may include:",
+ " -f TIME     begin at specified time",
+ " -h          print this usage summary",
+ " -H          read multifrequency signals in high resolution mode",
+ " -n N        divide the segment into N intervals (default: 10)",
+ " -t TIME     stop at specified time (default: end of record)",
+ " -w          write the envelope file for RECORD in the current directory,",
+ "              so that later summaries of the record can be made without",
+ "              reading its signals",
+NULL
+};
+
+static void help(void)
+{
+    int i;
+
+    (void)fprintf(stderr, help_strings[0], pname);
+    for (i = 1; help_strings[i] != NULL; i++)
+	(void)fprintf(stderr, "%s\n", help_strings[i]);
+}
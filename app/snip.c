@@ -1,5 +1,5 @@
 /* file: snip.c		G. Moody	30 July 1989
-               		Last revised:  18 August 2021
+               		Last revised:  18 October 2026
 -------------------------------------------------------------------------------
 snip: Copy an excerpt of a database record
 Copyright (C) 1989-2013 George B. Moody
@@ -27,6 +27,8 @@ _______________________________________________________________________________
 #include <wfdb/wfdb.h>
 #include <wfdb/wfdblib.h>
 
+#define RAWBUFSIZE	(1<<20)	/* maximum bytes per block in copy_raw */
+
 static char *pname;
 static int fmt = 0;	/* use specified output format if fmt > 0 */
 static int mflag = 0;	/* try to preserve segments if non-zero */
@@ -34,6 +36,10 @@ static int sflag = 0;	/* suppress copying info if non-zero */
 
 static char *prog_name(char *s);
 static void help(void);
+static int copy_raw(char *ofname, WFDB_Siginfo *si, int nsig, WFDB_Time from,
+		    WFDB_Time to);
+static long rawdecode(const unsigned char *p, long nbytes, int fmt,
+		      WFDB_Sample *v);
 
 int main(int argc, char *argv[])
 {
@@ -238,7 +244,7 @@ void copy_ann(char *nrec, char *irec, WFDB_Time from, WFDB_Time to,
 void copy_sig(char *nrec, char *irec, WFDB_Time from, WFDB_Time to, int recurse)
 {
     char *ofname, *p, *tstring = NULL;
-    int i, j, nsig, maxseg, maxres;
+    int i, j, nsig, maxseg, maxres, raw;
     WFDB_Time nsamp;
     WFDB_Sample *v;
     WFDB_Siginfo *si;
@@ -408,36 +414,228 @@ void copy_sig(char *nrec, char *irec, WFDB_Time from, WFDB_Time to, int recurse)
 	}
     }
 
-    /* Open the output signals. */
+    /* If the signal file can be copied without being reformatted, do so. */
     (void)sprintf(ofname, "%s.dat", nrec);
-    for (i = 0; i < nsig; i++) {
-	si[i].fname = ofname;
-	si[i].group = 0;
-	si[i].fmt = fmt;
-	si[i].spf = 1;
-    }
-    if (osigfopen(si, (unsigned)nsig) != nsig) exit(2);
+    raw = copy_raw(ofname, si, nsig, from, to);
+
+    if (!raw) {
+	/* Open the output signals. */
+	for (i = 0; i < nsig; i++) {
+	    si[i].fname = ofname;
+	    si[i].group = 0;
+	    si[i].fmt = fmt;
+	    si[i].spf = 1;
+	}
+	if (osigfopen(si, (unsigned)nsig) != nsig) exit(2);
 
-    /* Copy the selected segment. */
-    if (isigsettime(from) < 0) exit(2);
-    wfdbquiet();
-    nsamp = (to == 0L) ? -1L : to - from;
-    while (nsamp == -1L || nsamp-- > 0L) {
-	int stat = getvec(v);
-
-	if (stat > 0 || nsamp == 0L) putvec(v);
-	else break;
+	/* Copy the selected segment. */
+	if (isigsettime(from) < 0) exit(2);
+	wfdbquiet();
+	nsamp = (to == 0L) ? -1L : to - from;
+	while (nsamp == -1L || nsamp-- > 0L) {
+	    int stat = getvec(v);
+
+	    if (stat > 0 || nsamp == 0L) putvec(v);
+	    else break;
+	}
+	wfdbverbose();
     }
 
     /* Clean up. */
-    wfdbverbose();
-    free(ofname);
-    free(si);
-    free(v);
     setsampfreq(sampfreq(NULL));
     if (tstring) setbasetime(tstring);
     SFREE(tstring);
-    (void)newheader(nrec);
+    if (raw)
+	(void)setheader(nrec, si, (unsigned)nsig);
+    else
+	(void)newheader(nrec);
+    free(ofname);
+    free(si);
+    free(v);
+}
+
+/* copy_raw copies frames from through to-1 of the open input record into
+   ofname byte for byte, if this yields the signal file that getvec and putvec
+   would have produced.  This requires that all signals share a single input
+   file with no skew, that each signal has one sample per frame and is stored
+   in the output format, and that the excerpt begins and ends on a boundary
+   between packed groups of samples (for formats 212, 310, and 311).  The
+   samples are decoded only to obtain the checksums and initial values, which
+   are stored in si together with the other fields that the output header
+   needs.  copy_raw returns 1 if it copied the excerpt, or 0 (without having
+   written anything) if the excerpt must be copied using getvec and putvec. */
+static int copy_raw(char *ofname, WFDB_Siginfo *si, int nsig, WFDB_Time from,
+		    WFDB_Time to)
+{
+    int bits, bpu, first, fpu, i, spu;
+    long bsize, j, n, nbytes, ns, start, ubytes;
+    unsigned char *buf;
+    unsigned int *sum;
+    WFDB_FILE *ifp, *ofp;
+    WFDB_Sample *v;
+    WFDB_Seginfo *seginfo;
+    WFDB_Time endt;
+
+    /* Formats with fixed-size samples are packed as spu samples of the given
+       number of bits in bpu bytes. */
+    switch (fmt) {
+      case 80:	bits = 8;  spu = 1; bpu = 1; break;
+      case 16:
+      case 61:
+      case 160:	bits = 16; spu = 1; bpu = 2; break;
+      case 24:	bits = 24; spu = 1; bpu = 3; break;
+      case 32:	bits = 32; spu = 1; bpu = 4; break;
+      case 212:	bits = 12; spu = 2; bpu = 3; break;
+      case 310:
+      case 311:	bits = 10; spu = 3; bpu = 4; break;
+      default:	return (0);	/* difference or compressed formats */
+    }
+    if (getseginfo(&seginfo) > 0 || (getgvmode() & WFDB_GVPAD))
+	return (0);
+    for (i = 0; i < nsig; i++)
+	if (si[i].fmt != fmt || si[i].group != 0 || si[i].spf != 1 ||
+	    si[i].bsize != 0 || wfdbgetskew(i) != 0)
+	    return (0);
+
+    /* The excerpt must lie within the stated length of the record. */
+    endt = strtim("e");
+    if (to == 0L) to = endt;
+    if (endt <= 0L || to > endt || to <= from)
+	return (0);
+
+    /* Each unit of fpu frames fills ubytes bytes; the excerpt must consist
+       of whole units. */
+    fpu = (nsig % spu) ? spu : 1;
+    ubytes = (long)fpu * nsig / spu * bpu;
+    if (from % fpu || (to - from) % fpu)
+	return (0);
+    start = wfdbgetstart(0) + (long)(from / fpu) * ubytes;
+    nbytes = (long)((to - from) / fpu) * ubytes;
+
+    /* Check that the input file is long enough before writing anything. */
+    if ((ifp = wfdb_open(si[0].fname, (char *)NULL, WFDB_READ)) == NULL)
+	return (0);
+    if (wfdb_fseek(ifp, 0L, SEEK_END) != 0 ||
+	wfdb_ftell(ifp) < start + nbytes ||
+	wfdb_fseek(ifp, start, SEEK_SET) != 0) {
+	wfdb_fclose(ifp);
+	return (0);
+    }
+    if ((ofp = wfdb_open(ofname, (char *)NULL, WFDB_WRITE)) == NULL) {
+	fprintf(stderr, "%s: can't create %s\n", pname, ofname);
+	exit(2);
+    }
+
+    if ((bsize = (RAWBUFSIZE / ubytes) * ubytes) == 0L)
+	bsize = ubytes;
+    SUALLOC(buf, bsize, 1);
+    SUALLOC(v, bsize / bpu * spu, sizeof(WFDB_Sample));
+    SUALLOC(sum, nsig, sizeof(unsigned int));
+    for (first = 1; nbytes > 0L; nbytes -= n, first = 0) {
+	n = (nbytes < bsize) ? nbytes : bsize;
+	if (wfdb_fread(buf, 1, (size_t)n, ifp) != (size_t)n) {
+	    fprintf(stderr, "%s: error reading %s\n", pname, si[0].fname);
+	    exit(2);
+	}
+	if (wfdb_fwrite(buf, 1, (size_t)n, ofp) != (size_t)n) {
+	    fprintf(stderr, "%s: error writing %s\n", pname, ofname);
+	    exit(2);
+	}
+	ns = rawdecode(buf, n, fmt, v);
+	if (first)	/* getvec reports the lowest value as invalid */
+	    for (i = 0; i < nsig; i++)
+		si[i].initval = (v[i] == -1 << (bits - 1)) ?
+		    WFDB_INVALID_SAMPLE : v[i];
+	for (j = 0; j < ns; j += nsig)
+	    for (i = 0; i < nsig; i++)
+		sum[i] += v[j+i];
+    }
+    wfdb_fclose(ifp);
+    if (wfdb_fclose(ofp) != 0) {
+	fprintf(stderr, "%s: error writing %s\n", pname, ofname);
+	exit(2);
+    }
+
+    for (i = 0; i < nsig; i++) {
+	si[i].fname = ofname;
+	si[i].nsamp = to - from;
+	si[i].cksum = (int)(sum[i] & 0xffff);
+    }
+    SFREE(sum);
+    SFREE(v);
+    SFREE(buf);
+    return (1);
+}
+
+/* rawdecode unpacks the nbytes bytes at p, which contain samples in format
+   fmt, into v, and returns the number of samples.  Each group of packed
+   samples (3 bytes in format 212, 4 bytes in formats 310 and 311) must be
+   complete. */
+static long rawdecode(const unsigned char *p, long nbytes, int fmt,
+		      WFDB_Sample *v)
+{
+    const unsigned char *e = p + nbytes;
+    WFDB_Sample *v0 = v;
+    unsigned long x, y;
+
+    switch (fmt) {
+      case 80:
+	for ( ; p < e; p++)
+	    *v++ = (int)*p - 128;
+	break;
+      case 16:
+	for ( ; p < e; p += 2)
+	    *v++ = (int)((p[0] | p[1] << 8) ^ 0x8000) - 0x8000;
+	break;
+      case 61:
+	for ( ; p < e; p += 2)
+	    *v++ = (int)((p[1] | p[0] << 8) ^ 0x8000) - 0x8000;
+	break;
+      case 160:
+	for ( ; p < e; p += 2)
+	    *v++ = (int)(p[0] | p[1] << 8) - 0x8000;
+	break;
+      case 24:
+	for ( ; p < e; p += 3)
+	    *v++ = (long)((p[0] | p[1] << 8 | (unsigned long)p[2] << 16) ^
+			  0x800000) - 0x800000;
+	break;
+      case 32:
+	for ( ; p < e; p += 4) {
+	    x = p[0] | p[1] << 8 | (unsigned long)p[2] << 16 |
+		(unsigned long)p[3] << 24;
+	    *v++ = (x & 0x80000000) ? -(long)(0xffffffff - x) - 1 : (long)x;
+	}
+	break;
+      case 212:
+	for ( ; p < e; p += 3) {
+	    x = p[0] | (p[1] & 0xf) << 8;
+	    y = (p[1] & 0xf0) << 4 | p[2];
+	    *v++ = (int)(x ^ 0x800) - 0x800;
+	    *v++ = (int)(y ^ 0x800) - 0x800;
+	}
+	break;
+      case 310:
+	for ( ; p < e; p += 4) {
+	    x = p[0] | p[1] << 8;
+	    y = p[2] | p[3] << 8;
+	    *v++ = (int)(((x >> 1) & 0x3ff) ^ 0x200) - 0x200;
+	    *v++ = (int)(((y >> 1) & 0x3ff) ^ 0x200) - 0x200;
+	    *v++ = (int)((((x >> 11) & 0x1f) | ((y >> 6) & 0x3e0)) ^ 0x200) -
+		0x200;
+	}
+	break;
+      case 311:
+	for ( ; p < e; p += 4) {
+	    x = p[0] | p[1] << 8 | (unsigned long)p[2] << 16 |
+		(unsigned long)p[3] << 24;
+	    *v++ = (int)((x & 0x3ff) ^ 0x200) - 0x200;
+	    *v++ = (int)(((x >> 10) & 0x3ff) ^ 0x200) - 0x200;
+	    *v++ = (int)(((x >> 20) & 0x3ff) ^ 0x200) - 0x200;
+	}
+	break;
+    }
+    return (v - v0);
 }
 
 void copy_info(char *irec, char *startp)
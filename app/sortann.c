@@ -1,5 +1,5 @@
 /* file sortann.c	G. Moody	 7 April 1997
-			Last revised:	 24 April 2020
+			Last revised:	18 October 2026
 -------------------------------------------------------------------------------
 sortann: Rearrange annotations in canonical order
 Copyright (C) 1997-2010 George B. Moody
@@ -42,23 +42,35 @@ are sorted.
 If the input annotations are already in the correct order, no output is written
 unless you have used the -o option.
 
-If you attempt to sort a very large annotation file, sortann may run out of
-memory.  If this happens, use the -f and -t options to work on the file in
-sections of any convenient size, one at a time, then use mrgann to concatenate
-the sections.  Note that you must specify an output annotator name (with -o)
-when using the -f or -t options (to avoid replacing the entire input file with
-a sorted subset of its contents).
+Note that you must specify an output annotator name (with -o) when using the
+-f or -t options (to avoid replacing the entire input file with a sorted subset
+of its contents).
 
 The working memory required by sortann is approximately 10 times the size of
-the annotation file.  Since annotation files are rarely as large as 1 megabyte
-and available memory is rarely less than 10 megabytes, it is unlikely that
-sortann will exhaust available memory, however.
+the annotation file.  For very large annotation files, use the -m option to
+sort externally, holding no more than a specified number of annotations in
+memory at any time.  In this mode, the input is divided into runs.  Each run
+is sorted in memory (by several threads, each sorting a slice of the run),
+and written to a temporary file;  the runs are then merged to produce the
+output.  Stretches of the input that are already in order are not sorted, and
+once a full run of ordered input has been read, further annotations are copied
+directly to the current temporary file for as long as the input remains in
+order.  Each annotation carries its position in the input through the sort,
+so that the treatment of duplicate annotations is the same in both modes.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #ifndef __STDC__
 extern void exit();
 #endif
+#ifndef NOMKSTEMP
+#include <unistd.h>
+#endif
+#ifndef NOPTHREADS
+#include <pthread.h>
+#endif
 
 #include <wfdb/wfdb.h>
 #include <wfdb/ecgcodes.h>
@@ -71,10 +83,55 @@ struct annlistentry {
 
 static int in_order = 1;
 
+/* Variables used for external sorting (-m) */
+#define MAXRUNS	64	/* maximum number of temporary files open at once */
+#define MAXTHREADS 16	/* maximum number of threads used to sort a run */
+
+struct sann {		/* an annotation in the run buffer */
+    WFDB_Annotation a;	/* a.aux is not used (see auxoff) */
+    long seq;		/* position of the annotation in the input */
+    long auxoff;	/* offset of aux string in auxpool, or -1 if none */
+};
+
+struct srec {		/* an annotation in a temporary file */
+    WFDB_Time time;
+    long seq;
+    char anntyp;
+    signed char subtyp;
+    unsigned char chan;
+    signed char num;
+    short naux;		/* aux[0], or -1 if there is no aux string */
+};			/* followed by naux+1 bytes of aux (if naux >= 0) */
+
+struct source {		/* a sorted sequence of annotations to be merged */
+    FILE *fp;		/* temporary file, or NULL if reading from memory */
+    struct sann *p, *end;	/* next and end of a slice of the run buffer */
+    struct sann cur;	/* current annotation */
+    unsigned char *aux;	/* aux string of the current annotation */
+    unsigned char abuf[258];	/* aux string read from fp */
+};
+
+static long rmax;	/* maximum number of annotations in the run buffer */
+static long rlen;	/* number of annotations in the run buffer */
+static struct sann *rbuf;	/* the run buffer */
+static int rsorted;	/* non-zero if rbuf contents arrived in order */
+static char *auxpool;	/* aux strings of annotations in rbuf */
+static long auxlen, auxmax;
+static FILE *runs[MAXRUNS];	/* temporary files containing sorted runs */
+static int nruns;
+static int streaming;	/* non-zero while copying ordered input to a run */
+static int nthreads = 0;	/* number of threads used to sort a run */
+
 static char *prog_name(char *s);
 static void help(void);
 static void copybytes(char *dest, char *src, int n);
 static int insert_ann(WFDB_Annotation *pa);
+static int annlt(WFDB_Annotation *a, WFDB_Annotation *b);
+static void ext_init(void);
+static void ext_add(WFDB_Annotation *pa, long seq);
+static void ext_finish(void);
+static void ext_write(void);
+static void memerr(void);
 
 int main(int argc, char *argv[])
 {
@@ -113,6 +170,22 @@ int main(int argc, char *argv[])
 	    help();
 	    exit(0);
 	    break;
+	  case 'j':	/* number of sorting threads follows */
+	    if (++i >= argc || (nthreads = atoi(argv[i])) < 1) {
+		(void)fprintf(stderr,
+			      "%s: number of threads (> 0) must follow -j\n",
+			      pname);
+		exit(1);
+	    }
+	    break;
+	  case 'm':	/* maximum number of annotations in memory follows */
+	    if (++i >= argc || (rmax = atol(argv[i])) < 1L) {
+		(void)fprintf(stderr,
+		    "%s: maximum number of annotations (> 0) must follow -m\n",
+			      pname);
+		exit(1);
+	    }
+	    break;
 	  case 'o':	/* output annotator follows */
 	    if (++i >= argc) {
 		(void)fprintf(stderr, "%s: annotator must follow -o\n",
@@ -204,6 +277,36 @@ int main(int argc, char *argv[])
 	to = to * tps / sps + 0.5;
     }
 
+    if (rmax > 0L) {
+	/* Sort externally, in runs of no more than rmax annotations. */
+	WFDB_Annotation last;
+
+	ext_init();
+	while (getann(0, &annot) == 0) {
+	    if (annot.time < from || (to > 0L && annot.time >= to))
+		continue;
+	    if (nann > 0L && !annlt(&last, &annot))
+		in_order = 0;
+	    last = annot;
+	    ext_add(&annot, nann++);
+	}
+	iannclose(0);
+	if (in_order && ai[1].name == NULL) {
+	    fprintf(stderr,
+		    "%s: input is already ordered -- no output written\n",
+		    pname);
+	    exit(0);
+	}
+	ext_finish();
+	if (from == 0L && to == 0L && ai[1].name == NULL)
+	    ai[1].name = ai[0].name;
+	if (annopen(record, &ai[1], 1) < 0)
+	    exit(2);
+	ext_write();
+	wfdbquit();
+	exit(0);
+    }
+
     /* Build a linked list of annotations in memory. */
     while (getann(0, &annot) == 0) {
 	if (annot.time < from || (to > 0L && annot.time >= to))
@@ -281,7 +384,7 @@ static int insert_ann(WFDB_Annotation *pa)
 	   search is linear, beginning at the end of the list, which works
 	   well for nearly-ordered input. */
 	ap = lastp;
-	while (ap) {
+	while (ap != &annlist) {
 	    if (pa->time > (ap->annotation).time ||
 		(pa->time == (ap->annotation).time &&
 		 pa->num > (ap->annotation).num) ||
@@ -292,9 +395,9 @@ static int insert_ann(WFDB_Annotation *pa)
 	    }
 	    ap = ap->prev;
 	}
-	if (ap == NULL) {
+	if (ap == &annlist) {
 	    /* insert newp at the beginning of the list */
-	    newp->prev = NULL;
+	    newp->prev = &annlist;
 	    newp->next = annlist.next;
 	    (newp->next)->prev = annlist.next = newp;
 	}
@@ -305,7 +408,7 @@ static int insert_ann(WFDB_Annotation *pa)
 	    if (newp->next = ap->next) (newp->next)->prev = newp;
 	    else lastp = newp;
 	    if ((ap->annotation).aux) free((ap->annotation).aux);
-	    if (ap != &annlist) free(ap);
+	    free(ap);
 	}
 	else {	/* insert newp immediately after ap */
 	    newp->prev = ap;
@@ -324,6 +427,341 @@ void cleanup()	/* free the memory used for the annotation list */
     }
 }
 
+/* annlt returns non-zero if annotation a precedes annotation b in canonical
+   (time, num, chan) order. */
+static int annlt(WFDB_Annotation *a, WFDB_Annotation *b)
+{
+    if (a->time != b->time) return (a->time < b->time);
+    if (a->num != b->num) return (a->num < b->num);
+    return (a->chan < b->chan);
+}
+
+/* sanncmp orders annotations canonically, and simultaneous annotations with
+   equal num and chan fields by their positions in the input. */
+static int sanncmp(const void *p1, const void *p2)
+{
+    const struct sann *a = p1, *b = p2;
+
+    if (a->a.time != b->a.time) return (a->a.time < b->a.time ? -1 : 1);
+    if (a->a.num != b->a.num) return (a->a.num < b->a.num ? -1 : 1);
+    if (a->a.chan != b->a.chan) return (a->a.chan < b->a.chan ? -1 : 1);
+    return (a->seq < b->seq ? -1 : (a->seq > b->seq));
+}
+
+static void memerr(void)
+{
+    (void)fprintf(stderr, "%s: insufficient memory\n", pname);
+    exit(3);
+}
+
+/* Create an anonymous temporary file in the directory named by the TMPDIR
+   environment variable (default: /tmp).  The file is removed as soon as it
+   has been opened, so that it disappears when it is closed or when this
+   program exits. */
+static FILE *tmpspill(void)
+{
+    FILE *fp;
+#ifndef NOMKSTEMP
+    char *dir, *tfname;
+    int fd;
+
+    if ((dir = getenv("TMPDIR")) == NULL || *dir == '\0') dir = "/tmp";
+    if ((tfname = malloc(strlen(dir) + 16)) == NULL) memerr();
+    sprintf(tfname, "%s/sortannXXXXXX", dir);
+    if ((fd = mkstemp(tfname)) < 0 || (fp = fdopen(fd, "w+b")) == NULL)
+	fp = NULL;
+    else
+	(void)unlink(tfname);
+    free(tfname);
+#else
+    fp = tmpfile();
+#endif
+    if (fp == NULL) {
+	(void)fprintf(stderr, "%s: can't create a temporary file\n", pname);
+	exit(2);
+    }
+    return (fp);
+}
+
+static void ext_init(void)
+{
+    if (nthreads < 1) {
+#if !defined(NOPTHREADS) && defined(_SC_NPROCESSORS_ONLN)
+	nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if (nthreads < 1) nthreads = 1;
+    }
+    if (nthreads > MAXTHREADS) nthreads = MAXTHREADS;
+    if ((rbuf = (struct sann *)malloc(rmax * sizeof(struct sann))) == NULL)
+	memerr();
+    rsorted = 1;
+}
+
+/* Append an annotation to a temporary file. */
+static void spill(FILE *fp, WFDB_Annotation *pa, unsigned char *aux, long seq)
+{
+    struct srec r;
+
+    memset(&r, 0, sizeof(r));
+    r.time = pa->time; r.seq = seq;
+    r.anntyp = pa->anntyp; r.subtyp = pa->subtyp;
+    r.chan = pa->chan; r.num = pa->num;
+    r.naux = aux ? *aux : -1;
+    if (fwrite(&r, sizeof(r), 1, fp) != 1 ||
+	(aux && fwrite(aux, 1, *aux + 1, fp) != *aux + 1)) {
+	(void)fprintf(stderr, "%s: can't write a temporary file\n", pname);
+	exit(2);
+    }
+}
+
+/* Load the next annotation from a merge source;  return 0 at the end. */
+static int advance(struct source *sp)
+{
+    struct srec r;
+
+    if (sp->fp) {
+	if (fread(&r, sizeof(r), 1, sp->fp) != 1)
+	    return (0);
+	sp->cur.a.time = r.time; sp->cur.seq = r.seq;
+	sp->cur.a.anntyp = r.anntyp; sp->cur.a.subtyp = r.subtyp;
+	sp->cur.a.chan = r.chan; sp->cur.a.num = r.num;
+	if (r.naux >= 0) {
+	    if (fread(sp->abuf, 1, r.naux + 1, sp->fp) != r.naux + 1)
+		return (0);
+	    sp->abuf[r.naux + 1] = '\0';
+	    sp->aux = sp->abuf;
+	}
+	else
+	    sp->aux = NULL;
+	return (1);
+    }
+    if (sp->p >= sp->end)
+	return (0);
+    sp->cur = *(sp->p++);
+    sp->aux = (sp->cur.auxoff >= 0) ?
+	(unsigned char *)auxpool + sp->cur.auxoff : NULL;
+    return (1);
+}
+
+/* Merge n sources into a single sequence, passing each annotation to emit
+   (together with its aux string and its position in the input).  Of each group
+   of annotations with the same time, num, and chan fields, only the one that
+   occurred last in the input is passed on.  The merge uses a binary heap of
+   sources ordered by their current annotations. */
+static void merge(struct source *src, int n,
+		  void (*emit)(void *, WFDB_Annotation *, unsigned char *, long),
+		  void *arg)
+{
+    int i, j, k, nh = 0, *heap, pending = 0;
+    struct sann pend;
+    unsigned char pendaux[258], *pap = NULL;
+
+    if ((heap = (int *)malloc((n+1) * sizeof(int))) == NULL) memerr();
+#define HLT(x, y) (sanncmp(&src[heap[x]].cur, &src[heap[y]].cur) < 0)
+#define HSWAP(x, y) { int t = heap[x]; heap[x] = heap[y]; heap[y] = t; }
+    for (i = 0; i < n; i++)
+	if (advance(&src[i])) {
+	    heap[j = nh++] = i;
+	    while (j > 0 && HLT(j, (j-1)/2)) { HSWAP(j, (j-1)/2); j = (j-1)/2; }
+	}
+    while (nh > 0) {
+	struct source *sp = &src[heap[0]];
+
+	if (pending && (pend.a.time != sp->cur.a.time ||
+			pend.a.num != sp->cur.a.num ||
+			pend.a.chan != sp->cur.a.chan))
+	    (*emit)(arg, &pend.a, pap, pend.seq);
+	pend = sp->cur;
+	if (sp->aux) {
+	    copybytes((char *)pendaux, (char *)sp->aux, *(sp->aux) + 2);
+	    pap = pendaux;
+	}
+	else
+	    pap = NULL;
+	pending = 1;
+	if (!advance(sp)) heap[0] = heap[--nh];
+	for (j = 0; (k = 2*j+1) < nh; j = k) {	/* restore the heap */
+	    if (k+1 < nh && HLT(k+1, k)) k++;
+	    if (!HLT(k, j)) break;
+	    HSWAP(j, k);
+	}
+    }
+#undef HLT
+#undef HSWAP
+    if (pending)
+	(*emit)(arg, &pend.a, pap, pend.seq);
+    free(heap);
+}
+
+static void spill_emit(void *arg, WFDB_Annotation *pa, unsigned char *aux,
+		       long seq)
+{
+    spill((FILE *)arg, pa, aux, seq);
+}
+
+static void output_emit(void *arg, WFDB_Annotation *pa, unsigned char *aux,
+			long seq)
+{
+    if (pa->anntyp != NOTQRS) {
+	pa->aux = aux;
+	(void)putann(0, pa);
+    }
+}
+
+#ifndef NOPTHREADS
+static void *sortslice(void *arg)
+{
+    struct source *sp = arg;
+
+    qsort(sp->p, sp->end - sp->p, sizeof(struct sann), sanncmp);
+    return (NULL);
+}
+#endif
+
+/* Sort the run buffer as nslices slices (in parallel if possible), and set up
+   merge sources for the slices.  If the run buffer is already in order, it is
+   treated as a single slice. */
+static int sortrun(struct source *src)
+{
+    int i, n = rsorted ? 1 : nthreads;
+#ifndef NOPTHREADS
+    pthread_t tid[MAXTHREADS];
+    int started[MAXTHREADS];
+#endif
+
+    if (n > rlen / 1024 + 1) n = rlen / 1024 + 1;
+    for (i = 0; i < n; i++) {
+	src[i].fp = NULL;
+	src[i].p = rbuf + rlen * i / n;
+	src[i].end = rbuf + rlen * (i+1) / n;
+    }
+    if (rsorted) return (n);
+#ifndef NOPTHREADS
+    for (i = 1; i < n; i++)
+	started[i] = pthread_create(&tid[i], NULL, sortslice, &src[i]) == 0;
+    qsort(src[0].p, src[0].end - src[0].p, sizeof(struct sann), sanncmp);
+    for (i = 1; i < n; i++) {
+	if (started[i]) pthread_join(tid[i], NULL);
+	else sortslice(&src[i]);
+    }
+#else
+    for (i = 0; i < n; i++)
+	qsort(src[i].p, src[i].end - src[i].p, sizeof(struct sann), sanncmp);
+#endif
+    return (n);
+}
+
+/* Merge all of the temporary files into a single new one. */
+static void mergeruns(void)
+{
+    struct source *src;
+    FILE *fp = tmpspill();
+    int i;
+
+    if ((src = (struct source *)calloc(nruns, sizeof(struct source))) == NULL)
+	memerr();
+    for (i = 0; i < nruns; i++) {
+	src[i].fp = runs[i];
+	rewind(runs[i]);
+    }
+    merge(src, nruns, spill_emit, fp);
+    for (i = 0; i < nruns; i++)
+	fclose(runs[i]);
+    free(src);
+    runs[0] = fp;
+    nruns = 1;
+}
+
+/* Sort the contents of the run buffer and write them to a new temporary
+   file. */
+static void flushrun(void)
+{
+    struct source src[MAXTHREADS];
+    FILE *fp;
+    int n;
+
+    if (nruns >= MAXRUNS) mergeruns();
+    fp = runs[nruns++] = tmpspill();
+    n = sortrun(src);
+    merge(src, n, spill_emit, fp);
+    rlen = auxlen = 0L;
+    rsorted = 1;
+}
+
+/* Add an annotation to the current run. */
+static void ext_add(WFDB_Annotation *pa, long seq)
+{
+    static WFDB_Annotation last;
+    struct sann *sp;
+
+    if (streaming) {
+	if (annlt(&last, pa)) {	/* still in order:  copy it to the run */
+	    spill(runs[nruns-1], pa, pa->aux, seq);
+	    last = *pa;
+	    return;
+	}
+	streaming = 0;		/* begin a new run */
+    }
+    if (rlen > 0L && !annlt(&rbuf[rlen-1].a, pa))
+	rsorted = 0;
+    sp = &rbuf[rlen++];
+    sp->a = *pa;
+    sp->a.aux = NULL;
+    sp->seq = seq;
+    if (pa->aux) {
+	long n = *(pa->aux) + 2;
+
+	if (auxlen + n > auxmax) {
+	    auxmax = (auxmax > 0L) ? 2*auxmax : 4096L;
+	    if (auxmax < auxlen + n) auxmax = auxlen + n;
+	    if ((auxpool = realloc(auxpool, auxmax)) == NULL) memerr();
+	}
+	copybytes(auxpool + auxlen, (char *)pa->aux, n);
+	sp->auxoff = auxlen;
+	auxlen += n;
+    }
+    else
+	sp->auxoff = -1L;
+    if (rlen >= rmax) {
+	if (rsorted) {
+	    /* A full run arrived in order:  continue copying it to the same
+	       temporary file for as long as the input remains in order. */
+	    last = rbuf[rlen-1].a;
+	    flushrun();
+	    streaming = 1;
+	}
+	else
+	    flushrun();
+    }
+}
+
+/* Called after all input has been read;  the last run remains in memory. */
+static void ext_finish(void)
+{
+    int i;
+
+    for (i = 0; i < nruns; i++)
+	rewind(runs[i]);
+}
+
+/* Merge the runs and the contents of the run buffer into the output. */
+static void ext_write(void)
+{
+    struct source *src;
+    int i, n;
+
+    if ((src = (struct source *)calloc(nruns + MAXTHREADS,
+				       sizeof(struct source))) == NULL)
+	memerr();
+    for (i = 0; i < nruns; i++)
+	src[i].fp = runs[i];
+    n = (rlen > 0L) ? sortrun(src + nruns) : 0;
+    merge(src, nruns + n, output_emit, NULL);
+    for (i = 0; i < nruns; i++)
+	fclose(runs[i]);
+    free(src);
+}
+
 /* This function emulates memcpy (which is not universally available). */
 static void copybytes(char *dest, char *src, int n)
 {
@@ -355,6 +793,8 @@ static char *help_strings[] = {
  "where RECORD and ANNOTATOR specify the input, and OPTIONS may include:",
  " -f TIME    start at specified TIME",
  " -h         print this usage summary",
+ " -j N       use N threads to sort each run (with -m; default: one per CPU)",
+ " -m N       sort externally, keeping at most N annotations in memory",
  " -o OUTANN  write output as annotator OUTANN (required with -f or -t)",
  " -t TIME    stop at specified TIME",
  "The sorted output replaces the input if -o is omitted, the input is in",
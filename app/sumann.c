@@ -1,5 +1,5 @@
 /* file: sumann.c	G. Moody        5 February 1982
-			Last revised:    24 April 2020
+			Last revised:   18 October 2026
 
 -------------------------------------------------------------------------------
 sumann: Tabulates annotations
@@ -22,6 +22,10 @@ You may contact the author by e-mail (wfdb@physionet.org) or postal mail
 please visit PhysioNet (http://www.physionet.org/).
 _______________________________________________________________________________
 
+If the tabulation begins at the beginning of the record and includes all of
+the annotations, sumann uses the annotator summary from getannsummary (which
+is read from the annotator's summary file if there is a current one, and may
+be written to it using -w), rather than reading the annotation file.
 */
 
 #include <stdio.h>
@@ -43,15 +47,17 @@ static char *nstring[6] = {
 	"Both signals noisy" };
 
 static char *pname;
+static WFDB_Annsummary *as;
 
 static char *prog_name(char *s);
+static int nextann(WFDB_Annotation *annot);
 static void help(void);
 
 int main(int argc, char *argv[])
 {
     static WFDB_Anninfo ai;
     WFDB_Annotation annot;
-    int i, j, rhythm = 0, noise = 2, qflag = 0;
+    int i, j, rhythm = 0, noise = 2, qflag = 0, wflag = 0;
     static long tab[ACMAX+1], rtab[MAXR+1], ntab[6];
     static WFDB_Time rtime[MAXR+1], ntime[6], r0, n0, from_time, to_time;
     char *record = NULL;
@@ -162,6 +168,9 @@ int main(int argc, char *argv[])
 	    }
 	    to_time = i;
 	    break;
+	  case 'w':	/* write the annotator summary file */
+	    wflag = 1;
+	    break;
 	  default:
 	    (void)fprintf(stderr, "%s: unrecognized option %s\n",
 			  pname, argv[i]);
@@ -209,7 +218,18 @@ int main(int argc, char *argv[])
 	tt = from_time; from_time = to_time; to_time = tt;
     }
 
-    while (getann(0, &annot) >= 0 && (to_time == 0L || annot.time < to_time)) {
+    /* Use the annotator summary if the interval includes all of the
+       annotations.  Only its RHYTHM and NOISE annotations need be read. */
+    if ((from_time == 0L || wflag) &&
+	getannsummary(record, ai.name, &as) >= 0) {
+	if (wflag) (void)putannsummary(as);
+	if (from_time > 0L || (to_time > 0L && as->last >= to_time)) {
+	    freeannsummary(as);
+	    as = NULL;
+	}
+    }
+
+    while (nextann(&annot) >= 0 && (to_time == 0L || annot.time < to_time)) {
 	if (annot.time < from_time) {
 	    if (annot.anntyp == RHYTHM) {
 		r0 = from_time;
@@ -217,7 +237,7 @@ int main(int argc, char *argv[])
 		    if (annot.aux == NULL) break;
 		    else if (rstring[i] == NULL) {
 			if (rstring[i] =
-			    (char *)malloc((unsigned)(*annot.aux - 1))) {
+			    (char *)malloc((unsigned)*annot.aux)) {
 			    (void)strcpy(rstring[i], annot.aux+2);
 			    rhythm = i;
 			}
@@ -235,7 +255,7 @@ int main(int argc, char *argv[])
 	    }
 	    continue;
 	}
-	tab[annot.anntyp]++;
+	if (as == NULL) tab[annot.anntyp]++;
 	if (annot.anntyp == RHYTHM) {
 	    if (rhythm) {
 		rtab[rhythm]++;
@@ -245,7 +265,7 @@ int main(int argc, char *argv[])
 	    for (i = 1, rhythm = 0; i <= MAXR; i++)
 		if (annot.aux == NULL) break;
 	        else if (rstring[i] == NULL) {
-		    if (rstring[i] = (char *)malloc((unsigned)(*annot.aux-1))){
+		    if (rstring[i] = (char *)malloc((unsigned)*annot.aux)){
 			(void)strcpy(rstring[i], annot.aux+2);
 			rhythm = i;
 		    }
@@ -267,7 +287,12 @@ int main(int argc, char *argv[])
 	}
     }			
 
-    if (to_time == 0L) to_time = annot.time;
+    if (as) {
+	for (i = 1; i < ACMAX+1; i++)
+	    tab[i] = as->nanntyp[i];
+	if (to_time == 0L) to_time = as->last;
+    }
+    else if (to_time == 0L) to_time = annot.time;
     if (rhythm) {
 	rtab[rhythm]++;
 	rtime[rhythm] += to_time - r0;
@@ -348,6 +373,20 @@ static char *prog_name(char *s)
     return (p+1);
 }
 
+/* nextann reads the next annotation to be tabulated, from the episode table
+   of the annotator summary if it is being used, or from the annotator. */
+static int nextann(WFDB_Annotation *annot)
+{
+    static long k;
+
+    if (as == NULL)
+	return (getann(0, annot));
+    if (k >= as->nepisode)
+	return (-1);
+    *annot = as->episode[k++];
+    return (0);
+}
+
 static char *help_strings[] = {
  "usage: %s -r RECORD -a ANNOTATOR [OPTIONS ...]\n",
  "where RECORD and ANNOTATOR specify the input, and OPTIONS may include:",
@@ -356,6 +395,8 @@ static char *help_strings[] = {
  " -o BTAB RTAB  add summaries of beat and rhythm annotations to BTAB and RTAB",
  " -q            list only QRS annotations in the event table",
  " -t TIME       stop at specified TIME",
+ " -w            write the annotator summary file in the current directory, so",
+ "                that later summaries of the annotator can be made quickly",
  "If -o is not used, a readable summary is written to the standard output.",
  "",
  "Otherwise, BTAB and RTAB are names of files containing CSV-format tables.",
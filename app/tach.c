@@ -1,5 +1,5 @@
 /* file: tach.c		G. Moody	 18 April 1985
-               		Last revised:    24 April 2020
+               		Last revised:  18 October 2026
 
 -------------------------------------------------------------------------------
 tach: Generate heart rate vs. time signal with evenly spaced samples
@@ -44,20 +44,16 @@ none of these manipulations, although it usually attempts limited outlier
 rejection (`tach' maintains an estimate of the mean absolute deviation of its
 output, and replaces any output which is more than three times this amount from
 the previous value with the previous value).
+
+The heart rate signal is determined by the WFDB library's heart rate statistics
+functions (see newhrstats).
 */
 
 #include <stdio.h>
-#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include <wfdb/wfdb.h>
-#define map1
-#define map2
-#define ammap
-#define mamap
-#define annpos
-#include <wfdb/ecgmap.h>
-
-#define ABL	128	/* annotation buffer length (must be a power of 2) */
-#define beat(A)	(beatab[(A)&(ABL-1)])	/* time of beat A */
+
 #define RGAIN	100.0
 
 static char *irec, *orec, *pname;
@@ -69,13 +65,12 @@ static void help(void);
 
 int main(int argc, char *argv[])
 {
-    double sps, decf, dx, k=1., left, rdmax=40., right, rrcnt, rrate=80., x;
-    int i, Oflag = 0, vflag = 0, Vflag = 0;
-    WFDB_Time beatab[ABL], lastn, maxbt, minbt, n, start = 0L, end = 0L;
-    long max, min;
-
+    double sps, k=1., rrate=80.;
+    int i, j, Oflag = 0, stat = 1, vflag = 0, Vflag = 0;
+    WFDB_Time n, start = 0L, end = 0L;
     WFDB_Anninfo ai;
     WFDB_Annotation annot;
+    WFDB_Hrstats *h;
     WFDB_Siginfo si;
 
     pname = prog_name(argv[0]);
@@ -254,9 +249,14 @@ int main(int argc, char *argv[])
 
     if (iannsettime(start) < 0) exit(3);
 
-    decf = sps/ofreq;  	/* effective decimation factor */
-    n = start / decf;
-    lastn = end / decf;
+    if (newhrstats(sps, &h) < 0)
+	exit(2);
+    h->from = start;
+    h->to = end;
+    h->tachfreq = ofreq;
+    h->tachk = k;
+    h->tachreject = !Oflag;
+    h->tachrate = rrate;
 
     if (orec) {
 	static WFDB_Siginfo so;
@@ -271,64 +271,31 @@ int main(int argc, char *argv[])
 	if (osigfopen(&so, 1) < 1) exit(2);
     }
 
-    /* Read the first two beat annotations in the interval to be processed. */
-    while (getann(0, &annot) >= 0 && !isqrs(annot.anntyp))
-	;
-    beat(min = 0) = annot.time;
-    while (getann(0, &annot) >= 0 && !isqrs(annot.anntyp))
-	;
-    beat(max = 1) = annot.time;
-
-    /* Process the remainder of the annotations. */
-    while (lastn == 0L || n < lastn) {
-	left = decf * (n - k); right = decf * (n + k);	/* window limits */
-	while ((maxbt = beat(max)) < right) { /* read beats to right edge */
-	    if ((++max - min) > ABL) {  /* buffer full */
-		(void)fprintf(stderr,
-			      "%s: annotation buffer overflow\n", pname);
-		cleanup();
-		exit(6);
+    /* Process the annotations. */
+    while (stat > 0 && getann(0, &annot) >= 0 &&
+	   (stat = hrstatsann(h, &annot)) >= 0) {
+	for (j = 0, n = h->tachn; j < h->ntach; j++, n++) {
+	    rrate = h->tach[j];
+	    if (orec) {
+		int v = (int)(rrate*RGAIN + 0.5);
+
+		if (putvec(&v) < 1) { stat = 0; break; }
 	    }
-	    do {
-		if (getann(0, &annot) < 0) { /* quit at end of record */
-		    cleanup();
-		    exit(0);
+	    else {
+		switch (Vflag) {
+		  case 1: (void)printf("%g\t", n/ofreq); break;
+		  case 2: (void)printf("%g\t", n/(ofreq*60.0)); break;
+		  case 3: (void)printf("%g\t", n/(ofreq*3600.0)); break;
 		}
-	    } while (!isqrs(annot.anntyp));
-	    beat(max) = annot.time;
-	}
-	while ((minbt = beat(min)) <= left)
-	    min++;	/* advance to first beat past left edge */
-	if (min > 0L)	/* get number of RR intervals in window */
-	    rrcnt = max - min + (minbt - left) / (minbt - beat(min-1))
-			      - (maxbt - right) / (maxbt - beat(max-1));
-	else		/* handle samples between start and first beat */
-	    rrcnt = (beat(0) - start > beat(1) - beat(0)) ?
-			(2. * decf * k) / (beat(0) - start) :
-			(2. * decf * k) / (beat(1) - beat(0));
-	x = ofreq * 30. * rrcnt / k;  /* beats per minute */
-	if (!Oflag) {	/* attempt to detect and reject outliers */
-	    if ((dx = x - rrate) < 0.) dx = -dx;
-	    if (dx > 3.*rdmax) x = rrate;
-	    rdmax += (dx - rdmax)/20.;
-	    if (rdmax < 1.) rdmax = 1.;
-	}
-	rrate = x;
-	if (orec) {
-	    int v = (int)(rrate*RGAIN + 0.5);
-
-	    if (putvec(&v) < 1) break;
-	}
-	else {
-	    switch (Vflag) {
-	      case 1: (void)printf("%g\t", n/ofreq); break;
-	      case 2: (void)printf("%g\t", n/(ofreq*60.0)); break;
-	      case 3: (void)printf("%g\t", n/(ofreq*3600.0)); break;
+		if (vflag) (void)printf("%"WFDB_Pd_TIME"\t", n);
+		(void)printf("%g\n", rrate);
 	    }
-	    if (vflag) (void)printf("%"WFDB_Pd_TIME"\t", n);
-	    (void)printf("%g\n", rrate);
 	}
-	n++;
+    }
+    if (stat < 0) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	cleanup();
+	exit(2);
     }
     cleanup();
     exit(0);	/*NOTREACHED*/
@@ -1,5 +1,5 @@
 /* file: wfdbmap.c	G. Moody       	22 March 2009
-			Last revised:	4 November 2020
+			Last revised:	18 October 2026
 
 -------------------------------------------------------------------------------
 wfdbmap: generates a 'plt' script to make a PostScript map of a WFDB record
@@ -35,6 +35,7 @@ static char *pname;
 static WFDB_Anninfo *ai = NULL;
 static WFDB_Siginfo *si = NULL;
 static int mflag = 0;
+static int sflag = 0;
 static int spm;
 
 static char *prog_name(char *s);
@@ -93,6 +94,9 @@ int main(int argc, char *argv[])
 	    }
 	    record = argv[i];
 	    break;
+	  case 's':	/* map valid samples of fixed-layout records */
+	    sflag = 1;
+	    break;
 	  default:
 	    (void)fprintf(stderr, "%s: unrecognized option %s\n",
 			  pname, argv[i]);
@@ -156,15 +160,13 @@ int main(int argc, char *argv[])
 
     if (length < 1) {	/* try to get length from annotation file(s) */
         int alen;
-        WFDB_Annotation annot;
-	WFDB_Time t;
+	WFDB_Annsummary *as;
 
         for (i = 0; i < nann; i++) {
-	    if (annopen(record, &ai[i], 1) < 0) continue;
-	    while (getann(0, &annot) >= 0)
-	        t = annot.time;
-	    alen = (t + (spm-1))/spm;
+	    if (getannsummary(record, ai[i].name, &as) < 0) continue;
+	    alen = (as->last + (spm-1))/spm;
 	    if (alen > length) length = alen;
+	    freeannsummary(as);
 	}
     }
 
@@ -225,7 +227,20 @@ void map_sig(char *record, WFDB_Siginfo *si, int nsig, int **map, int length)
 {
     if (si[0].nsamp == strtim("e") || si[0].nsamp != 0) {
 	/* fixed-layout record */
-        int i, t;
+        int i, n, t;
+	WFDB_Envelope *env;
+
+	/* If requested, or if the record's envelope file is available, map
+	   only the minutes in which each signal has valid samples. */
+	if ((sflag || wfdbfile("env", record)) &&
+	    (env = malloc(length * nsig * sizeof(WFDB_Envelope))) != NULL) {
+	    n = getenvelope(0L, (WFDB_Time)length * spm, length, env);
+	    for (t = 0; t < n; t++)
+		for (i = 0; i < nsig; i++)
+		    map[i][t] = (env[t*nsig + i].nvalid > 0);
+	    free(env);
+	    if (n >= 0) return;
+	}
 	for (i = 0; i < nsig; i++)
 	    for (t = 0; t < length; t++)
 		map[i][t] = 1;
@@ -465,6 +480,9 @@ static char *help_strings[] = {
  "usage: %s -r RECORD -a ANNOTATOR [OPTIONS ...]\n",
  "where RECORD and ANNOTATOR specify the input, and OPTIONS may include:",
  " -h       print this usage summary",
+ " -m       print the map only (not a plt script)",
+ " -s       map the minutes in which each signal has valid samples (the",
+ "           default if RECORD has an envelope file)",
 NULL
 };
 
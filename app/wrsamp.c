@@ -1,5 +1,5 @@
 /* file: wrsamp.c	G. Moody	10 August 1993
-			Last revised:     18 May 2022
+			Last revised:  18 October 2026
 
 -------------------------------------------------------------------------------
 wrsamp: Select fields or columns from a file and generate a WFDB record
@@ -26,14 +26,24 @@ _______________________________________________________________________________
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#ifndef NOPTHREADS
+#include <pthread.h>
+#endif
 #include <wfdb/wfdb.h>
 
 /* The following definition yields dither with a triangular PDF in (-1,1). */
 #define DITHER	        (((double)rand() + (double)rand())/RAND_MAX - 1.0)
 
+#define IBUFSIZE   (1 << 22)	/* initial size of the input buffer (bytes) */
+#define MAXTHREADS 16	/* maximum number of threads used to parse input */
+
 static char *pname;
 static unsigned int ncols = 0;
 static unsigned int nosig = 0;
+static int *fv;		/* input column number for each output signal */
+static double *scalef;	/* scale factor for each output signal */
 
 static char *prog_name(char *s);
 static void help(void);
@@ -189,19 +199,225 @@ Tokenarray *parseline(char *line, Parsemode *pmode)
     return (ta);
 }
 
+/* The sample lines of the input are read in large blocks into ibuf, which
+contains iblen bytes, of which the first ibpos have been processed.  Each block
+is split into lines (without copying them), and the lines are converted by
+parsefast(), in parallel if several threads are available.  The converted
+samples are then written by putvec() in input order. */
+
+static char *ibuf;
+static size_t ibsize, iblen, ibpos;
+static int ibeof;
+
+/* Read as much input as will fit in ibuf, after moving any unprocessed bytes
+   to the beginning of ibuf.  If ibuf is full of unprocessed input (a line
+   longer than the buffer), its size is doubled first. */
+static void fillbuf(FILE *ifile)
+{
+    size_t n;
+
+    if (ibpos > 0) {
+	memmove(ibuf, ibuf + ibpos, iblen - ibpos);
+	iblen -= ibpos;
+	ibpos = 0;
+    }
+    if (iblen >= ibsize) {
+	ibsize = ibsize ? 2*ibsize : IBUFSIZE;
+	SREALLOC(ibuf, ibsize, 1);
+    }
+    while (iblen < ibsize && (n = fread(ibuf + iblen, 1, ibsize - iblen,
+					 ifile)) > 0)
+	iblen += n;
+    if (iblen < ibsize) ibeof = 1;
+}
+
+/* Return the next line of buffered input (null-terminated, without the
+   separator), or NULL if there are no more complete lines.  As with
+   read_line(), an incomplete line at the end of the input is ignored. */
+static char *nextline(FILE *ifile, char rsep)
+{
+    char *p;
+
+    while ((p = memchr(ibuf + ibpos, rsep, iblen - ibpos)) == NULL) {
+	if (ibeof) return (NULL);
+	fillbuf(ifile);
+    }
+    *p = '\0';
+    p = ibuf + ibpos;
+    ibpos += strlen(p) + 1;
+    return (p);
+}
+
+/* Character classes for parsefast(): CDELIM marks field separators, and
+   CSPECIAL marks characters that require the full parseline() treatment
+   (quotes, escapes, and embedded nulls). */
+#define CDATA	 0
+#define CDELIM	 1
+#define CSPECIAL 2
+static char cclass[256];
+static char *needcol;	/* non-zero for each column that is copied */
+
+/* Convert the token that begins at s and ends before e as sscanf("%lf")
+   would, returning 1 and setting *v if successful, or 0 otherwise.  Ordinary
+   decimal numbers with no more than 18 significant digits and small exponents
+   are converted directly;  since the mantissa and the power of ten are both
+   exact, a single multiplication or division yields the correctly rounded
+   result.  Anything else is passed to sscanf. */
+static int getnum(const char *s, const char *e, double *v)
+{
+    static const double p10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+	1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+	1e20, 1e21, 1e22 };
+    char tbuf[64], *tp = tbuf;
+    const char *p = s;
+    int ex = 0, esign = 1, fd = 0, nd = 0, neg = 0, ok;
+    unsigned long long m = 0;
+
+    while (p < e && (*p == ' ' || *p == '\t' || *p == '\r'))
+	p++;
+#if FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 1
+    if (p < e && (*p == '-' || *p == '+'))
+	neg = (*p++ == '-');
+    for ( ; p < e && '0' <= *p && *p <= '9'; p++, nd++)
+	m = 10*m + (*p - '0');
+    if (p < e && *p == '.')
+	for (p++; p < e && '0' <= *p && *p <= '9'; p++, nd++, fd++)
+	    m = 10*m + (*p - '0');
+    if (nd == 0 || nd > 18) goto slow;
+    if (p < e && (*p == 'e' || *p == 'E')) {
+	int n = 0;
+
+	if (++p < e && (*p == '-' || *p == '+'))
+	    esign = (*p++ == '-') ? -1 : 1;
+	for ( ; p < e && '0' <= *p && *p <= '9' && n < 4; p++, n++)
+	    ex = 10*ex + (*p - '0');
+	if (n == 0) goto slow;
+    }
+    if (p != e) goto slow;
+    ex = esign*ex - fd;
+    if (m == 0) *v = 0.0;
+    else if (m > (1ULL << 53) || ex < -22 || ex > 22) goto slow;
+    else if (ex < 0) *v = (double)m / p10[-ex];
+    else *v = (double)m * p10[ex];
+    if (neg) *v = -*v;
+    return (1);
+
+  slow:
+#endif
+    if (e - s >= sizeof(tbuf) && (tp = malloc(e - s + 1)) == NULL)
+	return (0);
+    memcpy(tp, s, e - s);
+    tp[e - s] = '\0';
+    ok = (sscanf(tp, "%lf", v) == 1);
+    if (tp != tbuf) free(tp);
+    return (ok);
+}
+
+/* Split the line that begins at p and ends before e into fields, and convert
+   the selected fields, storing the scaled values and validity flags for each
+   output signal in val[] and ok[].  The column values are kept temporarily in
+   cval[] and cok[].  parsefast() returns 0 if successful, or -1 if the line
+   must be parsed by parseline() instead. */
+static int parsefast(char *p, char *e, double *val, char *ok, double *cval,
+		     char *cok)
+{
+    char *s;
+    int c, i;
+
+    for (c = 0; p < e; c++) {
+	while (p < e && cclass[(unsigned char)*p] == CDELIM)
+	    p++;
+	if (p >= e) break;
+	for (s = p; p < e && cclass[(unsigned char)*p] == CDATA; p++)
+	    ;
+	if (p < e && cclass[(unsigned char)*p] == CSPECIAL)
+	    return (-1);
+	if (c < ncols && needcol[c])
+	    cok[c] = getnum(s, p, &cval[c]);
+    }
+    for (i = 0; i < nosig; i++) {
+	if (fv[i] < c && cok[fv[i]]) {
+	    val[i] = cval[fv[i]] * scalef[i];
+	    ok[i] = 1;
+	}
+	else
+	    ok[i] = 0;
+    }
+    return (0);
+}
+
+/* Line status codes set by parselines() */
+#define LFAST	0	/* converted by parsefast() */
+#define LSLOW	1	/* to be converted by parseline() */
+#define LXMLEND	2	/* end of WFDB-XML sample vectors */
+
+struct parsejob {
+    char **lp;		/* lp[i] and lp[i+1]-1 delimit line i */
+    long first, last;	/* lines to be parsed by this job */
+    int xml;		/* non-zero if input is WFDB-XML */
+    double *val;	/* scaled values for each line and signal */
+    char *ok;		/* validity flags for each line and signal */
+    char *st;		/* status (LFAST, LSLOW, LXMLEND) of each line */
+    double *cval;	/* workspace for parsefast() */
+    char *cok;
+};
+
+static void *parselines(void *arg)
+{
+    struct parsejob *j = arg;
+    long i;
+
+    for (i = j->first; i < j->last; i++) {
+	char *p = j->lp[i], *e = j->lp[i+1] - 1;
+
+	if (j->xml && e - p >= 16 && strncmp(p, "</samplevectors>", 16) == 0)
+	    j->st[i] = LXMLEND;
+	else if (parsefast(p, e, j->val + i*nosig, j->ok + i*nosig,
+			   j->cval, j->cok) < 0)
+	    j->st[i] = LSLOW;
+	else
+	    j->st[i] = LFAST;
+    }
+    return (NULL);
+}
+
+/* Convert a scaled input value to a sample, adding dither if requested. */
+static WFDB_Sample tosample(double v, int dflag)
+{
+    if (dflag) v+= DITHER;
+    if (v >= 0) return ((WFDB_Sample)(v + 0.5));
+    else return ((WFDB_Sample)(v - 0.5));
+}
+
+/* Convert a line using parseline(). */
+static void parseslow(char *line, WFDB_Sample *vout, int dflag)
+{
+    int i;
+
+    ta = parseline(line, NULL);
+    for (i = 0; i < nosig; i++) {
+	double v;
+
+	if (fv[i] < ta->ntokens && sscanf(ta->token[fv[i]], "%lf", &v) == 1)
+	    vout[i] = tosample(v * scalef[i], dflag);
+	else
+	    vout[i] = WFDB_INVALID_SAMPLE;
+    }
+}
+
 int main(int argc, char *argv[])
 {
     char **ap, *cp, **desc, *gain = "", *ifname = "(stdin)",
 	*line = NULL, ofname[40], *p, *record = NULL, rsep = '\n',
 	*scale = "", sflag = 0, trim = 0, Xflag = 0, **units;
     static char btime[25], **dstrings, **ustrings;
-    double freq = WFDB_DEFFREQ, *scalef, v;
+    double freq = WFDB_DEFFREQ, v;
 
-    int c, cf = 0, dflag = 0, format = 16, *fv = NULL, i, j, mf, zflag = 0;
+    int c, cf = 0, dflag = 0, format = 16, i, j, mf, nthreads = 1,
+	zflag = 0;
     FILE *ifile = stdin;
     long t = 0L, t0 = 0L, t1 = 0L;
 
-    Tokenarray *ta;
     WFDB_Sample *vout;
     WFDB_Siginfo *si;
 
@@ -258,6 +474,18 @@ int main(int argc, char *argv[])
 	    }
 	    ifname = argv[i];
 	    break;
+	  case 'j':	/* number of parsing threads follows */
+	    if (++i >= argc || (nthreads = atoi(argv[i])) < 1) {
+		(void)fprintf(stderr, "%s: number of threads must follow -j\n",
+			      pname);
+		exit(1);
+	    }
+#ifdef NOPTHREADS
+	    nthreads = 1;
+#else
+	    if (nthreads > MAXTHREADS) nthreads = MAXTHREADS;
+#endif
+	    break;
 	  case 'l':
 	    if (++i >= argc) --i;
 	    (void)fprintf(stderr, "%s: -l is obsolete, ignored\n", pname);
@@ -533,33 +761,128 @@ int main(int argc, char *argv[])
 	}
     }
 
-    /* read and copy samples */
-    while (line != NULL && (t1 == 0L || t++ < t1)) {
-	ta = parseline(line, NULL);
+    /* read and copy samples:  first the line already read, then the rest of
+       the input, in blocks */
+    if (line != NULL && (t1 == 0L || t++ < t1)) {
+	parseslow(line, vout, dflag);
+	if (putvec(vout) < 0) line = NULL;
+    }
+    else
+	line = NULL;
+    if (line != NULL) {
+	char **lp = NULL, *ok = NULL, *st = NULL;
+	double *val = NULL;
+	long k, maxlines = 0, nl;
+	int done = 0, n;
+	struct parsejob job[MAXTHREADS];
+#ifndef NOPTHREADS
+	pthread_t tid[MAXTHREADS];
+	int started[MAXTHREADS];
+#endif
 
-	for (i = 0; i < nosig; i++) {
-	    double v;
+	cclass['"'] = cclass['\''] = cclass['<'] = cclass[0] = CSPECIAL;
+	if (defpmode.esc) cclass[(unsigned char)defpmode.esc] = CSPECIAL;
+	for (p = defpmode.delim; *p; p++)
+	    cclass[(unsigned char)*p] = CDELIM;
+	SUALLOC(needcol, ncols, 1);
+	for (i = 0; i < nosig; i++)
+	    needcol[fv[i]] = 1;
+	for (i = 0; i < nthreads; i++) {
+	    SUALLOC(job[i].cval, ncols, sizeof(double));
+	    SUALLOC(job[i].cok, ncols, 1);
+	}
 
-	    if (sscanf(ta->token[fv[i]], "%lf", &v) == 1) {
-		v *= scalef[i];
-		if (dflag) v+= DITHER;
-		if (v >= 0) vout[i] = (WFDB_Sample)(v + 0.5);
-		else vout[i] = (WFDB_Sample)(v - 0.5);
+	while (!done) {
+	    /* Find the complete lines in the buffer. */
+	    char *bp, *be;
+
+	    if (!ibeof) fillbuf(ifile);
+	    bp = ibuf + ibpos;
+	    be = ibuf + iblen;
+	    for (nl = 0; bp < be && (p = memchr(bp, rsep, be - bp)); nl++) {
+		if (nl + 1 >= maxlines) {
+		    maxlines = maxlines ? 2*maxlines : 65536;
+		    SREALLOC(lp, maxlines, sizeof(char *));
+		    SREALLOC(st, maxlines, 1);
+		    SREALLOC(val, maxlines * nosig, sizeof(double));
+		    SREALLOC(ok, maxlines * nosig, 1);
+		}
+		lp[nl] = bp;
+		bp = p + 1;
 	    }
-	    else
-		vout[i] = WFDB_INVALID_SAMPLE;
-	}
-	if (putvec(vout) < 0) break;
+	    if (nl == 0) {
+		if (ibeof) break;	/* an incomplete line is ignored */
+		continue;		/* a long line:  read more */
+	    }
+	    lp[nl] = bp;
+
+	    /* Convert them. */
+	    if ((n = nthreads) > nl/1024 + 1) n = nl/1024 + 1;
+	    for (i = 0; i < n; i++) {
+		job[i].lp = lp;
+		job[i].first = nl * i / n;
+		job[i].last = nl * (i+1) / n;
+		job[i].xml = Xflag;
+		job[i].val = val;
+		job[i].ok = ok;
+		job[i].st = st;
+	    }
+#ifndef NOPTHREADS
+	    for (i = 1; i < n; i++)
+		started[i] = pthread_create(&tid[i], NULL, parselines,
+					    &job[i]) == 0;
+	    parselines(&job[0]);
+	    for (i = 1; i < n; i++) {
+		if (started[i]) pthread_join(tid[i], NULL);
+		else parselines(&job[i]);
+	    }
+#else
+	    for (i = 0; i < n; i++)
+		parselines(&job[i]);
+#endif
 
-	line = read_line(ifile, rsep);
-	if (line && Xflag && strncmp(line, "</samplevectors>", 16) == 0) {
-	    if (line = read_line(ifile, rsep))
-		if (strcmp(line, "</wfdbsampleset>")) {
-		    fprintf(stderr, 
+	    /* Write them. */
+	    for (k = 0; k < nl && !done; k++) {
+		if (t1 > 0L && t++ >= t1) {
+		    done = 1;
+		    break;
+		}
+		if (st[k] == LXMLEND) {
+		    ibpos = lp[k+1] - ibuf;
+		    if ((line = nextline(ifile, rsep)) != NULL &&
+			strcmp(line, "</wfdbsampleset>")) {
+			fprintf(stderr,
 			  "%s: (warning) unexpected EOF in XML input\n", pname);
+		    }
+		    done = 1;
+		    break;
 		}
-	    break;
+		if (st[k] == LSLOW) {
+		    *(lp[k+1] - 1) = '\0';
+		    parseslow(lp[k], vout, dflag);
+		}
+		else {
+		    double *vp = val + k*nosig;
+		    char *op = ok + k*nosig;
+
+		    for (i = 0; i < nosig; i++)
+			vout[i] = op[i] ? tosample(vp[i], dflag) :
+			    WFDB_INVALID_SAMPLE;
+		}
+		if (putvec(vout) < 0) done = 1;
+	    }
+	    if (!done) ibpos = lp[nl] - ibuf;
+	}
+	for (i = 0; i < nthreads; i++) {
+	    SFREE(job[i].cval);
+	    SFREE(job[i].cok);
 	}
+	SFREE(lp);
+	SFREE(st);
+	SFREE(val);
+	SFREE(ok);
+	SFREE(needcol);
+	SFREE(ibuf);
     }
 
     /* write the header */
@@ -606,6 +929,7 @@ static char *help_strings[] = {
  " -G GAIN     specify gain(s) to be written to header file (default: 200)",
  " -h          print this usage summary",
  " -i FILE     read input from FILE (default: standard input)",
+ " -j N        convert the input using N threads (default: 1)",
  " -o RECORD   save output in RECORD.dat, and generate a header file for",
  "              RECORD (default: write to standard output in format 16, do",
  "              not generate a header file)",
@@ -1,5 +1,5 @@
 /* file: xform.c	G. Moody        8 December 1983
-			Last revised:     18 May 2022
+			Last revised:  18 October 2026
 -------------------------------------------------------------------------------
 xform: Sampling frequency, amplitude, and format conversion for WFDB records
 Copyright (C) 1983-2010 George B. Moody
@@ -27,15 +27,57 @@ _______________________________________________________________________________
 #include <stdlib.h>
 #include <wfdb/wfdb.h>
 #include <wfdb/ecgcodes.h>
+#ifndef NOPTHREADS
+#include <pthread.h>
+#endif
+
+/* With -l, records are converted by separate processes, since the WFDB
+   library is not reentrant. */
+#if defined(MSDOS) || defined(_WIN32)
+#define NOFORK
+#else
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
 
 /* The following definition yields dither with a triangular PDF in (-1,1). */
 #define DITHER	        (((double)rand() + (double)rand())/RAND_MAX - 1.0)
 
+#define BLOCKLEN	1024	/* number of input frames per block */
+#define NBLOCKS		8	/* number of blocks in the pipeline */
+
+struct block {		/* a block of frames */
+    long nin;		/* number of input frames (0: end of input) */
+    long nout;		/* number of output frames */
+    int *in;		/* input frames (BLOCKLEN * iframelen samples) */
+    int *out;		/* output frames (maxout * oframelen samples) */
+};
+
 static char *pname;
 static char *prog_name(char *s);
 static char *script = NULL;
 static double gcd(double x, double y);
 static void help(void);
+static long readblock(int *in);
+static long xblock(const int *in, long nin, int *out);
+static int writeblock(const int *out, long nout);
+static void block_alloc(struct block *b);
+#ifndef NOPTHREADS
+static void pipeline(void);
+#endif
+#ifndef NOFORK
+static WFDB_Siginfo *read_template(char *orec, int *ntmpl);
+static int run_list(char *list, int njobs, char **irec, char **nrec);
+#endif
+
+/* Variables used by readblock, xblock, and writeblock. */
+static double *gain;	/* gain[i]: scale factor for output signal i */
+static int clip, dflag, fflag, gflag, iframelen, lflag, m, Mflag, mn,
+    *msiglist, n, nisig, nminutes, nosig, oframelen, *ospf, *siglist, *v,
+    *vmax, *vmin, *vv, *deltav;
+static long maxout;	/* maximum number of output frames per block */
+static WFDB_Time it, nsamp = -1L, nsm, ot, spm;
 
 static char *script_fgets(char *buffer, size_t length, FILE *f)
 {
@@ -53,18 +95,15 @@ static char *script_fgets(char *buffer, size_t length, FILE *f)
 
 int main(int argc, char *argv[])
 {
-    char btstring[30], **description, **filename, *irec = NULL, *orec = NULL,
-	*nrec = NULL, *startp = "0:0", **units;
-    double *gain, ifreq, ofreq = 0.0;
-    int clip = 0, *deltav, dflag = 0, fflag = 0, gflag = 0, Hflag = 0, i,
-	iframelen, j, m, Mflag = 0, mn, *msiglist, n, nann = 0, nisig,
-	nminutes = 0, nosig = 0, oframelen, reopen = 0, sflag = 0,
-	*siglist = NULL, spf, uflag = 0, use_irec_desc = 1, *v, *vin, *vmax,
-	*vmin, *vout, vt, *vv;
-    WFDB_Time from = 0L, it = 0L, nsamp = -1L, nsm = 0L, ot = 0L, spm, to = 0L;
+    char btstring[30], **description, **filename, *irec = NULL, *list = NULL,
+	*orec = NULL, *nrec = NULL, *startp = "0:0", **units;
+    double ifreq, ofreq = 0.0;
+    int Hflag = 0, i, j, nann = 0, njobs = 1, ntmpl = 0, reopen = 0,
+	sflag = 0, spf, uflag = 0, use_irec_desc = 1, *vin;
+    WFDB_Time from = 0L, to = 0L;
     WFDB_Anninfo *ai = NULL;
     WFDB_Annotation annot;
-    WFDB_Siginfo *dfin, *dfout;
+    WFDB_Siginfo *dfin, *dfout, *tmpl = NULL;
 
     pname = prog_name(argv[0]);
 
@@ -117,6 +156,13 @@ int main(int argc, char *argv[])
 	  case 'H':	/* open the input record in `high resolution' mode */
 	    Hflag = 1;
 	    break;
+	  case 'j':	/* number of threads or concurrent conversions follows */
+	    if (++i >= argc || (njobs = atoi(argv[i])) < 1) {
+		(void)fprintf(stderr, "%s: number of jobs must follow -j\n",
+			      pname);
+		exit(1);
+	    }
+	    break;
 	  case 'i':	/* input record name follows */
 	    if (++i >= argc) {
 		(void)fprintf(stderr, "%s: input record name must follow -i\n",
@@ -125,6 +171,14 @@ int main(int argc, char *argv[])
 	    }
 	    irec = argv[i];
 	    break;
+	  case 'l':	/* list of input and new record names follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: file name must follow -l\n",
+			      pname);
+		exit(1);
+	    }
+	    list = argv[i];
+	    break;
 	  case 'M':	/* multifrequency mode (no frequency changes) */
 	    Mflag = 1;
 	    break;
@@ -204,6 +258,33 @@ int main(int argc, char *argv[])
 	}
     }
 
+    /* If a list of records was specified, convert each of them (in a child
+       process that continues below) and exit. */
+    if (list) {
+	if (irec || nrec) {
+	    (void)fprintf(stderr,
+			  "%s: -l cannot be used with -i, -n, or -N\n", pname);
+	    exit(1);
+	}
+	if (orec == NULL) {
+	    (void)fprintf(stderr, "%s: -l requires -o\n", pname);
+	    exit(1);
+	}
+#ifdef NOFORK
+	(void)fprintf(stderr, "%s: -l is not supported on this system\n",
+		      pname);
+	exit(1);
+#else
+	tmpl = read_template(orec, &ntmpl);
+	if (run_list(list, njobs, &irec, &nrec) != 0)
+	    exit(1);		/* parent: some conversions failed */
+	if (irec == NULL)
+	    exit(0);		/* parent: all conversions succeeded */
+	lflag = 1;		/* child: convert irec to nrec */
+	njobs = 1;
+#endif
+    }
+
     /* Check that an input record was specified. */
     if (irec == NULL) {
 	help();
@@ -275,6 +356,7 @@ int main(int argc, char *argv[])
 	    (gain = malloc(nosig * sizeof(double))) == NULL ||
 	    (deltav = malloc(nosig * sizeof(int))) == NULL ||
 	    (msiglist = malloc(nosig * sizeof(int))) == NULL ||
+	    (ospf = malloc(nosig * sizeof(int))) == NULL ||
 	    (v = malloc(nosig * sizeof(int))) == NULL ||
 	    (vmax = malloc(nosig * sizeof(int))) == NULL ||
 	    (vmin = malloc(nosig * sizeof(int))) == NULL ||
@@ -305,8 +387,7 @@ int main(int argc, char *argv[])
 	iframelen = nisig;
 	oframelen = nosig;
     }
-    if ((vin = malloc(iframelen * sizeof(int))) == NULL ||
-	(vout = malloc(oframelen * sizeof(int))) == NULL) {
+    if ((vin = malloc(iframelen * sizeof(int))) == NULL) {
 	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
 	exit(2);
     }
@@ -645,20 +726,45 @@ int main(int argc, char *argv[])
     if (nosig == 0) exit(0);
 
     /* Check that the input signals are readable. */
-    (void)fprintf(stderr, "Checking input signals ...");
+    if (!lflag) (void)fprintf(stderr, "Checking input signals ...");
     if (isigsettime(from) < 0)
 	exit(2);
-    (void)fprintf(stderr, " done\n");
-
-     /* If an output record was specified using `-o', check that the output
-       signals are writable.  Suppress warning messages about possible
-       sampling frequency differences. */
-    wfdbquiet();
-    if (orec && (osigopen(orec, dfout, (unsigned)nosig) != nosig)) {
-	(void)fprintf(stderr, "%s: can't write output signals\n", pname);
-	exit(2);
+    if (!lflag) (void)fprintf(stderr, " done\n");
+
+    /* If records are being converted from a list (-l), the output record
+       (-o) is a template, and the output signals are written to files named
+       after the new record. */
+    if (lflag) {
+	if (ntmpl < nosig) {
+	    (void)fprintf(stderr, "%s: record %s has too few signals\n",
+			  pname, orec);
+	    exit(2);
+	}
+	for (i = 0; i < nosig; i++) {
+	    dfout[i] = tmpl[i];
+	    if ((dfout[i].fname = malloc(strlen(nrec) + 16)) == NULL) {
+		(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+		exit(2);
+	    }
+	    if (tmpl[ntmpl-1].group == 0)
+		(void)sprintf(dfout[i].fname, "%s.dat", nrec);
+	    else
+		(void)sprintf(dfout[i].fname, "%s.d%d", nrec, tmpl[i].group);
+	}
+	reopen = 1;
+    }
+
+    /* Otherwise, if an output record was specified using `-o', check that
+       the output signals are writable.  Suppress warning messages about
+       possible sampling frequency differences. */
+    else {
+	wfdbquiet();
+	if (orec && (osigopen(orec, dfout, (unsigned)nosig) != nosig)) {
+	    (void)fprintf(stderr, "%s: can't write output signals\n", pname);
+	    exit(2);
+	}
+	wfdbverbose();
     }
-    wfdbverbose();
 
     /* Make sure that signal file format is not 0 (putvec cannot write to
        a null record). */
@@ -831,266 +937,23 @@ int main(int argc, char *argv[])
 	}
     }
 
-    /* Process the signals. */
-    if (fflag == 0 && gflag == 0) {	/* no frequency or gain changes */
-      if (Mflag == 0) {			/* standard mode */
-	while (getvec(vin) >= nisig && (nsamp == -1L || nsamp-- > 0L)) {
-	    if (++nsm >= spm) {
-		nsm = 0L;
-		(void)fprintf(stderr, ".");
-		(void)fflush(stderr);
-		if (++nminutes >= 60) {
-		    nminutes = 0;
-		    (void)fprintf(stderr, "\n");
-		}
-	    }
-	    for (i = 0; i < nosig; i++) {
-		if ((vt = vin[siglist[i]]) == WFDB_INVALID_SAMPLE)
-		    vout[i] = vt;
-		else {
-		    vout[i] = vt + deltav[i];
-		    if (vout[i] > vmax[i]) {
-			(void)fprintf(stderr, "v[%d] = %d (out of range)\n",
-				      i, vout[i]);
-			if (clip) vout[i] = vmax[i];
-			else vmax[i] = vout[i];
-		    }
-		    else if (vout[i] < vmin[i]) {
-			(void)fprintf(stderr, "v[%d] = %d (out of range)\n",
-				      i, vout[i]);
-			if (clip) vout[i] = vmin[i];
-			else vmin[i] = vout[i];
-		    }
-		}
-	    }
-	    if (putvec(vout) < 0) break;
-	}
-      }
-      else {				/* multifrequency mode */
-	while (getframe(vin) >= nisig && (nsamp == -1L || nsamp-- > 0L)) {
-	    int j, k;
-
-	    if (++nsm >= spm) {
-		nsm = 0L;
-		(void)fprintf(stderr, ".");
-		(void)fflush(stderr);
-		if (++nminutes >= 60) {
-		    nminutes = 0;
-		    (void)fprintf(stderr, "\n");
-		}
-	    }
-	    for (i = j = 0; i < nosig; i++) {
-	      for (k = 0; k < dfout[i].spf; j++, k++) {
-		if ((vt = vin[msiglist[i] + k]) == WFDB_INVALID_SAMPLE)
-		    vout[j] = vt;
-		else {
-		    vout[j] = vt + deltav[i];
-		    if (vout[j] > vmax[i]) {
-			(void)fprintf(stderr, "v[%d] = %d (out of range)\n",
-				      i, vout[j]);
-			if (clip) vout[j] = vmax[i];
-			else vmax[i] = vout[j];
-		    }
-		    else if (vout[j] < vmin[i]) {
-			(void)fprintf(stderr, "v[%d] = %d (out of range)\n",
-				      i, vout[j]);
-			if (clip) vout[j] = vmin[i];
-			else vmin[i] = vout[j];
-		    }
-		}
-	      }
-	    }
-	    if (putvec(vout) < 0) break;
-	}
-      }
-    }
-    else if (fflag == 0 && gflag != 0) {	/* change gain only */
-      if (Mflag == 0) {			/* standard mode */
-	while (getvec(vin) >= nisig && (nsamp == -1L || nsamp-- > 0L)) {
-	    if (++nsm >= spm) {
-		nsm = 0L;
-		(void)fprintf(stderr, ".");
-		(void)fflush(stderr);
-		if (++nminutes >= 60) {
-		    nminutes = 0;
-		    (void)fprintf(stderr, "\n");
-		}
-	    }
-	    for (i = 0; i < nosig; i++) {
-		if ((vt = vin[siglist[i]]) == WFDB_INVALID_SAMPLE)
-		    vout[i] = vt;
-		else {
-		    double vd = vt*gain[i] + deltav[i];
-
-		    if (dflag) vd += DITHER;
-		    if (vd >= 0) vout[i] = (int)(vd + 0.5);
-		    else vout[i] = (int)(vd - 0.5);
-		    if (vout[i] > vmax[i]) {
-			(void)fprintf(stderr, "v[%d] = %d (out of range)\n",
-				      i, vout[i]);
-			if (clip) vout[i] = vmax[i];
-			else vmax[i] = vout[i];
-		    }
-		    else if (vout[i] < vmin[i]) {
-			(void)fprintf(stderr, "v[%d] = %d (out of range)\n",
-				      i, vout[i]);
-			if (clip) vout[i] = vmin[i];
-			else vmin[i] = vout[i];
-		    }
-		}
-	    }
-	    if (putvec(vout) < 0) break;
-	}
-      }
-      else {				/* multifrequency mode */
-	while (getframe(vin) >= nisig && (nsamp == -1L || nsamp-- > 0L)) {
-	    int j, k;
-
-	    if (++nsm >= spm) {
-		nsm = 0L;
-		(void)fprintf(stderr, ".");
-		(void)fflush(stderr);
-		if (++nminutes >= 60) {
-		    nminutes = 0;
-		    (void)fprintf(stderr, "\n");
-		}
-	    }
-	    for (i = j = 0; i < nosig; i++) {
-	      for (k = 0; k < dfout[i].spf; j++, k++) {
-		if ((vt = vin[msiglist[i] + k]) == WFDB_INVALID_SAMPLE)
-		    vout[j] = vt;
-		else {
-		    double vd = vt*gain[i] + deltav[i];
-
-		    if (dflag) vd += DITHER;
-		    if (vd >= 0) vout[j] = (int)(vd + 0.5);
-		    else vout[j] = (int)(vd - 0.5);
-		    if (vout[j] > vmax[i]) {
-			(void)fprintf(stderr, "v[%d] = %d (out of range)\n",
-				      i, vout[j]);
-			if (clip) vout[j] = vmax[i];
-			else vmax[i] = vout[j];
-		    }
-		    else if (vout[j] < vmin[i]) {
-			(void)fprintf(stderr, "v[%d] = %d (out of range)\n",
-				      i, vout[j]);
-			if (clip) vout[j] = vmin[i];
-			else vmin[i] = vout[j];
-		    }
-		}
-	      }
-	    }
-	    if (putvec(vout) < 0) break;
-	}
-      }
-    }
-    else if (fflag != 0 && gflag == 0) {	/* change frequency only */
-	while (getvec(vin) >= nisig && (nsamp == -1L || nsamp-- > 0L)) {
-	    if (++nsm >= spm) {
-		nsm = 0L;
-		(void)fprintf(stderr, ".");
-		(void)fflush(stderr);
-		if (++nminutes >= 60) {
-		    nminutes = 0;
-		    (void)fprintf(stderr, "\n");
-		}
-	    }
-	    for (i = 0; i < nosig; i++) {
-		if ((vt = vin[siglist[i]]) == WFDB_INVALID_SAMPLE)
-		    v[i] = vt;
-		else
-		    v[i] = vt + deltav[i];
-	    }
-	    while (ot <= it) {
-		double x = (ot%n == 0) ? 1.0 : (double)(ot % n)/(double)n;
-		for (i = 0; i < nosig; i++) {
-		    if (v[i] == WFDB_INVALID_SAMPLE ||
-			vv[i] == WFDB_INVALID_SAMPLE)
-			vout[i] = WFDB_INVALID_SAMPLE;
-		    else {
-			double vd = vv[i] + x*(v[i]-vv[i]);
-
-			if (dflag) vd += DITHER;
-			if (vd >= 0) vout[i] = (int)(vd + 0.5);
-			else vout[i] = (int)(vd - 0.5);
-			if (vout[i] > vmax[i]) {
-			    (void)fprintf(stderr,"v[%d] = %d (out of range)\n",
-					  i, vout[i]);
-			    if (clip) vout[i] = vmax[i];
-			    else vmax[i] = vout[i];
-			}
-			else if (vout[i] < vmin[i]) {
-			    (void)fprintf(stderr,"v[%d] = %d (out of range)\n",
-					  i, vout[i]);
-			    if (clip) vout[i] = vmin[i];
-			    else vmin[i] = vout[i];
-			}
-		    }
-		}
-		if (putvec(vout) < 0) { nsamp = 0L; break; }
-		ot += m;
-	    }
-	    for (i = 0; i < nosig; i++)
-		vv[i] = v[i];
-	    if (it > mn) { it -= mn; ot -= mn; }
-	    it += n;
-	}
-    }
-    else if (fflag != 0 && gflag != 0) {	/* change frequency and gain */
-	while (getvec(vin) >= nisig && (nsamp == -1L || nsamp-- > 0L)) {
-	    if (++nsm >= spm) {
-		nsm = 0L;
-		(void)fprintf(stderr, ".");
-		(void)fflush(stderr);
-		if (++nminutes >= 60) {
-		    nminutes = 0;
-		    (void)fprintf(stderr, "\n");
-		}
-	    }
-	    for (i = 0; i < nosig; i++) {
-		if ((vt = vin[siglist[i]]) == WFDB_INVALID_SAMPLE)
-		    v[i] = vt;
-		else {
-		    double vd = vt*gain[i] + deltav[i];
-
-		    if (dflag) vd += DITHER;
-		    if (vd >= 0) v[i] = (int)(vd + 0.5);
-		    else v[i] = (int)(vd - 0.5);
-		}
-	    }
-	    while (ot <= it) {
-		double x = (ot%n == 0) ? 1.0 : (double)(ot % n)/(double)n;
-		for (i = 0; i < nosig; i++) {
-		    if (v[i] == WFDB_INVALID_SAMPLE ||
-			vv[i] == WFDB_INVALID_SAMPLE)
-			vout[i] = WFDB_INVALID_SAMPLE;
-		    else {
-			double vd =  vv[i] + x*(v[i]-vv[i]);
+    /* Process the signals, one block of frames at a time.  With -j, the
+       blocks are read, transformed, and written by three threads at once. */
+    for (i = 0; i < nosig; i++)
+	ospf[i] = dfout[i].spf;
+    maxout = fflag ? BLOCKLEN * (n/m + 2) : BLOCKLEN;
+#ifndef NOPTHREADS
+    if (njobs > 1)
+	pipeline();
+    else
+#endif
+    {
+	struct block b;
 
-			if (dflag) vd += DITHER;
-			if (vd >= 0) vout[i] = (int)(vd + 0.5);
-			else vout[i] = (int)(vd - 0.5);
-			if (vout[i] > vmax[i]) {
-			    (void)fprintf(stderr,"v[%d] = %d (out of range)\n",
-					  i, vout[i]);
-			    if (clip) vout[i] = vmax[i];
-			    else vmax[i] = vout[i];
-			}
-			else if (vout[i] < vmin[i]) {
-			    (void)fprintf(stderr,"v[%d] = %d (out of range)\n",
-					  i, vout[i]);
-			    if (clip) vout[i] = vmin[i];
-			    else vmin[i] = vout[i];
-			}
-		    }
-		}
-		if (putvec(vout) < 0) { nsamp = 0L; break; }
-		ot += m;
-	    }
-	    for (i = 0; i < nosig; i++)
-		vv[i] = v[i];
-	    if (it > mn) { it -= mn; ot -= mn; }
-	    it += n;
+	block_alloc(&b);
+	while ((b.nin = readblock(b.in)) > 0) {
+	    b.nout = xblock(b.in, b.nin, b.out);
+	    if (writeblock(b.out, b.nout) < 0) break;
 	}
     }
     if (nminutes > 0) (void)fprintf(stderr, "\n");
@@ -1142,6 +1005,371 @@ int main(int argc, char *argv[])
 }
 
 
+/* readblock reads up to BLOCKLEN input frames into in, and returns the number
+   of frames read (0 at the end of the input or of the interval to be
+   converted). */
+static long readblock(int *in)
+{
+    static int done;
+    long k;
+
+    if (done) return (0L);
+    for (k = 0L; k < BLOCKLEN; k++, in += iframelen) {
+	if ((Mflag ? getframe(in) : getvec(in)) < nisig ||
+	    !(nsamp == -1L || nsamp-- > 0L)) {
+	    done = 1;
+	    break;
+	}
+	if (!lflag && ++nsm >= spm) {
+	    nsm = 0L;
+	    (void)fprintf(stderr, ".");
+	    (void)fflush(stderr);
+	    if (++nminutes >= 60) {
+		nminutes = 0;
+		(void)fprintf(stderr, "\n");
+	    }
+	}
+    }
+    return (k);
+}
+
+/* scale returns the (valid) sample vt of output signal i, shifted and (if
+   necessary) rescaled and rounded. */
+static int scale(int i, int vt)
+{
+    double vd;
+
+    if (gflag == 0)
+	return (vt + deltav[i]);
+    vd = vt*gain[i] + deltav[i];
+    if (dflag) vd += DITHER;
+    return (vd >= 0 ? (int)(vd + 0.5) : (int)(vd - 0.5));
+}
+
+/* range checks that x is a legal sample value for output signal i, and
+   returns x or (with -c) the nearest legal value. */
+static int range(int i, int x)
+{
+    if (x > vmax[i]) {
+	(void)fprintf(stderr, "v[%d] = %d (out of range)\n", i, x);
+	if (clip) x = vmax[i];
+	else vmax[i] = x;
+    }
+    else if (x < vmin[i]) {
+	(void)fprintf(stderr, "v[%d] = %d (out of range)\n", i, x);
+	if (clip) x = vmin[i];
+	else vmin[i] = x;
+    }
+    return (x);
+}
+
+/* xblock transforms nin input frames from in into output frames in out,
+   and returns the number of output frames. */
+static long xblock(const int *in, long nin, int *out)
+{
+    int i, j, k, vt;
+    long f, nout = 0L;
+
+    for (f = 0L; f < nin; f++, in += iframelen) {
+	if (fflag == 0 && Mflag == 0 && dflag == 0) {
+	    /* Scale all signals in one branch-free pass (a gain of 1 yields
+	       vt + deltav[i] exactly), then check the results. */
+	    for (i = 0; i < nosig; i++) {
+		double vd = in[siglist[i]]*gain[i] + deltav[i];
+		int x = vd >= 0 ? (int)(vd + 0.5) : (int)(vd - 0.5);
+
+		out[i] = (in[siglist[i]] == WFDB_INVALID_SAMPLE) ?
+		    WFDB_INVALID_SAMPLE : x;
+	    }
+	    for (i = 0; i < nosig; i++)
+		if (in[siglist[i]] != WFDB_INVALID_SAMPLE &&
+		    (out[i] > vmax[i] || out[i] < vmin[i]))
+		    out[i] = range(i, out[i]);
+	    out += oframelen;
+	    nout++;
+	}
+	else if (fflag == 0) {
+	    for (i = j = 0; i < nosig; i++) {
+		for (k = 0; k < (Mflag ? ospf[i] : 1); j++, k++) {
+		    vt = Mflag ? in[msiglist[i] + k] : in[siglist[i]];
+		    out[j] = (vt == WFDB_INVALID_SAMPLE) ? vt :
+			range(i, scale(i, vt));
+		}
+	    }
+	    out += oframelen;
+	    nout++;
+	}
+	else {			/* resample */
+	    for (i = 0; i < nosig; i++) {
+		vt = in[siglist[i]];
+		v[i] = (vt == WFDB_INVALID_SAMPLE) ? vt : scale(i, vt);
+	    }
+	    while (ot <= it) {
+		double x = (ot%n == 0) ? 1.0 : (double)(ot % n)/(double)n;
+
+		for (i = 0; i < nosig; i++) {
+		    if (v[i] == WFDB_INVALID_SAMPLE ||
+			vv[i] == WFDB_INVALID_SAMPLE)
+			out[i] = WFDB_INVALID_SAMPLE;
+		    else {
+			double vd = vv[i] + x*(v[i]-vv[i]);
+
+			if (dflag) vd += DITHER;
+			out[i] = range(i, vd >= 0 ? (int)(vd + 0.5) :
+				       (int)(vd - 0.5));
+		    }
+		}
+		out += oframelen;
+		nout++;
+		ot += m;
+	    }
+	    for (i = 0; i < nosig; i++)
+		vv[i] = v[i];
+	    if (it > mn) { it -= mn; ot -= mn; }
+	    it += n;
+	}
+    }
+    return (nout);
+}
+
+/* writeblock writes nout output frames from out, and returns 0, or -1 if an
+   error occurs. */
+static int writeblock(const int *out, long nout)
+{
+    for ( ; nout > 0L; nout--, out += oframelen)
+	if (putvec(out) < 0) return (-1);
+    return (0);
+}
+
+static void block_alloc(struct block *b)
+{
+    if ((b->in = malloc(BLOCKLEN * iframelen * sizeof(int))) == NULL ||
+	(b->out = malloc(maxout * oframelen * sizeof(int))) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+}
+
+#ifndef NOPTHREADS
+/* In pipelined mode, blocks pass from the reading thread (the main thread)
+   to the transforming thread, then to the writing thread, and then back to the
+   reading thread, through three queues.  The WFDB library is not reentrant
+   (getvec and putvec both report errors using wfdb_error, for example), so
+   the reading and writing threads hold wfdblock while they use it;  blocks
+   are transformed while other blocks are being read or written. */
+struct queue {
+    struct block *b[NBLOCKS];
+    int head, count;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static struct queue qfree, qread, qxform;
+static pthread_mutex_t wfdblock = PTHREAD_MUTEX_INITIALIZER;
+static int stop;	/* set by the writing thread if putvec fails */
+
+static void qput(struct queue *q, struct block *b)
+{
+    pthread_mutex_lock(&q->lock);
+    q->b[(q->head + q->count++) % NBLOCKS] = b;
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static struct block *qget(struct queue *q)
+{
+    struct block *b;
+
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0)
+	pthread_cond_wait(&q->cond, &q->lock);
+    b = q->b[q->head];
+    q->head = (q->head + 1) % NBLOCKS;
+    q->count--;
+    pthread_mutex_unlock(&q->lock);
+    return (b);
+}
+
+/* Once a block has been passed on, it may be reused by another thread, so
+   the number of frames in it must be saved first. */
+static void *xthread(void *arg)
+{
+    long nin;
+    struct block *b;
+
+    do {
+	b = qget(&qread);
+	if ((nin = b->nin) > 0L) b->nout = xblock(b->in, nin, b->out);
+	qput(&qxform, b);
+    } while (nin > 0L);
+    return (NULL);
+}
+
+static void *wthread(void *arg)
+{
+    struct block *b;
+
+    while ((b = qget(&qxform))->nin > 0L) {
+	pthread_mutex_lock(&wfdblock);
+	if (!stop && writeblock(b->out, b->nout) < 0)
+	    stop = 1;
+	pthread_mutex_unlock(&wfdblock);
+	qput(&qfree, b);
+    }
+    return (NULL);
+}
+
+static void pipeline(void)
+{
+    int i;
+    long nin;
+    pthread_t xtid, wtid;
+    struct block *b, blocks[NBLOCKS];
+    struct queue *q[3];
+
+    q[0] = &qfree; q[1] = &qread; q[2] = &qxform;
+    for (i = 0; i < 3; i++) {
+	pthread_mutex_init(&q[i]->lock, NULL);
+	pthread_cond_init(&q[i]->cond, NULL);
+    }
+    for (i = 0; i < NBLOCKS; i++) {
+	block_alloc(&blocks[i]);
+	qput(&qfree, &blocks[i]);
+    }
+    if (pthread_create(&xtid, NULL, xthread, NULL) != 0)
+	i = 0;
+    else if (pthread_create(&wtid, NULL, wthread, NULL) != 0) {
+	/* Stop the transforming thread. */
+	b = qget(&qfree);
+	b->nin = 0L;
+	qput(&qread, b);
+	(void)pthread_join(xtid, NULL);
+	(void)qget(&qxform);
+	i = 0;
+    }
+    else
+	i = 1;
+    if (i == 0) {	/* threads are unavailable; process blocks in turn */
+	b = &blocks[0];
+	while ((b->nin = readblock(b->in)) > 0) {
+	    b->nout = xblock(b->in, b->nin, b->out);
+	    if (writeblock(b->out, b->nout) < 0) break;
+	}
+	return;
+    }
+    do {
+	b = qget(&qfree);
+	pthread_mutex_lock(&wfdblock);
+	b->nin = nin = stop ? 0L : readblock(b->in);
+	pthread_mutex_unlock(&wfdblock);
+	qput(&qread, b);
+    } while (nin > 0L);
+    (void)pthread_join(xtid, NULL);
+    (void)pthread_join(wtid, NULL);
+}
+#endif
+
+#ifndef NOFORK
+/* read_template returns the signal specifications from the header of record
+   orec (used as a template for each output record with -l), and sets *ntmpl
+   to the number of signals. */
+static WFDB_Siginfo *read_template(char *orec, int *ntmpl)
+{
+    char *p;
+    int i, ns;
+    WFDB_Siginfo *t;
+
+    if ((ns = isigopen(orec, NULL, 0)) <= 0) {
+	(void)fprintf(stderr, "%s: can't read header for record %s\n",
+		      pname, orec);
+	exit(2);
+    }
+    if ((t = malloc(ns * sizeof(WFDB_Siginfo))) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    (void)isigopen(orec, t, -ns);
+    /* Copy the strings, which belong to the WFDB library. */
+    for (i = 0; i < ns; i++) {
+	if (t[i].desc) {
+	    if ((p = malloc(strlen(t[i].desc) + 1)) == NULL) {
+		(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+		exit(2);
+	    }
+	    t[i].desc = strcpy(p, t[i].desc);
+	}
+	if (t[i].units) {
+	    if ((p = malloc(strlen(t[i].units) + 1)) == NULL) {
+		(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+		exit(2);
+	    }
+	    t[i].units = strcpy(p, t[i].units);
+	}
+	t[i].fname = NULL;
+    }
+    wfdbquit();
+    *ntmpl = ns;
+    return (t);
+}
+
+/* run_list reads pairs of input and new record names from the file named by
+   list, and starts a process to convert each input record, running up to
+   njobs at once.  In each child process, run_list sets *irec and *nrec and
+   returns 0.  In the parent, it returns (leaving *irec NULL) when all of the
+   child processes have finished:  0 if all of them succeeded, or 1 if not. */
+static int run_list(char *list, int njobs, char **irec, char **nrec)
+{
+    char buf[1024], ibuf[1024], nbuf[1024];
+    int nrun = 0, stat, status = 0;
+    FILE *lfile;
+    pid_t pid;
+
+    if ((lfile = fopen(list, "r")) == NULL) {
+	(void)fprintf(stderr, "%s: can't read %s\n", pname, list);
+	return (1);
+    }
+    while (fgets(buf, sizeof(buf), lfile)) {
+	int nf = sscanf(buf, "%1023s%1023s", ibuf, nbuf);
+
+	if (nf < 1 || *ibuf == '#')
+	    continue;	/* skip empty lines and comments */
+	if (nf < 2) {
+	    (void)fprintf(stderr, "%s: no new record name for %s in %s\n",
+			  pname, ibuf, list);
+	    status = 1;
+	    continue;
+	}
+	if (nrun >= njobs && wait(&stat) > 0) {
+	    nrun--;
+	    if (stat != 0) status = 1;
+	}
+	(void)fflush(stdout);
+	if ((pid = fork()) == 0) {
+	    (void)fclose(lfile);
+	    if ((*irec = malloc(strlen(ibuf) + 1)) == NULL ||
+		(*nrec = malloc(strlen(nbuf) + 1)) == NULL) {
+		(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+		exit(2);
+	    }
+	    (void)strcpy(*irec, ibuf);
+	    (void)strcpy(*nrec, nbuf);
+	    return (0);
+	}
+	else if (pid < 0) {
+	    (void)fprintf(stderr, "%s: can't create process for record %s\n",
+			  pname, ibuf);
+	    status = 1;
+	}
+	else
+	    nrun++;
+    }
+    (void)fclose(lfile);
+    while (wait(&stat) > 0)
+	if (stat != 0) status = 1;
+    return (status);
+}
+#endif
+
 /* Calculate the greatest common divisor of x and y.  This function uses
    Euclid's algorithm, modified so that an exact answer is not required if the
    (possibly non-integral) arguments do not have a common divisor that can be
@@ -1190,6 +1418,10 @@ static char *help_strings[] = {
  " -f TIME     begin at specified time",
  " -h          print this usage summary",
  " -H          open the input record in `high resolution' mode",
+ " -j N        read, transform, and write signals in parallel threads if N > 1;",
+ "              with -l, convert up to N records at once",
+ " -l FILE     convert each record named in FILE (one 'IREC NREC' pair per",
+ "              line), using OREC (-o) as a template for the output signals",
  " -M          process multifrequency record without changing frequencies",
  " -n NREC     create a header file, using record name NREC and signal",
  "              descriptions from IREC",
@@ -14,5 +14,11 @@ lcheck:		lcheck.c $(DESTDIR)$(INCDIR)/wfdb/wfdb.h
 	@$(CC) $(CFLAGS) lcheck.c -o lcheck$(EXEEXT) $(LDFLAGS) \
 	  && echo " Succeeded"
 
+# 'make hdrbench' measures the speed of header parsing (not run by 'make check').
+hdrbench:	hdrbench.c $(DESTDIR)$(INCDIR)/wfdb/wfdb.h
+	@$(CC) $(CFLAGS) hdrbench.c -o hdrbench$(EXEEXT) $(LDFLAGS)
+	@WFDB=". input `cd ../data; pwd`" ./hdrbench input/*.hea ../data/*.hea
+
 clean:
-	rm -f *~ lcheck lcheck.exe libcheck.out appcheck.out
+	rm -f *~ lcheck lcheck.exe hdrbench hdrbench.exe libcheck.out \
+	  appcheck.out
@@ -0,0 +1,162 @@
+/* file: hdrbench.c	WFDB contributors	18 October 2026
+-------------------------------------------------------------------------------
+hdrbench: measure the speed of WFDB header file parsing
+Copyright (C) 2026 WFDB contributors
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author by e-mail (wfdb@physionet.org) or postal mail
+(MIT Room E25-505A, Cambridge, MA 02139 USA).  For updates to this software,
+please visit PhysioNet (http://www.physionet.org/).
+_______________________________________________________________________________
+
+This program is not run by 'make check';  use 'make hdrbench' to compile it and
+run it on the header files in ./input and in ../data.  Each of the header files
+named on the command line is processed repeatedly in three ways:
+  1. parsed from memory by wfdb_parseheader
+  2. read and parsed by wfdb_readheader
+  3. opened by isigopen (without opening the signal files), followed by
+     reading all of its info strings using getinfo
+and the average time per header is reported for each.  The third method is
+what most WFDB applications do, and it can be used to compare this version of
+the WFDB library with earlier versions.  Since isigopen finds header files by
+record name, the WFDB path must include the directories that contain them.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wfdb/wfdb.h>
+
+static char *pname;
+static char *prog_name(char *s);
+static void help(void);
+
+int main(int argc, char *argv[])
+{
+    char **text, *p;
+    static char record[WFDB_MAXRNL+5];
+    clock_t t0;
+    double t;
+    int i, j, k, nfiles, passes = 1000;
+    long *len;
+    FILE *ifile;
+    WFDB_Hdrinfo *h;
+
+    pname = prog_name(argv[0]);
+    for (i = 1; i < argc && *argv[i] == '-'; i++) {
+	if (strcmp(argv[i], "-n") == 0 && i+1 < argc)
+	    passes = atoi(argv[++i]);
+	else {
+	    help();
+	    exit(1);
+	}
+    }
+    if (i >= argc || passes < 1) {
+	help();
+	exit(1);
+    }
+    argv += i;
+    nfiles = argc - i;
+    if ((text = calloc(nfiles, sizeof(char *))) == NULL ||
+	(len = calloc(nfiles, sizeof(long))) == NULL) {
+	fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+
+    /* Read the header files into memory, and check that they can be parsed. */
+    for (j = 0; j < nfiles; j++) {
+	if ((ifile = fopen(argv[j], "rb")) == NULL ||
+	    fseek(ifile, 0L, SEEK_END) != 0 || (len[j] = ftell(ifile)) < 0 ||
+	    (text[j] = malloc(len[j] + 1)) == NULL) {
+	    fprintf(stderr, "%s: can't read %s\n", pname, argv[j]);
+	    exit(2);
+	}
+	rewind(ifile);
+	len[j] = fread(text[j], 1, len[j], ifile);
+	text[j][len[j]] = '\0';
+	fclose(ifile);
+	if (wfdb_parseheader(text[j], len[j], &h) < 0) {
+	    fprintf(stderr, "%s: can't parse %s\n", pname, argv[j]);
+	    exit(2);
+	}
+	wfdb_freeheader(h);
+    }
+    printf("%d header files, %d passes\n", nfiles, passes);
+
+    t0 = clock();
+    for (i = 0; i < passes; i++)
+	for (j = 0; j < nfiles; j++) {
+	    wfdb_parseheader(text[j], len[j], &h);
+	    wfdb_freeheader(h);
+	}
+    t = (double)(clock() - t0) / CLOCKS_PER_SEC;
+    printf(" wfdb_parseheader:  %8.2f us/header\n", 1e6*t/passes/nfiles);
+
+    t0 = clock();
+    for (i = 0; i < passes; i++)
+	for (j = 0; j < nfiles; j++) {
+	    wfdb_readheader(argv[j], &h);
+	    wfdb_freeheader(h);
+	}
+    t = (double)(clock() - t0) / CLOCKS_PER_SEC;
+    printf(" wfdb_readheader:   %8.2f us/header\n", 1e6*t/passes/nfiles);
+
+    wfdbquiet();
+    t0 = clock();
+    for (i = 0, k = 0; i < passes; i++)
+	for (j = 0; j < nfiles; j++) {
+	    /* The record is found using the WFDB path, so strip off any
+	       directory names.  isigopen and getinfo may modify the record
+	       name, so use a copy. */
+	    if ((p = strrchr(argv[j], '/')) == NULL) p = argv[j];
+	    else p++;
+	    strncpy(record, p, sizeof(record)-1);
+	    if (isigopen(record, NULL, 0) < 0) k++;
+	    for (p = getinfo(record); p; p = getinfo(NULL))
+		;
+	}
+    t = (double)(clock() - t0) / CLOCKS_PER_SEC;
+    wfdbquit();
+    printf(" isigopen+getinfo:  %8.2f us/header", 1e6*t/passes/nfiles);
+    if (k) printf(" (%d errors)", k/passes);
+    printf("\n");
+    exit(0);
+}
+
+static char *prog_name(char *s)
+{
+    char *p = s + strlen(s);
+
+#ifdef MSDOS
+    while (p >= s && *p != '\\' && *p != ':') {
+	if (*p == '.')
+	    *p = '\0';		/* strip off extension */
+	if ('A' <= *p && *p <= 'Z')
+	    *p += 'a' - 'A';	/* convert to lower case */
+	p--;
+    }
+#else
+    while (p >= s && *p != '/')
+	p--;
+#endif
+    return (p+1);
+}
+
+static void help(void)
+{
+    fprintf(stderr, "usage: %s [ -n PASSES ] FILE.hea ...\n", pname);
+    fprintf(stderr, " PASSES is the number of times each file is read "
+	    "(default: 1000)\n");
+}
@@ -1,5 +1,5 @@
 /* file: lcheck.c	G. Moody       7 September 2001
-			Last revised:  18 May 2022
+			Last revised:  18 October 2026
 -------------------------------------------------------------------------------
 wfdbcheck: test WFDB library
 Copyright (C) 2001-2010 George B. Moody
@@ -40,6 +40,7 @@ static void help(void);
 static void list_untested(void);
 static void check_annotations(char *record);
 static void check_signals(char *record, char *orec, int fmt, int split_info);
+static void check_edf(char *record, char *bdfrec);
 static char *prog_name(char *s);
 
 int main(int argc, char *argv[])
@@ -184,6 +185,9 @@ int main(int argc, char *argv[])
 #endif
   check_signals("100y", "100z", 212, 0);
 
+  /* Test direct access to the data records of EDF+D and BDF files. */
+  check_edf("input/edfd.edf", "input/test.bdf");
+
   /* Test I/O again using the remote record. */
   if (WFDB_NETFILES) {
     if (vflag)
@@ -719,6 +723,141 @@ static void check_signals(char *record, char *orec, int ofmt, int split_info)
   setanndesc(-1, "Normal beat");
 }
 
+/* The EDF+D record (input/edfd.edf) has six 1-second data records, each
+   containing 4 samples of signal 0, 2 samples of signal 1, and an EDF
+   Annotations signal with the onset of the data record.  There are gaps
+   between data records 2 and 3, and between 4 and 5.  Sample k of data record
+   b of signal 0 is (4b+k)*100 - 1000, except for an invalid sample at b=3,
+   k=1;  sample k of data record b of signal 1 is (2b+k)*-50 + 7, except for an
+   invalid sample at b=4, k=0.  The BDF record (input/test.bdf) has five
+   data records containing 3 samples of signal 0 ((3b+k)*100000 - 700000,
+   except for an invalid sample at b=2, k=2) and one of signal 1. */
+static void check_edf(char *record, char *bdfrec)
+{
+  static double onset[6] = { 0.0, 1.0, 2.0, 10.0, 11.0, 30.5 };
+  WFDB_Sample v[16];
+  WFDB_Time b;
+  double x;
+  int k, nf;
+
+  /* *** getedfonset *** */
+  n = isigopen(record, NULL, 0);
+  si = calloc(n, sizeof(WFDB_Siginfo));
+  if ((nsig = isigopen(record, si, n)) != 3) {
+    printf("Error: isigopen(%s) returned %d (should have been 3)\n",
+	   record, nsig);
+    errors++;
+    wfdbquit();
+    free(si);
+    return;
+  }
+  for (b = 0; b < 6; b++) {
+    if ((x = getedfonset(b)) != onset[b]) {
+      printf("Error: getedfonset(%"WFDB_Pd_TIME") returned %g"
+	     " (should have been %g)\n", b, x, onset[b]);
+      errors++;
+    }
+  }
+  if ((x = getedfonset(6)) != -1.0) {
+    printf("Error: getedfonset(6) returned %g (should have been -1)\n", x);
+    errors++;
+  }
+  else if (vflag)
+    printf("[OK]:  getedfonset returned the onsets of %s\n", record);
+
+  /* *** getedfblock *** */
+  for (i = framelen = 0; i < nsig; i++)
+    framelen += si[i].spf;
+  vector = calloc(framelen, sizeof(WFDB_Sample));
+  (void)getframe(vector);
+  n = getedfblock(0, 3, v);
+  if (n != 4 || v[0] != 200 || v[1] != WFDB_INVALID_SAMPLE || v[2] != 400 ||
+      v[3] != 500) {
+    printf("Error: getedfblock(0, 3) returned %d, {%d, %d, %d, %d}\n",
+	   n, v[0], v[1], v[2], v[3]);
+    errors++;
+  }
+  n = getedfblock(1, 4, v);
+  if (n != 2 || v[0] != WFDB_INVALID_SAMPLE || v[1] != -443) {
+    printf("Error: getedfblock(1, 4) returned %d, {%d, %d}\n",
+	   n, v[0], v[1]);
+    errors++;
+  }
+  if ((n = getedfblock(0, 6, v)) != -1) {
+    printf("Error: getedfblock(0, 6) returned %d (should have been -1)\n",
+	   n);
+    errors++;
+  }
+  /* getedfblock must not change the position used by getframe. */
+  if ((n = getframe(vector)) != nsig || vector[0] != -600 ||
+      vector[4] != -93) {
+    printf("Error: after getedfblock, getframe returned %d, {%d, ..., %d, "
+	   "...} (should have been {-600, ..., -93, ...})\n",
+	   n, vector[0], vector[4]);
+    errors++;
+  }
+  else if (vflag)
+    printf("[OK]:  getedfblock read data records of %s\n", record);
+
+  /* Read the record from data record 4 (after a seek) and from the
+     beginning, and check that each frame matches the data record read by
+     getedfblock. */
+  for (b = 4; b >= 0; b -= 4) {
+    isigsettime(b * getspf());
+    for (nf = b; getframe(vector) == nsig; nf++) {
+      WFDB_Sample *vp = vector;
+
+      for (i = 0; i < nsig; vp += si[i].spf, i++) {
+	if (getedfblock(i, nf, v) != si[i].spf)
+	  break;
+	for (k = 0; k < si[i].spf && vp[k] == v[k]; k++)
+	  ;
+	if (k < si[i].spf)
+	  break;
+      }
+      if (i < nsig)
+	break;
+    }
+    if (nf != 6) {
+      printf("Error: frame %d of %s (after seeking to frame %"WFDB_Pd_TIME
+	     ") does not match its data record\n", nf, record, b);
+      errors++;
+      break;
+    }
+  }
+  if (b < 0 && vflag)
+    printf("[OK]:  getframe and getedfblock read %s consistently\n", record);
+  free(vector);
+  free(si);
+
+  /* Repeat a few of these checks using a BDF file. */
+  n = isigopen(bdfrec, NULL, 0);
+  si = calloc(n, sizeof(WFDB_Siginfo));
+  if ((nsig = isigopen(bdfrec, si, n)) != 2) {
+    printf("Error: isigopen(%s) returned %d (should have been 2)\n",
+	   bdfrec, nsig);
+    errors++;
+  }
+  else {
+    n = getedfblock(0, 2, v);
+    x = getedfonset(2);
+    if (n != 3 || v[0] != -100000 || v[1] != 0 ||
+	v[2] != WFDB_INVALID_SAMPLE || x != 2.0) {
+      printf("Error: getedfblock(0, 2) returned %d, {%d, %d, %d},"
+	     " getedfonset(2) returned %g\n", n, v[0], v[1], v[2], x);
+      errors++;
+    }
+    else if (vflag)
+      printf("[OK]:  getedfblock and getedfonset read %s\n", bdfrec);
+  }
+  free(si);
+  wfdbquit();
+  /* Opening an EDF file selects high-resolution mode and sets the annotation
+     time resolution;  restore the defaults. */
+  setgvmode(WFDB_LOWRES);
+  setafreq(0.0);
+}
+
 static char *prog_name(char *s)
 {
     char *p = s + strlen(s);
@@ -1,5 +1,5 @@
 # file: Makefile.tpl		G. Moody	24 May 2000
-#				Last revised:	24 April 2020
+#				Last revised:	18 October 2026
 # This section of the Makefile should not need to be changed.
 
 CFILES = a2m.c ad2m.c ahaecg2mit.c m2a.c md2a.c readid.c makeid.c edf2mit.c \
@@ -45,6 +45,10 @@ collect:
 uninstall:
 	../uninstall.sh $(DESTDIR)$(BINDIR) $(XFILES) $(SCRIPTS)
 
+# mit2edf encodes its output using several threads.
+mit2edf$(EXEEXT):	mit2edf.c
+	$(CC) $(CFLAGS) mit2edf.c -o $@ $(LDFLAGS) -lpthread
+
 # `make clean':  remove intermediate and backup files
 clean:
 	rm -f $(XFILES) *.o *~
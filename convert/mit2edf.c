@@ -1,5 +1,5 @@
 /* file: mit2edf.c		G. Moody	2 November 2002
-				Last revised:     18 May 2022
+				Last revised:  18 October 2026
 -------------------------------------------------------------------------------
 Convert MIT format header and signal files to EDF (European Data Format) file
 Copyright (C) 2002-2014 George B. Moody
@@ -26,25 +26,64 @@ _______________________________________________________________________________
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef NOPTHREADS
+#include <pthread.h>
+#endif
 #include <wfdb/wfdb.h>
 
 #define EDFMAXBLOCK	61440	/* maximum data block length, in bytes */
+#define BATCHBYTES (1 << 20)	/* approximate size of a batch of blocks */
+#define MAXTHREADS	16	/* maximum number of encoding threads */
+#define MAXANNOTATORS	32	/* maximum number of input annotators */
+
+/* Data blocks are converted in batches.  The main thread reads the frames of
+   each batch using getframe() (the WFDB library is not thread-safe), the
+   batch is divided among the encoding threads, each of which transposes its
+   blocks into EDF's per-signal layout independently, and the main thread then
+   writes the encoded batch with a single fwrite(). */
+struct encjob {
+    WFDB_Sample *fbuf;	/* frames of the batch */
+    char *obuf;		/* encoded blocks of the batch */
+    char **blockp;	/* per-signal output pointers for this job */
+    long block0;	/* block number of the first block of the batch */
+    long first, last;	/* range of blocks (within the batch) for this job */
+};
+
+static int nsig, samples_per_frame;
+static long frames_per_block, bytes_per_block, sig_bytes_per_block;
+static WFDB_Siginfo *si;
+
+/* EDF annotations are stored as time-stamped annotation lists (TALs) in an
+   extra "EDF Annotations" signal.  Each block begins with a timekeeping TAL
+   giving its onset, followed by a TAL for each annotation within the block. */
+static char **tal;	/* TAL for each input annotation */
+static long *tfirst;	/* index of the first annotation in each block */
+static double frames_per_second;
 
 static char *prog_name(const char *s);
+static char *onsetstr(char *buf, WFDB_Time t);
+static long readanns(char *record, char **aname, int nann, long nblocks);
+static void *encode(void *arg);
 static void help(void);
 
 int main(int argc, char **argv)
 {
     char buf[100];
-    char *header, *ofname = NULL, *p, *block, **blockp, *record = NULL;
-    double *pmax, *pmin, frames_per_second, seconds_per_block;
+    char *header, *ofname = NULL, *p, *obuf, *record = NULL,
+	*aname[MAXANNOTATORS];
+    double *pmax, *pmin, seconds_per_block;
     FILE *ofile = NULL;
-    int *dmax, *dmin, i, j, k, nsig, samples_per_frame, start_date_recorded,
-	edfplusflag = 0, vflag = 0, day, month, year, hour, minute, second;
-    long bytes_per_block, frames_per_block, n, nblocks, blocks_per_minute,
-	blocks_per_hour;
-    WFDB_Sample *v, *vp;
-    WFDB_Siginfo *si;
+    int *dmax, *dmin, i, j, nann = 0, nout, nthreads = 1, start_date_recorded,
+	edfplusflag = 0, vflag = 0, day, month, year, hour, minute, second,
+	eof = 0;
+    long ann_bytes_per_block = 0, batch, blocks_per_batch, n, nblocks,
+	blocks_per_minute, blocks_per_hour, frames_per_batch;
+    WFDB_Sample *fbuf, *vp;
+    struct encjob job[MAXTHREADS];
+#ifndef NOPTHREADS
+    pthread_t tid[MAXTHREADS];
+    int started[MAXTHREADS];
+#endif
     static char *month_name[] = {  "JAN", "FEB", "MAR", "APR", "MAY", "JUN",
 				   "JUL", "AUG", "SEP", "OCT", "NOV", "DEC" };
     const char *pname;
@@ -53,9 +92,36 @@ int main(int argc, char **argv)
     pname = argv[0];
     for (i = 1; i < argc; i++) {
 	if (*argv[i] == '-') switch (argv[i][1]) {
+	  case 'a':	/* annotator name(s) follow */
+	    while (++i < argc && *argv[i] != '-') {
+		if (nann >= MAXANNOTATORS) {
+		    fprintf(stderr, "%s: too many annotators\n", pname);
+		    exit(1);
+		}
+		aname[nann++] = argv[i];
+	    }
+	    if (nann == 0) {
+		fprintf(stderr, "%s: annotator name must follow -a\n", pname);
+		exit(1);
+	    }
+	    edfplusflag = 1;	/* EDF annotations require EDF+ */
+	    i--;
+	    break;
 	  case 'h':	/* show usage and quit */
 	    help();
 	    exit(0);
+	  case 'j':	/* number of encoding threads follows */
+	    if (++i >= argc || (nthreads = atoi(argv[i])) < 1) {
+		fprintf(stderr, "%s: number of threads must follow -j\n",
+			pname);
+		exit(1);
+	    }
+#ifdef NOPTHREADS
+	    nthreads = 1;
+#else
+	    if (nthreads > MAXTHREADS) nthreads = MAXTHREADS;
+#endif
+	    break;
 	  case 'o':	/* output file name follows */
 	    if (++i < argc)
 		ofname = argv[i];
@@ -181,19 +247,41 @@ int main(int argc, char **argv)
        an exact multiple of frames_per_block. */
     nblocks = strtim("e") / frames_per_block + 1;
 
+    /* If annotations are to be written, prepare their TALs and add an "EDF
+       Annotations" signal long enough for the busiest block. */
+    sig_bytes_per_block = bytes_per_block;
+    nout = nsig;
+    if (nann > 0) {
+	ann_bytes_per_block = readanns(record, aname, nann, nblocks);
+	bytes_per_block += ann_bytes_per_block;
+	nout++;
+    }
+
+    /* Choose the number of blocks per batch. */
+    if ((blocks_per_batch = BATCHBYTES / bytes_per_block) < 1)
+	blocks_per_batch = 1;
+    if (blocks_per_batch > nblocks)
+	blocks_per_batch = nblocks;
+    frames_per_batch = blocks_per_batch * frames_per_block;
+
     /* Allocate and initialize arrays and buffers. */
     if ((dmax = malloc(nsig * sizeof(int))) == NULL ||
 	(dmin = malloc(nsig * sizeof(int))) == NULL ||
 	(pmax = malloc(nsig * sizeof(double))) == NULL ||
 	(pmin = malloc(nsig * sizeof(double))) == NULL ||
-	(header = malloc((nsig + 1) * 256)) == NULL ||
-	(v = malloc(samples_per_frame * sizeof(WFDB_Sample))) == NULL ||
-	(block = malloc(bytes_per_block)) == NULL ||
-	(blockp = malloc(nsig * sizeof(char *))) == NULL) {
+	(header = malloc((nout + 1) * 256)) == NULL ||
+	(fbuf = malloc(frames_per_batch * samples_per_frame *
+		       sizeof(WFDB_Sample))) == NULL ||
+	(obuf = malloc(blocks_per_batch * bytes_per_block)) == NULL) {
 	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
 	exit(2);
     }
-    for (i = 0; i < (nsig + 1)*256; i++)
+    for (i = 0; i < nthreads; i++)
+	if ((job[i].blockp = malloc(nsig * sizeof(char *))) == NULL) {
+	    (void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	    exit(2);
+	}
+    for (i = 0; i < (nout + 1)*256; i++)
 	    header[i] = ' ';
 
     if (vflag)
@@ -275,7 +363,7 @@ int main(int argc, char **argv)
     p += 8;
 
     /* Number of bytes in header. */
-    sprintf(buf, "%ld", (nsig + 1)*256L);
+    sprintf(buf, "%ld", (nout + 1)*256L);
     strncpy(p, buf, strlen(buf));
     p += 8;
 
@@ -296,21 +384,30 @@ int main(int argc, char **argv)
     p += 8;
 
     /* Number of signals. */
-    sprintf(buf, "%d", nsig);
+    sprintf(buf, "%d", nout);
     strncpy(p, buf, strlen(buf));
     p += 4;
 
+    /* In each of the signal header fields below, the annotation signal (if
+       any) follows the input signals;  its transducer type, physical
+       dimension, and prefiltering fields are left blank, as EDF+ requires. */
+
     /* Label (e.g., EEG FpzCz or Body temp). */
     for (i = 0; i < nsig; i++, p += 16) {
 	if (strlen(si[i].desc) > 16) si[i].desc[16] = '\0';
 	strncpy(p, si[i].desc, strlen(si[i].desc));
     }
+    if (nann > 0) {
+	strncpy(p, "EDF Annotations", 15);
+	p += 16;
+    }
 
     /* Transducer type (e.g., AgAgCl electrode). */
     for (i = 0; i < nsig; i++, p += 80) {
 	strncpy(p, "transducer type not recorded",
 		strlen("transducer type not recorded"));
     }
+    if (nann > 0) p += 80;
 
     /* Physical dimension (e.g., uV or degreeC). */
     for (i = 0; i < nsig; i++, p += 8) {
@@ -318,53 +415,76 @@ int main(int argc, char **argv)
 	else if (strlen(si[i].units) > 8) si[i].units[8] = '\0';
 	strncpy(p, si[i].units, strlen(si[i].units));
     }
+    if (nann > 0) p += 8;
 
     /* Physical minimum (e.g., -500 or 34). */
     for (i = 0; i < nsig; i++, p += 8) {
 	sprintf(buf, "%g", pmin[i]);
 	strncpy(p, buf, strlen(buf));
     }
+    if (nann > 0) {
+	strncpy(p, "-1", 2);
+	p += 8;
+    }
 
     /* Physical maximum (e.g., 500 or 40). */
     for (i = 0; i < nsig; i++, p += 8) {
 	sprintf(buf, "%g", pmax[i]);
 	strncpy(p, buf, strlen(buf));
     }
+    if (nann > 0) {
+	strncpy(p, "1", 1);
+	p += 8;
+    }
 
     /* Digital minimum (e.g., -2048). */
     for (i = 0; i < nsig; i++, p += 8) {
 	sprintf(buf, "%d", dmin[i]);
 	strncpy(p, buf, strlen(buf));
     }
+    if (nann > 0) {
+	strncpy(p, "-32768", 6);
+	p += 8;
+    }
 
     /* Digital maximum (e.g., 2047). */
     for (i = 0; i < nsig; i++, p += 8) {
 	sprintf(buf, "%d", dmax[i]);
 	strncpy(p, buf, strlen(buf));
     }
+    if (nann > 0) {
+	strncpy(p, "32767", 5);
+	p += 8;
+    }
 
     /* Prefiltering (e.g., HP:0.1Hz LP:75Hz). */
     for (i = 0; i < nsig; i++, p += 80) {
 	strncpy(p, "prefiltering not recorded",
 		strlen("prefiltering not recorded"));
     }
+    if (nann > 0) p += 80;
 
     /* Number of samples per block. */
     for (i = 0; i < nsig; i++, p += 8) {
 	sprintf(buf, "%ld", frames_per_block * si[i].spf);
 	strncpy(p, buf, strlen(buf));
     }
+    if (nann > 0) {
+	sprintf(buf, "%ld", ann_bytes_per_block / 2);
+	strncpy(p, buf, strlen(buf));
+	p += 8;
+    }
 
-    /* (The last 32*nsig bytes in the header are unused.) */
+    /* (The last 32*nout bytes in the header are unused.) */
 
     /* Write the header to the output file. */
-    fwrite(header, 1, (nsig+1) * 256, ofile);
+    fwrite(header, 1, (nout+1) * 256, ofile);
 
     /* Check that all characters in the header are valid (printable ASCII
        between 32 and 126 inclusive).  Note that this test does not prevent
        generation of files containing invalid characters;  it merely warns
        the user if this has happened. */
-    for (i = 0; i < (nsig+1) * 256; i++)
+    for (i = 0; i < (nout+1) * 256; i++)
 	if (header[i] < 32 || header[i] > 126)
 	    fprintf(stderr,
 		    "WARNING (%s): output contains an invalid character, %d,"
@@ -372,7 +492,7 @@ int main(int argc, char **argv)
 
     /* In verbose mode, summarize what we've done so far. */
     if (vflag) {
-	printf(" Header block size: %d bytes\n", (nsig+1) * 256);
+	printf(" Header block size: %d bytes\n", (nout+1) * 256);
 	printf(" Data block size: %g second%s (%ld frame%s or %ld bytes)\n",
 	       seconds_per_block, seconds_per_block == 1.0 ? "" : "s",
 	       frames_per_block, frames_per_block == 1 ? "" : "s",
@@ -383,35 +503,61 @@ int main(int argc, char **argv)
 	       " (%ld data blocks, %ld frames, %ld bytes)\n",
 	       p, nblocks, nblocks*frames_per_block, nblocks*bytes_per_block);
 	printf(" Total length of file to be written: %ld bytes\n",
-	       (nsig+1)*256 + nblocks*bytes_per_block);
+	       (nout+1)*256 + nblocks*bytes_per_block);
 
 	blocks_per_minute = (long)(60 / seconds_per_block);
 	blocks_per_hour = (long)60 * blocks_per_minute;
     }
 
     /* Write the data blocks. */
-    for (n = 1; n <= nblocks; n++) {
-	blockp[0] = block;
-	for (j = 1; j < nsig; j++)
-	    blockp[j] = blockp[j-1] + 2 * frames_per_block * si[j-1].spf;
-	for (i = 0; i < frames_per_block; i++) {
-	    if (nsig != getframe(v)) {
+    for (n = 0; n < nblocks; n += batch) {
+	int nj;
+
+	if ((batch = nblocks - n) > blocks_per_batch)
+	    batch = blocks_per_batch;
+
+	/* Read the frames of this batch. */
+	for (i = 0, vp = fbuf; i < batch * frames_per_block; i++) {
+	    if (eof || nsig != getframe(vp)) {
 		/* end of input: pad last block with invalid samples */
+		eof = 1;
 		for (j = 0; j < samples_per_frame; j++)
-		    v[j] = WFDB_INVALID_SAMPLE;
-	    }
-	    vp = v;
-	    for (j = 0; j < nsig; j++) {
-		for (k = 0; k < si[j].spf; k++) {
-		    *(blockp[j]++) = (*vp) & 0xff;
-		    *(blockp[j]++) = ((*vp++ >> 8) & 0xff);
-		}
+		    vp[j] = WFDB_INVALID_SAMPLE;
 	    }
+	    vp += samples_per_frame;
+	}
+
+	/* Encode them. */
+	if ((nj = nthreads) > batch) nj = batch;
+	for (i = 0; i < nj; i++) {
+	    job[i].fbuf = fbuf;
+	    job[i].obuf = obuf;
+	    job[i].block0 = n;
+	    job[i].first = batch * i / nj;
+	    job[i].last = batch * (i+1) / nj;
 	}
-	fwrite(block, 1, bytes_per_block, ofile);
+#ifndef NOPTHREADS
+	for (i = 1; i < nj; i++)
+	    started[i] = pthread_create(&tid[i], NULL, encode, &job[i]) == 0;
+	encode(&job[0]);
+	for (i = 1; i < nj; i++) {
+	    if (started[i]) pthread_join(tid[i], NULL);
+	    else encode(&job[i]);
+	}
+#else
+	for (i = 0; i < nj; i++)
+	    encode(&job[i]);
+#endif
+
+	/* Write them. */
+	fwrite(obuf, 1, batch * bytes_per_block, ofile);
 	if (vflag) {
-	    if (n % blocks_per_minute == 0) { printf("."); fflush(stdout); }
-	    if (n % blocks_per_hour == 0) printf("\n");
+	    long m;
+
+	    for (m = n + 1; m <= n + batch; m++) {
+		if (m % blocks_per_minute == 0) { printf("."); fflush(stdout); }
+		if (m % blocks_per_hour == 0) printf("\n");
+	    }
 	}
     }
     (void)fclose(ofile);
@@ -430,7 +576,7 @@ int main(int argc, char **argv)
 	for (i = nsig-1; i >= 0; i--)
 	    if (strcmp(si[i].desc, "EDF-Annotations") == 0)
 		break;
-	if (i < 0)
+	if (i < 0 && nann == 0)
 	    fprintf(stderr,
 "\nWARNING:  The output file does not include EDF annotations, which are\n"
 		    " required for EDF+.\n");
@@ -440,6 +586,147 @@ int main(int argc, char **argv)
     exit(0);
 }
 
+/* Transpose the frames of the blocks assigned to a job into EDF's layout, in
+   which all of the samples of the first signal in a block precede those of the
+   second signal, and so on;  then fill in the annotation signal, if any. */
+static void *encode(void *arg)
+{
+    struct encjob *jp = arg;
+    char **blockp = jp->blockp;
+    int i, j, k;
+    long b;
+    WFDB_Sample *vp;
+
+    for (b = jp->first; b < jp->last; b++) {
+	char *block = jp->obuf + b * bytes_per_block;
+
+	blockp[0] = block;
+	for (j = 1; j < nsig; j++)
+	    blockp[j] = blockp[j-1] + 2 * frames_per_block * si[j-1].spf;
+	vp = jp->fbuf + b * frames_per_block * samples_per_frame;
+	for (i = 0; i < frames_per_block; i++) {
+	    for (j = 0; j < nsig; j++) {
+		char *bp = blockp[j];
+
+		for (k = 0; k < si[j].spf; k++) {
+		    *bp++ = (*vp) & 0xff;
+		    *bp++ = ((*vp++ >> 8) & 0xff);
+		}
+		blockp[j] = bp;
+	    }
+	}
+	if (tal) {
+	    char *ap = block + sig_bytes_per_block, buf[32];
+	    long n = jp->block0 + b, t;
+
+	    memset(ap, 0, bytes_per_block - sig_bytes_per_block);
+	    ap += sprintf(ap, "%s\024\024", onsetstr(buf, n*frames_per_block))
+		+ 1;
+	    for (t = tfirst[n]; t < tfirst[n+1]; t++) {
+		strcpy(ap, tal[t]);
+		ap += strlen(tal[t]) + 1;
+	    }
+	}
+    }
+    return (NULL);
+}
+
+/* Format the onset of a TAL (time t, in frames, in seconds from the beginning
+   of the record, with a leading sign and without trailing zeroes). */
+static char *onsetstr(char *buf, WFDB_Time t)
+{
+    char *p;
+
+    sprintf(buf, "+%.6f", t / frames_per_second);
+    for (p = buf + strlen(buf) - 1; *p == '0'; p--)
+	*p = '\0';
+    if (*p == '.') *p = '\0';
+    return (buf);
+}
+
+/* Read the annotations to be written, prepare a TAL for each of them, and
+   find the first annotation in each block.  The annotators are merged in
+   canonical order by getmergedann.  The value returned is the number of bytes needed for
+   the annotation signal in each block, including the timekeeping TAL. */
+static long readanns(char *record, char **aname, int nann, long nblocks)
+{
+    char buf[32], text[512], *p;
+    int i;
+    long b, bytes, maxbytes, n, nmax = 0, t;
+    WFDB_Annotation annot;
+    WFDB_Annotator an;
+    WFDB_Anninfo ai[MAXANNOTATORS];
+    WFDB_Time *atime = NULL, tend = nblocks * frames_per_block;
+
+    for (i = 0; i < nann; i++) {
+	ai[i].name = aname[i];
+	ai[i].stat = WFDB_READ;
+    }
+    if (annopen(record, ai, nann) < 0 || annmerge(NULL, 0) < 0)
+	exit(2);
+
+    /* Read all of the annotations. */
+    for (n = 0; getmergedann(&an, &annot) == 0; n++) {
+	if (n >= nmax) {
+	    nmax = nmax ? 2*nmax : 1024;
+	    if ((atime = realloc(atime, nmax * sizeof(WFDB_Time))) == NULL
+		|| (tal = realloc(tal, nmax * sizeof(char *))) == NULL) {
+		(void)fprintf(stderr, "%s: insufficient memory\n",
+			      prog_name("mit2edf"));
+		exit(2);
+	    }
+	}
+
+	/* The annotation text is the mnemonic for the annotation type,
+	   followed by the aux string, if any (without control characters,
+	   which are not permitted in TALs). */
+	strcpy(text, annstr(annot.anntyp));
+	if (annot.aux && *annot.aux) {
+	    int len = *annot.aux;
+
+	    p = text + strlen(text);
+	    *p++ = ' ';
+	    memcpy(p, annot.aux + 1, len);
+	    p[len] = '\0';
+	    for ( ; *p; p++)
+		if ((unsigned char)*p < ' ') *p = ' ';
+	}
+	if (annot.time < 0) annot.time = 0;
+	else if (annot.time >= tend) annot.time = tend - 1;
+	atime[n] = annot.time;
+	onsetstr(buf, annot.time);
+	if ((tal[n] = malloc(strlen(buf) + strlen(text) + 3)) == NULL) {
+	    (void)fprintf(stderr, "%s: insufficient memory\n",
+			  prog_name("mit2edf"));
+	    exit(2);
+	}
+	sprintf(tal[n], "%s\024%s\024", buf, text);
+    }
+    if (tal == NULL && (tal = malloc(sizeof(char *))) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n",
+		      prog_name("mit2edf"));
+	exit(2);
+    }
+
+    /* Find the first annotation in each block and the length of the longest
+       annotation signal. */
+    if ((tfirst = malloc((nblocks + 1) * sizeof(long))) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n",
+		      prog_name("mit2edf"));
+	exit(2);
+    }
+    for (b = t = maxbytes = 0; b < nblocks; b++) {
+	tfirst[b] = t;
+	bytes = strlen(onsetstr(buf, b*frames_per_block)) + 3;
+	for ( ; t < n && atime[t] < (b+1) * frames_per_block; t++)
+	    bytes += strlen(tal[t]) + 1;
+	if (bytes > maxbytes) maxbytes = bytes;
+    }
+    tfirst[nblocks] = n;
+    free(atime);
+    return ((maxbytes + 1) & ~1L);	/* the signal has 2-byte samples */
+}
+
 static char *prog_name(const char *s)
 {
     const char *p = s + strlen(s);
@@ -452,7 +739,10 @@ static char *prog_name(const char *s)
 static char *help_strings[] = {
  "usage: %s -r RECORD [OPTIONS ...]\n",
  "where RECORD is the name of the input record, and OPTIONS may include:",
+ " -a ANNOTATOR [ANNOTATOR ...]  write EDF annotations from the specified",
+ "              annotator(s) (implies -p)",
  " -h          print this usage summary",
+ " -j N        use N threads to encode the output (default: 1)",
  " -o EDFILE   write the specified European Data Format file (default:",
  "              RECORD.edf)",
  " -p          write the output as an EDF+ file",
@@ -1,5 +1,5 @@
 /* file: wfdb2mat.c	G. Moody	26 February 2009
-			Last revised:	  16 June 2021
+			Last revised:  18 October 2026
 -------------------------------------------------------------------------------
 wfdb2mat: Convert (all or part of) a WFDB signal file to Matlab .mat format
 Copyright (C) 2009-2013 George B. Moody
@@ -54,6 +54,15 @@ otherwise.
 The maximum size of the output variable is 2^31 bytes. wfdb2mat from versions
 10.5.24 and earlier of the WFDB software package writes version 4 MAT files
 which have the additional constraint of 100,000,000 elements per variable.
+Longer outputs are divided among several .mat files (RECm_1.mat, RECm_2.mat,
+...), each of which is a segment of the multi-segment output record RECm.
+The -c option can be used to choose a smaller size for these files.
+
+Samples are read in blocks of BLKLEN frames, converted to the output format,
+and written directly to the .mat file (the WFDB library's output functions are
+used only to write the header file).  If the length of the input record is not
+given in its header, it is calculated from the sizes of its signal files if
+possible, or found by a binary search otherwise.
 
 The output files (recordm.mat + recordm.hea) are still WFDB-compatible, given
 the .hea file constructed by this program.
@@ -76,6 +85,8 @@ wfdb2mat.
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <wfdb/wfdb.h>
 
 /* Output .mat data storage types (values of mattype), defined by the
@@ -85,9 +96,12 @@ wfdb2mat.
 #define MAT16 3	/* 16 bits per sample signed */
 #define	MAT32 5	/* 32 bits per sample signed */
 
+#define BLKLEN 16384	/* number of frames converted at a time */
+
 static char *help_strings[] = {
  "usage: %s -r RECORD [OPTIONS ...]\n",
  "where RECORD is the name of the input record, and OPTIONS may include:",
+ " -c N        write at most N columns (samples per signal) in each .mat file",
  " -f TIME     begin at specified time",
  " -h          print this usage summary",
  " -H          read multifrequency signals in high resolution mode",
@@ -109,6 +123,167 @@ static void help(const char *pname)
 	(void)fprintf(stderr, "%s\n", help_strings[i]);
 }
 
+/* Return the length of the open input record, in frames (or in samples of the
+   most frequently sampled signal, in high-resolution mode), as determined from
+   the sizes of its signal files, or 0 if this is not possible (because the
+   files are not local files, or their formats are not of fixed width). */
+static WFDB_Time flength(WFDB_Siginfo *si, int nsig, int highres)
+{
+    char *path;
+    int g, i, spfmax = 1, u;
+    long start;
+    struct stat st;
+    WFDB_Time len = 0, n;
+
+    for (i = 0; i < nsig; i++)
+	if (si[i].spf > spfmax) spfmax = si[i].spf;
+    for (g = 0; g <= si[nsig-1].group; g++) {
+	/* Find the size of a frame of group g in sixths of a byte. */
+	for (i = u = 0; i < nsig; i++) {
+	    if (si[i].group != g) continue;
+	    switch (si[i].fmt) {
+	      case 8: case 80: u += 6 * si[i].spf; break;
+	      case 16: case 61: case 160: u += 12 * si[i].spf; break;
+	      case 212: u += 9 * si[i].spf; break;
+	      case 310: case 311: u += 8 * si[i].spf; break;
+	      case 24: u += 18 * si[i].spf; break;
+	      case 32: u += 24 * si[i].spf; break;
+	      default: return (0);
+	    }
+	}
+	if (u == 0) continue;
+	for (i = 0; si[i].group != g; i++)
+	    ;
+	if (strcmp(si[i].fname, "-") == 0 ||
+	    (path = wfdbfile(si[i].fname, NULL)) == NULL ||
+	    strstr(path, "://") || stat(path, &st) != 0 ||
+	    (start = wfdbgetstart(i)) > st.st_size)
+	    return (0);
+	n = (WFDB_Time)(st.st_size - start) * 6 / u;
+	if (len == 0 || n < len) len = n;
+    }
+    if (highres) len *= spfmax;
+    return (len);
+}
+
+/* Fill in the .mat file prolog for a matrix of nrows signals, ncols samples
+   per signal, and nbytesofdata bytes of samples of type sub4type.
+
+   The entire file is composed of:
+       - 128 byte descriptive text
+       - 8 byte master tag. 4 bytes indicate data type = matrix, 4
+         bytes indicate data size.
+       - 4 subelements. Each subelement has a 4 byte tag giving the
+         data type of the elements, a 4 byte tag giving the subelement's
+         size, and the subelement's actual content.
+         - Subelement 1: array flags (8 + 8 bytes)
+         - Subelement 2: array dimension (8 + 8 bytes)
+         - Subelement 3: array name (8 + 8 bytes)
+         - Subelement 4: array content (8 + ?? bytes)
+       - padding (if needed) to make the file size a multiple of 8 bytes
+*/
+static void mkprolog(char *prolog, int nrows, WFDB_Time ncols,
+		     unsigned long nbytesofdata, int sub4type)
+{
+    /* mastertype=matrix, sub1type=UINT32, sub2type=INT32, sub3type=INT8
+       fieldversion=0x0100 indicating mat file */
+    int mastertype = 14, sub1type = 6, sub2type = 5, sub3type = 1,
+	fieldversion = 256, sub1class = 6;
+    unsigned long nbytesmaster, lremain;
+
+    memset(prolog, 0, 192);
+    lremain = nbytesofdata%8;
+    if (lremain==0){
+	nbytesmaster = nbytesofdata + 56;
+    }
+    else{
+	nbytesmaster = nbytesofdata + 64 - (lremain);
+    }
+
+    sprintf(prolog, "MATLAB 5.0");
+    prolog[124] = fieldversion & 0xff;
+    prolog[125] = (fieldversion >> 8) & 0xff;
+    sprintf(prolog + 126, "I");
+    sprintf(prolog + 127, "M");
+
+    prolog[128] = mastertype & 0xff;
+    prolog[132] = nbytesmaster & 0xff;
+    prolog[133] = (nbytesmaster >> 8) & 0xff;
+    prolog[134] = (nbytesmaster >> 16) & 0xff;
+    prolog[135] = (nbytesmaster >> 24) & 0xff;
+
+    prolog[136] = (sub1type & 0xff);
+    prolog[140] = 8 & 0xff;
+    prolog[144] = sub1class & 0xff;
+
+    prolog[152] = sub2type & 0xff;
+    prolog[156] = 8 & 0xff;
+    prolog[160] = nrows & 0xff;
+    prolog[161] = (nrows >> 8) & 0xff;
+    prolog[162] = (nrows >> 16) & 0xff;
+    prolog[163] = (nrows >> 24) & 0xff;
+    prolog[164] = ncols & 0xff;
+    prolog[165] = (ncols >> 8) & 0xff;
+    prolog[166] = (ncols >> 16) & 0xff;
+    prolog[167] = (ncols >> 24) & 0xff;
+
+    prolog[168] = sub3type & 0xff;
+    prolog[172] = 3 & 0xff;
+    sprintf(prolog + 176, "val");
+
+    prolog[184] = sub4type & 0xff;
+    prolog[188] = nbytesofdata & 0xff;
+    prolog[189] = (nbytesofdata >> 8) & 0xff;
+    prolog[190] = (nbytesofdata >> 16) & 0xff;
+    prolog[191] = (nbytesofdata >> 24) & 0xff;
+}
+
+/* Convert n frames of samples in v (nsig samples per frame, already offset
+   by adczero) to WFDB format fmt (80, 16, or 32) in buf, and return the number
+   of bytes in buf.  As in putvec, invalid samples are replaced by the lowest
+   value that can be represented in the output format, and each output sample
+   is added to the checksum of its signal. */
+static size_t encode(unsigned char *buf, WFDB_Sample *v, long n, int nsig,
+		     int fmt, int *cksum)
+{
+    long i;
+    int s;
+    unsigned char *p = buf;
+    WFDB_Sample x;
+
+    switch (fmt) {
+      case 80:
+	for (i = 0; i < n; i++)
+	    for (s = 0; s < nsig; s++) {
+		if ((x = *v++) == WFDB_INVALID_SAMPLE) x = -1 << 7;
+		*p++ = (x & 0xff) + (1 << 7);
+		cksum[s] += x;
+	    }
+	break;
+      case 16:
+	for (i = 0; i < n; i++)
+	    for (s = 0; s < nsig; s++) {
+		x = *v++;	/* WFDB_INVALID_SAMPLE is -1 << 15 */
+		*p++ = x & 0xff;
+		*p++ = (x >> 8) & 0xff;
+		cksum[s] += x;
+	    }
+	break;
+      case 32:
+	for (i = 0; i < n; i++)
+	    for (s = 0; s < nsig; s++) {
+		if ((x = *v++) == WFDB_INVALID_SAMPLE) x = INT_MIN;
+		*p++ = x & 0xff;
+		*p++ = (x >> 8) & 0xff;
+		*p++ = (x >> 16) & 0xff;
+		*p++ = (x >> 24) & 0xff;
+		cksum[s] += x;
+	    }
+	break;
+    }
+    return (p - buf);
+}
+
 static char *prog_name(const char *s)
 {
     const char *p = s + strlen(s);
@@ -132,43 +307,34 @@ int main(int argc, char *argv[])
 {
     char *matname, *orec, *p, *q, *record = NULL, *search = NULL;
 
-    /* The entire file is composed of:
-       - 128 byte descriptive text
-       - 8 byte master tag. 4 bytes indicate data type = matrix, 4
-         bytes indicate data size.
-       - 4 subelements. Each subelement has a 4 byte tag giving the
-         data type of the elements, a 4 byte tag giving the subelement's
-         size, and the subelement's actual content.
-         - Subelement 1: array flags (8 + 8 bytes)
-         - Subelement 2: array dimension (8 + 8 bytes)
-         - Subelement 3: array name (8 + 8 bytes)
-         - Subelement 4: array content (8 + ?? bytes)
-    */
     static char prolog[192];  /* 128 byte descriptive text
 				 + 64 bytes of fixed length content */
-    /* mastertype=matrix, sub1type=UINT32, sub2type=INT32, sub3type=INT8
-       fieldversion=0x0100 indicating mat file */
-    int highres = 0, i, isiglist, mattype, nisig, nosig = 0, pflag = 0,
-	mastertype = 14, sub1type = 6, sub2type = 5, sub3type = 1, sub4type,
-	fieldversion = 256, s, sfname = 0, *sig = NULL, stat = 0, vflag = 0,
-	sub1class = 6, nbytesperelement, wfdbtype, offset;
-
-    /* nbytesmaster is the value specified in the master tag
-       representing the size of all following content.
-       nbytesofdata gives the number of bytes of signal data.
-       lremain stores the number of bytes to pad to make the file size
-       a multiple of 8.
-       max_length is the maximum permissible signal length. */
-    unsigned long nbytesmaster, nbytesofdata, lremain, max_length;
+    char **info = NULL, **segname, **segstart;
+    int highres = 0, i, isiglist, k, nfiles, ninfo, nisig, nosig = 0, s,
+	sfname = 0, *sig = NULL, stat = 0, sub4type, nbytesperelement,
+	wfdbtype, offset, *cksum, *zero;
+    unsigned char *ob;
+
+    /* nbytesofdata gives the number of bytes of signal data in a .mat file.
+       max_length is the maximum permissible signal length in one file. */
+    unsigned long nbytesofdata, max_length;
 
     WFDB_Frequency freq;
-    WFDB_Sample *vi, *vo;
+    WFDB_Sample *vi, *initval, *vb;
     WFDB_Siginfo *si, *so;
-    WFDB_Time from = 0L, maxl = 0L, t, to = 0L, lower, upper;
+    WFDB_Time from = 0L, maxl = 0L, maxcols = 0L, t, tinvalid, to = 0L,
+	lower, upper;
     const char *pname = prog_name(argv[0]);
 
     for (i = 1 ; i < argc; i++) {
 	if (*argv[i] == '-') switch (*(argv[i]+1)) {
+	  case 'c':	/* maximum number of columns per .mat file follows */
+	    if (++i >= argc || (maxcols = atol(argv[i])) <= 0) {
+		(void)fprintf(stderr,
+			      "%s: number of columns must follow -c\n", pname);
+		exit(1);
+	    }
+	    break;
 	  case 'f':	/* starting time */
 	    if (++i >= argc) {
 		(void)fprintf(stderr, "%s: time must follow -f\n", pname);
@@ -262,7 +428,6 @@ int main(int argc, char *argv[])
 
     if (nosig) {	      /* convert samples only from specified signals */
 	SUALLOC(so, nosig, sizeof(WFDB_Siginfo));
-	SUALLOC(vo, nosig, sizeof(WFDB_Sample));
 	SUALLOC(sig, nosig, sizeof(int));
 	for (i = 0; i < nosig; i++) {
 	    if ((s = findsig(argv[isiglist+i])) < 0) {
@@ -276,7 +441,6 @@ int main(int argc, char *argv[])
     else {			/* convert samples from all signals */
 	nosig = nisig;
 	SUALLOC(so, nosig, sizeof(WFDB_Siginfo));
-	SUALLOC(vo, nosig, sizeof(WFDB_Sample));
 	SUALLOC(sig, nosig, sizeof(int));
 	for (i = 0; i < nosig; i++)
 	    sig[i] = i;
@@ -296,20 +460,28 @@ int main(int argc, char *argv[])
 
     t = strtim("e"); /* the end of the record */
     if (t == 0) {
-	/* record length unspecified; determine length by a binary search */
+	/* record length unspecified; try to calculate it from the sizes of
+	   the signal files, and confirm the result by reading the last frame */
 	wfdbquiet();
-	lower = 0;
-	upper = WFDB_TIME_MAX;
-	t = 16 * 1024;
-	while (lower < upper) {
-	    if (isigsettime(t) >= 0 && getvec(vi) > 0)
-		lower = t + 1;
-	    else
-		upper = t;
-	    if (upper == WFDB_TIME_MAX && t < WFDB_TIME_MAX / 2)
-		t *= 2;
-	    else
-		t = lower + (upper - lower) / 2;
+	if ((t = flength(si, nisig, highres)) > 0 &&
+	    (isigsettime(t-1) < 0 || getvec(vi) <= 0 ||
+	     (isigsettime(t) >= 0 && getvec(vi) > 0)))
+	    t = 0;
+	if (t == 0) {
+	    /* determine length by a binary search */
+	    lower = 0;
+	    upper = WFDB_TIME_MAX;
+	    t = 16 * 1024;
+	    while (lower < upper) {
+		if (isigsettime(t) >= 0 && getvec(vi) > 0)
+		    lower = t + 1;
+		else
+		    upper = t;
+		if (upper == WFDB_TIME_MAX && t < WFDB_TIME_MAX / 2)
+		    t *= 2;
+		else
+		    t = lower + (upper - lower) / 2;
+	    }
 	}
 	wfdbverbose();
 	if (isigsettime(from) < 0)
@@ -327,7 +499,7 @@ int main(int argc, char *argv[])
 	exit(1);
     }
 
-    /* Generate the names for the output .mat file and the output record. */
+    /* Generate the name for the output record. */
     p = record + strlen(record) - 1;	/* *p = final char of record name */
     if (*p == '/')	/* short form name ('rec/' rather than 'rec/rec') */
 	sfname = 1;
@@ -341,8 +513,6 @@ int main(int argc, char *argv[])
     for (p = orec; *p; p++)
 	if (*p == '.') *p = '_';
     *p = 'm';	/* append 'm' to the output record name */
-    SUALLOC(matname, strlen(record)+6, sizeof(char));
-    sprintf(matname, "%s.mat", orec);
 
     /* Determine if we can write 8-bit unsigned samples, or if 16 or 32 bits are
        needed per sample. */
@@ -377,7 +547,6 @@ int main(int argc, char *argv[])
 
     for (i = 0; i < nosig; i++) {
 	so[i] = si[sig[i]];
-	so[i].fname = matname;
 	so[i].group = 0;
 	so[i].spf = 1;
 	so[i].fmt = wfdbtype;
@@ -395,102 +564,136 @@ int main(int argc, char *argv[])
 	}
     }
 
-
-    /* Ensure the signal size does not exceed 2^31 byte limit */
+    /* Ensure the size of each output variable does not exceed the 2^31 byte
+       limit, by dividing the output among several files if necessary. */
     max_length = 2147483648/nbytesperelement/nosig;
-    if ((to - from) > max_length){
-	(void)fprintf(stderr, "%s: cannot write mat file -"
-		      " data size exceeds 2GB limit\n", pname);
-	exit(1);
-    }
+    if (maxcols <= 0 || maxcols > max_length)
+	maxcols = max_length;
+    nfiles = (to - from + maxcols - 1) / maxcols;
+    SUALLOC(segname, nfiles, sizeof(char *));
+    SUALLOC(segstart, nfiles, sizeof(char *));
+    SUALLOC(cksum, nfiles * nosig, sizeof(int));
+    SUALLOC(initval, nfiles * nosig, sizeof(WFDB_Sample));
+    SUALLOC(zero, nosig, sizeof(int));
+    SUALLOC(vb, BLKLEN * nosig, sizeof(WFDB_Sample));
+    SUALLOC(ob, BLKLEN * nosig, nbytesperelement);
+    for (i = 0; i < nosig; i++)
+	zero[i] = si[sig[i]].adczero;
 
-    nbytesofdata = nbytesperelement*nosig*(to-from);
-    lremain = nbytesofdata%8;
+    for (k = 0, t = from, tinvalid = to; k < nfiles; k++) {
+	WFDB_Time ncols, tf;
+	FILE *ofile;
 
-    if (lremain==0){
-	nbytesmaster = nbytesofdata + 56;
-    }
-    else{
-	nbytesmaster = nbytesofdata + 64 - (lremain);
-	for (i = 0; i < nosig; i++)
-	    so[i].bsize = 8;
-    }
+	if (nfiles == 1)
+	    SSTRCPY(segname[k], orec);
+	else {
+	    SUALLOC(segname[k], strlen(orec) + 16, 1);
+	    sprintf(segname[k], "%s_%d", orec, k+1);
+	}
+	SUALLOC(matname, strlen(segname[k])+5, sizeof(char));
+	sprintf(matname, "%s.mat", segname[k]);
+	if ((ofile = fopen(matname, "wb")) == NULL) {
+	    fprintf(stderr, "%s: can't create %s\n", pname, matname);
+	    wfdbquit();
+	    exit(1);
+	}
+	SSTRCPY(segstart[k], mstimstr(-t));
+
+	/* Write the prolog. */
+	ncols = (to - t < maxcols) ? to - t : maxcols;
+	nbytesofdata = nbytesperelement*nosig*ncols;
+	mkprolog(prolog, nosig, ncols, nbytesofdata, sub4type);
+	fwrite(prolog, 1, 192, ofile);
+
+	/* Read, convert, and write the samples in blocks. */
+	for (tf = t + ncols; t < tf; ) {
+	    long j, n = (tf - t < BLKLEN) ? tf - t : BLKLEN;
+	    WFDB_Sample *v = vb;
+
+	    for (j = 0; j < n && stat != -1 && stat != -3; j++, v += nosig) {
+		/* getvec returns -4 (checksum error) together with the
+		   samples of the last frame, which are kept. */
+		if ((stat = getvec(vi)) == -1 || stat == -3)
+		    break;
+		for (i = 0; i < nosig; i++)
+		    v[i] = vi[sig[i]] - zero[i];
+	    }
+	    if (j < n) {	/* end of input: fill with invalid samples */
+		if (t + j < tinvalid)
+		    tinvalid = t + j;
+		for (v = vb + j*nosig; v < vb + n*nosig; v++)
+		    *v = WFDB_INVALID_SAMPLE;
+	    }
+	    if (t == tf - ncols)
+		for (i = 0; i < nosig; i++)
+		    initval[k*nosig + i] = vb[i];
+	    fwrite(ob, 1, encode(ob, vb, n, nosig, wfdbtype, cksum + k*nosig),
+		   ofile);
+	    t += n;
+	}
 
-    /* Create an empty .mat file. */
-    if (osigfopen(so, nosig) != nosig) {
-	wfdbquit();		/* failed to open output, quit */
-	exit(1);
+	/* Pad the file to a multiple of 8 bytes. */
+	if (nbytesofdata % 8) {
+	    static char pad[8];
+	    fwrite(pad, 1, 8 - nbytesofdata % 8, ofile);
+	}
+	if (ferror(ofile) || fclose(ofile)) {
+	    fprintf(stderr, "%s: error writing %s\n", pname, matname);
+	    wfdbquit();
+	    exit(1);
+	}
+	SFREE(matname);
     }
-    
-    /* Fill in the .mat file's prolog and write it. */
-
-    sprintf(prolog, "MATLAB 5.0");
-    prolog[124] = fieldversion & 0xff;
-    prolog[125] = (fieldversion >> 8) & 0xff;
-    sprintf(prolog + 126, "I");
-    sprintf(prolog + 127, "M");
-
-    prolog[128] = mastertype & 0xff;
-    prolog[132] = nbytesmaster & 0xff;
-    prolog[133] = (nbytesmaster >> 8) & 0xff;
-    prolog[134] = (nbytesmaster >> 16) & 0xff;
-    prolog[135] = (nbytesmaster >> 24) & 0xff;
 
-    prolog[136] = (sub1type & 0xff);
-    prolog[140] = 8 & 0xff;
-    prolog[144] = sub1class & 0xff;
-
-    prolog[152] = sub2type & 0xff;
-    prolog[156] = 8 & 0xff;
-    prolog[160] = nosig & 0xff;
-    prolog[161] = (nosig >> 8) & 0xff;
-    prolog[162] = (nosig >> 16) & 0xff;
-    prolog[163] = (nosig >> 24) & 0xff;
-    prolog[164] = (to - from) & 0xff;
-    prolog[165] = ((to - from) >> 8) & 0xff;
-    prolog[166] = ((to - from) >> 16) & 0xff;
-    prolog[167] = ((to - from) >> 24) & 0xff;
-
-    prolog[168] = sub3type & 0xff;
-    prolog[172] = 3 & 0xff;
-    sprintf(prolog + 176, "val");
+    if (tinvalid < to)
+	fprintf(stderr,
+		"%s (warning): final %"WFDB_Pd_TIME" columns are invalid\n",
+		pname, to - tinvalid);
 
-    prolog[184] = sub4type & 0xff;
-    prolog[188] = nbytesofdata & 0xff;
-    prolog[189] = (nbytesofdata >> 8) & 0xff;
-    prolog[190] = (nbytesofdata >> 16) & 0xff;
-    prolog[191] = (nbytesofdata >> 24) & 0xff;
+    /* Save the info strings of the input record. */
+    for (ninfo = 0; (p = getinfo(NULL)); ninfo++) {
+	SREALLOC(info, ninfo+1, sizeof(char *));
+	info[ninfo] = NULL;
+	SSTRCPY(info[ninfo], p);
+    }
 
-    wfdbputprolog((char *)prolog, 192, 0);
+    /* Write the header file(s). */
+    setsampfreq(freq);
+    for (k = t = 0; k < nfiles; k++) {
+	WFDB_Time ncols = (to - from - t < maxcols) ? to - from - t : maxcols;
 
-    for (t = from; t < to && stat >= 0; t++) {
-	stat = getvec(vi);
-	for (i = 0; i < nosig; i++)
-	    vo[i] = vi[sig[i]] - si[sig[i]].adczero;
-	if (putvec(vo) != nosig)
-	    break;
+	for (i = 0; i < nosig; i++) {
+	    so[i].fname = NULL;
+	    SUALLOC(so[i].fname, strlen(segname[k])+5, sizeof(char));
+	    sprintf(so[i].fname, "%s.mat", segname[k]);
+	    so[i].nsamp = ncols;
+	    so[i].initval = initval[k*nosig + i];
+	    so[i].cksum = cksum[k*nosig + i];
+	    so[i].bsize = (nbytesperelement*nosig*ncols) % 8 ? 8 : 0;
+	}
+	if (*segstart[k] == '[') {
+	    SSTRCPY(p, segstart[k]);
+	    setbasetime(p+1);
+	    SFREE(p);
+	}
+	wfdbsetstart(0, 192);
+	setheader(segname[k], so, nosig);
+	t += ncols;
     }
-
-    if (t != to) {
-	fprintf(stderr,
-		"%s (warning): final %"WFDB_Pd_TIME" columns are invalid\n",
-		pname, to - t);
-	for (i = 0; i < nosig; i++)
-	    vo[i] = WFDB_INVALID_SAMPLE;
-	while (t++ < to)
-	    putvec(vo);
+    if (nfiles > 1) {
+	/* Write the master header for a multi-segment record.  This closes
+	   the input record, and reading the segment headers resets the base
+	   time, so restore it for the summary below. */
+	setmsheader(orec, segname, nfiles);
+	if (*segstart[0] == '[') {
+	    SSTRCPY(p, segstart[0]);
+	    setbasetime(p+1);
+	    SFREE(p);
+	}
     }
 
-    setsampfreq(freq);
-    p = mstimstr(-from);
-    if (p && *p == '[')
-	setbasetime(p+1);
-    newheader(orec);
-
-    if (p = getinfo(NULL))
-	do {
-	    (void)putinfo(p);
-	} while (p = getinfo((char *)NULL));
+    for (i = 0; i < ninfo; i++)
+	(void)putinfo(info[i]);
 
     SUALLOC(p, strlen(record)+80, 1);
     (void)sprintf(p, "Creator: %s", pname);
@@ -1,5 +1,5 @@
 /* file: annot.c	G. Moody       	 13 April 1989
-			Last revised:   4 November 2020  	wfdblib 10.7.0
+			Last revised:   18 October 2026  	wfdblib 10.7.0
 WFDB library functions for annotations
 
 _______________________________________________________________________________
@@ -38,6 +38,15 @@ This file also contains definitions of the following WFDB library functions:
  ungetann [5.3]		(pushes an annotation back into an input stream)
  putann			(writes an annotation)
  iannsettime		(skips to a specified time in input annotation files)
+ annmerge [10.7.1]	(selects input annotators to be read by getmergedann)
+ getmergedann [10.7.1]	(reads the next annotation from merged annotators)
+ getannsummary [10.7.1]	(summarizes an annotator)
+ putannsummary [10.7.1]	(writes an annotator summary file)
+ freeannsummary [10.7.1] (frees memory allocated by getannsummary)
+ newhrstats [10.7.1]	(allocates and initializes heart rate statistics)
+ hrstatsann [10.7.1]	(adds an annotation to heart rate statistics)
+ endhrstats [10.7.1]	(summarizes heart rate statistics)
+ freehrstats [10.7.1]	(frees memory allocated by newhrstats)
  ecgstr			(converts MIT annotation codes to ASCII strings)
  strecg			(converts ASCII strings to MIT annotation codes)
  setecgstr		(modifies code-to-string translation table)
@@ -100,6 +109,7 @@ may be attached to the same signal provided that their num fields are unique.
 #include "ecgmap.h"
 
 #include <limits.h>
+#include <sys/stat.h>
 
 /* Annotation word format */
 #define CODE	0176000	/* annotation code segment of annotation word */
@@ -183,6 +193,15 @@ static struct oadata {
 } **oad;
 static WFDB_Frequency oafreq;	/* time resolution in ticks/sec for newly-
 				   created output annotators */
+static unsigned nmrg;		/* number of annotators being merged */
+static struct mrgdata {
+    WFDB_Annotator an;		/* input annotator number */
+    WFDB_Annotation ann;	/* next annotation from this annotator */
+} *mrg;
+static unsigned *mheap;		/* heap of indices into mrg */
+static unsigned nmheap;		/* number of annotators in mheap */
+static unsigned char mauxstr[AUXBUFLEN]; /* aux string of the annotation most
+				   recently returned by getmergedann */
 static int annclose_error;	/* if <0, error occurred while closing
 				   annotation files */
 
@@ -770,6 +789,922 @@ FINT iannsettime(WFDB_Time t)
     return (stat);	/* -1 if all inputs are invalid, 0 otherwise */
 }
 
+/* Merging annotators
+
+   annmerge and getmergedann read annotations from several input annotators
+   as a single stream in canonical (time, num, chan) order.  Simultaneous
+   annotations with equal num and chan fields are returned in the order in
+   which their annotators were given to annmerge.  The next annotation from
+   each annotator is kept in mrg[], and mheap[] is a binary heap of the
+   indices of the annotators that have not reached EOF, ordered by these
+   annotations, so that each annotation is returned in O(log n) time when n
+   annotators are merged. */
+
+/* mrglt returns non-zero if the next annotation from mrg[i] precedes that from
+   mrg[j]. */
+static int mrglt(unsigned i, unsigned j)
+{
+    WFDB_Annotation *a = &mrg[i].ann, *b = &mrg[j].ann;
+
+    if (a->time != b->time) return (a->time < b->time);
+    if (a->num != b->num) return (a->num < b->num);
+    if (a->chan != b->chan) return (a->chan < b->chan);
+    return (i < j);
+}
+
+/* mrgsift restores the heap property after mheap[k] has been replaced. */
+static void mrgsift(unsigned k)
+{
+    unsigned c, t;
+
+    while ((c = 2*k + 1) < nmheap) {
+	if (c+1 < nmheap && mrglt(mheap[c+1], mheap[c])) c++;
+	if (!mrglt(mheap[c], mheap[k])) break;
+	t = mheap[c]; mheap[c] = mheap[k]; mheap[k] = t;
+	k = c;
+    }
+}
+
+/* annmerge: prepare to merge the n input annotators listed in alist (or all
+   open input annotators, if alist is NULL) */
+FINT annmerge(const WFDB_Annotator *alist, unsigned int n)
+{
+    unsigned i, k, t;
+    int stat;
+
+    nmrg = nmheap = 0;
+    if (alist == NULL) n = niaf;
+    SREALLOC(mrg, n, sizeof(struct mrgdata));
+    SREALLOC(mheap, n, sizeof(unsigned));
+    if ((n > 0 && mrg == NULL) || (n > 0 && mheap == NULL))
+	return (-3);
+    for (i = 0; i < n; i++) {
+	mrg[i].an = alist ? alist[i] : i;
+	if (mrg[i].an >= niaf || iad[mrg[i].an] == NULL) {
+	    wfdb_error("annmerge: can't read annotator %d\n", mrg[i].an);
+	    return (-2);
+	}
+    }
+    nmrg = n;
+    for (i = 0; i < n; i++) {
+	if ((stat = getann(mrg[i].an, &mrg[i].ann)) == -1)
+	    continue;		/* this annotator is empty */
+	else if (stat < 0) {
+	    nmrg = nmheap = 0;
+	    return (stat);
+	}
+	for (mheap[k = nmheap++] = i; k > 0; k = (k-1)/2) {
+	    if (!mrglt(mheap[k], mheap[(k-1)/2])) break;
+	    t = mheap[k]; mheap[k] = mheap[(k-1)/2]; mheap[(k-1)/2] = t;
+	}
+    }
+    return (0);
+}
+
+/* getmergedann: read the next annotation from the annotators selected by
+   annmerge into *annot, and the number of its annotator into *an */
+FINT getmergedann(WFDB_Annotator *an, WFDB_Annotation *annot)
+{
+    struct mrgdata *m;
+    int stat;
+
+    if (nmrg == 0) {
+	wfdb_error("getmergedann: no annotators selected by annmerge\n");
+	return (-2);
+    }
+    if (nmheap == 0)
+	return (-1);
+    m = &mrg[mheap[0]];
+    *annot = m->ann;
+    if (an) *an = m->an;
+    /* Copy the aux string, since reading the next annotation from the same
+       annotator may overwrite it. */
+    if (annot->aux) {
+	memcpy(mauxstr, annot->aux, *(annot->aux) + 2);
+	annot->aux = mauxstr;
+    }
+    if ((stat = getann(m->an, &m->ann)) == -1)
+	mheap[0] = mheap[--nmheap];
+    else if (stat < 0) {
+	nmrg = nmheap = 0;
+	return (stat);
+    }
+    mrgsift(0);
+    return (0);
+}
+
+/* Annotation summaries
+
+getannsummary summarizes an annotator:  it finds the times of its earliest and
+latest annotations, counts its annotations by anntyp, subtyp, and chan, and
+collects its RHYTHM and NOISE annotations (the beginnings of rhythm and noise
+episodes).  Doing so requires reading the entire annotation file, but
+putannsummary saves the summary in a small text file (record.annotator.sum,
+in the current directory), and getannsummary reads the summary from this file
+instead if it can find it in the WFDB path and if the size and modification
+time of the annotation file are those recorded in it.  Annotation files that
+are not local files are always read in full. */
+
+struct annsumdata {		/* a WFDB_Annsummary and its private data */
+    WFDB_Annsummary s;
+    char *record;		/* record name */
+    char *annotator;		/* annotator name */
+    int keyed;			/* if non-zero, the annotation file is a
+				   local file, with the size and mtime below */
+    long long size;		/* size of the annotation file in bytes */
+    long long mtime;		/* modification time of the annotation file */
+    double tmul;		/* see iadata, above */
+};
+
+/* annsumclear frees the episode table of a summary under construction, in
+   which each aux string has been allocated separately. */
+static void annsumclear(WFDB_Annsummary *s)
+{
+    long i;
+
+    if (s->episode) {
+	for (i = 0; i < s->nepisode; i++)
+	    SFREE(s->episode[i].aux);
+	SFREE(s->episode);
+    }
+    s->nepisode = 0;
+}
+
+/* annsumadd appends a copy of *annot to the episode table of s. */
+static int annsumadd(WFDB_Annsummary *s, long *nmax, const WFDB_Annotation *annot)
+{
+    WFDB_Annotation *e = s->episode;
+
+    if (s->nepisode >= *nmax) {
+	SREALLOC(e, *nmax ? 2 * *nmax : 64, sizeof(WFDB_Annotation));
+	if (e == NULL)
+	    return (-1);
+	s->episode = e;
+	*nmax = *nmax ? 2 * *nmax : 64;
+    }
+    e = &s->episode[s->nepisode];
+    *e = *annot;
+    e->aux = NULL;
+    if (annot->aux) {
+	SUALLOC(e->aux, *annot->aux + 2, 1);
+	if (e->aux == NULL)
+	    return (-1);
+	memcpy(e->aux, annot->aux, *annot->aux + 1);
+    }
+    s->nepisode++;
+    return (0);
+}
+
+/* annsumpack copies s into a single block of memory, and frees the episode
+   table of s. */
+static struct annsumdata *annsumpack(WFDB_Annsummary *s)
+{
+    long i;
+    size_t auxlen = 0;
+    unsigned char *p;
+    struct annsumdata *d;
+
+    for (i = 0; i < s->nepisode; i++)
+	if (s->episode[i].aux)
+	    auxlen += *s->episode[i].aux + 2;
+    if ((d = calloc(1, sizeof(struct annsumdata) +
+		    s->nepisode * sizeof(WFDB_Annotation) + auxlen)) != NULL) {
+	d->s = *s;
+	d->s.episode = (WFDB_Annotation *)(d + 1);
+	p = (unsigned char *)(d->s.episode + s->nepisode);
+	for (i = 0; i < s->nepisode; i++) {
+	    d->s.episode[i] = s->episode[i];
+	    if (s->episode[i].aux) {
+		memcpy(p, s->episode[i].aux, *s->episode[i].aux + 2);
+		d->s.episode[i].aux = p;
+		p += *p + 2;
+	    }
+	}
+    }
+    else
+	wfdb_error("getannsummary: insufficient memory\n");
+    annsumclear(s);
+    return (d);
+}
+
+/* annsumscan reads annotator an to the end, and summarizes it. */
+static struct annsumdata *annsumscan(WFDB_Annotator an)
+{
+    int stat;
+    long nmax = 0;
+    WFDB_Annotation annot;
+    WFDB_Annsummary s;
+
+    memset(&s, 0, sizeof(s));
+    while ((stat = getann(an, &annot)) == 0) {
+	if (s.nann++ == 0)
+	    s.first = s.last = annot.time;
+	else if (annot.time < s.first)
+	    s.first = annot.time;
+	else if (annot.time > s.last)
+	    s.last = annot.time;
+	s.nanntyp[(unsigned char)annot.anntyp]++;
+	s.nsubtyp[annot.subtyp + 128]++;
+	s.nchan[annot.chan]++;
+	if ((annot.anntyp == RHYTHM || annot.anntyp == NOISE) &&
+	    annsumadd(&s, &nmax, &annot) < 0) {
+	    stat = -3;
+	    break;
+	}
+    }
+    if (stat != -1) {	/* an error other than end of file */
+	annsumclear(&s);
+	return (NULL);
+    }
+    return (annsumpack(&s));
+}
+
+/* annsumname returns the name of the summary file for an annotator.  (This
+   name is passed to wfdb_open as a record name with an empty file type, since
+   wfdb_open would truncate a file type such as "atr.sum" to "atr" if no file
+   with the full name were found.) */
+static char *annsumname(const char *record, const char *annotator)
+{
+    char *name = NULL;
+
+    SUALLOC(name, strlen(record) + strlen(annotator) + 6, 1);
+    if (name)
+	sprintf(name, "%s.%s.sum", record, annotator);
+    return (name);
+}
+
+/* annsumload reads the summary file for the annotator described by *key, and
+   returns the summary if the file matches the key. */
+static struct annsumdata *annsumload(const struct annsumdata *key)
+{
+    char *buf = NULL, *p, *name;
+    unsigned char aux[257];
+    int a, c, n, num, pos, sub, x, ok = 0;
+    unsigned o;
+    long nmax = 0, count;
+    long long size, mtime;
+    double tmul;
+    size_t bufsize = 0;
+    WFDB_Annotation annot;
+    WFDB_Annsummary s;
+    WFDB_FILE *ifile;
+    struct annsumdata *d = NULL;
+
+    if ((name = annsumname(key->record, key->annotator)) == NULL)
+	return (NULL);
+    if ((ifile = wfdb_open("", name, WFDB_READ)) == NULL) {
+	SFREE(name);
+	return (NULL);
+    }
+    SFREE(name);
+    name = wfdbfile(NULL, NULL);	/* the path of the summary file */
+    memset(&s, 0, sizeof(s));
+    if (wfdb_getline(&buf, &bufsize, ifile) == 0 ||
+	strcmp(buf, "#WFDB annotation summary\n") != 0 ||
+	wfdb_getline(&buf, &bufsize, ifile) == 0 ||
+	sscanf(buf, "key %lld %lld %lf", &size, &mtime, &tmul) != 3 ||
+	size != key->size || mtime != key->mtime || tmul != key->tmul) {
+	wfdb_error("getannsummary: ignoring '%s' (it does not match annotator"
+		   " %s)\n", name, key->annotator);
+	goto done;
+    }
+    while (wfdb_getline(&buf, &bufsize, ifile) > 0) {
+	if (strcmp(buf, "end\n") == 0) {
+	    ok = 1;
+	    break;
+	}
+	else if (sscanf(buf, "time %"WFDB_Sd_TIME" %"WFDB_Sd_TIME" %ld",
+			&s.first, &s.last, &s.nann) == 3)
+	    continue;
+	else if (sscanf(buf, "anntyp %d %ld", &x, &count) == 2 &&
+		 0 <= x && x < 256)
+	    s.nanntyp[x] = count;
+	else if (sscanf(buf, "subtyp %d %ld", &x, &count) == 2 &&
+		 -128 <= x && x < 128)
+	    s.nsubtyp[x + 128] = count;
+	else if (sscanf(buf, "chan %d %ld", &x, &count) == 2 &&
+		 0 <= x && x < 256)
+	    s.nchan[x] = count;
+	else if (sscanf(buf, "episode %"WFDB_Sd_TIME" %d %d %d %d %d%n",
+			&annot.time, &a, &sub, &c, &num, &n, &pos) == 6 &&
+		 n < 256) {
+	    annot.anntyp = a;
+	    annot.subtyp = sub;
+	    annot.chan = c;
+	    annot.num = num;
+	    annot.aux = NULL;
+	    if (n >= 0) {	/* decode the aux string (see putannsummary) */
+		for (p = buf + pos + 1, x = 1; *p && *p != '\n' && x <= n;
+		     x++, p++)
+		    if (*p != '\\')
+			aux[x] = *p;
+		    else if (sscanf(p+1, "%3o", &o) == 1 && o < 256) {
+			aux[x] = o;
+			p += 3;
+		    }
+		    else
+			break;
+		if (x != n+1 || (*p && *p != '\n'))
+		    break;
+		aux[0] = n;
+		aux[n+1] = '\0';
+		annot.aux = aux;
+	    }
+	    if (annsumadd(&s, &nmax, &annot) < 0)
+		break;
+	}
+	else
+	    break;
+    }
+    if (ok)
+	d = annsumpack(&s);
+    else {
+	wfdb_error("getannsummary: ignoring '%s' (format error)\n", name);
+	annsumclear(&s);
+    }
+
+ done:
+    SFREE(buf);
+    wfdb_fclose(ifile);
+    return (d);
+}
+
+/* getannsummary: summarize annotator 'annotator' of 'record' (see above) */
+FINT getannsummary(char *record, char *annotator, WFDB_Annsummary **summary)
+{
+    char *rec = NULL;
+    int stat;
+    unsigned an = niaf, savenmrg = nmrg, savenmheap = nmheap;
+    struct annsumdata key, *d = NULL;
+    struct stat st;
+    WFDB_Anninfo ai;
+
+    *summary = NULL;
+    memset(&key, 0, sizeof(key));
+    SUALLOC(rec, strlen(record) + 2, 1);
+    if (rec == NULL)
+	return (-3);
+    sprintf(rec, "+%s", record);	/* keep other annotators open */
+    ai.name = annotator;
+    ai.stat = WFDB_READ;
+    stat = annopen(rec, &ai, 1);
+    if (stat < 0) {
+	SFREE(rec);
+	return (stat);
+    }
+    key.record = rec + 1;
+    key.annotator = annotator;
+    key.tmul = iad[an]->tmul;
+    if (iad[an]->file->type == WFDB_LOCAL &&
+	fstat(fileno(iad[an]->file->fp), &st) == 0) {
+	key.keyed = 1;
+	key.size = st.st_size;
+	key.mtime = st.st_mtime;
+	if ((d = annsumload(&key)) != NULL)
+	    stat = 1;
+    }
+    if (d == NULL && (d = annsumscan(an)) == NULL)
+	stat = -3;
+    iannclose(an);
+    /* Other annotators have kept their numbers, so a merge in progress can
+       continue. */
+    nmrg = savenmrg;
+    nmheap = savenmheap;
+
+    if (d) {
+	d->record = d->annotator = NULL;
+	SSTRCPY(d->record, key.record);
+	SSTRCPY(d->annotator, annotator);
+	d->keyed = key.keyed;
+	d->size = key.size;
+	d->mtime = key.mtime;
+	d->tmul = key.tmul;
+	*summary = &d->s;
+    }
+    SFREE(rec);
+    return (stat);
+}
+
+/* putannsummary: write a summary file (see above) */
+FINT putannsummary(WFDB_Annsummary *summary)
+{
+    char *name;
+    int i;
+    long k;
+    unsigned char *p;
+    struct annsumdata *d = (struct annsumdata *)summary;
+    WFDB_Annotation *e;
+    WFDB_FILE *ofile;
+
+    if (d == NULL || d->record == NULL || d->annotator == NULL) {
+	wfdb_error("putannsummary: no summary\n");
+	return (-1);
+    }
+    if (!d->keyed) {
+	wfdb_error("putannsummary: annotator %s of record %s is not a local"
+		   " file\n", d->annotator, d->record);
+	return (-1);
+    }
+    if ((name = annsumname(d->record, d->annotator)) == NULL)
+	return (-3);
+    if ((ofile = wfdb_open("", name, WFDB_WRITE)) == NULL) {
+	wfdb_error("putannsummary: can't write '%s'\n", name);
+	SFREE(name);
+	return (-4);
+    }
+    SFREE(name);
+    wfdb_fprintf(ofile, "#WFDB annotation summary\n");
+    wfdb_fprintf(ofile, "key %lld %lld %.17g\n", d->size, d->mtime, d->tmul);
+    wfdb_fprintf(ofile, "time %"WFDB_Pd_TIME" %"WFDB_Pd_TIME" %ld\n",
+		 summary->first, summary->last, summary->nann);
+    for (i = 0; i < 256; i++)
+	if (summary->nanntyp[i])
+	    wfdb_fprintf(ofile, "anntyp %d %ld\n", i, summary->nanntyp[i]);
+    for (i = 0; i < 256; i++)
+	if (summary->nsubtyp[i])
+	    wfdb_fprintf(ofile, "subtyp %d %ld\n", i-128, summary->nsubtyp[i]);
+    for (i = 0; i < 256; i++)
+	if (summary->nchan[i])
+	    wfdb_fprintf(ofile, "chan %d %ld\n", i, summary->nchan[i]);
+    /* Aux strings are written as their lengths followed by their contents,
+       in which any characters other than printable ASCII characters (and
+       backslashes) are written as backslashes followed by three octal
+       digits. */
+    for (k = 0, e = summary->episode; k < summary->nepisode; k++, e++) {
+	wfdb_fprintf(ofile, "episode %"WFDB_Pd_TIME" %d %d %d %d %d",
+		     e->time, e->anntyp, e->subtyp, e->chan, e->num,
+		     e->aux ? *e->aux : -1);
+	if (e->aux) {
+	    wfdb_fprintf(ofile, " ");
+	    for (i = 1, p = e->aux + 1; i <= *e->aux; i++, p++)
+		if (' ' < *p && *p < 127 && *p != '\\')
+		    wfdb_fprintf(ofile, "%c", *p);
+		else
+		    wfdb_fprintf(ofile, "\\%03o", *p);
+	}
+	wfdb_fprintf(ofile, "\n");
+    }
+    wfdb_fprintf(ofile, "end\n");
+    if (wfdb_fclose(ofile) != 0) {
+	wfdb_error("putannsummary: error writing summary of annotator %s\n",
+		   d->annotator);
+	return (-4);
+    }
+    return (0);
+}
+
+/* freeannsummary: free memory allocated by getannsummary */
+FVOID freeannsummary(WFDB_Annsummary *summary)
+{
+    struct annsumdata *d = (struct annsumdata *)summary;
+
+    if (d) {
+	SFREE(d->record);
+	SFREE(d->annotator);
+	free(d);
+    }
+}
+
+/* Heart rate statistics
+
+newhrstats, hrstatsann, endhrstats, and freehrstats derive the heart rate
+measurements made by several WFDB applications from a single pass through an
+annotation file:  the RR interval series (as in ann2rr), instantaneous heart
+rate (as in ihr), a histogram of heart rates measured in overlapping 6-second
+windows and its summary (as in hrstats), time-domain heart rate variability
+measures, and evenly sampled, smoothed heart rate (as in tach).  The caller
+reads the annotations and passes each of them to hrstatsann, which stores the
+results for that annotation in the WFDB_Hrstats structure;  endhrstats then
+fills in the summaries.  Only a few seconds' worth of beat times are kept, so
+that memory use does not grow with the length of the record. */
+
+struct hrsbeat {
+    WFDB_Time t;		/* time of a beat */
+    int x;			/* non-zero if the interval ending with this beat
+				   is excluded from HR windows */
+};
+
+struct hrsdata {		/* a WFDB_Hrstats and its private data */
+    WFDB_Hrstats h;
+    int started;		/* non-zero once hrstatsann has been called */
+    char flag[256];		/* ihrflag[] */
+    long hist[WFDB_HRMAX+1];	/* hrhist[] */
+    WFDB_Time lastbeat;		/* time of the previous beat */
+    int lastnormal;		/* non-zero if the previous beat was normal */
+
+    /* time-domain HRV (NN interval) statistics */
+    WFDB_Time lastnn;		/* previous NN interval (0: none) */
+    double nnmean, nnm2;	/* running mean and sum of squared deviations */
+    double sumsqd;		/* sum of squared differences of adjacent NNs */
+    long nsd, n50;		/* number of such differences, and of those
+				   exceeding 50 ms */
+    long seg;			/* current 5-minute segment (-1: none) */
+    double segmean, segm2;	/* NN statistics for the current segment */
+    long segn;
+    double smean, sm2, sdsum;	/* statistics of the segment means and SDs */
+    long nseg, nsdseg;
+
+    /* 6-second HR windows (hrstats) */
+    struct hrsbeat *wb;		/* beats wmin-1 ... wmax (a ring) */
+    long wsize, wmin, wmax;	/* ring size (a power of 2) and indices */
+    int wexcl;			/* number of excluded intervals in window */
+    double wt;			/* time of the center of the next window */
+
+    /* evenly sampled HR (tach) */
+    struct hrsbeat *tb;		/* beats tmin-1 ... tmax (a ring) */
+    long tsize, tmin, tmax;
+    WFDB_Time tn, lastn;	/* next and last output sample numbers */
+    double decf, rdmax, rrate;
+    double *tbuf;		/* tach[] */
+    long tbufsize;
+
+    /* instantaneous HR (ihr) */
+    int lastann, last2ann, lastint, thisint;
+    WFDB_Time lasttime;
+    double mhr, ihrlast;
+};
+
+#define HRSEG	300.0		/* length of SDANN segments, in seconds */
+#define hrsabs(X)	((X) < 0 ? -(X) : (X))
+
+/* hrssqrt returns the square root of x (Newton's method, starting from above,
+   stopping when the estimate no longer decreases).  The WFDB library does not
+   otherwise need the math library. */
+static double hrssqrt(double x)
+{
+    double r, s;
+
+    if (!(x > 0.)) return (x == 0. ? 0. : x);
+    r = (x > 1.) ? x : 1.;
+    do {
+	s = r;
+	r = (r + x/r) / 2.;
+    } while (r < s);
+    return (s);
+}
+
+/* hrsgrow doubles the size of a ring of beats (*size elements, holding beats
+   lo ... hi). */
+static int hrsgrow(struct hrsbeat **r, long *size, long lo, long hi)
+{
+    long i, n = *size ? 2 * *size : 64;
+    struct hrsbeat *p = NULL;
+
+    SUALLOC(p, n, sizeof(struct hrsbeat));
+    if (p == NULL)
+	return (-3);
+    for (i = lo; *r && i <= hi; i++)
+	p[i & (n-1)] = (*r)[i & (*size-1)];
+    SFREE(*r);
+    *r = p;
+    *size = n;
+    return (0);
+}
+
+#define wbeat(D, A)	((D)->wb[(A) & ((D)->wsize-1)].t)
+#define wexcl(D, A)	((D)->wb[(A) & ((D)->wsize-1)].x)
+#define tbeat(D, A)	((D)->tb[(A) & ((D)->tsize-1)].t)
+
+/* hrswin adds a beat at time t to the 6-second HR windows, and adds the HR in
+   each window that ends before t to the histogram.  As in hrstats, windows
+   begin at 1-second intervals, starting with the first beat, and windows that
+   include intervals shorter than 0.2 seconds or longer than 3 seconds are
+   excluded. */
+static int hrswin(struct hrsdata *d, WFDB_Time t)
+{
+    double dt = 3 * d->h.sps, left, right, rr, rrcnt;
+    int hr;
+    WFDB_Time tmaxb, tminb;
+
+    if (d->wmax - d->wmin + 3 > d->wsize &&
+	hrsgrow(&d->wb, &d->wsize, d->wmin-1, d->wmax) < 0)
+	return (-3);
+    if (d->h.nbeats == 1) {	/* first beat */
+	wbeat(d, -1) = -1;	/* avoid division by zero if t is 0 */
+	wbeat(d, 0) = t;
+	d->wt = t + dt;
+	return (0);
+    }
+    wbeat(d, ++d->wmax) = t;
+    rr = t - wbeat(d, d->wmax-1);
+    wexcl(d, d->wmax) = !(0.2 * d->h.sps < rr && rr < dt);
+    d->wexcl += wexcl(d, d->wmax);
+
+    while ((tmaxb = wbeat(d, d->wmax)) > (right = d->wt + dt)) {
+	left = d->wt - dt;
+	while ((tminb = wbeat(d, d->wmin)) <= left)
+	    d->wexcl -= wexcl(d, d->wmin++);
+	if (d->wexcl == 0) {
+	    rrcnt = d->wmax - d->wmin
+		+ (tminb - left) / (tminb - wbeat(d, d->wmin-1))
+		- (tmaxb - right) / (tmaxb - wbeat(d, d->wmax-1));
+	    hr = (int)(10 * rrcnt + 0.5);
+	    if (hr > WFDB_HRMAX) hr = WFDB_HRMAX;
+	    d->hist[hr]++;
+	    d->h.nhr++;
+	}
+	d->wt += d->h.sps;
+    }
+    return (0);
+}
+
+/* hrstach adds a beat at time t to the tach input, and produces all of the
+   tach output samples that can be determined once it is known. */
+static int hrstach(struct hrsdata *d, WFDB_Time t)
+{
+    double dx, k = d->h.tachk, left, right, rrcnt, x;
+    WFDB_Time maxbt, minbt, start = d->h.from;
+
+    if (d->tmax - d->tmin + 3 > d->tsize &&
+	hrsgrow(&d->tb, &d->tsize, d->tmin-1, d->tmax) < 0)
+	return (-3);
+    if (d->tmax < 0) {		/* first beat */
+	tbeat(d, d->tmax = 0) = t;
+	return (0);
+    }
+    tbeat(d, ++d->tmax) = t;
+
+    while (d->lastn == 0 || d->tn < d->lastn) {
+	left = d->decf * (d->tn - k); right = d->decf * (d->tn + k);
+	if ((maxbt = tbeat(d, d->tmax)) < right)
+	    break;		/* wait for the next beat */
+	while ((minbt = tbeat(d, d->tmin)) <= left)
+	    d->tmin++;
+	if (d->tmin > 0)	/* get number of RR intervals in window */
+	    rrcnt = d->tmax - d->tmin
+		+ (minbt - left) / (minbt - tbeat(d, d->tmin-1))
+		- (maxbt - right) / (maxbt - tbeat(d, d->tmax-1));
+	else		/* handle samples between start and first beat */
+	    rrcnt = (tbeat(d, 0) - start > tbeat(d, 1) - tbeat(d, 0)) ?
+		(2. * d->decf * k) / (tbeat(d, 0) - start) :
+		(2. * d->decf * k) / (tbeat(d, 1) - tbeat(d, 0));
+	x = d->h.tachfreq * 30. * rrcnt / k;  /* beats per minute */
+	if (d->h.tachreject) {	/* reject outliers */
+	    dx = hrsabs(x - d->rrate);
+	    if (dx > 3.*d->rdmax) x = d->rrate;
+	    d->rdmax += (dx - d->rdmax)/20.;
+	    if (d->rdmax < 1.) d->rdmax = 1.;
+	}
+	d->rrate = x;
+	if (d->h.ntach >= d->tbufsize) {
+	    SREALLOC(d->tbuf, d->tbufsize ? 2*d->tbufsize : 256,
+		     sizeof(double));
+	    if (d->tbuf == NULL)
+		return (-3);
+	    d->tbufsize = d->tbufsize ? 2*d->tbufsize : 256;
+	    d->h.tach = d->tbuf;
+	}
+	if (d->h.ntach++ == 0)
+	    d->h.tachn = d->tn;
+	d->tbuf[d->h.ntach-1] = d->rrate;
+	d->tn++;
+    }
+    return (0);
+}
+
+/* hrsnn adds an NN interval of length rr, ending at time t, to the HRV
+   statistics. */
+static void hrsnn(struct hrsdata *d, WFDB_Time t, WFDB_Time rr)
+{
+    double delta;
+    long seg = (long)((t - d->h.from) / (HRSEG * d->h.sps));
+
+    delta = rr - d->nnmean;
+    d->nnmean += delta / d->h.nnn;
+    d->nnm2 += delta * (rr - d->nnmean);
+    if (d->lastnn > 0) {
+	delta = rr - d->lastnn;
+	d->sumsqd += delta * delta;
+	d->nsd++;
+	if (hrsabs(delta) > 0.05 * d->h.sps) d->n50++;
+    }
+    d->lastnn = rr;
+
+    if (seg != d->seg) {	/* close the previous segment */
+	if (d->segn > 0) {
+	    delta = d->segmean - d->smean;
+	    d->smean += delta / ++d->nseg;
+	    d->sm2 += delta * (d->segmean - d->smean);
+	    if (d->segn > 1) {
+		d->sdsum += hrssqrt(d->segm2 / (d->segn - 1));
+		d->nsdseg++;
+	    }
+	}
+	d->seg = seg;
+	d->segmean = d->segm2 = 0.;
+	d->segn = 0;
+    }
+    delta = rr - d->segmean;
+    d->segmean += delta / ++d->segn;
+    d->segm2 += delta * (rr - d->segmean);
+}
+
+/* hrsihr determines the instantaneous HR (if any) at an annotation of type
+   anntyp at time t, as ihr does.  It returns 0 if the annotation is not one
+   that bounds intervals. */
+static int hrsihr(struct hrsdata *d, int anntyp, WFDB_Time t)
+{
+    double dmhr, ihr, tol = d->h.ihrtol;
+
+    if (d->flag[anntyp]) {
+	ihr = d->h.sps*60./(t - d->lasttime);
+	dmhr = (ihr - d->mhr)/10.;
+	/* Limit the influence of any single observation on the predictor. */
+	if (dmhr > tol) dmhr = tol;
+	else if (dmhr < -tol) dmhr = -tol;
+	d->mhr += dmhr;
+	if (d->flag[d->lastann] && hrsabs(ihr - d->ihrlast) < tol &&
+	    hrsabs(ihr - d->mhr) < tol &&
+	    (d->flag[d->last2ann] || !d->h.ihrx)) {
+	    d->h.ihrok = 1;
+	    d->h.ihr = ihr;
+	    d->h.ihrstart = d->lasttime;
+	    d->h.ihrgap = d->lastint;
+	    d->thisint = 0;
+	}
+	d->ihrlast = ihr;
+    }
+    else if (!isqrs(anntyp))
+	return (0);
+    d->last2ann = d->lastann;
+    d->lastann = anntyp;
+    d->lasttime = t;
+    d->lastint = d->thisint;
+    d->thisint = 1;
+    return (1);
+}
+
+/* newhrstats: allocate and initialize heart rate statistics */
+FINT newhrstats(WFDB_Frequency sps, WFDB_Hrstats **hrstats)
+{
+    int i;
+    struct hrsdata *d;
+
+    if ((*hrstats = calloc(1, sizeof(struct hrsdata))) == NULL) {
+	wfdb_error("newhrstats: insufficient memory\n");
+	return (-3);
+    }
+    d = (struct hrsdata *)*hrstats;
+    d->h.sps = (sps > 0.) ? sps : WFDB_DEFFREQ;
+    d->h.ihrflag = d->flag;
+    for (i = 0; i <= ACMAX; i++)
+	d->flag[i] = (map1(i) == NORMAL);
+    d->h.ihrtol = 10.;
+    d->h.tachfreq = 2.;
+    d->h.tachk = 1.;
+    d->h.tachreject = 1;
+    d->h.tachrate = 80.;
+    d->h.hrhist = d->hist;
+    d->seg = -1;
+    d->wmin = d->wmax = 0;
+    d->tmin = 0;
+    d->tmax = -1;
+    d->lastann = d->last2ann = NOTQRS;
+    d->lastint = 1;
+    d->lasttime = -9999L;
+    d->mhr = 70.;
+    return (0);
+}
+
+/* hrstatsann: add an annotation to heart rate statistics */
+FINT hrstatsann(WFDB_Hrstats *h, const WFDB_Annotation *annot)
+{
+    int anntyp = (unsigned char)annot->anntyp, normal, tach;
+    struct hrsdata *d = (struct hrsdata *)h;
+    WFDB_Time t = annot->time;
+
+    if (!d->started) {
+	d->started = 1;
+	if (h->tachfreq > 0.) {
+	    d->decf = h->sps / h->tachfreq;
+	    d->tn = h->from / d->decf;
+	    d->lastn = h->to / d->decf;
+	    d->rrate = h->tachrate;
+	    d->rdmax = 40.;
+	}
+    }
+    h->beat = h->nn = h->ihrok = h->ntach = 0;
+    h->rr = 0;
+    if (t < h->from)
+	return (1);
+    /* Beats after the end of the interval may be needed for tach output. */
+    tach = (d->decf > 0. && (d->lastn == 0 || d->tn < d->lastn));
+    if (tach && isqrs(anntyp) && hrstach(d, t) < 0)
+	return (-3);
+    if (h->to > 0 && t > h->to)
+	return ((d->decf > 0. && (d->lastn == 0 || d->tn < d->lastn)) ? 1 : 0);
+
+    (void)hrsihr(d, anntyp, t);
+    if (!isqrs(anntyp))
+	return (1);
+    h->beat = 1;
+    normal = (map2(anntyp) == NORMAL);	/* not ectopic */
+    if (h->nbeats++ > 0) {
+	h->rr = t - d->lastbeat;
+	h->nrr++;
+	if (normal && d->lastnormal) {
+	    h->nn = 1;
+	    h->nnn++;
+	    hrsnn(d, t, h->rr);
+	}
+	else
+	    d->lastnn = 0;
+    }
+    d->lastbeat = t;
+    d->lastnormal = normal;
+    if (hrswin(d, t) < 0)
+	return (-3);
+    return (1);
+}
+
+/* endhrstats: summarize heart rate statistics */
+FVOID endhrstats(WFDB_Hrstats *h)
+{
+    double delta, mean, sdsum, sm2, smean, ssum, sum, target;
+    int i, max95, min5;
+    long c[WFDB_HRMAX+1], k, nseg, nsdseg;
+    struct hrsdata *d = (struct hrsdata *)h;
+
+    /* Summarize the HR histogram as hrstats does:  the extremes, the 5th and
+       95th percentiles, and the mean and standard deviation of the HRs
+       between these percentiles. */
+    h->hrlow = h->hr5 = h->hrmean = h->hr95 = h->hrhigh = 0;
+    h->hrsd = 0.;
+    if (h->nhr > 0) {
+	for (i = 0; d->hist[i] == 0; i++)
+	    ;
+	h->hrlow = i;
+	for (i = WFDB_HRMAX; d->hist[i] == 0; i--)
+	    ;
+	h->hrhigh = i;
+	memcpy(c, d->hist, sizeof(c));
+	for (i = h->hrlow, k = 0, target = 0.05 * h->nhr; k <= target; i++)
+	    k += c[i];
+	/* Adjust the count in the 5th percentile bin so that exactly 5% of
+	   the lowest values are excluded from the mean. */
+	c[--i] = k - target;
+	min5 = i;
+	for (i = h->hrhigh, k = 0; k <= target; i--)
+	    k += c[i];
+	c[++i] = k - target;	/* likewise for the 95th percentile */
+	max95 = i;
+	for (i = min5, k = 0, sum = 0; i <= max95; i++) {
+	    k += c[i];
+	    sum += c[i]*i;
+	}
+	if (k > 0) {
+	    mean = sum / k;
+	    for (i = min5, ssum = 0; i <= max95; i++)
+		ssum += c[i] * (i - mean) * (i - mean);
+	    h->hrmean = (int)(mean + 0.5);
+	    h->hrsd = hrssqrt(ssum / k);
+	}
+	h->hr5 = min5;
+	h->hr95 = max95;
+    }
+
+    /* Time-domain HRV measures, in seconds (pNN50 in percent). */
+    h->avnn = h->sdnn = h->sdann = h->sdnnidx = h->rmssd = h->pnn50 = 0.;
+    if (h->nnn > 0)
+	h->avnn = d->nnmean / h->sps;
+    if (h->nnn > 1)
+	h->sdnn = hrssqrt(d->nnm2 / (h->nnn - 1)) / h->sps;
+    if (d->nsd > 0) {
+	h->rmssd = hrssqrt(d->sumsqd / d->nsd) / h->sps;
+	h->pnn50 = 100. * d->n50 / d->nsd;
+    }
+    /* Include the current segment without closing it, so that endhrstats can
+       be called more than once. */
+    smean = d->smean; sm2 = d->sm2; sdsum = d->sdsum;
+    nseg = d->nseg; nsdseg = d->nsdseg;
+    if (d->segn > 0) {
+	delta = d->segmean - smean;
+	smean += delta / ++nseg;
+	sm2 += delta * (d->segmean - smean);
+	if (d->segn > 1) {
+	    sdsum += hrssqrt(d->segm2 / (d->segn - 1));
+	    nsdseg++;
+	}
+    }
+    if (nseg > 1)
+	h->sdann = hrssqrt(sm2 / (nseg - 1)) / h->sps;
+    if (nsdseg > 0)
+	h->sdnnidx = sdsum / nsdseg / h->sps;
+}
+
+/* freehrstats: free memory allocated by newhrstats */
+FVOID freehrstats(WFDB_Hrstats *h)
+{
+    struct hrsdata *d = (struct hrsdata *)h;
+
+    if (d) {
+	SFREE(d->wb);
+	SFREE(d->tb);
+	SFREE(d->tbuf);
+	free(d);
+    }
+}
+
 /* Functions for converting between anntyp values (annotation codes defined in
    <ecgcode.h>), mnemonics (short strings, usually only one character), and
    descriptive strings
@@ -1055,6 +1990,7 @@ FVOID iannclose(WFDB_Annotator n)
     struct iadata *ia;
 
     if (n < niaf && (ia = iad[n]) != NULL && ia->file != NULL) {
+	nmrg = nmheap = 0;	/* annotator numbers are about to change */
 	(void)wfdb_fclose(ia->file);
 	SFREE(ia->info.name);
 	SFREE(ia);
@@ -1329,10 +2265,265 @@ FINT putann(WFDB_Annotator a, const struct WFDB_ann_L *annot)
     return (wfdb_putann_LL(a, &lla));
 }
 
+#undef getmergedann
+FINT getmergedann(WFDB_Annotator *an, struct WFDB_ann_L *annot)
+{
+    WFDB_Annotation lla;
+    struct WFDB_ann_L la;
+    int stat;
+
+    stat = wfdb_getmergedann_LL(an, &lla);
+    if (stat < 0)
+	return (stat);
+
+    if (lla.time > LONG_MAX || lla.time < LONG_MIN)
+	lla.time = (lla.time < 0 ? LONG_MIN : LONG_MAX);
+
+    memset(&la, 0, sizeof(struct WFDB_ann_L));
+    la.time = lla.time;
+    la.anntyp = lla.anntyp;
+    la.subtyp = lla.subtyp;
+    la.chan = lla.chan;
+    la.num = lla.num;
+    la.aux = lla.aux;
+    *annot = la;
+    return (stat);
+}
+
 #undef iannsettime
 FINT iannsettime(long t)
 {
     return (wfdb_iannsettime_LL(t == LONG_MIN ? WFDB_TIME_MIN : t));
 }
 
+
+struct WFDB_annsummary_L {
+    /* WFDB_Time */ long first;
+    /* WFDB_Time */ long last;
+    long nann;
+    long nanntyp[256];
+    long nsubtyp[256];
+    long nchan[256];
+    long nepisode;
+    struct WFDB_ann_L *episode;
+    void *arena;	/* here, the WFDB_Annsummary from which this was made */
+};
+
+static long aclamp(WFDB_Time t)
+{
+    if (t > LONG_MAX || t < LONG_MIN)
+	return (t < 0 ? LONG_MIN : LONG_MAX);
+    return ((long)t);
+}
+
+#undef getannsummary
+FINT getannsummary(char *record, char *annotator,
+		   struct WFDB_annsummary_L **summary)
+{
+    int stat;
+    long k;
+    WFDB_Annsummary *s;
+    struct WFDB_annsummary_L *sl;
+
+    *summary = NULL;
+    if ((stat = wfdb_getannsummary_LL(record, annotator, &s)) < 0)
+	return (stat);
+    /* The aux strings are shared with the original, which is freed along
+       with the copy by the wrapper for freeannsummary. */
+    if ((sl = calloc(1, sizeof(*sl) +
+		     s->nepisode * sizeof(struct WFDB_ann_L))) == NULL) {
+	wfdb_freeannsummary_LL(s);
+	return (-3);
+    }
+    sl->first = aclamp(s->first);
+    sl->last = aclamp(s->last);
+    sl->nann = s->nann;
+    memcpy(sl->nanntyp, s->nanntyp, sizeof(sl->nanntyp));
+    memcpy(sl->nsubtyp, s->nsubtyp, sizeof(sl->nsubtyp));
+    memcpy(sl->nchan, s->nchan, sizeof(sl->nchan));
+    sl->nepisode = s->nepisode;
+    sl->episode = (struct WFDB_ann_L *)(sl + 1);
+    for (k = 0; k < s->nepisode; k++) {
+	sl->episode[k].time = aclamp(s->episode[k].time);
+	sl->episode[k].anntyp = s->episode[k].anntyp;
+	sl->episode[k].subtyp = s->episode[k].subtyp;
+	sl->episode[k].chan = s->episode[k].chan;
+	sl->episode[k].num = s->episode[k].num;
+	sl->episode[k].aux = s->episode[k].aux;
+    }
+    sl->arena = s;
+    *summary = sl;
+    return (stat);
+}
+
+#undef putannsummary
+FINT putannsummary(struct WFDB_annsummary_L *summary)
+{
+    return (wfdb_putannsummary_LL(summary ? summary->arena : NULL));
+}
+
+#undef freeannsummary
+FVOID freeannsummary(struct WFDB_annsummary_L *summary)
+{
+    if (summary) {
+	wfdb_freeannsummary_LL(summary->arena);
+	free(summary);
+    }
+}
+
+
+struct WFDB_hrstats_L {
+    WFDB_Frequency sps;
+    /* WFDB_Time */ long from;
+    /* WFDB_Time */ long to;
+    char *ihrflag;
+    double ihrtol;
+    int ihrx;
+    double tachfreq;
+    double tachk;
+    int tachreject;
+    double tachrate;
+    int beat;
+    /* WFDB_Time */ long rr;
+    int nn;
+    int ihrok;
+    double ihr;
+    /* WFDB_Time */ long ihrstart;
+    int ihrgap;
+    int ntach;
+    /* WFDB_Time */ long tachn;
+    double *tach;
+    long nbeats;
+    long nrr;
+    long nnn;
+    long *hrhist;
+    long nhr;
+    int hrlow, hr5, hrmean, hr95, hrhigh;
+    double hrsd;
+    double avnn;
+    double sdnn;
+    double sdann;
+    double sdnnidx;
+    double rmssd;
+    double pnn50;
+    void *arena;	/* here, the WFDB_Hrstats for which this is a copy */
+};
+
+/* hrsget_L copies everything from a WFDB_Hrstats into its copy. */
+static void hrsget_L(struct WFDB_hrstats_L *hl)
+{
+    WFDB_Hrstats *h = hl->arena;
+
+    hl->sps = h->sps;
+    hl->from = aclamp(h->from);
+    hl->to = aclamp(h->to);
+    hl->ihrflag = h->ihrflag;
+    hl->ihrtol = h->ihrtol;
+    hl->ihrx = h->ihrx;
+    hl->tachfreq = h->tachfreq;
+    hl->tachk = h->tachk;
+    hl->tachreject = h->tachreject;
+    hl->tachrate = h->tachrate;
+    hl->beat = h->beat;
+    hl->rr = aclamp(h->rr);
+    hl->nn = h->nn;
+    hl->ihrok = h->ihrok;
+    hl->ihr = h->ihr;
+    hl->ihrstart = aclamp(h->ihrstart);
+    hl->ihrgap = h->ihrgap;
+    hl->ntach = h->ntach;
+    hl->tachn = aclamp(h->tachn);
+    hl->tach = h->tach;
+    hl->nbeats = h->nbeats;
+    hl->nrr = h->nrr;
+    hl->nnn = h->nnn;
+    hl->hrhist = h->hrhist;
+    hl->nhr = h->nhr;
+    hl->hrlow = h->hrlow;
+    hl->hr5 = h->hr5;
+    hl->hrmean = h->hrmean;
+    hl->hr95 = h->hr95;
+    hl->hrhigh = h->hrhigh;
+    hl->hrsd = h->hrsd;
+    hl->avnn = h->avnn;
+    hl->sdnn = h->sdnn;
+    hl->sdann = h->sdann;
+    hl->sdnnidx = h->sdnnidx;
+    hl->rmssd = h->rmssd;
+    hl->pnn50 = h->pnn50;
+}
+
+/* hrsput_L copies the parameters from a copy into its WFDB_Hrstats. */
+static void hrsput_L(struct WFDB_hrstats_L *hl)
+{
+    WFDB_Hrstats *h = hl->arena;
+
+    h->sps = hl->sps;
+    h->from = hl->from;
+    h->to = hl->to;
+    h->ihrflag = hl->ihrflag;
+    h->ihrtol = hl->ihrtol;
+    h->ihrx = hl->ihrx;
+    h->tachfreq = hl->tachfreq;
+    h->tachk = hl->tachk;
+    h->tachreject = hl->tachreject;
+    h->tachrate = hl->tachrate;
+}
+
+#undef newhrstats
+FINT newhrstats(WFDB_Frequency sps, struct WFDB_hrstats_L **hrstats)
+{
+    int stat;
+    WFDB_Hrstats *h;
+    struct WFDB_hrstats_L *hl;
+
+    *hrstats = NULL;
+    if ((stat = wfdb_newhrstats_LL(sps, &h)) < 0)
+	return (stat);
+    if ((hl = calloc(1, sizeof(*hl))) == NULL) {
+	wfdb_freehrstats_LL(h);
+	return (-3);
+    }
+    hl->arena = h;
+    hrsget_L(hl);
+    *hrstats = hl;
+    return (stat);
+}
+
+#undef hrstatsann
+FINT hrstatsann(struct WFDB_hrstats_L *hrstats,
+		const struct WFDB_ann_L *annot)
+{
+    int stat;
+    WFDB_Annotation lla;
+
+    lla.time = annot->time;
+    lla.anntyp = annot->anntyp;
+    lla.subtyp = annot->subtyp;
+    lla.chan = annot->chan;
+    lla.num = annot->num;
+    lla.aux = annot->aux;
+    hrsput_L(hrstats);
+    stat = wfdb_hrstatsann_LL(hrstats->arena, &lla);
+    hrsget_L(hrstats);
+    return (stat);
+}
+
+#undef endhrstats
+FVOID endhrstats(struct WFDB_hrstats_L *hrstats)
+{
+    hrsput_L(hrstats);
+    wfdb_endhrstats_LL(hrstats->arena);
+    hrsget_L(hrstats);
+}
+
+#undef freehrstats
+FVOID freehrstats(struct WFDB_hrstats_L *hrstats)
+{
+    if (hrstats) {
+	wfdb_freehrstats_LL(hrstats->arena);
+	free(hrstats);
+    }
+}
+
 #endif /* WFDB_LARGETIME */
@@ -1,5 +1,5 @@
 /* file: signal.c	G. Moody	13 April 1989
-			Last revised:    18 May 2022		wfdblib 10.7.0
+			Last revised:   18 October 2026	wfdblib 10.7.0
 WFDB library functions for signals
 
 _______________________________________________________________________________
@@ -38,6 +38,12 @@ visible outside of this file:
  sigmap_init	(manages the signal maps)
  sigmap		(creates a virtual signal vector from a raw sample vector)
  edfparse [10.4.5](gets header info from an EDF file)
+ edffree [10.7.1](deallocates memory used to describe an EDF file)
+ halloc [10.7.1] (allocates memory for a parsed header)
+ htoken [10.7.1] (splits a token from a line of a header file)
+ hrest [10.7.1]	(returns the remainder of a line of a header file)
+ hparse [10.7.1] (parses the contents of a header file)
+ hread [10.7.1]	(reads the entire contents of a header file)
  readheader	(reads a header file)
  hsdfree	(deallocates memory used by readheader)
  flac_getsamp	(reads the next sample from a FLAC input file)
@@ -52,6 +58,10 @@ visible outside of this file:
  osigclose	(closes output signals)
  isgsetframe	(skips to a specified frame number in a specified signal group)
  getskewedframe	(reads an input frame, without skew correction)
+ edfdecode [10.7.1] (converts EDF or BDF samples from a data record)
+ edfgetframe [10.7.1] (reads an input frame from an EDF file)
+ edfseek [10.7.1](seeks to a signal within an EDF data record)
+ edfindex [10.7.1](reads the onsets of EDF+D data records)
  meansamp       (calculates mean of an array of samples)
  rgetvec        (reads a sample from each input signal without resampling)
  openosig       (opens output signals)
@@ -88,6 +98,9 @@ This file also contains definitions of the following WFDB library functions:
  wfdbgetstart [9.4](returns byte offset of sample 0 within signal file)
  wfdbsetstart [9.4](sets byte offset to be written by setheader)
  wfdbputprolog [10.4.15](writes a prolog to a signal file)
+ wfdb_parseheader [10.7.1] (parses the text of a header file)
+ wfdb_readheader [10.7.1] (reads and parses a header file)
+ wfdb_freeheader [10.7.1] (releases memory allocated by wfdb_parseheader)
  setinfo [10.5.11] (creates a .info file for a record)
  putinfo [4.0]	(writes a line of info for a record)
  getinfo [4.0]	(reads a line of info for a record)
@@ -109,6 +122,10 @@ This file also contains definitions of the following WFDB library functions:
  physadu [6.0]	(converts physical units to ADC units)
  sample [10.3.0](get a sample from a given signal at a given time)
  sample_valid [10.3.0](verify that last value returned by sample was valid)
+ getedfblock [10.7.1](reads one signal from a specified EDF data record)
+ getedfonset [10.7.1](returns the onset time of an EDF data record)
+ getenvelope [10.7.1](summarizes the input signals over an interval)
+ putenvelope [10.7.1](writes the summaries of the input signals to a file)
 
 (Numbers in brackets in the list above indicate the first version of the WFDB
 library that included the corresponding function.  Functions not so marked
@@ -210,8 +227,10 @@ void example(void)
 */
 static unsigned maxhsig;	/* # of hsdata structures pointed to by hsd */
 static WFDB_FILE *hheader;	/* file pointer for header file */
-static char *linebuf;		/* temporary buffer for reading header lines */
+static char *linebuf;		/* temporary buffer for reading header files */
 static size_t linebufsize;	/* size of linebuf */
+static WFDB_Hdrinfo *hdrinfo;	/* parsed header of the current record */
+static char *hdrrec;		/* name of the record described by hdrinfo */
 static struct hsdata {
     WFDB_Siginfo info;		/* info about signal from header */
     long start;			/* signal file byte offset to sample 0 */
@@ -322,6 +341,29 @@ static unsigned framelen;	/* total number of samples per frame */
 static int gvmode = DEFWFDBGVMODE;	/* getvec mode */
 static int gvc;			/* getvec sample-within-frame counter */
 static int isedf;		/* if non-zero, record is stored as EDF/EDF+ */
+#define EDFRECSPERBUF	16	/* minimum number of EDF data records per
+				   input buffer */
+#define EDFTALMAX	64	/* maximum length of a timekeeping TAL */
+static struct edfdata {		/* layout of an EDF or BDF file */
+    char *fname;		/* name of the file */
+    long start;			/* byte offset of the first data record */
+    long recsize;		/* length of a data record, in bytes (if 0,
+				   this structure is not in use) */
+    int bps;			/* bytes per sample (2: EDF, 3: BDF) */
+    unsigned nsig;		/* number of signals */
+    long *soff;			/* byte offset of each signal within a data
+				   record */
+    int *spf;			/* samples of each signal per data record */
+    WFDB_Time nrec;		/* number of data records (0: unknown) */
+    double spr;			/* duration of a data record, in seconds */
+    int annsig;			/* number of the annotation signal (or -1) */
+    int discont;		/* if non-zero, file is EDF+D or BDF+D */
+    WFDB_FILE *fp;		/* used by getedfblock and getedfonset only */
+    char *buf;			/* workspace for one data record */
+    double *onset;		/* onset of each data record, in seconds */
+    WFDB_Time nonset;		/* number of entries in onset */
+} hedf, iedf;		/* hedf is filled in by edfparse;  isigopen moves it
+			   to iedf when it opens the signals of an EDF file */
 static WFDB_Sample *sbuf = NULL;	/* buffer used by sample() */
 static int sample_vflag;	/* if non-zero, last value returned by sample()
 				   was valid */
@@ -766,12 +808,25 @@ static void read_edf_str(char *buf, int size, WFDB_FILE *ifile)
     }
 }
 
+/* Release the memory used to describe an EDF file. */
+static void edffree(struct edfdata *e)
+{
+    if (e->fp) (void)wfdb_fclose(e->fp);
+    SFREE(e->fname);
+    SFREE(e->soff);
+    SFREE(e->spf);
+    SFREE(e->buf);
+    SFREE(e->onset);
+    memset(e, 0, sizeof(struct edfdata));
+}
+
 /* get header information from an EDF file */
 static int edfparse(WFDB_FILE *ifile)
 {
     char buf[81], *edf_fname, *p;
     double *pmax, *pmin, spr, baseline;
-    int format, i, s, nsig, offset, day, month, year, hour, minute, second;
+    int discont, format, i, s, nsig, offset, day, month, year, hour, minute,
+	second;
     long adcrange, *dmax, *dmin, nframes;
  
     edf_fname = wfdbfile(NULL, NULL);
@@ -799,7 +854,8 @@ static int edfparse(WFDB_FILE *ifile)
     sscanf(buf, "%d%*c%d%*c%d", &hour, &minute, &second);
     read_edf_str(buf, 8, ifile);	/* number of bytes in header */
     sscanf(buf, "%d", &offset);
-    read_edf_str(buf, 44, ifile);	/* free space (ignored) */
+    read_edf_str(buf, 44, ifile);	/* reserved (EDF+: "EDF+C" or "EDF+D") */
+    discont = (strlen(buf) >= 5 && strncmp(buf+1, "DF+D", 4) == 0);
     read_edf_str(buf, 8, ifile);	/* number of frames (EDF blocks) */
     sscanf(buf, "%ld", &nframes);
     if (nframes < 0) nframes = 0;
@@ -830,11 +886,21 @@ static int edfparse(WFDB_FILE *ifile)
     SUALLOC(dmin, nsig, sizeof(long));
     SUALLOC(pmax, nsig, sizeof(double));
     SUALLOC(pmin, nsig, sizeof(double));
+    SUALLOC(hedf.soff, nsig, sizeof(long));
+    SUALLOC(hedf.spf, nsig, sizeof(int));
 
     /* Strip off any path info from the EDF file name. */
     p = edf_fname + strlen(edf_fname) - 4;
     while (--p > edf_fname)
 	if (*p == '/') edf_fname = p+1;
+    SSTRCPY(hedf.fname, edf_fname);
+    hedf.start = offset;
+    hedf.bps = format / 8;
+    hedf.nsig = nsig;
+    hedf.nrec = nframes;
+    hedf.spr = spr;
+    hedf.annsig = -1;
+    hedf.discont = discont;
 
     /* Read the variable-size section of the header. */
     for (s = 0; s < nsig; s++) {
@@ -847,6 +913,8 @@ static int edfparse(WFDB_FILE *ifile)
 
 	read_edf_str(buf, 16, ifile);	/* signal type */
 	SSTRCPY(hsd[s]->info.desc, buf);
+	if (strcmp(buf+1, "DF Annotations") == 0 && hedf.annsig < 0)
+	    hedf.annsig = s;
     }
 
     for (s = 0; s < nsig; s++)
@@ -901,6 +969,9 @@ static int edfparse(WFDB_FILE *ifile)
 	read_edf_str(buf, 8, ifile);	/* samples per frame (EDF block) */
 	sscanf(buf, "%d", &n);
 	if ((hsd[s]->info.spf = n) > spfmax) spfmax = n;
+	hedf.spf[s] = n;
+	hedf.soff[s] = hedf.recsize;
+	hedf.recsize += (long)n * hedf.bps;
     }
 
     (void)wfdb_fclose(ifile);	/* (don't bother reading nsig*32 bytes of free
@@ -924,14 +995,435 @@ static int edfparse(WFDB_FILE *ifile)
     return (nsig);
 }
 
+/* Header file parsing.
+
+wfdb_parseheader interprets the text of a header file in a single pass,
+splitting its lines into tokens in place.  The resulting WFDB_Hdrinfo structure,
+the strings and arrays it points to, and the copy of the text that contains the
+strings, are all allocated from one arena (a short chain of large memory
+blocks), which wfdb_freeheader releases at once.  Since wfdb_parseheader uses
+no static variables and reports errors only through its return value, it may
+be used by several threads at once;  readheader and getinfo use it to
+interpret the header files read by the library. */
+
+struct harena {		/* a block of memory belonging to a WFDB_Hdrinfo */
+    struct harena *next;	/* the previously allocated block */
+    size_t size;		/* size of the block, excluding this header */
+    size_t used;		/* number of bytes allocated from the block */
+};
+
+/* Error codes from hparse. */
+#define HE_NONAME	1	/* no record line */
+#define HE_OBSOLETE	2	/* no number of signals in the record line */
+#define HE_FREQ		3	/* incorrect sampling frequency */
+#define HE_NSAMP	4	/* incorrect number of samples */
+#define HE_NSIG		5	/* incorrect number of signals */
+#define HE_SEGNAME	6	/* invalid segment name */
+#define HE_SEGLONG	7	/* segment name too long */
+#define HE_SEGLEN	8	/* segment length missing or incorrect */
+#define HE_FMT		9	/* illegal signal format */
+#define HE_GROUP	10	/* format or block size differs within a group */
+#define HE_EOF		11	/* missing signal or segment lines */
+#define HE_MEM		12	/* insufficient memory */
+
+/* Allocate n bytes (zeroed) from the arena whose most recent block is *ap,
+   adding a block if necessary.  Return NULL if memory is exhausted. */
+static void *halloc(struct harena **ap, size_t n)
+{
+    struct harena *a = *ap;
+    char *p;
+
+    n = (n + 7) & ~(size_t)7;	/* keep everything aligned */
+    if (a == NULL || a->used + n > a->size) {
+	size_t size = (a && 2*a->size > n) ? 2*a->size : n + 4096;
+
+	if ((a = malloc(sizeof(struct harena) + size)) == NULL)
+	    return (NULL);
+	a->next = *ap;
+	a->size = size;
+	a->used = 0;
+	*ap = a;
+    }
+    p = (char *)(a + 1) + a->used;
+    a->used += n;
+    memset(p, 0, n);
+    return (p);
+}
+
+/* Split the next token (delimited by white space) from the line at *pp, and
+   advance *pp past the delimiter that follows it.  Return NULL if the line
+   contains no more tokens. */
+static char *htoken(char **pp)
+{
+    char *p = *pp, *q;
+
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+	p++;
+    if (*p == '\0') {
+	*pp = p;
+	return (NULL);
+    }
+    for (q = p; *q && *q != ' ' && *q != '\t' && *q != '\r' && *q != '\n'; q++)
+	;
+    if (*q) *q++ = '\0';
+    *pp = q;
+    return (p);
+}
+
+/* Return the rest of the line at *pp (not including a trailing carriage
+   return), or NULL if nothing remains. */
+static char *hrest(char **pp)
+{
+    char *p = *pp, *q;
+
+    while (*p == '\r' || *p == '\n')
+	p++;
+    if (*p == '\0')
+	return (NULL);
+    for (q = p; *q && *q != '\r' && *q != '\n'; q++)
+	;
+    *q = '\0';
+    *pp = q;
+    return (p);
+}
+
+/* Parse the len bytes of header file text, returning a WFDB_Hdrinfo structure
+   (or NULL if memory is exhausted).  If the text is not a valid header, *err
+   is set to one of the HE_* codes above, *where to the number of the signal
+   or segment in error, and *etok to the offending segment name, if any;  the
+   structure is nonetheless returned, with
+   its contents complete up to the error and with all of its info strings.
+   (Info strings are the comment lines that follow the first line that is not
+   a comment.) */
+static WFDB_Hdrinfo *hparse(const char *text, size_t len, int *err, int *where,
+			   char **etok)
+{
+    char *end, *line, *next, *p, *q, *tok, *rest;
+    int i = 0, maxinfo = 0, nobaseline, seen = 0, state = 0;
+    struct harena *a = NULL;
+    WFDB_Hdrinfo *h;
+    WFDB_Siginfo *sp;
+    WFDB_Time ns = 0;
+
+    *err = *where = 0;
+    *etok = NULL;
+    if ((h = halloc(&a, sizeof(WFDB_Hdrinfo) + len + 1)) == NULL)
+	return (NULL);
+    line = (char *)(h + 1);
+    memcpy(line, text, len);
+    end = line + len;
+    *end = '\0';
+
+    for ( ; line < end; line = next) {
+	if ((next = memchr(line, '\n', end - line)) != NULL)
+	    *next++ = '\0';
+	else
+	    next = end;
+
+	/* Save info strings. */
+	if (*line == '#') {
+	    if (seen) {
+		if (h->ninfo >= maxinfo) {
+		    char **pinfo = h->info;
+
+		    maxinfo = maxinfo ? 2*maxinfo : 16;
+		    if ((h->info = halloc(&a, maxinfo*sizeof(char *))) == NULL)
+			goto nomem;
+		    if (pinfo)
+			memcpy(h->info, pinfo, h->ninfo*sizeof(char *));
+		}
+		p = line + strlen(line);
+		if (p > line + 1 && *(p-1) == '\r') *(p-1) = '\0';
+		h->info[h->ninfo++] = line + 1;
+	    }
+	    continue;	/* comments are otherwise ignored */
+	}
+	seen = 1;
+	if (state < 0)
+	    continue;	/* an error was found, or the header is complete */
+
+	/* Skip empty lines and comments. */
+	rest = line;
+	if ((tok = htoken(&rest)) == NULL || *tok == '#')
+	    continue;
+
+	switch (state) {
+	  case 0:	/* the record line */
+	    for (q = tok+1; *q && *q != '/'; q++)
+		;
+	    if (*q == '/') {
+		h->nseg = strtol(q+1, NULL, 10);
+		*q = '\0';
+	    }
+	    h->recname = tok;
+	    if ((p = htoken(&rest)) == NULL) {
+		*err = HE_OBSOLETE;
+		state = -1;
+		break;
+	    }
+	    h->nsig = strtol(p, NULL, 10);
+	    if (p = htoken(&rest)) {
+		if ((h->ffreq = strtod(p, NULL)) <= 0.) {
+		    *err = HE_FREQ;
+		    state = -1;
+		    break;
+		}
+		for ( ; *p && *p != '/'; p++)
+		    ;
+		if (*p == '/') {
+		    h->cfreq = strtod(++p, NULL);
+		    for ( ; *p && *p != '('; p++)
+			;
+		    if (*p == '(')
+			h->bcount = strtod(++p, NULL);
+		}
+		if (p = htoken(&rest)) {
+		    if ((h->nsamp = strtotime(p, NULL, 10)) < 0L) {
+			h->nsamp = 0;
+			*err = HE_NSAMP;
+			state = -1;
+			break;
+		    }
+		    h->btime = hrest(&rest);
+		}
+	    }
+	    if (h->nseg > 0) {
+		if ((h->seginfo = halloc(&a, h->nseg * sizeof(WFDB_Seginfo)))
+		    == NULL)
+		    goto nomem;
+		state = 1;
+	    }
+	    else if (h->nsig < 0 || h->nseg < 0) {
+		*err = HE_NSIG;
+		state = -1;
+	    }
+	    else if (h->nsig > 0) {
+		if ((h->siginfo = halloc(&a, h->nsig * sizeof(WFDB_Siginfo)))
+		    == NULL ||
+		    (h->skew = halloc(&a, h->nsig * sizeof(int))) == NULL ||
+		    (h->start = halloc(&a, h->nsig * sizeof(long))) == NULL)
+		    goto nomem;
+		state = 2;
+	    }
+	    else
+		state = -1;
+	    break;
+
+	  case 1:	/* a segment line */
+	    *where = i;
+	    *etok = tok;
+	    if (*tok == '+') {
+		*err = HE_SEGNAME;
+		state = -1;
+		break;
+	    }
+	    if (strlen(tok) > WFDB_MAXRNL) {
+		*err = HE_SEGLONG;
+		state = -1;
+		break;
+	    }
+	    (void)strcpy(h->seginfo[i].recname, tok);
+	    if ((p = htoken(&rest)) == NULL ||
+		(h->seginfo[i].nsamp = strtotime(p, NULL, 10)) < 0L) {
+		*err = HE_SEGLEN;
+		state = -1;
+		break;
+	    }
+	    h->seginfo[i].samp0 = ns;
+	    ns += h->seginfo[i].nsamp;
+	    if (++i >= h->nseg) state = -1;
+	    break;
+
+	  case 2:	/* a signal line */
+	    *where = i;
+	    sp = &h->siginfo[i];
+
+	    /* Signals whose file names match that of the previous signal belong
+	       to the same group, and share its copy of the file name. */
+	    if (i == 0)
+		sp->fname = tok;
+	    else if (strcmp(tok, (sp-1)->fname)) {
+		sp->group = (sp-1)->group + 1;
+		sp->fname = tok;
+	    }
+	    else {
+		sp->group = (sp-1)->group;
+		sp->fname = (sp-1)->fname;
+	    }
+
+	    /* The format field may include samples per frame, skew, and
+	       byte offset. */
+	    if ((p = htoken(&rest)) == NULL ||
+		!isfmt(sp->fmt = strtol(p, NULL, 10))) {
+		*err = HE_FMT;
+		state = -1;
+		break;
+	    }
+	    sp->spf = 1;
+	    while (*p && *(++p)) {
+		if (*p == 'x' && *(++p))
+		    if ((sp->spf = strtol(p, NULL, 10)) < 1) sp->spf = 1;
+		if (*p == ':' && *(++p))
+		    if ((h->skew[i] = strtol(p, NULL, 10)) < 0) h->skew[i] = 0;
+		if (*p == '+' && *(++p))
+		    if ((h->start[i] = strtol(p, NULL, 10)) < 0L)
+			h->start[i] = 0L;
+	    }
+
+	    /* The gain field may include the baseline and the units. */
+	    nobaseline = 1;
+	    if (p = htoken(&rest)) {
+		sp->gain = (WFDB_Gain)strtod(p, NULL);
+		for ( ; *p && *p != '(' && *p != '/'; p++)
+		    ;
+		if (*p == '(') {
+		    sp->baseline = strtol(++p, NULL, 10);
+		    nobaseline = 0;
+		}
+		while (*p)
+		    if (*p++ == '/' && *p)
+			break;
+		if (*p) sp->units = p;
+	    }
+
+	    /* Fill in defaults for any of the remaining fields that are
+	       missing. */
+	    if (p = htoken(&rest))
+		sp->adcres = strtol(p, NULL, 10);
+	    else switch (sp->fmt) {
+	      case 80: sp->adcres = 8; break;
+	      case 160: sp->adcres = 16; break;
+	      case 212: sp->adcres = 12; break;
+	      case 310: sp->adcres = 10; break;
+	      case 311: sp->adcres = 10; break;
+	      default: sp->adcres = WFDB_DEFRES; break;
+	    }
+	    sp->adczero = (p = htoken(&rest)) ? strtol(p, NULL, 10) : 0;
+	    if (nobaseline)
+		sp->baseline = sp->adczero;
+	    sp->initval = (p = htoken(&rest)) ? strtol(p, NULL, 10) :
+		sp->adczero;
+	    if (p = htoken(&rest)) {
+		sp->cksum = strtol(p, NULL, 10);
+		sp->nsamp = (h->nsamp > LONG_MAX ? 0 : h->nsamp);
+	    }
+	    sp->bsize = (p = htoken(&rest)) ? strtol(p, NULL, 10) : 0;
+	    if (i > 0 && sp->group == (sp-1)->group &&
+		(sp->fmt != (sp-1)->fmt || sp->bsize != (sp-1)->bsize)) {
+		*err = HE_GROUP;
+		state = -1;
+		break;
+	    }
+	    sp->desc = hrest(&rest);
+	    if (++i >= h->nsig) state = -1;
+	    break;
+	}
+    }
+
+    if (state == 0)
+	*err = HE_NONAME;
+    else if (state > 0) {
+	*err = HE_EOF;
+	*where = i;
+    }
+    h->arena = a;
+    return (h);
+
+ nomem:
+    h->arena = a;
+    wfdb_freeheader(h);
+    *err = HE_MEM;
+    return (NULL);
+}
+
+/* Read the entire contents of ifile into *buf (enlarging it as needed), and
+   return the number of bytes read.  A null is appended to the contents. */
+static size_t hread(WFDB_FILE *ifile, char **buf, size_t *bufsize)
+{
+    size_t len = 0, n;
+
+    if (*buf == NULL)
+	*bufsize = 0;
+    do {
+	if (*bufsize < len + 4097) {
+	    char *p = realloc(*buf, *bufsize = 2*(len + 4097));
+
+	    if (p == NULL) {
+		SFREE(*buf);
+		*bufsize = 0;
+		return (0);
+	    }
+	    *buf = p;
+	}
+	n = wfdb_fread(*buf + len, 1, *bufsize - len - 1, ifile);
+	len += n;
+    } while (n > 0);
+    (*buf)[len] = '\0';
+    return (len);
+}
+
+FINT wfdb_parseheader(const char *text, long length, WFDB_Hdrinfo **header)
+{
+    char *etok;
+    int err, where;
+
+    *header = hparse(text, length, &err, &where, &etok);
+    if (*header == NULL)
+	return (-3);
+    if (err) {
+	wfdb_freeheader(*header);
+	*header = NULL;
+	return (-2);
+    }
+    return (0);
+}
+
+FINT wfdb_readheader(char *record, WFDB_Hdrinfo **header)
+{
+    char *buf = NULL, *q;
+    int stat;
+    size_t bufsize = 0, len;
+    WFDB_FILE *ifile;
+
+    *header = NULL;
+    /* As in readheader, a record name ending in ".hea" is a file name. */
+    q = record + strlen(record);
+    if (q - record > 4 && strcmp(q - 4, ".hea") == 0)
+	ifile = wfdb_open(NULL, record, WFDB_READ);
+    else
+	ifile = wfdb_open("hea", record, WFDB_READ);
+    if (ifile == NULL)
+	return (-1);
+    len = hread(ifile, &buf, &bufsize);
+    (void)wfdb_fclose(ifile);
+    if (buf == NULL)
+	return (-3);
+    stat = wfdb_parseheader(buf, (long)len, header);
+    SFREE(buf);
+    return (stat);
+}
+
+FVOID wfdb_freeheader(WFDB_Hdrinfo *header)
+{
+    struct harena *a, *b;
+
+    if (header)
+	for (a = header->arena; a; a = b) {
+	    b = a->next;
+	    free(a);
+	}
+}
+
 static int readheader(const char *record)
 {
-    char *p, *q;
-    WFDB_Frequency f;
+    char *etok, *q;
+    int err, where;
+    size_t len;
+    WFDB_Hdrinfo *h;
+    WFDB_Siginfo *sp;
     WFDB_Signal s;
     WFDB_Time ns;
-    unsigned int i, nsig;
-    static char sep[] = " \t\n\r";
+    unsigned int nsig;
 
     /* If another input header file was opened, close it. */
     if (hheader) {
@@ -942,6 +1434,7 @@ static int readheader(const char *record)
     spfmax = 1;
     sfreq = ffreq;
     isedf = 0;
+    edffree(&hedf);
     if (strcmp(record, "~") == 0) {
 	if (in_msrec && vsd) {
 	    char *p;
@@ -967,8 +1460,13 @@ static int readheader(const char *record)
 	    wfdb_error("init: can't open %s\n", record);
 	    return (-1);
 	}
-	else if (strcmp(q+1, "hea"))	/* assume EDF if suffix is not '.hea' */
+	else if (strcmp(q+1, "hea")) {	/* assume EDF if suffix is not '.hea' */
+	    if (!in_msrec) {
+		wfdb_freeheader(hdrinfo);
+		hdrinfo = NULL;
+	    }
 	    return (edfparse(hheader));
+	}
     }
 
     /* Otherwise, assume the file name is record.hea. */
@@ -977,10 +1475,13 @@ static int readheader(const char *record)
 	return (-1);
     }
 
-    /* Read the first line and check for a magic string. */
-    if (wfdb_getline(&linebuf, &linebufsize, hheader) == 0) {
-        wfdb_error("init: record %s header is empty\n", record);
-	    return (-2);
+    /* Read the entire file, and check the first line for a magic string. */
+    len = hread(hheader, &linebuf, &linebufsize);
+    if (len == 0) {
+	wfdb_error("init: record %s header is empty\n", record);
+	(void)wfdb_fclose(hheader);
+	hheader = NULL;
+	return (-2);
     }
     if (strncmp("#wfdb", linebuf, 5) == 0) { /* found the magic string */
 	int i, major, minor = 0, release = 0;
@@ -998,36 +1499,43 @@ static int readheader(const char *record)
 	}
     }
 
-    /* Get the first token (the record name) from the first non-empty,
-       non-comment line. */
-    while ((p = strtok(linebuf, sep)) == NULL || *p == '#') {
-	if (wfdb_getline(&linebuf, &linebufsize, hheader) == 0) {
-	    wfdb_error("init: can't find record name in record %s header\n",
-		     record);
-	    return (-2);
-	}
+    /* Parse the header.  The structure describing the header of the record
+       named by the caller (but not those of its segments) is kept for
+       getinfo. */
+    if ((h = hparse(linebuf, len, &err, &where, &etok)) == NULL) {
+	wfdb_error("init: insufficient memory for record %s header\n", record);
+	return (-2);
+    }
+    if (!in_msrec) {
+	wfdb_freeheader(hdrinfo);
+	hdrinfo = h;
+	SSTRCPY(hdrrec, record);
     }
 
-    for (q = p+1; *q && *q != '/'; q++)
-	;
-    if (*q == '/') {
+    if (err == HE_NONAME) {
+	wfdb_error("init: can't find record name in record %s header\n",
+		   record);
+	goto bad;
+    }
+
+    if (h->nseg) {
 	if (in_msrec) {
 	    wfdb_error(
 	  "init: record %s cannot be nested in another multi-segment record\n",
 		     record);
-	    return (-2);
+	    goto bad;
 	}
-	segments = strtol(q+1, NULL, 10);
-	*q = '\0';
     }
+    if (!in_msrec)
+	segments = h->nseg;
 
-    /* For local files, be sure that the name (p) within the header file
+    /* For local files, be sure that the name within the header file
        matches the name (record) provided as an argument to this function --
        if not, the header file may have been renamed in error or its contents
        may be corrupted.  The requirement for a match is waived for remote
        files since the user may not be able to make any corrections to them. */
-    if (hheader->type == WFDB_LOCAL &&
-	hheader->fp != stdin && strncmp(p, record, strlen(p)) != 0) {
+    if (hheader->type == WFDB_LOCAL && hheader->fp != stdin &&
+	strncmp(h->recname, record, strlen(h->recname)) != 0) {
 	/* If there is a mismatch, check to see if the record argument includes
 	   a directory separator (whether valid or not for this OS);  if so,
 	   compare only the final portion of the argument against the name in
@@ -1038,42 +1546,38 @@ static int readheader(const char *record)
 	    if (*s == '/' || *s == '\\' || *s == ':')
 		break;
 
-	if (q > s && (r > s || strcmp(p, s+1) != 0)) {
+	if (q > s && (r > s || strcmp(h->recname, s+1) != 0)) {
 	    wfdb_error("init: record name in record %s header is incorrect\n",
 		       record);
-	    return (-2);
+	    goto bad;
 	}
     }
+    (void)wfdb_fclose(hheader);
+    hheader = NULL;
 
-    /* Identify which type of header file is being read by trying to get
-       another token from the line which contains the record name.  (Old-style
-       headers have only one token on the first line, but new-style headers
-       have two or more.) */
-    if ((p = strtok((char *)NULL, sep)) == NULL) {
-	/* The file appears to be an old-style header file. */
+    /* Old-style headers have only one token on the first line, but new-style
+       headers have two or more. */
+    if (err == HE_OBSOLETE) {
 	wfdb_error("init: obsolete format in record %s header\n", record);
-	return (-2);
+	goto bad;
     }
-
-    /* The file appears to be a new-style header file.  The second token
-       specifies the number of signals. */
-    nsig = (unsigned)strtol(p, NULL, 10);
+    nsig = (unsigned)h->nsig;
 
     /* Determine the frame rate, if present and not set already. */
-    if (p = strtok((char *)NULL, sep)) {
-	if ((f = (WFDB_Frequency)strtod(p, NULL)) <= (WFDB_Frequency)0.) {
-	    wfdb_error(
+    if (err == HE_FREQ) {
+	wfdb_error(
 		 "init: sampling frequency in record %s header is incorrect\n",
 		 record);
-	    return (-2);
-	}
-	if (ffreq > (WFDB_Frequency)0. && f != ffreq) {
+	goto bad;
+    }
+    if (h->ffreq > (WFDB_Frequency)0.) {
+	if (ffreq > (WFDB_Frequency)0. && h->ffreq != ffreq) {
 	    wfdb_error("warning (init):\n");
 	    wfdb_error(" record %s sampling frequency differs", record);
 	    wfdb_error(" from that of previously opened record\n");
 	}
 	else
-	    ffreq = f;
+	    ffreq = h->ffreq;
     }
     else if (ffreq == (WFDB_Frequency)0.)
 	ffreq = WFDB_DEFFREQ;
@@ -1084,32 +1588,21 @@ static int readheader(const char *record)
     sfreq = ffreq;
 
     /* Determine the counter frequency and the base counter value. */
-    cfreq = bcount = 0.0;
-    if (p) {
-	for ( ; *p && *p != '/'; p++)
-	    ;
-	if (*p == '/') {
-	    cfreq = strtod(++p, NULL);
-	    for ( ; *p && *p != '('; p++)
-		;
-	    if (*p == '(')
-		bcount = strtod(++p, NULL);
-	}
-    }
+    cfreq = h->cfreq;
+    bcount = h->bcount;
     if (cfreq <= 0.0) cfreq = ffreq;
 
     /* Determine the number of samples per signal, if present and not
        set already. */
-    if (p = strtok((char *)NULL, sep)) {
-	if ((ns = strtotime(p, NULL, 10)) < 0L) {
-	    wfdb_error(
-		"init: number of samples in record %s header is incorrect\n",
-		record);
-	    return (-2);
-	}
+    if (err == HE_NSAMP) {
+	wfdb_error("init: number of samples in record %s header is incorrect\n",
+		   record);
+	goto bad;
+    }
+    if ((ns = h->nsamp) > (WFDB_Time)0L) {
 	if (nsamples == (WFDB_Time)0L)
 	    nsamples = ns;
-	else if (ns > (WFDB_Time)0L && ns != nsamples && !in_msrec) {
+	else if (ns != nsamples && !in_msrec) {
 	    wfdb_error("warning (init):\n");
 	    wfdb_error(" record %s duration differs", record);
 	    wfdb_error(" from that of previously opened record\n");
@@ -1118,66 +1611,56 @@ static int readheader(const char *record)
 		nsamples = ns;
 	}
     }
-    else
-	ns = (WFDB_Time)0L;
 
     /* Determine the base time and date, if present and not set already. */
-    if ((p = strtok((char *)NULL,"\n\r")) != NULL &&
-	btime == 0L && setbasetime(p) < 0)
-	return (-2);	/* error message will come from setbasetime */
+    if (h->btime != NULL && btime == 0L && setbasetime(h->btime) < 0)
+	goto bad;	/* error message will come from setbasetime */
+
+    if (err == HE_NSIG) {
+	wfdb_error("init: number of signals in record %s header is incorrect\n",
+		   record);
+	goto bad;
+    }
 
     /* Special processing for master header of a multi-segment record. */
     if (segments && !in_msrec) {
 	msbtime = btime;
 	msbdate = bdate;
 	msnsamples = nsamples;
-	/* Read the names and lengths of the segment records. */
+	/* Copy the names and lengths of the segment records. */
 	SALLOC(segarray, segments, sizeof(WFDB_Seginfo));
 	SFREE(segarray_L);
 	segp = segarray;
-	for (i = 0, ns = (WFDB_Time)0L; i < segments; i++, segp++) {
-	    /* Get next segment spec, skip empty lines and comments. */
-	    do {
-		if (wfdb_getline(&linebuf, &linebufsize, hheader) == 0) {
-		    wfdb_error(
-			"init: unexpected EOF in header file for record %s\n",
-			record);
-		    SFREE(segarray);
-		    segments = 0;
-		    return (-2);
-		}
-	    } while ((p = strtok(linebuf, sep)) == NULL || *p == '#');
-	    if (*p == '+') {
+	if (err) {
+	    switch (err) {
+	      case HE_SEGNAME:
 		wfdb_error(
 		    "init: `%s' is not a valid segment name in record %s\n",
-		    p, record);
-		SFREE(segarray);
-		segments = 0;
-		return (-2);
-	    }
-	    if (strlen(p) > WFDB_MAXRNL) {
+		    etok, record);
+		break;
+	      case HE_SEGLONG:
 		wfdb_error(
 		    "init: `%s' is too long for a segment name in record %s\n",
-		    p, record);
-		SFREE(segarray);
-		segments = 0;
-		return (-2);
-	    }
-	    (void)strcpy(segp->recname, p);
-	    if ((p = strtok((char *)NULL, sep)) == NULL ||
-		(segp->nsamp = strtotime(p, NULL, 10)) < 0L) {
+		    etok, record);
+		break;
+	      case HE_SEGLEN:
 		wfdb_error(
 		"init: length must be specified for segment %s in record %s\n",
-		           segp->recname, record);
-		SFREE(segarray);
-		segments = 0;
-		return (-2);
+			   h->seginfo[where].recname, record);
+		break;
+	      default:
+		wfdb_error(
+			"init: unexpected EOF in header file for record %s\n",
+			record);
+		break;
 	    }
-	    segp->samp0 = ns;
-	    ns += segp->nsamp;
+	    SFREE(segarray);
+	    segments = 0;
+	    goto bad;
 	}
-	segend = --segp;
-	segp = segarray;
+	(void)memcpy(segarray, h->seginfo, segments * sizeof(WFDB_Seginfo));
+	segend = segarray + segments - 1;
+	ns = segend->samp0 + segend->nsamp;
 	if (msnsamples == 0L)
 	    msnsamples = ns;
 	else if (ns != msnsamples) {
@@ -1187,6 +1670,7 @@ static int readheader(const char *record)
 	    wfdb_error(" does not match sum of segment lengths "
 		       "(%"WFDB_Pd_TIME")\n", ns);
 	}
+	if (in_msrec) wfdb_freeheader(h);
 	return (0);
     }
 
@@ -1202,154 +1686,59 @@ static int readheader(const char *record)
 	maxhsig = nsig;
     }
 
-    /* Now get information for each signal. */
-    for (s = 0; s < nsig; s++) {
-	struct hsdata *hp, *hs;
-	int nobaseline;
-
-	hs = hsd[s];
-	hp = (s ? hsd[s-1] : NULL);
-	/* Get the first token (the signal file name) from the next
-	   non-empty, non-comment line. */
-	do {
-	    if (wfdb_getline(&linebuf, &linebufsize, hheader) == 0) {
-		wfdb_error(
-			"init: unexpected EOF in header file for record %s\n",
-			record);
-		return (-2);
-	    }
-	} while ((p = strtok(linebuf, sep)) == NULL || *p == '#');
-
-	/* Determine the signal group number.  The group number for signal
-	   0 is zero.  For subsequent signals, if the file name does not
-	   match that of the previous signal, the group number is one
-	   greater than that of the previous signal. */
-	if (s == 0 || strcmp(p, hp->info.fname)) {
-	    hs->info.group = (s == 0) ? 0 : hp->info.group + 1;
-	    SSTRCPY(hs->info.fname, p);
-	}
-	/* If the file names of the current and previous signals match,
-	   they are assigned the same group number and share a copy of the
-	   file name.  All signals associated with a given file must be
-	   listed together in the header in order to be identified as
-	   belonging to the same group;  readheader does not check that
-	   this has been done. */
-	else {
-	    hs->info.group = hp->info.group;
-	    SSTRCPY(hs->info.fname, hp->info.fname);
-	}
+    /* Now copy the information for each signal, up to the first error (if
+       any). */
+    for (s = 0; s < nsig && (err == 0 || s < where); s++) {
+	struct hsdata *hs = hsd[s];
 
-	/* Determine the signal format. */
-	if ((p = strtok((char *)NULL, sep)) == NULL ||
-	    !isfmt(hs->info.fmt = strtol(p, NULL, 10))) {
-	    wfdb_error("init: illegal format for signal %d, record %s\n",
-		       s, record);
-	    return (-2);
-	}
-	hs->info.spf = 1;
-	hs->skew = 0;
-	hs->start = 0L;
-	while (*(++p)) {
-	    if (*p == 'x' && *(++p))
-		if ((hs->info.spf = strtol(p, NULL, 10)) < 1) hs->info.spf = 1;
-	    if (*p == ':' && *(++p))
-		if ((hs->skew = strtol(p, NULL, 10)) < 0) hs->skew = 0;
-	    if (*p == '+' && *(++p))
-		if ((hs->start = strtol(p, NULL, 10)) < 0L) hs->start = 0L;
-	}
-	if (hs->info.spf > spfmax) spfmax = hs->info.spf;
+	sp = &h->siginfo[s];
+	SFREE(hs->info.fname);
+	SFREE(hs->info.units);
+	SFREE(hs->info.desc);
+	hs->info = *sp;
+	hs->info.fname = hs->info.units = hs->info.desc = NULL;
+	SSTRCPY(hs->info.fname, sp->fname);
+	if (sp->spf > spfmax) spfmax = sp->spf;
 	/* The resolution for deskewing is one frame.  The skew in samples
 	   (given in the header) is converted to skew in frames here. */
-	hs->skew = (int)(((double)hs->skew)/hs->info.spf + 0.5);
-
-	/* Determine the gain in ADC units per physical unit.  This number
-	   may be zero or missing;  if so, the signal is uncalibrated. */
-	if (p = strtok((char *)NULL, sep))
-	    hs->info.gain = (WFDB_Gain)strtod(p, NULL);
-	else
-	    hs->info.gain = (WFDB_Gain)0.;
-
-	/* Determine the baseline if specified, and the physical units
-	   (assumed to be millivolts unless otherwise specified). */
-	nobaseline = 1;
-	if (p) {
-	    for ( ; *p && *p != '(' && *p != '/'; p++)
-		;
-	    if (*p == '(') {
-		hs->info.baseline = strtol(++p, NULL, 10);
-		nobaseline = 0;
-	    }
-	    while (*p)
-		if (*p++ == '/' && *p)
-		    break;
-	}
-	if (p && *p) {
+	hs->skew = (int)(((double)h->skew[s])/sp->spf + 0.5);
+	hs->start = h->start[s];
+	if (sp->units) {
 	    SALLOC(hs->info.units, WFDB_MAXUSL+1, 1);
-	    (void)strncpy(hs->info.units, p, WFDB_MAXUSL);
-	}
-	else
-	    hs->info.units = NULL;
-
-	/* Determine the ADC resolution in bits.  If this number is
-	   missing and cannot be inferred from the format, the default
-	   value (from wfdb.h) is filled in. */
-	if (p = strtok((char *)NULL, sep))
-	    i = (unsigned)strtol(p, NULL, 10);
-	else switch (hs->info.fmt) {
-	  case 80: i = 8; break;
-	  case 160: i = 16; break;
-	  case 212: i = 12; break;
-	  case 310: i = 10; break;
-	  case 311: i = 10; break;
-	  default: i = WFDB_DEFRES; break;
-	}
-	hs->info.adcres = i;
-
-	/* Determine the ADC zero (assumed to be zero if missing). */
-	hs->info.adczero = (p=strtok((char *)NULL,sep)) ? strtol(p,NULL,10) : 0;
-	    
-	/* Set the baseline to adczero if no baseline field was found. */
-	if (nobaseline) hs->info.baseline = hs->info.adczero;
-
-	/* Determine the initial value (assumed to be equal to the ADC 
-	   zero if missing). */
-	hs->info.initval = (p = strtok((char *)NULL, sep)) ?
-	    strtol(p, NULL, 10) : hs->info.adczero;
-
-	/* Determine the checksum (assumed to be zero if missing). */
-	if (p = strtok((char *)NULL, sep)) {
-	    hs->info.cksum = strtol(p, NULL, 10);
-	    hs->info.nsamp = (ns > LONG_MAX ? 0 : ns);
-	}
-	else {
-	    hs->info.cksum = 0;
-	    hs->info.nsamp = (WFDB_Time)0L;
+	    (void)strncpy(hs->info.units, sp->units, WFDB_MAXUSL);
 	}
-
-	/* Determine the block size (assumed to be zero if missing). */
-	hs->info.bsize = (p = strtok((char *)NULL,sep)) ? strtol(p,NULL,10) : 0;
-
-	/* Check that formats and block sizes match for signals belonging
-	   to the same group. */
-	if (s && (hp == NULL || (hs->info.group == hp->info.group &&
-	    (hs->info.fmt != hp->info.fmt ||
-	     hs->info.bsize != hp->info.bsize)))) {
-	    wfdb_error("init: error in specification of signal %d or %d\n",
-		       s-1, s);
-	    return (-2);
-	}
-	    
-	/* Get the signal description.  If missing, a description of
-	   the form "record xx, signal n" is filled in. */
+	/* If the description is missing, one of the form "record xx, signal
+	   n" is filled in. */
 	SALLOC(hs->info.desc, 1, WFDB_MAXDSL+1);
-	if (p = strtok((char *)NULL, "\n\r"))
-	    (void)strncpy(hs->info.desc, p, WFDB_MAXDSL);
+	if (sp->desc)
+	    (void)strncpy(hs->info.desc, sp->desc, WFDB_MAXDSL);
 	else
 	    (void)sprintf(hs->info.desc,
 			  "record %s, signal %d", record, s);
     }
+    switch (err) {
+      case 0:
+	break;
+      case HE_FMT:
+	wfdb_error("init: illegal format for signal %d, record %s\n",
+		   where, record);
+	goto bad;
+      case HE_GROUP:
+	wfdb_error("init: error in specification of signal %d or %d\n",
+		   where-1, where);
+	goto bad;
+      default:
+	wfdb_error("init: unexpected EOF in header file for record %s\n",
+		   record);
+	goto bad;
+    }
+    if (in_msrec) wfdb_freeheader(h);
     setgvmode(gvmode);		/* Reset sfreq if appropriate. */
     return (s);			/* return number of available signals */
+
+ bad:
+    if (in_msrec) wfdb_freeheader(h);
+    return (-2);
 }
 
 static void hsdfree(void)
@@ -2057,6 +2446,8 @@ static int flac_osclose(struct ogdata *og)
 
 #endif
 
+static void envfree(void);
+
 static void isigclose(void)
 {
     struct isdata *is;
@@ -2066,6 +2457,8 @@ static void isigclose(void)
 	SFREE(sbuf);
 	sample_vflag = 0;
     }
+    if (!in_msrec)
+	envfree();	/* discard the envelope of the previous record */
     if (isd) {
 	while (maxisig)
 	    if (is = isd[--maxisig]) {
@@ -2091,6 +2484,7 @@ static void isigclose(void)
 	SFREE(igd);
     }
     maxigroup = nigroup = 0;
+    edffree(&iedf);
 
     istime = 0L;
     gvc = ispfmax = 1;
@@ -2729,6 +3123,8 @@ static int isgsetframe(WFDB_Group g, WFDB_Time t)
    invalid sample */
 #define VFILL	((gvmode & WFDB_GVPAD) ? is->samp : WFDB_INVALID_SAMPLE)
 
+static int edfgetframe(WFDB_Sample *vector);
+
 static int getskewedframe(WFDB_Sample *vector)
 {
     int c, stat;
@@ -2739,6 +3135,8 @@ static int getskewedframe(WFDB_Sample *vector)
     WFDB_Signal s;
 
     if ((stat = (int)nisig) == 0) return (nvsig > 0 ? -1 : 0);
+    if (iedf.recsize > 0 && nigroup == 1 && !in_msrec && !need_sigmap)
+	return (edfgetframe(vector));
     if (istime == 0L) {
 	for (s = 0; s < nisig; s++)
 	    isd[s]->samp = isd[s]->info.initval;
@@ -2899,6 +3297,163 @@ static int getskewedframe(WFDB_Sample *vector)
     return (stat);
 }
 
+/* Convert n samples of an EDF (bps = 2) or BDF (bps = 3) signal, beginning at
+   p, into vector.  The conversion loops are simple enough to be vectorized by
+   the compiler.  The value returned is non-zero if any of the samples has the
+   smallest representable value (which the WFDB library treats as invalid). */
+static int edfdecode(WFDB_Sample *vector, const unsigned char *p, int n,
+		     int bps)
+{
+    int i, invalid = 0;
+
+    if (bps == 2) {
+	for (i = 0; i < n; i++) {
+	    vector[i] = (short)(p[2*i] | (p[2*i+1] << 8));
+	    invalid |= (vector[i] == -1 << 15);
+	}
+    }
+    else {
+	for (i = 0; i < n; i++) {
+	    vector[i] = ((p[3*i] | (p[3*i+1] << 8) | (p[3*i+2] << 16))
+			 ^ 0x800000) - 0x800000;
+	    invalid |= (vector[i] == -1 << 23);
+	}
+    }
+    return (invalid);
+}
+
+/* Read the next frame (data record) from an EDF file.  This is equivalent to
+   the general case of getskewedframe (all signals of an EDF file belong to a
+   single group, with one frame per data record), but each data record is
+   converted one signal at a time, in place in the input buffer unless it
+   spans the end of the buffer. */
+static int edfgetframe(WFDB_Sample *vector)
+{
+    int invalid, stat = (int)nisig;
+    long n, nr, recsize = iedf.recsize;
+    unsigned char *p;
+    struct igdata *ig = igd[0];
+    struct isdata *is;
+    WFDB_Sample vinvalid = (iedf.bps == 2) ? -1 << 15 : -1 << 23;
+    WFDB_Signal s;
+
+    if (istime == 0L) {
+	for (s = 0; s < nisig; s++)
+	    isd[s]->samp = isd[s]->info.initval;
+    }
+    if (ig->initial_skip)
+	isgsetframe(0, 0);
+
+    if (ig->be - ig->bp >= recsize) {
+	p = (unsigned char *)ig->bp;
+	ig->bp += recsize;
+    }
+    else {	/* assemble the data record in iedf.buf */
+	n = ig->be - ig->bp;
+	memcpy(iedf.buf, ig->bp, n);
+	ig->bp = ig->be;
+	while (n < recsize) {
+	    if ((ig->stat = nr = wfdb_fread(ig->buf, 1, ig->bsize, ig->fp)) <= 0)
+		break;
+	    ig->be = (ig->bp = ig->buf) + nr;
+	    if (nr > recsize - n) nr = recsize - n;
+	    memcpy(iedf.buf + n, ig->buf, nr);
+	    ig->bp += nr;
+	    n += nr;
+	}
+	if (n < recsize) {
+	    /* End of file -- see getskewedframe. */
+	    ig->stat = 0;
+	    ig->count = 0;
+	    stat = -1;
+	    for (s = 0; s < nisig; s++)
+		if (isd[s]->info.nsamp > (WFDB_Time)0L) {
+		    wfdb_error("getvec: unexpected EOF in signal %d\n", s);
+		    stat = -3;
+		    break;
+		}
+	    for (n = 0; n < framelen; n++)
+		vector[n] = WFDB_INVALID_SAMPLE;
+	    return (stat);
+	}
+	p = (unsigned char *)iedf.buf;
+    }
+
+    for (s = 0; s < nisig; s++) {
+	int c, spf;
+
+	is = isd[s];
+	spf = is->info.spf;
+	invalid = edfdecode(vector, p, spf, iedf.bps);
+	if (invalid) {
+	    for (c = 0; c < spf; c++) {
+		if (vector[c] == vinvalid)
+		    vector[c] = VFILL;
+		else
+		    is->samp = vector[c];
+	    }
+	}
+	else if (spf > 0)
+	    is->samp = vector[spf-1];
+	if (is->info.nsamp >= 0)
+	    is->info.nsamp--;
+	vector += spf;
+	p += spf * iedf.bps;
+    }
+    return (stat);
+}
+
+/* Position iedf.fp at byte offset off within data record b of the open EDF
+   file, opening it first if necessary. */
+static int edfseek(WFDB_Time b, long off)
+{
+    WFDB_Time pos = iedf.start + b * iedf.recsize + off;
+
+    if (iedf.fp == NULL &&
+	(iedf.fp = wfdb_open(iedf.fname, (char *)NULL, WFDB_READ)) == NULL)
+	return (-1);
+    if (pos > LONG_MAX || wfdb_fseek(iedf.fp, (long)pos, 0))
+	return (-1);
+    return (0);
+}
+
+/* Read the onset of each data record of the open EDF+D file from the
+   timekeeping TAL at the beginning of its annotation signal.  Only the first
+   few bytes of the annotation signal in each data record are read. */
+static int edfindex(void)
+{
+    char tal[EDFTALMAX+1], *p;
+    long n, nmax = iedf.nrec;
+    WFDB_Time b;
+
+    if ((n = iedf.spf[iedf.annsig] * iedf.bps) > EDFTALMAX) n = EDFTALMAX;
+    if (nmax <= 0) nmax = 1024;
+    SALLOC(iedf.onset, nmax, sizeof(double));
+    for (b = 0; iedf.nrec <= 0 || b < iedf.nrec; b++) {
+	if (edfseek(b, iedf.soff[iedf.annsig]) < 0 ||
+	    wfdb_fread(tal, 1, n, iedf.fp) != n)
+	    break;
+	if (b >= nmax) {
+	    nmax *= 2;
+	    SREALLOC(iedf.onset, nmax, sizeof(double));
+	}
+	tal[n] = '\0';
+	for (p = tal; *p && *p != '\024' && *p != '\025'; p++)
+	    ;
+	*p = '\0';
+	if (*tal == '+' || *tal == '-')
+	    iedf.onset[b] = strtod(tal, &p);
+	else
+	    iedf.onset[b] = b * iedf.spr;	/* missing or invalid TAL */
+    }
+    if ((iedf.nonset = b) == 0) {
+	wfdb_error("getedfonset: can't read data records of %s\n",
+		   iedf.fname);
+	return (-1);
+    }
+    return (0);
+}
+
 /* meansamp: calculate the mean of n sample values.  The result is
    rounded to the nearest integer, with halfway cases always rounded
    up. */
@@ -3092,6 +3647,10 @@ FINT isigopen(char *record, WFDB_Siginfo *siarray, int nsig)
 	    if ((ig->bsize = hs->info.bsize) == 0) ig->bsize = ibsize;
 	    ig->seek = 1;
 	}
+	/* Make sure that most EDF data records can be decoded in place. */
+	if (isedf && hedf.recsize > 0 && ig->bsize < EDFRECSPERBUF*hedf.recsize
+	    && hedf.recsize <= INT_MAX / EDFRECSPERBUF)
+	    ig->bsize = EDFRECSPERBUF * hedf.recsize;
 	SALLOC(ig->buf, 1, ig->bsize);
 
 	/* Check that the signal file is readable. */
@@ -3162,6 +3721,15 @@ FINT isigopen(char *record, WFDB_Siginfo *siarray, int nsig)
 	if (ispfmax < is->info.spf) ispfmax = is->info.spf;
 	if (skewmax < is->skew) skewmax = is->skew;
     }
+    /* If all of the signals of an EDF file have been opened (and no others),
+       keep its layout for the EDF input functions. */
+    if (isedf && nisig == 0 && s == hedf.nsig && hedf.recsize > 0 &&
+	!in_msrec) {
+	edffree(&iedf);
+	iedf = hedf;
+	memset(&hedf, 0, sizeof(struct edfdata));
+	SUALLOC(iedf.buf, iedf.recsize, 1);
+    }
     nisig += s;		/* Update the count of open input signals. */
     nigroup += g;	/* Update the count of open input signal groups. */
     if (sigmap_init(first_segment) < 0) {
@@ -3868,6 +4436,11 @@ FINT setheader(char *record, const WFDB_Siginfo *siarray, unsigned int nsig)
     if (wfdb_checkname(record, "record"))
 	return (-1);
 
+    /* Discard readheader's copy of the old header, if any. */
+    wfdb_freeheader(hdrinfo);
+    hdrinfo = NULL;
+    SFREE(hdrrec);
+
     /* Try to create the header file. */
     if ((oheader = wfdb_open("hea", record, WFDB_WRITE)) == NULL) {
 	wfdb_error("newheader: can't create header for record %s\n", record);
@@ -4013,6 +4586,11 @@ FINT setmsheader(char *record, char **segment_name, unsigned int nsegments)
 	}
     }
 
+    /* Discard readheader's copy of the old header, if any. */
+    wfdb_freeheader(hdrinfo);
+    hdrinfo = NULL;
+    SFREE(hdrrec);
+
     /* Try to create the header file. */
     if ((oheader = wfdb_open("hea", record, WFDB_WRITE)) == NULL) {
 	wfdb_error("setmsheader: can't create header file for record %s\n",
@@ -4178,32 +4756,34 @@ FSTRING getinfo(char *record)
 	nimax = 16;	       /* initial allotment of info string pointers */
 	SALLOC(pinfo, nimax, sizeof(char *));
 
-	/* Read info from the .hea file, if available (skip for EDF files) */
+	/* Read info from the .hea file, if available (skip for EDF files).
+	   If readheader has already parsed it, use its copy. */
 	if (!isedf) {
+	    WFDB_Hdrinfo *h = NULL;
+	    int err, where;
+
 	    /* Remove trailing .hea, if any, from record name. */
 	    wfdb_striphea(record);
-	    if ((ifile = wfdb_open("hea", record, WFDB_READ))) {
-		while (wfdb_getline(&buf, &bufsize, ifile))
-		    if (*buf != '#') break; /* skip initial comments, if any */
-		while (wfdb_getline(&buf, &bufsize, ifile))
-		    if (*buf == '#') break; /* skip header content */
-		while (*buf) {	/* read and save info */
-		    if (*buf == '#') {	    /* skip anything that isn't info */
-			p = buf + strlen(buf) - 1;
-			if (*p == '\n') *p-- = '\0';
-			if (*p == '\r') *p = '\0';
-			if (ninfo >= nimax) {
-			    int j = nimax;
-			    nimax += 16;
-			    SREALLOC(pinfo, nimax, sizeof(char *));
-			    memset(pinfo + j, 0, (size_t)(16*sizeof(char *)));
-			}
-			SSTRCPY(pinfo[ninfo], buf+1);
-			ninfo++;
-		    }
-		    if (wfdb_getline(&buf, &bufsize, ifile) == 0) break;
-		}
+	    if (hdrinfo && hdrrec && strcmp(record, hdrrec) == 0)
+		h = hdrinfo;
+	    else if ((ifile = wfdb_open("hea", record, WFDB_READ))) {
+		size_t len = hread(ifile, &buf, &bufsize);
+
 		wfdb_fclose(ifile);
+		if (buf)
+		    h = hparse(buf, len, &err, &where, &p);
+	    }
+	    if (h) {
+		if (h->ninfo > nimax) {
+		    int j = nimax;
+		    nimax = h->ninfo + 16;
+		    SREALLOC(pinfo, nimax, sizeof(char *));
+		    memset(pinfo + j, 0, (size_t)((nimax-j)*sizeof(char *)));
+		}
+		for ( ; ninfo < h->ninfo; ninfo++)
+		    SSTRCPY(pinfo[ninfo], h->info[ninfo]);
+		if (h != hdrinfo)
+		    wfdb_freeheader(h);
 	    }
 	}
 	/* Read more info from the .info file, if available */
@@ -4671,6 +5251,517 @@ FINT sample_valid(void)
     return (sample_vflag);
 }
 
+/* getedfblock reads the spf samples of signal s from data record b of the
+   open EDF or BDF file, without reading or converting any other signals.  The
+   file position used by getvec and getframe is unaffected. */
+FINT getedfblock(WFDB_Signal s, WFDB_Time b, WFDB_Sample *vector)
+{
+    int c, n;
+
+    if (iedf.recsize == 0) {
+	wfdb_error("getedfblock: no EDF input file is open\n");
+	return (-2);
+    }
+    if (s >= iedf.nsig) {
+	wfdb_error("getedfblock: invalid signal number %d\n", s);
+	return (-2);
+    }
+    if (b < 0 || (iedf.nrec > 0 && b >= iedf.nrec))
+	return (-1);
+    n = iedf.spf[s] * iedf.bps;
+    if (edfseek(b, iedf.soff[s]) < 0 ||
+	wfdb_fread(iedf.buf, 1, n, iedf.fp) != n)
+	return (-1);
+    if (edfdecode(vector, (unsigned char *)iedf.buf, iedf.spf[s], iedf.bps)) {
+	WFDB_Sample vinvalid = (iedf.bps == 2) ? -1 << 15 : -1 << 23;
+
+	for (c = 0; c < iedf.spf[s]; c++)
+	    if (vector[c] == vinvalid)
+		vector[c] = WFDB_INVALID_SAMPLE;
+    }
+    return (iedf.spf[s]);
+}
+
+/* getedfonset returns the onset of data record b of the open EDF or BDF file,
+   in seconds from the start time given in its header.  The data records of
+   EDF+D (discontinuous) files may be separated by gaps;  their onsets are read
+   from the timekeeping TALs of all data records when this function is first
+   used, after which each call takes constant time. */
+FDOUBLE getedfonset(WFDB_Time b)
+{
+    if (iedf.recsize == 0) {
+	wfdb_error("getedfonset: no EDF input file is open\n");
+	return (-1.0);
+    }
+    if (b < 0 || (iedf.nrec > 0 && b >= iedf.nrec))
+	return (-1.0);
+    if (!iedf.discont || iedf.annsig < 0)
+	return (b * iedf.spr);
+    if (iedf.onset == NULL && edfindex() < 0)
+	return (-1.0);
+    if (b >= iedf.nonset)
+	return (-1.0);
+    return (iedf.onset[b]);
+}
+
+/* Summary pyramid (envelope) functions
+
+getenvelope summarizes the samples returned by getvec, so that any interval
+of the open input record can be described by its N-point envelope (the
+extremes, mean, and numbers of valid and invalid samples of each signal in N
+equal subintervals) in time proportional to N, regardless of the length of the
+interval.  To do so, it keeps a pyramid of block summaries:  level 0 describes
+blocks of 2^ENVSHIFT samples, and each block at level k+1 combines two
+adjacent blocks at level k.  The pyramid is built incrementally, as far into
+the record as the requests have reached, by reading the record with getvec
+(the caller's input position is restored afterwards).  putenvelope completes
+the pyramid and saves its level 0 in the record's 'env' file, from which
+getenvelope can load it later without reading the signals.
+
+Short intervals (fewer than ENVRAW level-0 blocks per point) are summarized
+by reading the samples directly.  Otherwise, the boundaries between points are
+rounded to the nearest multiples of 2^ENVSHIFT samples, so that each point
+can be assembled from at most two blocks per level. */
+
+#define ENVSHIFT	8	/* log2(number of samples in a level-0 block) */
+#define ENVBLOCK	(1L << ENVSHIFT)
+#define ENVLEVELS	48	/* maximum number of levels */
+#define ENVRAW		8	/* see above */
+#define ENVHDRSIZE	40	/* size of the fixed part of an 'env' header */
+#define ENVENTSIZE	20	/* size of a block summary in an 'env' file */
+
+struct envent {		/* summary of a block of samples of one signal */
+    WFDB_Sample min, max;	/* extremes of the valid samples */
+    long long sum;		/* sum of the valid samples */
+    long nvalid;		/* number of valid samples */
+};
+
+static struct envdata {
+    char *record;		/* record name */
+    int nsig;			/* number of signals in each getvec vector */
+    int mode;			/* getvec mode */
+    WFDB_Frequency freq;	/* getvec sampling frequency */
+    WFDB_Time nsamp;		/* number of samples per signal summarized */
+    int done;			/* 1 if the end of the record was reached */
+    struct envlevel {
+	struct envent *e;	/* nsig summaries for each block */
+	WFDB_Time n, size;	/* number of blocks (summarized, allocated) */
+    } lev[ENVLEVELS];
+    struct envent *acc;		/* summaries of the current partial block,
+				   followed by nsig more for envappend */
+    WFDB_Sample *v;		/* sample vector for getvec */
+} *envp;
+
+static void envfree(void)
+{
+    int k;
+
+    if (envp) {
+	SFREE(envp->record);
+	for (k = 0; k < ENVLEVELS; k++)
+	    SFREE(envp->lev[k].e);
+	SFREE(envp->acc);
+	SFREE(envp->v);
+	SFREE(envp);
+    }
+}
+
+/* Return the time of the next sample to be read by getvec, in the units used
+   by isigsettime. */
+static WFDB_Time envitime(void)
+{
+    if (ifreq > (WFDB_Frequency)0)
+	return (strtim("i"));
+    if ((gvmode & WFDB_HIGHRES) && ispfmax > 1)
+	return ((istime - 1) * ispfmax + gvc);
+    return (istime);
+}
+
+static void envclear(struct envent *e, int n)
+{
+    while (n-- > 0) {
+	e->min = WFDB_SAMPLE_MAX;
+	e->max = WFDB_SAMPLE_MIN;
+	e->sum = 0;
+	e->nvalid = 0;
+	e++;
+    }
+}
+
+/* Add the summaries in s to those in d. */
+static void envmerge(struct envent *d, const struct envent *s, int n)
+{
+    while (n-- > 0) {
+	if (s->nvalid) {
+	    if (d->min > s->min) d->min = s->min;
+	    if (d->max < s->max) d->max = s->max;
+	    d->sum += s->sum;
+	    d->nvalid += s->nvalid;
+	}
+	d++, s++;
+    }
+}
+
+/* Append a block summary (e) to level k, and combine it with its predecessor
+   to form a new block at level k+1 if appropriate. */
+static int envappend(int k, const struct envent *e)
+{
+    int nsig = envp->nsig;
+    struct envlevel *l = &envp->lev[k];
+    struct envent *p;
+
+    if (k >= ENVLEVELS)
+	return (0);
+    if (l->n >= l->size) {
+	l->size = l->size ? 2*l->size : 64;
+	SREALLOC(l->e, l->size, nsig * sizeof(struct envent));
+	if (l->e == NULL) {
+	    l->n = l->size = 0;
+	    return (-1);
+	}
+    }
+    p = l->e + l->n * nsig;
+    memcpy(p, e, nsig * sizeof(struct envent));
+    if ((++l->n & 1) == 0) {	/* combine the last two blocks */
+	struct envent *q = envp->acc + nsig;
+
+	memcpy(q, p - nsig, nsig * sizeof(struct envent));
+	envmerge(q, p, nsig);
+	return (envappend(k+1, q));
+    }
+    return (0);
+}
+
+/* Append the summary of the current partial block, and complete the pyramid,
+   after the end of the record has been reached. */
+static int envfinish(void)
+{
+    int k;
+
+    envp->done = 1;
+    if ((envp->nsamp & (ENVBLOCK-1)) && envappend(0, envp->acc) < 0)
+	return (-1);
+    /* Levels with an odd number of blocks have an unpaired block at the end,
+       which is copied to the next level up. */
+    for (k = 0; k < ENVLEVELS-1 && envp->lev[k].n > 1; k++)
+	if ((envp->lev[k].n & 1) && envappend(k+1, envp->lev[k].e +
+			    (envp->lev[k].n - 1) * envp->nsig) < 0)
+	    return (-1);
+    return (0);
+}
+
+/* Read and write little-endian integers of n bytes in 'env' files. */
+static void envput(unsigned char *p, long long x, int n)
+{
+    while (n-- > 0) {
+	*p++ = x & 0xff;
+	x >>= 8;
+    }
+}
+
+static long long envget(const unsigned char *p, int n)
+{
+    long long x = (p[n-1] & 0x80) ? -1 : 0;
+
+    while (n-- > 0)
+	x = (x << 8) | p[n];
+    return (x);
+}
+
+/* Write the fixed part of an 'env' header (and the signal checksums and
+   initial values) for the open record into buf, which must have room for
+   ENVHDRSIZE + 8*nsig bytes. */
+static void envheader(unsigned char *buf)
+{
+    int s;
+
+    memcpy(buf, "WFDBENV1", 8);
+    envput(buf + 8, envp->nsig, 4);
+    envput(buf + 12, ENVSHIFT, 4);
+    envput(buf + 16, envp->mode, 4);
+    envput(buf + 20, 0, 4);
+    envput(buf + 24, (long long)(envp->freq * 1000.0 + 0.5), 8);
+    envput(buf + 32, envp->nsamp, 8);
+    for (s = 0; s < envp->nsig; s++) {
+	envput(buf + ENVHDRSIZE + 8*s, vsd[s]->info.initval, 4);
+	envput(buf + ENVHDRSIZE + 8*s + 4, vsd[s]->info.cksum, 4);
+    }
+}
+
+/* Load level 0 of the pyramid from the record's 'env' file, if it exists and
+   matches the open record, and build the other levels from it. */
+static int envload(void)
+{
+    int i, nsig = envp->nsig, stat = -1;
+    size_t hlen = ENVHDRSIZE + 8*nsig, blen = ENVENTSIZE*nsig;
+    unsigned char *buf = NULL, *ref = NULL, *p;
+    struct envent *e;
+    WFDB_Time b, nb, nsamp;
+    WFDB_FILE *ifile;
+
+    if ((ifile = wfdb_open("env", envp->record, WFDB_READ)) == NULL)
+	return (-1);
+    SUALLOC(buf, hlen > blen ? hlen : blen, 1);
+    SUALLOC(ref, hlen, 1);
+    if (buf == NULL || ref == NULL || wfdb_fread(buf, 1, hlen, ifile) != hlen)
+	goto done;
+    /* The header must match that which putenvelope would write now, apart
+       from the number of samples. */
+    envp->nsamp = nsamp = envget(buf + 32, 8);
+    envheader(ref);
+    if (nsamp < 0 || memcmp(buf, ref, hlen) != 0) {
+	wfdb_error("getenvelope: ignoring '%s' (it does not match record %s)\n",
+		   wfdbfile("env", envp->record), envp->record);
+	goto done;
+    }
+    envp->nsamp = 0;
+    nb = (nsamp + ENVBLOCK-1) >> ENVSHIFT;
+    for (b = 0; b < nb; b++) {
+	if (wfdb_fread(buf, 1, blen, ifile) != blen)
+	    goto done;
+	for (i = 0, p = buf, e = envp->acc; i < nsig; i++, p += ENVENTSIZE, e++){
+	    e->min = envget(p, 4);
+	    e->max = envget(p + 4, 4);
+	    e->sum = envget(p + 8, 8);
+	    e->nvalid = envget(p + 16, 4);
+	}
+	/* An incomplete last block is left in acc for envfinish. */
+	if (b < nsamp >> ENVSHIFT && envappend(0, envp->acc) < 0)
+	    goto done;
+    }
+    envp->nsamp = nsamp;
+    stat = envfinish();
+
+ done:
+    SFREE(buf);
+    SFREE(ref);
+    wfdb_fclose(ifile);
+    return (stat);
+}
+
+/* Check that the pyramid (if any) describes the open record as getvec will
+   read it, and start a new one if not.  A new pyramid is loaded from the
+   record's 'env' file if there is a matching one. */
+static int envcheck(const char *caller)
+{
+    char *record = wfdb_getirec();
+    WFDB_Frequency freq = getifreq();
+
+    if (nvsig == 0 || record == NULL) {
+	wfdb_error("%s: no input signals\n", caller);
+	return (-1);
+    }
+    if (envp && envp->nsig == nvsig && envp->mode == gvmode &&
+	envp->freq == freq && strcmp(envp->record, record) == 0)
+	return (0);
+    envfree();
+    SUALLOC(envp, 1, sizeof(struct envdata));
+    if (envp == NULL)
+	return (-1);
+    SSTRCPY(envp->record, record);
+    envp->nsig = nvsig;
+    envp->mode = gvmode;
+    envp->freq = freq;
+    SUALLOC(envp->acc, 2 * nvsig, sizeof(struct envent));
+    SUALLOC(envp->v, nvsig, sizeof(WFDB_Sample));
+    if (envp->record == NULL || envp->acc == NULL || envp->v == NULL) {
+	envfree();
+	return (-1);
+    }
+    envclear(envp->acc, nvsig);
+    if (envload() < 0) {	/* no usable 'env' file -- start from scratch */
+	int k;
+
+	for (k = 0; k < ENVLEVELS; k++) {
+	    SFREE(envp->lev[k].e);
+	    envp->lev[k].n = envp->lev[k].size = 0;
+	}
+	envp->nsamp = envp->done = 0;
+	envclear(envp->acc, nvsig);
+    }
+    return (0);
+}
+
+/* Extend the pyramid until it describes samples up to (but not including)
+   sample t, or the end of the record. */
+static int envextend(WFDB_Time t)
+{
+    int s, nsig = envp->nsig, stat = 0;
+    struct envent *e;
+    WFDB_Sample *v = envp->v, x;
+    WFDB_Time t0;
+
+    if (envp->done || envp->nsamp >= t)
+	return (0);
+    t0 = envitime();
+    if (isigsettime(envp->nsamp) < 0)
+	return (-1);
+    while (envp->nsamp < t) {
+	if (getvec(v) < 0) {
+	    stat = envfinish();
+	    break;
+	}
+	for (s = 0, e = envp->acc; s < nsig; s++, e++)
+	    if ((x = v[s]) != WFDB_INVALID_SAMPLE) {
+		if (e->min > x) e->min = x;
+		if (e->max < x) e->max = x;
+		e->sum += x;
+		e->nvalid++;
+	    }
+	if ((++envp->nsamp & (ENVBLOCK-1)) == 0) {
+	    if ((stat = envappend(0, envp->acc)) < 0)
+		break;
+	    envclear(envp->acc, nsig);
+	}
+    }
+    if (isigsettime(t0) < 0)
+	stat = -1;
+    return (stat);
+}
+
+/* Copy a summary (covering n samples) into an envelope point. */
+static void envset(WFDB_Envelope *p, const struct envent *e, long n)
+{
+    if (e->nvalid > 0) {
+	p->min = e->min;
+	p->max = e->max;
+	p->mean = (double)e->sum / e->nvalid;
+    }
+    else {
+	p->min = p->max = WFDB_INVALID_SAMPLE;
+	p->mean = 0.0;
+    }
+    p->nvalid = e->nvalid;
+    p->ninvalid = n - e->nvalid;
+}
+
+FINT getenvelope(WFDB_Time t0, WFDB_Time t1, int n, WFDB_Envelope *env)
+{
+    int i, k, nsig, s;
+    struct envent *e;
+    WFDB_Time a, b, d, j, t;
+
+    if (envcheck("getenvelope") < 0)
+	return (-1);
+    if (t0 < 0 || t1 <= t0 || n < 1) {
+	wfdb_error("getenvelope: improper interval or number of points\n");
+	return (-1);
+    }
+    nsig = envp->nsig;
+    e = envp->acc + nsig;
+    d = t1 - t0;
+
+    /* For a short interval, read and summarize the samples. */
+    if (d < (WFDB_Time)n * ENVRAW * ENVBLOCK) {
+	WFDB_Sample *v = envp->v, x;
+	WFDB_Time tt = envitime();
+
+	if (isigsettime(t0) < 0)
+	    return (-1);
+	for (i = 0, t = t0; i < n; i++) {
+	    b = t0 + d * (i+1) / n;
+	    envclear(e, nsig);
+	    for (a = t; t < b && getvec(v) >= 0; t++)
+		for (s = 0; s < nsig; s++)
+		    if ((x = v[s]) != WFDB_INVALID_SAMPLE) {
+			if (e[s].min > x) e[s].min = x;
+			if (e[s].max < x) e[s].max = x;
+			e[s].sum += x;
+			e[s].nvalid++;
+		    }
+	    if (t == a)
+		break;		/* end of record */
+	    for (s = 0; s < nsig; s++)
+		envset(&env[i*nsig + s], &e[s], (long)(t - a));
+	    if (t < b) {	/* end of record */
+		i++;
+		break;
+	    }
+	}
+	if (isigsettime(tt) < 0)
+	    return (-1);
+	return (i);
+    }
+
+    /* Otherwise, assemble each point from blocks of the pyramid. */
+    if (envextend(((t1 >> ENVSHIFT) + 1) << ENVSHIFT) < 0)
+	return (-1);
+    b = (t0 + ENVBLOCK/2) >> ENVSHIFT;
+    for (i = 0; i < n; i++) {
+	a = b;		/* first block of this point */
+	t = t0 + d * (i+1) / n;
+	b = (t + ENVBLOCK/2) >> ENVSHIFT;
+	if (a >= envp->lev[0].n)
+	    break;	/* end of record */
+	if (b > envp->lev[0].n || (envp->done && t >= envp->nsamp))
+	    b = envp->lev[0].n;	/* include the incomplete last block */
+	envclear(e, nsig);
+	for (j = a; j < b; j += (WFDB_Time)1 << k) {
+	    /* Use the largest block that begins at j and ends by b. */
+	    for (k = 0; k+1 < ENVLEVELS &&
+		     (j & (((WFDB_Time)2 << k) - 1)) == 0 &&
+		     j + ((WFDB_Time)2 << k) <= b &&
+		     (j >> (k+1)) < envp->lev[k+1].n; k++)
+		;
+	    envmerge(e, envp->lev[k].e + (j >> k) * nsig, nsig);
+	}
+	/* The number of samples covered is b - a blocks, except that the last
+	   block of the record may be incomplete. */
+	t = (b - a) << ENVSHIFT;
+	if (envp->done && b == envp->lev[0].n && (envp->nsamp & (ENVBLOCK-1)))
+	    t -= ENVBLOCK - (envp->nsamp & (ENVBLOCK-1));
+	for (s = 0; s < nsig; s++)
+	    envset(&env[i*nsig + s], &e[s], (long)t);
+    }
+    return (i);
+}
+
+FINT putenvelope(void)
+{
+    int i, nsig;
+    size_t blen;
+    unsigned char *buf = NULL, *p;
+    struct envent *e;
+    WFDB_Time b, nb;
+    WFDB_FILE *ofile;
+
+    if (envcheck("putenvelope") < 0 || envextend(WFDB_TIME_MAX) < 0)
+	return (-1);
+    nsig = envp->nsig;
+    blen = ENVENTSIZE * nsig;
+    if ((ofile = wfdb_open("env", envp->record, WFDB_WRITE)) == NULL) {
+	wfdb_error("putenvelope: can't write envelope file for record %s\n",
+		   envp->record);
+	return (-2);
+    }
+    SUALLOC(buf, ENVHDRSIZE + 8*nsig > blen ? ENVHDRSIZE + 8*nsig : blen, 1);
+    if (buf == NULL) {
+	wfdb_fclose(ofile);
+	return (-1);
+    }
+    envheader(buf);
+    wfdb_fwrite(buf, 1, ENVHDRSIZE + 8*nsig, ofile);
+    nb = envp->lev[0].n;
+    for (b = 0; b < nb; b++) {
+	for (i = 0, p = buf, e = envp->lev[0].e + b*nsig; i < nsig;
+	     i++, p += ENVENTSIZE, e++) {
+	    envput(p, e->min, 4);
+	    envput(p + 4, e->max, 4);
+	    envput(p + 8, e->sum, 8);
+	    envput(p + 16, e->nvalid, 4);
+	}
+	wfdb_fwrite(buf, 1, blen, ofile);
+    }
+    SFREE(buf);
+    if (wfdb_ferror(ofile)) {
+	wfdb_error("putenvelope: write error in envelope file for record %s\n",
+		   envp->record);
+	wfdb_fclose(ofile);
+	return (-2);
+    }
+    return (wfdb_fclose(ofile) ? -2 : 0);
+}
+
 /* Private functions (for use by other WFDB library functions only). */
 
 void wfdb_sampquit(void)
@@ -4685,6 +5776,8 @@ void wfdb_sigclose(void)
 {
     isigclose();
     osigclose();
+    envfree();
+    edffree(&hedf);
     btime = bdate = nsamples = msbtime = msbdate = msnsamples = (WFDB_Time)0;
     sfreq = ifreq = ffreq = (WFDB_Frequency)0;
     pdays = (WFDB_Date)-1;
@@ -4705,6 +5798,9 @@ void wfdb_sigclose(void)
 	}
     }
     SFREE(segarray_L);
+    wfdb_freeheader(hdrinfo);
+    hdrinfo = NULL;
+    SFREE(hdrrec);
     SFREE(gv0);
     SFREE(gv1);
     SFREE(tvector);
@@ -4859,6 +5955,24 @@ FSAMPLE sample(WFDB_Signal s, long t)
     return (wfdb_sample_LL(s, t));
 }
 
+#undef getedfblock
+FINT getedfblock(WFDB_Signal s, long b, WFDB_Sample *vector)
+{
+    return (wfdb_getedfblock_LL(s, b, vector));
+}
+
+#undef getedfonset
+FDOUBLE getedfonset(long b)
+{
+    return (wfdb_getedfonset_LL(b));
+}
+
+#undef getenvelope
+FINT getenvelope(long t0, long t1, int n, WFDB_Envelope *env)
+{
+    return (wfdb_getenvelope_LL(t0, t1, n, env));
+}
+
 #undef getseginfo
 FINT getseginfo(struct WFDB_seginfo_L **sarray)
 {
@@ -4876,4 +5990,98 @@ FINT getseginfo(struct WFDB_seginfo_L **sarray)
     return (segments);
 }
 
+struct WFDB_hdrinfo_L {
+    char *recname;
+    int nsig;
+    int nseg;
+    WFDB_Frequency ffreq;
+    WFDB_Frequency cfreq;
+    double bcount;
+    /* WFDB_Time */ long nsamp;
+    char *btime;
+    struct WFDB_siginfo *siginfo;
+    int *skew;
+    long *start;
+    struct WFDB_seginfo_L *seginfo;
+    int ninfo;
+    char **info;
+    void *arena;	/* here, the WFDB_Hdrinfo from which this was made */
+};
+
+/* hconv makes a copy of a WFDB_Hdrinfo structure for use by an application
+   that does not support WFDB_LARGETIME.  The strings and arrays other than
+   seginfo are shared with the original, which is freed along with the copy
+   by the wrapper for wfdb_freeheader. */
+static struct WFDB_hdrinfo_L *hconv(WFDB_Hdrinfo *h)
+{
+    int i;
+    struct WFDB_hdrinfo_L *hl;
+
+    if ((hl = calloc(1, sizeof(*hl) +
+		     h->nseg * sizeof(struct WFDB_seginfo_L))) == NULL) {
+	wfdb_freeheader_LL(h);
+	return (NULL);
+    }
+    hl->recname = h->recname;
+    hl->nsig = h->nsig;
+    hl->nseg = h->nseg;
+    hl->ffreq = h->ffreq;
+    hl->cfreq = h->cfreq;
+    hl->bcount = h->bcount;
+    hl->nsamp = tclamp(h->nsamp);
+    hl->btime = h->btime;
+    hl->siginfo = h->siginfo;
+    hl->skew = h->skew;
+    hl->start = h->start;
+    if (h->nseg > 0) {
+	hl->seginfo = (struct WFDB_seginfo_L *)(hl + 1);
+	for (i = 0; i < h->nseg; i++) {
+	    memcpy(hl->seginfo[i].recname, h->seginfo[i].recname,
+		   sizeof(h->seginfo[i].recname));
+	    hl->seginfo[i].nsamp = tclamp(h->seginfo[i].nsamp);
+	    hl->seginfo[i].samp0 = tclamp(h->seginfo[i].samp0);
+	}
+    }
+    hl->ninfo = h->ninfo;
+    hl->info = h->info;
+    hl->arena = h;
+    return (hl);
+}
+
+#undef wfdb_parseheader
+FINT wfdb_parseheader(const char *text, long length,
+		      struct WFDB_hdrinfo_L **header)
+{
+    int stat;
+    WFDB_Hdrinfo *h;
+
+    *header = NULL;
+    if ((stat = wfdb_parseheader_LL(text, length, &h)) == 0 &&
+	(*header = hconv(h)) == NULL)
+	stat = -3;
+    return (stat);
+}
+
+#undef wfdb_readheader
+FINT wfdb_readheader(char *record, struct WFDB_hdrinfo_L **header)
+{
+    int stat;
+    WFDB_Hdrinfo *h;
+
+    *header = NULL;
+    if ((stat = wfdb_readheader_LL(record, &h)) == 0 &&
+	(*header = hconv(h)) == NULL)
+	stat = -3;
+    return (stat);
+}
+
+#undef wfdb_freeheader
+FVOID wfdb_freeheader(struct WFDB_hdrinfo_L *header)
+{
+    if (header) {
+	wfdb_freeheader_LL(header->arena);
+	free(header);
+    }
+}
+
 #endif /* WFDB_LARGETIME */
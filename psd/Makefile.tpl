@@ -1,5 +1,5 @@
 # file: Makefile.tpl		G. Moody	  24 May 2000
-#				Last revised:	 24 April 2020
+#				Last revised:	18 October 2026
 # This section of the Makefile should not need to be changed.
 
 # Programs to be compiled.
@@ -8,7 +8,8 @@ XFILES = \
  fft$(EXEEXT) \
  log10$(EXEEXT) \
  lomb$(EXEEXT) \
- memse$(EXEEXT)
+ memse$(EXEEXT) \
+ spectrogram$(EXEEXT)
 
 # Shell scripts to be installed.
 SCRIPTS = hrfft hrlomb hrmem hrplot plot2d plot3d
@@ -38,20 +39,24 @@ scripts:	$(DESTDIR)$(BINDIR)
 uninstall:
 	../uninstall.sh $(DESTDIR)$(BINDIR) $(XFILES) $(SCRIPTS)
 
-coherence$(EXEEXT):	coherence.c
-	$(CC) $(CFLAGS) -o coherence$(EXEEXT) -O coherence.c -lm
+coherence$(EXEEXT):	coherence.c spectrum.c spectrum.h
+	$(CC) $(CFLAGS) -o coherence$(EXEEXT) -O coherence.c spectrum.c -lm -lpthread
 
-fft$(EXEEXT):		fft.c
-	$(CC) $(CFLAGS) -o fft$(EXEEXT) -O fft.c -lm
+fft$(EXEEXT):		fft.c spectrum.c spectrum.h
+	$(CC) $(CFLAGS) -o fft$(EXEEXT) -O fft.c spectrum.c -lm -lpthread
 
 log10$(EXEEXT):		log10.c
 	$(CC) $(CFLAGS) -o log10$(EXEEXT) -O log10.c -lm
 
-lomb$(EXEEXT):		lomb.c
-	$(CC) $(CFLAGS) -o lomb$(EXEEXT) -O lomb.c -lm
+lomb$(EXEEXT):		lomb.c spectrum.c spectrum.h
+	$(CC) $(CFLAGS) -o lomb$(EXEEXT) -O lomb.c spectrum.c -lm -lpthread
 
-memse$(EXEEXT):		memse.c
-	$(CC) $(CFLAGS) -o memse$(EXEEXT) -O memse.c -lm
+memse$(EXEEXT):		memse.c spectrum.c spectrum.h
+	$(CC) $(CFLAGS) -o memse$(EXEEXT) -O memse.c spectrum.c -lm -lpthread
+
+spectrogram$(EXEEXT):	spectrogram.c spectrum.c spectrum.h
+	$(CC) $(CFLAGS) -o spectrogram$(EXEEXT) -O spectrogram.c spectrum.c \
+	  $(LDFLAGS) -lm -lpthread
 
 # `make clean': remove intermediate and backup files.
 clean:
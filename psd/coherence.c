@@ -1,9 +1,9 @@
 /* file: coherence.c		G. Moody	22 December 1993
-				Last revised:   17 November 2002
+				Last revised:   18 October 2026
 
 -------------------------------------------------------------------------------
 coherence: Coherence and cross-spectral power estimation
-Copyright (C) 2002 George B. Moody
+Copyright (C) 2002-2026 George B. Moody
 
 This program is free software; you can redistribute it and/or modify it under
 the terms of the GNU General Public License as published by the Free Software
@@ -61,10 +61,22 @@ In outline, the computations are performed as follows:
    normalized, accumulated, squared cross-spectrum and the product of the
    normalized, accumulated autospectra.
 
+With the -m option, the input may contain any number of columns, and the
+coherence and cross-spectra of each pair of columns are estimated in one pass.
+The input is read sequentially (so that it may come from a pipe), and the
+segments of each column are transformed once, in batches, using segfft (in
+spectrum.c);  the auto- and cross-spectra of all pairs of columns are then
+accumulated from the transforms by csdacc.  Both are performed by several
+threads if the -j option is used.  The output for each pair of columns has the
+same format as that described above, and the outputs for the pairs are
+separated by empty lines.
+
 Usage:
   coherence -i FILENAME [ OPTIONS ]
 where FILENAME is the name of the input file, and OPTIONS may include:
   -f FREQUENCY	specify sampling frequency in Hz (default: 250)
+  -j N		use N threads (with -m)
+  -m		estimate coherence and cross-spectra of all pairs of columns
   -n SIZE	specify number of samples per segment (default: 1024)
   -v		print column headings
   -x SX SY	specify scale factors for the two time series (defaults: 1)
@@ -74,10 +86,15 @@ where FILENAME is the name of the input file, and OPTIONS may include:
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include "spectrum.h"
+
+#define BATCH	16	/* segments per batch for each thread (see -m) */
 
 /* Function prototypes */
 static int load(double *xx, double *yy, int nnn);
 static void coherence(int nnn, double sfx, double sfy);
+static void matrix(int nnn, int nthreads);
+static int firstrow(double **row);
 static void lremv(double *xx, int nnn);
 static void fft842(int isign, int n, double *ar, double *ai);
 static void r2tx(int nthpo, double *cr0, double *cr1, double *ci0, double *ci1);
@@ -94,14 +111,16 @@ static void help(void);
 static double *xx, *yy, *gxx, *gyy, *gxyre, *gxyim, *phi, *weight;
 static double sampfreq = 250.0;
 static FILE *ifile = NULL;
+static char *pname;
 static int npfft;   /* points per Fourier transform segment (a power of 2) */
 static int vflag;   /* print column headings if non-zero */
 
 int main(int argc, char *argv[])
 {
-    int i, pps = 1024;
+    int i, mflag = 0, nthreads = 1, pps = 1024;
     double sfx = 1.0, sfy = 1.0;
 
+    pname = prog_name(argv[0]);
     for (i = 1; i < argc; i++) {
         if (*argv[i] == '-') switch (*(argv[i]+1)) {
           case 'f':   /* sampling frequency (Hz) follows */
@@ -126,6 +145,21 @@ int main(int argc, char *argv[])
                 exit(1);
             }
             break;
+          case 'j':   /* number of threads follows */
+            if (++i >= argc || (nthreads = atoi(argv[i])) < 1) {
+                (void)fprintf(stderr, "%s: number of threads must follow -j\n",
+			      argv[0]);
+                exit(1);
+            }
+#ifdef NOPTHREADS
+            nthreads = 1;
+#else
+            if (nthreads > MAXTHREADS) nthreads = MAXTHREADS;
+#endif
+            break;
+          case 'm':   /* cross-spectral matrix of all columns */
+            mflag = 1;
+            break;
           case 'n':   /* number of points per segment follows */
             if (++i >= argc || (pps = atoi(argv[i])) < 2 || pps > 32768) {
                 (void)fprintf(stderr,
@@ -160,7 +194,11 @@ int main(int argc, char *argv[])
         help();
         exit(1);
     }
-    
+    if (mflag && (sfx != 1.0 || sfy != 1.0)) {
+        (void)fprintf(stderr, "%s: -x cannot be used with -m\n", argv[0]);
+        exit(1);
+    }
+
     /* Number of FFT inputs (a power of 2 no less than nnn). */
     for (npfft = 2; npfft < pps; npfft <<= 1)
         ;
@@ -178,7 +216,8 @@ int main(int argc, char *argv[])
 		      argv[0], npfft/2);
         exit(1);
     }
-    coherence(pps, sfx, sfy);
+    if (mflag) matrix(pps, nthreads);
+    else coherence(pps, sfx, sfy);
     exit(0);
 }
 
@@ -259,6 +298,163 @@ static void coherence(int nnn, double sfx, double sfy)
     }
 }
 
+/* This function estimates the coherence and cross-spectra of all pairs of
+   columns of the input (see -m).  The input is read into a buffer that holds
+   the samples needed for a batch of overlapping segments;  the segments begin
+   every nnn/2 samples, and are processed as they are by coherence() (and by
+   load()), so that the results for a two-column input match those obtained
+   without -m. */
+static void matrix(int nnn, int nthreads)
+{
+    double df, dt, *buf, *gre, *gim, gxx, gyy, *im, norm, *re, *row, *x;
+    int c, i, j, k, nch, nd2 = nnn/2, nb = npfft/2 + 1;
+    long avail, cap, n, nbatch = (long)BATCH*nthreads, nffts = 0, nseg, s;
+    int done = 0, eof = 0;
+    struct fftplan *p;
+
+    if ((nch = firstrow(&row)) < 2) {
+        (void)fprintf(stderr,
+		      "%s: at least two columns of input are needed with -m\n",
+		      pname);
+        exit(1);
+    }
+    cap = (nbatch - 1)*nd2 + nnn;
+    if ((buf = (double *)malloc(nch*cap * sizeof(double))) == NULL ||
+        (x = (double *)malloc(nbatch*nch*npfft * sizeof(double))) == NULL ||
+        (re = (double *)malloc(nbatch*nch*nb * sizeof(double))) == NULL ||
+        (im = (double *)malloc(nbatch*nch*nb * sizeof(double))) == NULL ||
+        (gre = (double *)calloc(nch*(nch+1)/2*nb, sizeof(double))) == NULL ||
+        (gim = (double *)calloc(nch*(nch+1)/2*nb, sizeof(double))) == NULL ||
+        (p = fftplan(npfft)) == NULL) {
+        (void)fprintf(stderr, "%s: insufficient memory\n", pname);
+        exit(1);
+    }
+    for (c = 0; c < nch; c++)
+        buf[c*cap] = row[c];
+    avail = 1;
+
+    /* Compute Hanning window. */
+    for (i = 0; i < nnn; i++)
+        weight[i] = 0.5*(1 - cos(2.0*M_PI*i/(nnn - 1)));
+
+    while (!done) {
+        /* Fill the buffer. */
+        while (!eof && avail < cap) {
+            for (c = 0; c < nch; c++)
+                if (fscanf(ifile, "%lf", &buf[c*cap + avail]) != 1) {
+                    eof = 1;
+                    break;
+                }
+            if (!eof) avail++;
+        }
+
+        /* Detrend, zero-mean, window, and zero-pad the segments of each
+           column.  A segment is processed once it is complete, or at the
+           end of the input;  the last segment is the first one that contains
+           no more than nnn/2 samples. */
+        for (nseg = s = 0; nseg < nbatch; ) {
+            if ((n = avail - s) > nnn) n = nnn;
+            if (n <= 0) { done = 1; break; }
+            if (n < nnn && !eof) break;
+            for (c = 0; c < nch; c++) {
+                double *xs = x + (nseg*nch + c)*npfft;
+
+                for (i = 0; i < n; i++)
+                    xs[i] = buf[c*cap + s + i];
+                lremv(xs, n);
+                for (i = 0; i < n; i++)
+                    xs[i] *= weight[i];
+                for ( ; i < npfft; i++)
+                    xs[i] = 0.0;
+            }
+            nseg++;
+            if (n <= nd2) { done = 1; break; }
+            s += nd2;
+        }
+        if (nseg > 0) {
+            if (segfft(p, x, nseg*nch, NULL, re, im, nthreads) < 0) {
+                (void)fprintf(stderr, "%s: insufficient memory\n", pname);
+                exit(1);
+            }
+            csdacc(re, im, nseg, nch, nb, gre, gim, nthreads);
+            nffts += nseg;
+        }
+        else if (eof) done = 1;
+
+        /* Discard the samples that are not needed for the next batch. */
+        for (c = 0; c < nch; c++)
+            memmove(buf + c*cap, buf + c*cap + s, (avail - s)*sizeof(double));
+        avail -= s;
+    }
+    if (nffts == 0) return;
+
+    /* Normalize and print the estimates for each pair of columns. */
+    dt = 1.0/sampfreq;
+    df = 1.0/(dt*npfft);
+    norm = dt/((double)nnn*nffts);
+    for (i = 0; i < nch; i++)
+        for (j = i+1; j < nch; j++) {
+            double *gxyre = gre + CSDPAIR(i, j, nch)*nb,
+                   *gxyim = gim + CSDPAIR(i, j, nch)*nb,
+                   *gxxre = gre + CSDPAIR(i, i, nch)*nb,
+                   *gyyre = gre + CSDPAIR(j, j, nch)*nb, coh, phi;
+
+            if (i > 0 || j > 1) (void)printf("\n");
+            if (vflag)
+                (void)printf("Columns %d and %d:\n"
+                "Freq (Hz)  Coherence    gxy (dB)    gxx (dB)    gyy (dB)\n",
+                             i+1, j+1);
+            for (k = 0; k < npfft/2; k++) {
+                gxx = gxxre[k]*norm;
+                gyy = gyyre[k]*norm;
+                phi = (gxyre[k]*gxyre[k] + gxyim[k]*gxyim[k])*norm*norm;
+                if (gxx == 0.0 || gyy == 0.0) coh = 1.0;
+                else coh = phi / (gxx*gyy);
+                (void)printf("%9.4lf  %9.4lf  %10.4lf  %10.4lf  %10.4lf\n",
+                             df*k, coh,
+                             (phi > 1.0e-10 ? 5.0*log10(phi) : -50.0),
+                             (gxx > 1.0e-10 ? 10.0*log10(gxx) : -100.0),
+                             (gyy > 1.0e-10 ? 10.0*log10(gyy) : -100.0));
+            }
+        }
+    free(buf);
+    free(x);
+    free(re);
+    free(im);
+    free(gre);
+    free(gim);
+    free(row);
+}
+
+/* This function reads the first line of the input, stores the numbers in it
+   in *row (allocated here), and returns the number of columns. */
+static int firstrow(double **row)
+{
+    char *line = NULL, *p, *q;
+    int c, n = 0, size = 0;
+
+    for (;;) {
+        if (n >= size - 1 &&
+            (line = (char *)realloc(line, size += 1024)) == NULL) {
+            (void)fprintf(stderr, "%s: insufficient memory\n", pname);
+            exit(1);
+        }
+        if ((c = getc(ifile)) == EOF || c == '\n') break;
+        line[n++] = c;
+    }
+    line[n] = '\0';
+    if ((*row = (double *)malloc((n/2 + 2) * sizeof(double))) == NULL) {
+        (void)fprintf(stderr, "%s: insufficient memory\n", pname);
+        exit(1);
+    }
+    for (c = 0, p = line; ; p = q, c++) {
+        (*row)[c] = strtod(p, &q);
+        if (q == p) break;
+    }
+    free(line);
+    return (c);
+}
+
 /* This function loads the data arrays. */
 static int load(double *xx, double *yy, int nnn)
 {
@@ -523,11 +719,15 @@ static void help(void)
     (void)fprintf(stderr,
 " time series arranged in two columns (use `-' for standard input, which\n");
     (void)fprintf(stderr,
-" may not come from a pipe), and\n");
+" may not come from a pipe unless -m is used), and\n");
     (void)fprintf(stderr, " OPTIONS may include:\n");
     (void)fprintf(stderr,
 "  -f FREQ    specify sampling frequency in Hz (default: 250)\n");
     (void)fprintf(stderr,
+"  -j N       use N threads (with -m)\n");
+    (void)fprintf(stderr,
+"  -m         estimate coherence and cross-spectra of all pairs of columns\n");
+    (void)fprintf(stderr,
 "  -n SIZE    specify number of samples per segment (default: 1024)\n");
     (void)fprintf(stderr,
 "  -v         print column headings\n");
@@ -536,5 +736,7 @@ static void help(void)
     (void)fprintf(stderr,
 " The standard output contains five columns: frequency (Hz), coherence,\n");
     (void)fprintf(stderr,
-" and power cross- and auto-spectral densities (dB).\n");
+" and power cross- and auto-spectral densities (dB).  With -m, the output\n");
+    (void)fprintf(stderr,
+" for each pair of columns is followed by an empty line.\n");
 }
\ No newline at end of file
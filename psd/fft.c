@@ -1,9 +1,9 @@
 /* file: fft.c		G. Moody	24 February 1988
-		   Last revised:	27 October 2008
+		   Last revised:	18 October 2026
 
 -------------------------------------------------------------------------------
 fft: Fast Fourier transform of real data
-Copyright (C) 1988-2005 George B. Moody
+Copyright (C) 1988-2026 George B. Moody
 
 This program is free software; you can redistribute it and/or modify it under
 the terms of the GNU General Public License as published by the Free Software
@@ -27,15 +27,19 @@ time series, presented as a column of numbers.  The default standard output is
 the magnitude of the discrete Fourier transform of the input series, normalized
 by the length of the FFT.
 
-The functions `realft' and `four1' are based on those in Press, W.H., et al.,
-Numerical Recipes in C: the Art of Scientific Computing (Cambridge Univ. Press,
-1989;  2nd ed., 1992).
+The transforms are computed in double precision by the functions in
+spectrum.c, which accept series of any length.  Unless the -e option is used,
+the input is padded with zeroes to a power of two, as in earlier versions of
+this program (which used the radix-2 `realft' and `four1' functions from
+Numerical Recipes).  When the input is processed in chunks (-n or -N), batches
+of chunks are transformed in parallel.
 */
 
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include "spectrum.h"
 
 #ifndef BSD
 # include <string.h>
@@ -45,129 +49,34 @@ Numerical Recipes in C: the Art of Scientific Computing (Cambridge Univ. Press,
 #endif
 
 #define	LEN	16384		/* maximum points in FFT */
-#ifdef i386
-#define strcasecmp strcmp
-#endif
-#define PI	M_PI	/* pi to machine precision, defined in math.h */
-#define TWOPI	(2.0*PI)
+#define BATCH	16		/* chunks per batch for each thread */
 
 /* Function prototypes */
-static double win_bartlett(int i, int n);
-static double win_blackman(int i, int n);
-static double win_blackman_harris(int i, int n);
-static double win_hamming(int i, int n);
-static double win_hanning(int i, int n);
-static double win_parzen(int i, int n);
-static double win_square(int i, int n);
-static double win_welch(int i, int n);
 static char *prog_name(char *s);
 static void help(void);
-static void four1(float data[], int nn, int isign);
-static void realft(float data[], int n, int isign);
 static void read_input(void);
+static void prep(double *x, int n);
 static void fft(void);
 static void ifft(void);
 static void fft_out(void);
-static long input(void);
 
 /* Global variables (kept minimal) */
 static int m, n;
 static char *pname;
 static FILE *ifile;
-static float *c;
-static double freq, fstep, norm, rmean;
+static double *c, *cre, *cim;
+static double freq, fstep, norm;
 static double wsum, rsum;
-static double (*window)(int, int);
+static winfn window;
+static struct fftplan *plan;
 static long nchunks;
-static int wflag, zflag;
+static int eflag, wflag, zflag;
 static int cflag, fflag, iflag, pflag, Pflag;
 static int nflag, Nflag;
+static int nthreads = 1;
 static long len = LEN;
 static long smooth = 1, decimation = 1;
 
-/* See Oppenheim & Schafer, Digital Signal Processing, p. 241 (1st ed.) */
-static double win_bartlett(int j, int n)
-{
-    double a = 2.0/(n-1), w;
-
-    if ((w = j*a) > 1.0) w = 2.0 - w;
-    wsum += w;
-    return (w);
-}
-
-/* See Oppenheim & Schafer, Digital Signal Processing, p. 242 (1st ed.) */
-static double win_blackman(int j, int n)
-{
-    double a = 2.0*PI/(n-1), w;
-
-    w = 0.42 - 0.5*cos(a*j) + 0.08*cos(2*a*j);
-    wsum += w;
-    return (w);
-}
-
-/* See Harris, F.J., "On the use of windows for harmonic analysis with the
-   discrete Fourier transform", Proc. IEEE, Jan. 1978 */
-static double win_blackman_harris(int j, int n)
-{
-    double a = 2.0*PI/(n-1), w;
-
-    w = 0.35875 - 0.48829*cos(a*j) + 0.14128*cos(2*a*j) - 0.01168*cos(3*a*j);
-    wsum += w;
-    return (w);
-}
-
-/* See Oppenheim & Schafer, Digital Signal Processing, p. 242 (1st ed.) */
-static double win_hamming(int j, int n)
-{
-    double a = 2.0*PI/(n-1), w;
-
-    w = 0.54 - 0.46*cos(a*j);
-    wsum += w;
-    return (w);
-}
-
-/* See Oppenheim & Schafer, Digital Signal Processing, p. 242 (1st ed.)
-   The second edition of Numerical Recipes calls this the "Hann" window. */
-static double win_hanning(int j, int n)
-{
-    double a = 2.0*PI/(n-1), w;
-
-    w = 0.5 - 0.5*cos(a*j);
-    wsum += w;
-    return (w);
-}
-
-/* See Press, Flannery, Teukolsky, & Vetterling, Numerical Recipes in C,
-   p. 442 (1st ed.) */
-static double win_parzen(int j, int n)
-{
-    double a = (n-1)/2.0, w;
-
-    if ((w = (j-a)/(a+1)) > 0.0) w = 1 - w;
-    else w = 1 + w;
-    wsum += w;
-    return (w);
-}
-
-/* See any of the above references. */
-static double win_square(int j, int n)
-{
-    wsum += 1.0;
-    return (1.0);
-}
-
-/* See Press, Flannery, Teukolsky, & Vetterling, Numerical Recipes in C,
-   p. 442 (1st ed.) or p. 554 (2nd ed.) */
-static double win_welch(int j, int n)
-{
-    double a = (n-1)/2.0, w;
-
-    w = (j-a)/(a+1);
-    w = 1 - w*w;
-    wsum += w;
-    return (w);
-}
-
 int main(int argc, char *argv[])
 {
     int i = 0;
@@ -187,6 +96,9 @@ int main(int argc, char *argv[])
 	  case 'c':	/* print complex spectrum */
 	    cflag = 1;
 	    break;
+	  case 'e':	/* don't pad transforms to a power of two */
+	    eflag = 1;
+	    break;
 	  case 'f':	/* sampling frequency in Hz */
 	    if (++i >= argc) {
 		fprintf(stderr, "%s: sampling frequency must follow -f\n",
@@ -216,6 +128,18 @@ int main(int argc, char *argv[])
 	    }
 	    iflag = -1;
 	    break;
+	  case 'j':	/* number of threads follows */
+	    if (++i >= argc || (nthreads = atoi(argv[i])) < 1) {
+		fprintf(stderr, "%s: number of threads must follow -j\n",
+			pname);
+		exit(1);
+	    }
+#ifdef NOPTHREADS
+	    nthreads = 1;
+#else
+	    if (nthreads > MAXTHREADS) nthreads = MAXTHREADS;
+#endif
+	    break;
 	  case 'l':	/* perform up to n-point transforms */
 	    if (++i >= argc) {
 		fprintf(stderr, "%s: transform size must follow -l\n", pname);
@@ -264,28 +188,7 @@ int main(int argc, char *argv[])
 			pname);
 		exit(1);
 	    }
-	    if (strcasecmp(argv[i], "Bartlett") == 0)
-		window = win_bartlett;
-	    else if (strcasecmp(argv[i], "Blackman") == 0)
-		window = win_blackman;
-	    else if (strcasecmp(argv[i], "Blackman-Harris") == 0)
-		window = win_blackman_harris;
-	    else if (strcasecmp(argv[i], "Hamming") == 0)
-		window = win_hamming;
-	    /* Numerical Recipes 2nd ed. calls Hanning window "Hann window" */
-	    else if (strcasecmp(argv[i], "Hann") == 0)
-		window = win_hanning;
-	    else if (strcasecmp(argv[i], "Hanning") == 0)
-		window = win_hanning;
-	    else if (strcasecmp(argv[i], "Parzen") == 0)
-		window = win_parzen;
-	    else if (strcasecmp(argv[i], "Square") == 0 ||
-		     strcasecmp(argv[i], "Rectangular") == 0 ||
-		     strcasecmp(argv[i], "Dirichlet") == 0)
-		window = win_square;
-	    else if (strcasecmp(argv[i], "Welch") == 0)
-		window = win_welch;
-	    else {
+	    if ((window = win_lookup(argv[i])) == NULL) {
 		fprintf(stderr, "%s: unrecognized window type %s\n",
 			pname, argv[i]);
 		exit(1);
@@ -341,91 +244,144 @@ int main(int argc, char *argv[])
 	}
     }
 
-    /* Make sure that len is a power of two. */
+    /* Unless the -e option was given, make sure that len is a power of two. */
     if (len < 1) len = 1;
-    if (len < LEN) {
+    if (eflag)
+	;
+    else if (len < LEN) {
 	for (m = LEN; m >= len; m >>= 1)
 	    ;
 	m <<= 1;
+	len = m;
     }
     else {
 	for (m = LEN; m < len; m <<= 1)
 	    ;
+	len = m;
     }
-    len = m;
 
-    if ((c = (float *)calloc(len, sizeof(float))) == NULL) {
-	fprintf(stderr, "%s: insufficient memory\n", pname);
-	exit(2);
-    }
-	
     if (iflag) {		/* calculate and print inverse FFT */
-	for (n = 0, rsum = 0.; n < len && fscanf(ifile, "%f", &c[n]) == 1; n++)
+	if ((c = (double *)calloc(len+2, sizeof(double))) == NULL) {
+	    fprintf(stderr, "%s: insufficient memory\n", pname);
+	    exit(2);
+	}
+	for (n = 0; n < len+2 && fscanf(ifile, "%lf", &c[n]) == 1; n++)
 	    ;
 	if (n == 0) {
 	    fprintf(stderr, "%s: standard input is empty\n", pname);
 	    exit(2);
 	}
+	if (n < 4) {
+	    fprintf(stderr, "%s: input series is too short\n", pname);
+	    exit(2);
+	}
 	ifft();
 	exit(0);
     }
 
     else {			/* calculate and print forward FFT */
 	if (nflag) {		/* process input in chunks */
-	    float *s, *t;
-	    int nf2 = nflag/2;
+	    double *s, *t, *x, *xi, *xr, *win = NULL;
+	    int done = 0, nb, nf2 = nflag/2;
+	    long k, nbatch = BATCH * nthreads, nseg;
 
-	    for (m = len; m >= nflag; m >>= 1)
-		;
-	    m <<= 1;		/* m is now the smallest power of 2 >= nflag */
-	    if ((s = (float *)calloc(sizeof(float), m)) == NULL ||
-		(t = (float *)calloc(sizeof(float), m/2)) == NULL) {
+	    if (eflag)
+		m = nflag;
+	    else {
+		for (m = len; m >= nflag; m >>= 1)
+		    ;
+		m <<= 1;	/* m is now the smallest power of 2 >= nflag */
+	    }
+	    nb = m/2 + 1;
+	    if ((plan = fftplan(m)) == NULL ||
+		(wflag && (win = win_table(window, m, &wsum)) == NULL) ||
+		(x = (double *)malloc(nbatch * m * sizeof(double))) == NULL ||
+		(xr = (double *)malloc(nbatch * nb * sizeof(double))) == NULL ||
+		(xi = (double *)malloc(nbatch * nb * sizeof(double))) == NULL ||
+		(s = (double *)calloc(2*nb, sizeof(double))) == NULL ||
+		(t = (double *)calloc(nf2 + 1, sizeof(double))) == NULL ||
+		(cre = (double *)calloc(nb + smooth, sizeof(double))) == NULL ||
+		(cim = (double *)calloc(nb + smooth, sizeof(double))) == NULL) {
 		fprintf(stderr, "%s: insufficient memory\n", pname);
 		exit(2);
 	    }
-	    for (n = 0; n < nf2 && fscanf(ifile, "%f", &t[n]) == 1; n++)
+	    if (!wflag) wsum = m;
+	    n = nflag;
+	    norm = sqrt(2.0/(wsum*n));
+	    if (fflag) fstep = freq/m;
+
+	    /* Each chunk begins with the last nf2 samples of the previous one.
+	       The chunks are read in batches, and the chunks in each batch
+	       are transformed in parallel. */
+	    for (i = 0; i < nf2 && fscanf(ifile, "%lf", &t[i]) == 1; i++)
 		;
-	    while (1) {
-		if (zflag) {
-		    for (n = 0, rsum = 0.; n < nf2; n++)
-			rsum += c[n] = t[n];
-		    for (i=0; n<nflag && fscanf(ifile,"%f",&t[i])==1; i++, n++)
-			rsum += c[n] = t[i]; /* read input, accumulate sum */
+	    while (!done) {
+		for (nseg = 0; nseg < nbatch; nseg++) {
+		    double *seg = x + nseg*m;
+
+		    for (n = 0; n < nf2; n++)
+			seg[n] = t[n];
+		    while (n < nflag && fscanf(ifile, "%lf", &seg[n]) == 1)
+			n++;
+		    if (n < nflag) {
+			done = 1;
+			break;
+		    }
+		    for (i = 0; i < nf2; i++)
+			t[i] = seg[nflag-nf2+i];
+		    prep(seg, n);
+		    for (i = n; i < m; i++)    /* zero the padding, if any */
+			seg[i] = 0.0;
 		}
-		else {
-		    for (n = 0, rsum = 0.; n < nf2; n++)
-			c[n] = t[n];
-		    for (i=0; n<nflag && fscanf(ifile,"%f",&t[i])==1; i++, n++)
-			c[n] = t[i];
-		    ;
+		if (nseg == 0) break;
+		if (segfft(plan, x, nseg, win, xr, xi, nthreads) < 0) {
+		    fprintf(stderr, "%s: insufficient memory\n", pname);
+		    exit(2);
+		}
+		for (k = 0; k < nseg; k++) {
+		    double *r = xr + k*nb, *q = xi + k*nb;
+
+		    if (Nflag) {
+			for (i = 0; i < nb; i++) {
+			    cre[i] = r[i];
+			    cim[i] = 0.0 - q[i];
+			}
+			fft_out();
+		    }
+		    else if (Pflag)
+			for (i = 0; i < nb; i++) {
+			    s[2*i] += r[i]*r[i];
+			    s[2*i+1] += q[i]*q[i];
+			}
+		    else
+			for (i = 0; i < nb; i++) {
+			    s[2*i] += r[i];
+			    s[2*i+1] -= q[i];
+			}
 		}
-		if (n < nflag) break;
-		for (i = n; i < m; i++)    /* re-zero the padding, if any */
-		    c[i] = 0;
-		fft();
-		if (Nflag)
-		    fft_out();
-		else if (Pflag)
-		    for (i = 0; i < m; i++)
-			s[i] += c[i]*c[i];
-		else
-		    for (i = 0; i < m; i++)
-			s[i] += c[i];
-		nchunks++;
+		nchunks += nseg;
 	    }
 	    if (nchunks < 1) {
 		fprintf(stderr, "%s: input series is too short\n", pname);
 		exit(2);
 	    }
 	    if (Nflag == 0 && Pflag)
-		for (i = 0; i < m; i++)
-		    c[i] = sqrt(s[i])/nchunks;
+		for (i = 0; i < nb; i++) {
+		    cre[i] = sqrt(s[2*i]/nchunks);
+		    cim[i] = sqrt(s[2*i+1]/nchunks);
+		}
 	    else
-		for (i = 0; i < m; i++)
-		    c[i] = s[i]/nchunks;
+		for (i = 0; i < nb; i++) {
+		    cre[i] = s[2*i]/nchunks;
+		    cim[i] = s[2*i+1]/nchunks;
+		}
 	}
 
 	else {
+	    if ((c = (double *)calloc(len, sizeof(double))) == NULL) {
+		fprintf(stderr, "%s: insufficient memory\n", pname);
+		exit(2);
+	    }
 	    read_input();
 	    if (n == 0) {
 		fprintf(stderr, "%s: standard input is empty\n", pname);
@@ -443,7 +399,7 @@ int main(int argc, char *argv[])
 
 /* This function detrends (subtracts a least-squares fitted line from) a
    a sequence of n uniformily spaced ordinates supplied in c. */
-static void detrend(float *c, int n)
+static void detrend(double *c, int n)
 {
     int i;
     double a, b = 0.0, tsqsum = 0.0, ysum = 0.0, t;
@@ -467,62 +423,77 @@ static void detrend(float *c, int n)
 
 static void read_input()
 {
-    if (zflag)
-	for (n = 0, rsum = 0.; n < len && fscanf(ifile, "%f", &c[n]) == 1; n++)
-	    rsum += c[n];	/* read input, accumulate sum */
-    else
-	for (n = 0, rsum = 0.; n < len && fscanf(ifile, "%f", &c[n]) == 1; n++)
-	    ;
+    for (n = 0; n < len && fscanf(ifile, "%lf", &c[n]) == 1; n++)
+	;
 }
 
-static void fft()		/* calculate forward FFT */
+/* Zero-mean and detrend the n samples in x, as specified by zflag. */
+static void prep(double *x, int n)
 {
     int i;
 
-    if (zflag) {		/* zero-mean the input array */
-	rmean = rsum/n;
+    if (zflag) {
+	for (i = 0, rsum = 0.; i < n; i++)
+	    rsum += x[i];
 	for (i = 0; i < n; i++)
-	    c[i] -= rmean;	
+	    x[i] -= rsum/n;
 	if (zflag == 2)
-	    detrend(c, n);
+	    detrend(x, n);
     }
-    for (m = len; m >= n; m >>= 1)
-	;
-    m <<= 1;		/* m is now the smallest power of 2 >= n; this is the
+}
+
+static void fft()		/* calculate forward FFT */
+{
+    double *w = NULL, *work;
+    int i, nb;
+
+    prep(c, n);
+    if (eflag)
+	m = n;
+    else {
+	for (m = len; m >= n; m >>= 1)
+	    ;
+	m <<= 1;	/* m is now the smallest power of 2 >= n; this is the
 			   length of the input series (including padding) */
+    }
+    nb = m/2 + 1;
+    if ((plan = fftplan(m)) == NULL || (work = fftwork(plan)) == NULL ||
+	(wflag && (w = win_table(window, m, &wsum)) == NULL) ||
+	(cre = (double *)calloc(nb + smooth, sizeof(double))) == NULL ||
+	(cim = (double *)calloc(nb + smooth, sizeof(double))) == NULL) {
+	fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
     if (wflag)			/* apply the chosen windowing function */
 	for (i = 0; i < m; i++)
-	    c[i] *= (*window)(i, m);
+	    c[i] *= w[i];
     else
 	wsum = m;
     norm = sqrt(2.0/(wsum*n));
-    if (fflag) fstep = freq/(2.*m); /* note that fstep is actually half of
-				       the frequency interval;  it is
-				       multiplied by the doubled index i
-				       to obtain the center frequency for
-				       bin (i/2) */
-    realft(c-1, m/2, 1);	/* perform the FFT;  see Numerical Recipes */
+    if (fflag) fstep = freq/m;
+    rfft(plan, c, cre, cim, work);
+    for (i = 0; i < nb; i++)	/* the phases are those of exp(+2 pi i ...) */
+	cim[i] = 0.0 - cim[i];
+    free(work);
 }
 
 static void fft_out()	/* print the FFT */
 {
     int i;
 
-    c[m] = c[1];		/* unpack the output array */
-    c[1] = c[m+1] = 0.;
-    for (i = 0; i <= m; i += 2*decimation) {
+    for (i = 0; i <= m/2; i += decimation) {
 	int j;
 	double pow;
 
 	if (fflag) printf("%g\t", i*fstep);
-	if (cflag) printf("%g\t%g\n", c[i], c[i+1]);
+	if (cflag) printf("%g\t%g\n", cre[i], cim[i]);
 	else {
-	    for (j = 0, pow = 0.0; j < 2*smooth; j += 2)
-	        pow += (c[i+j]*c[i+j] + c[i+j+1]*c[i+j+1])*norm*norm;
+	    for (j = 0, pow = 0.0; j < smooth; j++)
+	        pow += (cre[i+j]*cre[i+j] + cim[i+j]*cim[i+j])*norm*norm;
 	    pow /= smooth/decimation;
 	    if (Pflag) printf("%g", pow);
 	    else printf("%g", sqrt(pow));
-	    if (pflag) printf("\t%g", atan2(c[i+1], c[i]));
+	    if (pflag) printf("\t%g", atan2(cim[i], cre[i]));
 	    printf("\n");
 	}
     }
@@ -530,28 +501,43 @@ static void fft_out()	/* print the FFT */
 
 static void ifft()		/* calculate and print inverse FFT */
 {
+    double *work, *x, *xi, *xr;
     int i;
 
-    n -= 2;
-    c[1] = c[n];		/* repack IFFT input array */
-    if (iflag < 0) {		/* convert polar form input to rectangular */
-	for (i = 2; i < n; i += 2) {
-	    float im;
-
-	    im = c[i]*sin(c[i+1]);
-	    c[i] *= cos(c[i+1]);
-	    c[i+1] = im;
+    n = (n - 2) & ~1;		/* length of the output series */
+    if ((plan = fftplan(n)) == NULL || (work = fftwork(plan)) == NULL ||
+	(x = (double *)malloc(n * sizeof(double))) == NULL ||
+	(xr = (double *)malloc((n/2+1) * sizeof(double))) == NULL ||
+	(xi = (double *)malloc((n/2+1) * sizeof(double))) == NULL) {
+	fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    xr[0] = c[0];		/* the DC and Nyquist components are real */
+    xr[n/2] = c[n];
+    xi[0] = xi[n/2] = 0.0;
+    for (i = 1; i < n/2; i++) {
+	if (iflag < 0) {	/* convert polar form input to rectangular */
+	    xr[i] = c[2*i]*cos(c[2*i+1]);
+	    xi[i] = -c[2*i]*sin(c[2*i+1]);
+	}
+	else {
+	    xr[i] = c[2*i];
+	    xi[i] = -c[2*i+1];
 	}
     }
-    realft(c-1, n/2, -1);
+    rifft(plan, xr, xi, x, work);
     if (iflag < 0) {
-	norm = sqrt(2.0);
+	norm = sqrt(0.5);
 	for (i = 0; i < n; i++)
-	    printf("%g\n", c[i]*norm);
+	    printf("%g\n", x[i]*norm);
     }
     else
 	for (i = 0; i < n; i++)
-	    printf("%g\n", c[i]/(n/2.0));
+	    printf("%g\n", x[i]/n);
+    free(xi);
+    free(xr);
+    free(x);
+    free(work);
 }
 
 static char *prog_name(char *s)
@@ -579,6 +565,7 @@ static char *help_strings[] = {
  " (use `-' to read the standard input), and OPTIONS may be any of:",
  " -c       Output unnormalized complex FFT (real components in first column,",
  "          imaginary components in second column).",
+ " -e       Don't pad transforms to a power of two (see -l, -n, and -N).",
  " -f FREQ  Show the center frequency for each bin in the first column.  The",
  "          FREQ argument specifies the input sampling frequency;  the center",
  "          frequencies are given in the same units.",
@@ -587,20 +574,20 @@ static char *help_strings[] = {
  "          in the form generated by `fft -c', and the standard output is",
  "          a series of samples.",
  " -I       Perform inverse FFT as above, but using input generated by `fft -p'.",
+ " -j N     Transform chunks (see -n and -N) using N threads (default: 1).",
  " -l LEN   Perform up to LEN-point transforms.  `fft' rounds n up to the next",
- "          higher power of two unless LEN is already a power of two.  If the",
- "          input series contains fewer than LEN samples, it is padded with",
- "          zeros up to the next higher power of two.  Any additional input",
+ "          higher power of two unless LEN is already a power of two (or -e is",
+ "          used).  If the input series contains fewer than LEN samples, it is",
+ "          padded with zeros up to the next higher power of two (or not at all",
+ "          if -e is used).  Any additional input",
  "          samples beyond the first LEN are not read.  Default: LEN = 16384.",
- " -n NN     Process the input in overlapping chunks of N samples and output",
+ " -n NN    Process the input in overlapping chunks of NN samples and output",
  "          an averaged spectrum.  If used in combination with -P, the output",
  "          is the average of the individual squared magnitudes;  otherwise,",
  "          the output is derived from the averages of the real components and",
- "          of the imaginary components taken separately.  For best results,",
- "          NN should be a power of two.",
+ "          of the imaginary components taken separately.",
  " -N NN    Process the input in overlapping chunks of NN samples and output a",
- "          spectrum for each chunk.  For best results, NN should be a power",
- "          of two.",
+ "          spectrum for each chunk.",
  " -p       Show the phase in radians in the last column.",
  " -P       Generate a power spectrum (print squared magnitudes).",
  " -s N     Smooth the output by applying an N-point moving average to each bin.",
@@ -630,93 +617,3 @@ void help()
 	}
     }
 }
-
-void realft(float data[], int n, int isign)
-{
-    int i, i1, i2, i3, i4, n2p3;
-    float c1 = 0.5, c2, h1r, h1i, h2r, h2i;
-    double wr, wi, wpr, wpi, wtemp, theta;
-
-    theta = PI/(double) n;
-    if (isign == 1) {
-	c2 = -0.5;
-	four1(data, n, 1);
-    } 
-    else {
-	c2 = 0.5;
-	theta = -theta;
-    }
-    wtemp = sin(0.5*theta);
-    wpr = -2.0*wtemp*wtemp;
-    wpi = sin(theta);
-    wr = 1.0+wpr;
-    wi = wpi;
-    n2p3 = 2*n+3;
-    for (i = 2; i <= n/2; i++) {
-	i4 = 1 + (i3 = n2p3 - (i2 = 1 + ( i1 = i + i - 1)));
-	h1r =  c1*(data[i1] + data[i3]);
-	h1i =  c1*(data[i2] - data[i4]);
-	h2r = -c2*(data[i2] + data[i4]);
-	h2i =  c2*(data[i1] - data[i3]);
-	data[i1] =  h1r + wr*h2r - wi*h2i;
-	data[i2] =  h1i + wr*h2i + wi*h2r;
-	data[i3] =  h1r - wr*h2r + wi*h2i;
-	data[i4] = -h1i + wr*h2i + wi*h2r;
-	wr = (wtemp = wr)*wpr - wi*wpi+wr;
-	wi = wi*wpr + wtemp*wpi + wi;
-    }
-    if (isign == 1) {
-	data[1] = (h1r = data[1]) + data[2];
-	data[2] = h1r - data[2];
-    } else {
-	data[1] = c1*((h1r = data[1]) + data[2]);
-	data[2] = c1*(h1r - data[2]);
-	four1(data, n, -1);
-    }
-}
-
-void four1(float data[], int nn, int isign)
-{
-    int n, mmax, m, j, istep, i;
-    double wtemp, wr, wpr, wpi, wi, theta;
-    float tempr, tempi;
-    
-    n = nn << 1;
-    j = 1;
-    for (i = 1; i < n; i += 2) {
-	if (j > i) {
-	    tempr = data[j];     data[j] = data[i];     data[i] = tempr;
-	    tempr = data[j+1]; data[j+1] = data[i+1]; data[i+1] = tempr;
-	}
-	m = n >> 1;
-	while (m >= 2 && j > m) {
-	    j -= m;
-	    m >>= 1;
-	}
-	j += m;
-    }
-    mmax = 2;
-    while (n > mmax) {
-	istep = 2*mmax;
-	theta = TWOPI/(isign*mmax);
-	wtemp = sin(0.5*theta);
-	wpr = -2.0*wtemp*wtemp;
-	wpi = sin(theta);
-	wr = 1.0;
-	wi = 0.0;
-	for (m = 1; m < mmax; m += 2) {
-	    for (i = m; i <= n; i += istep) {
-		j =i + mmax;
-		tempr = wr*data[j]   - wi*data[j+1];
-		tempi = wr*data[j+1] + wi*data[j];
-		data[j]   = data[i]   - tempr;
-		data[j+1] = data[i+1] - tempi;
-		data[i] += tempr;
-		data[i+1] += tempi;
-	    }
-	    wr = (wtemp = wr)*wpr - wi*wpi + wr;
-	    wi = wi*wpr + wtemp*wpi + wi;
-	}
-	mmax = istep;
-    }
-}
\ No newline at end of file
@@ -1,9 +1,9 @@
 /* file: memse.c	G. Moody	6 February 1992
-			Last revised:	 13 March 2006
+			Last revised:	18 October 2026
 
 -------------------------------------------------------------------------------
 memse: Estimate power spectrum using maximum entropy (all poles) method
-Copyright (C) 1992-2006 George B. Moody
+Copyright (C) 1992-2026 George B. Moody
 
 This program is free software; you can redistribute it and/or modify it under
 the terms of the GNU General Public License as published by the Free Software
@@ -32,12 +32,19 @@ equal to the variance);  thanks to Joe Mietus.
 The function 'integ' (to compute total power over a band), and the code using
 'integ' to summarize power in several bands of interest for HRV analysis, was
 contributed by Peter P. Domitrovich.
+
+The models are fitted by burg (in spectrum.c), which can also choose the model
+order using one of several criteria (-a).  With -W, a model is fitted to each
+of a series of (possibly overlapping) windows, by memwin (also in spectrum.c),
+which fits the models of several windows at once (-j), and which reuses the
+lagged products of each window in computing those of the next.
 */
 
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include "spectrum.h"
 
 #ifndef BSD
 # include <string.h>
@@ -46,132 +53,43 @@ contributed by Peter P. Domitrovich.
 # define strchr index
 #endif
 
-#define PI	M_PI	/* pi to machine precision, defined in math.h */ 
+#define PI	M_PI	/* pi to machine precision, defined in math.h */
 #define SQR(x) ((x)*(x))
+#define BATCH	64	/* windows per batch for each thread (see -W) */
 
 /* Function prototypes */
-static double (*window)(int j, long n);
-static double win_bartlett(int j, long n);
-static double win_blackman(int j, long n);
-static double win_blackman_harris(int j, long n);
-static double win_hamming(int j, long n);
-static double win_hanning(int j, long n);
-static double win_parzen(int j, long n);
-static double win_square(int j, long n);
-static double win_welch(int j, long n);
 static char *prog_name(char *s);
 static int detrend(double *ordinates, long n_ordinates);
 static void error(char *error_message);
 static void help(void);
-static int memcof(double *data, long n, long m, double *pm, double *cof);
 static double evlmem(double f, double *cof, long m, double pm);
 static long input();
 static double integ(double *cof, long poles, double pm, double lowfreq,
 	     double highfreq, double tolerance);
 static void band_power(double f0, double f1);
+static void memwindows(int nthreads, int pflag);
 
-static double wsum = 0.0;
+static winfn window = NULL;
 static char *pname = NULL;
 static FILE *ifile = NULL;
-static double *data = NULL, *wk1 = NULL, *wk2 = NULL;
+static double *data = NULL;
 static long nmax = 512L;	/* Initial buffer size (must be a power of 2).
 			   Note that input() will increase this value as
 			   necessary by repeated doubling, depending on
 			   the length of the input series. */
 static double pm = 0.0;
 static double *cof = NULL;
-static double *wkm = NULL;
+static int crit = MEM_FIXED;
 static int fflag = 0;
 static long len = 0;
 static long nout = 0;
 static long poles = 0;
+static long step = 0;
+static long wlen = 0;
 static int wflag = 0;
 static int zflag = 0;
 static double freq = 0.0;
 
-/* See Oppenheim & Schafer, Digital Signal Processing, p. 241 (1st ed.) */
-static double win_bartlett(int j, long n)
-{
-    double a = 2.0/(n-1), w = 0.0;
-    if ((w = j*a) > 1.0) w = 2.0 - w;
-    wsum += w;
-    return (w);
-}
-
-/* See Oppenheim & Schafer, Digital Signal Processing, p. 242 (1st ed.) */
-static double win_blackman(int j, long n)
-{
-    double a = 2.0*PI/(n-1), w = 0.0;
-
-    w = 0.42 - 0.5*cos(a*j) + 0.08*cos(2*a*j);
-    wsum += w;
-    return (w);
-}
-
-/* See Harris, F.J., "On the use of windows for harmonic analysis with the
-   discrete Fourier transform", Proc. IEEE, Jan. 1978 */
-static double win_blackman_harris(int j, long n)
-{
-    double a = 2.0*PI/(n-1), w = 0.0;
-
-    w = 0.35875 - 0.48829*cos(a*j) + 0.14128*cos(2*a*j) - 0.01168*cos(3*a*j);
-    wsum += w;
-    return (w);
-}
-
-/* See Oppenheim & Schafer, Digital Signal Processing, p. 242 (1st ed.) */
-static double win_hamming(int j, long n)
-{
-    double a = 2.0*PI/(n-1), w = 0.0;
-
-    w = 0.54 - 0.46*cos(a*j);
-    wsum += w;
-    return (w);
-}
-
-/* See Oppenheim & Schafer, Digital Signal Processing, p. 242 (1st ed.)
-   The second edition of Numerical Recipes calls this the "Hann" window. */
-static double win_hanning(int j, long n)
-{
-    double a = 2.0*PI/(n-1), w = 0.0;
-
-    w = 0.5 - 0.5*cos(a*j);
-    wsum += w;
-    return (w);
-}
-
-/* See Press, Flannery, Teukolsky, & Vetterling, Numerical Recipes in C,
-   p. 442 (1st ed.) */
-static double win_parzen(int j, long n)
-{
-    double a = (n-1)/2.0, w = 0.0;
-
-    if ((w = (j-a)/(a+1)) > 0.0) w = 1 - w;
-    else w = 1 + w;
-    wsum += w;
-    return (w);
-}
-
-/* See any of the above references. */
-static double win_square(int j, long n)
-{
-    if (j < n)		/* to quiet the compiler */
-       wsum += 1.0;
-    return (1.0);
-}
-
-/* See Press, Flannery, Teukolsky, & Vetterling, Numerical Recipes in C,
-   p. 442 (1st ed.) or p. 554 (2nd ed.) */
-static double win_welch(int j, long n)
-{
-    double a = (n-1)/2.0, w = 0.0;
-
-    w = (j-a)/(a+1);
-    w = 1 - w*w;
-    wsum += w;
-    return (w);
-}
-
 /* Calculate and print power in specified frequency band. */
 void band_power(double f0, double f1)
 {
@@ -182,7 +100,7 @@ void band_power(double f0, double f1)
     if (f0 > f1) { double f = f0; f0 = f1; f1 = f; }
     if (f0 == f1) return;
     if (first_band) {
-	printf("\nModel order = %d\n", poles);
+	printf("\nModel order = %ld\n", poles);
 	printf("     Band (Hz)\t\t  Power\n");
 	first_band = 0;
     }
@@ -192,13 +110,29 @@ void band_power(double f0, double f1)
 
 int main(int argc, char *argv[])
 {
-    int i = 0, pflag = 0, sflag = 0, fi, fi0 = -1, fi1 = -1;
-    double df = 0.0;
+    int i = 0, k, nthreads = 1, pflag = 0, sflag = 0, fi, fi0 = -1, fi1 = -1;
+    long n;
+    double *c, df = 0.0, *work;
     double f = 0.0, f0, f1, p = 0.0;
 
     pname = prog_name(argv[0]);
     for (i = 1; i < argc; i++) {
 	if (*argv[i] == '-') switch (*(argv[i]+1)) {
+	  case 'a':	/* choose the model order using the specified criterion */
+	    if (++i >= argc)
+		error("criterion (AIC, FPE, or MDL) must follow -a");
+	    if (strcasecmp(argv[i], "AIC") == 0)
+		crit = MEM_AIC;
+	    else if (strcasecmp(argv[i], "FPE") == 0)
+		crit = MEM_FPE;
+	    else if (strcasecmp(argv[i], "MDL") == 0)
+		crit = MEM_MDL;
+	    else {
+		fprintf(stderr, "%s: unrecognized criterion %s\n",
+			pname, argv[i]);
+		exit(1);
+	    }
+	    break;
 	  case 'b':	/* print power in specified bands */
 	    if (++i > argc-1 || *argv[i] == '-')
 		error("at least two frequencies must follow -b");
@@ -217,6 +151,19 @@ int main(int argc, char *argv[])
 	    help();
 	    exit(0);
 	    break;
+	  case 'i':	/* interval between windows follows */
+	    if (++i >= argc || (step = atol(argv[i])) < 1)
+		error("window interval (> 0) must follow -i");
+	    break;
+	  case 'j':	/* number of threads follows */
+	    if (++i >= argc || (nthreads = atoi(argv[i])) < 1)
+		error("number of threads must follow -j");
+#ifdef NOPTHREADS
+	    nthreads = 1;
+#else
+	    if (nthreads > MAXTHREADS) nthreads = MAXTHREADS;
+#endif
+	    break;
 	  case 'l':	/* handle up to n-point input series (obsolete) */
 	    fprintf(stderr,
 	    "%s: -l option is obsolete (%s can handle inputs of any length)\n",
@@ -242,32 +189,17 @@ int main(int argc, char *argv[])
 	  case 'w':	/* apply windowing function to input */
 	    if (++i >= argc)
                 error("window type must follow -w");
-	    if (strcasecmp(argv[i], "Bartlett") == 0)
-		window = win_bartlett;
-	    else if (strcasecmp(argv[i], "Blackman") == 0)
-		window = win_blackman;
-	    else if (strcasecmp(argv[i], "Blackman-Harris") == 0)
-		window = win_blackman_harris;
-	    else if (strcasecmp(argv[i], "Hamming") == 0)
-		window = win_hamming;
-	    else if (strcasecmp(argv[i], "Hanning") == 0 ||
-		     strcasecmp(argv[i], "Hann") == 0)
-		window = win_hanning;
-	    else if (strcasecmp(argv[i], "Parzen") == 0)
-		window = win_parzen;
-	    else if (strcasecmp(argv[i], "Dirichlet") == 0 ||
-		     strcasecmp(argv[i], "Rectangular") == 0 ||
-		     strcasecmp(argv[i], "Square") == 0)
-		window = win_square;
-	    else if (strcasecmp(argv[i], "Welch") == 0)
-		window = win_welch;
-	    else {
+	    if ((window = win_lookup(argv[i])) == NULL) {
 		fprintf(stderr, "%s: unrecognized window type %s\n",
 			pname, argv[i]);
 		exit(1);
 	    }
 	    wflag = 1;
 	    break;
+	  case 'W':	/* fit a model to each window of n samples */
+	    if (++i >= argc || (wlen = atol(argv[i])) < 1)
+		error("window length (> 0) must follow -W");
+	    break;
 	  case 'z':			/* zero-mean the input */
 	    zflag = 1;
 	    break;
@@ -293,24 +225,38 @@ int main(int argc, char *argv[])
 	help();
 	exit(1);
     }
+    if (wlen && (sflag || fi0 >= 0))
+	error("-b and -s cannot be used with -W");
 
     /* Read the input series. */
     len = input( );
 
+    /* With -W, fit a model to each window, write the results, and exit. */
+    if (wlen) {
+	memwindows(nthreads, pflag);
+	free(data);
+	return 0;
+    }
+
     /* Check the model order. */
-    if (poles > len) poles = len;
+    if (len < 3) error("input series is too short");
+    if (poles > len-2) poles = len-2;
     if ((double)poles*poles > len)
 	fprintf(stderr, "%s: the model order (number of poles) may be too high\n", pname);
 
     /* Set the model order to a reasonable value if it is unspecified. */
     if (poles == 0) {
 	poles = (int)(sqrt((double)len) + 0.5);
-	fprintf(stderr, "%s: using a model order of %ld\n", pname, poles);
+	if (poles > len-2) poles = len-2;
+	if (crit == MEM_FIXED)
+	    fprintf(stderr, "%s: using a model order of %ld\n", pname, poles);
     }
 
-    /* Allocate arrays for coefficients. */
+    /* Allocate arrays for coefficients and lagged products. */
     if (((cof = (double *)malloc((unsigned)poles*sizeof(double))) == NULL) ||
-	((wkm = (double *)malloc((unsigned)poles*sizeof(double))) == NULL)) {
+	((c = (double *)malloc((unsigned)(poles+1)*sizeof(double))) == NULL) ||
+	((work = (double *)malloc((unsigned)3*(poles+3)*sizeof(double)))
+	 == NULL)) {
 	fprintf(stderr, "%s: insufficient memory\n", pname);
 	exit(1);
     }
@@ -331,8 +277,19 @@ int main(int argc, char *argv[])
 	for (i = 0; i < len; i++)
 	    data[i] *= (*window)(i, len);
 
-    /* Calculate coefficients for MEM spectral estimation. */
-    memcof(data, len, poles, &pm, cof);
+    /* Calculate coefficients for MEM spectral estimation, choosing the model
+       order if a criterion was specified. */
+    for (k = 0; k <= poles; k++)
+	for (n = 0, c[k] = 0.0; n < len - k; n++)
+	    c[k] += data[n]*data[n+k];
+    n = burg(c, data, data + len - poles - 2, len, poles, crit, cof, &pm,
+	     work);
+    if (crit != MEM_FIXED)
+	fprintf(stderr, "%s: using a model order of %ld (of %ld)\n",
+		pname, n, poles);
+    poles = n;
+    free(c);
+    free(work);
 
     /* If the number of output points was not specified, choose the largest
       power of 2 less than len, plus 1 (so that the number of output points
@@ -359,9 +316,6 @@ int main(int argc, char *argv[])
     else {
 	free(cof);
 	free(data);
-	free(wk1);
-	free(wk2);
-	free(wkm);
 	error("no output produced");
     }
 
@@ -381,49 +335,56 @@ int main(int argc, char *argv[])
 
     free(cof);
     free(data);
-    free(wk1);
-    free(wk2);
-    free(wkm);
 
     return 0;
 }
 
-/* Calculate coefficients for MEM spectral estimation.  See Numerical Recipes,
-   pp. 447-451. */
-int memcof(double *data, long n, long m, double *pm, double *cof)
+/* Fit a model to each window of wlen samples, beginning every step samples,
+   and print the estimates for each window in three columns (the time of the
+   beginning of the window, the frequency, and the amplitude or power),
+   followed by an empty line.  Times and frequencies are in sample intervals
+   and fractions of the sampling frequency, or in the units of the sampling
+   frequency given with -f. */
+static void memwindows(int nthreads, int pflag)
 {
-    int i = 0, j = 0, k = 0;
-    double denom = 0.0, num = 0.0, p = 0.0;
-
-    for (j = 0; j < n; j++)
-	p += data[j]*data[j];
-    *pm = p/n;
-    wk1[0] = data[0];
-    wk2[n-2] = data[n-1];
-    for (j = 1; j < n-1; j++) {
-	wk1[j] = data[j];
-	wk2[j-1] = data[j];
+    int *order;
+    long j, k, m, nb, nbatch = (long)BATCH*nthreads, nw;
+    double df, p, *pw, tscale = (fflag && freq > 0.0) ? 1.0/freq : 1.0,
+	fscale = (fflag && freq > 0.0) ? freq : 1.0;
+
+    if (step == 0) step = wlen;
+    if (wlen < 3 || len < wlen)
+	error("input series is shorter than one window");
+    nw = (len - wlen)/step + 1;
+    if ((m = poles) == 0)
+	m = (long)(sqrt((double)wlen) + 0.5);
+    if (m > wlen-2) m = wlen-2;
+    if ((double)m*m > wlen)
+	fprintf(stderr, "%s: the model order (number of poles) may be too high\n", pname);
+    if (nout == 0) {
+	for (nout = 1; 2*nout < wlen; nout *= 2)
+	    ;
+	nout++;
     }
-    for (k = 0; k < m; k++) {
-	for (j = 0, num = denom = 0.0; j < n-k-1; j++) {
-	    num += wk1[j]*wk2[j];
-	    denom += wk1[j]*wk1[j] + wk2[j]*wk2[j];
-	}
-	cof[k] = 2.0*num/denom;
-	*pm *= 1.0 - cof[k]*cof[k];
-	if (k)
-	    for (i = 0; i < k; i++)
-		cof[i] = wkm[i] - cof[k]*wkm[k-i-1];
-	if (k != m-1) {
-	    for (i = 0; i <= k; i++)
-		wkm[i] = cof[i];
-	    for (j = 0; j < n-k-2; j++) {
-		wk1[j] -= wkm[k]*wk2[j];
-		wk2[j] = wk2[j+1] - wkm[k]*wk1[j+1];
-	}
+    if (nout < 2) error("no output produced");
+    df = 0.5/(nout-1);
+    if ((pw = (double *)malloc(nbatch*nout * sizeof(double))) == NULL ||
+	(order = (int *)malloc(nbatch * sizeof(int))) == NULL)
+	error("insufficient memory");
+    for (k = 0; k < nw; k += nb) {
+	if ((nb = nw - k) > nbatch) nb = nbatch;
+	if (memwin(data + k*step, wlen, step, nb, m, crit, zflag, window, nout,
+		   pw, order, nthreads) < 0)
+	    error("insufficient memory");
+	for (j = 0; j < nb*nout; j++) {
+	    p = pw[j]/(nout-1);
+	    printf("%g\t%g\t%g\n", (k + j/nout)*step*tscale,
+		   (j%nout)*df*fscale, pflag ? p : sqrt(p));
+	    if (j%nout == nout-1) printf("\n");
 	}
     }
-    return 0;
+    free(pw);
+    free(order);
 }
 
 /* Evaluate power spectral estimate at f (0 <= f < = 0.5, where 1 is the
@@ -501,22 +462,30 @@ static char *help_strings[] = {
 "usage: %s [ OPTIONS ...] INPUT-FILE\n",
 " where INPUT-FILE is the name of a text file containing a time series",
 " (use `-' to read the standard input), and OPTIONS may be any of:",
+" -a CRIT  Choose the model order (up to the order given by -o) that minimizes",
+"          CRIT, which may be `AIC', `FPE', or `MDL'.",
 " -b LF HF Print the power in the frequency band defined by LF and HF.  More",
 "          than one band may be specified following a single -b option.",
 " -f FREQ  Show the center frequency for each bin in the first column.  The",
 "          FREQ argument specifies the input sampling frequency;  the center",
 "          frequencies are given in the same units.",
 " -h       Print on-line help.",
+" -i STEP  Begin windows (see -W) every STEP samples; default: STEP = the window",
+"          length.",
+" -j N     Fit the models of windows (see -W) using N threads.",
 " -n N     Print N equally-spaced output values; default: N = half the number",
-"          of input samples.",
+"          of input samples (per window, with -W).",
 " -o P     Specify the model order (number of poles); default: P = the square",
-"          root of the number of input samples.",
+"          root of the number of input samples (per window, with -W).",
 " -P       Generate a power spectrum (print squared magnitudes).",
 " -s       Print a summary of power in bands of interest for HRV analysis.",
 " -w WINDOW",
 "          Apply the specified WINDOW to the input data.  WINDOW may be one",
 "          of: `Bartlett', `Blackman', `Blackman-Harris', `Hamming',",
 "          `Hanning', `Parzen', `Square', and `Welch'.",
+" -W LEN   Fit a model to each window of LEN samples, and print the start time",
+"          of the window, the frequency, and the estimate in three columns,",
+"          with an empty line after each window.",
 " -z       Zero-mean the input data.",
 " -Z       Detrend and zero-mean the input data.",
 NULL
@@ -541,26 +510,22 @@ static void help(void)
 /* Read input data, allocating and filling data[].  The return value is
    the number of points read.
 
-   This function allows the input buffers to grow as large as necessary, up to
+   This function allows the input buffer to grow as large as necessary, up to
    the available memory (assuming that a long int is large enough to address
    any memory location). */
 long input( )
 {
     long npts = 0L;
 
-    if (((data = (double *)malloc(nmax * sizeof(double))) == NULL) ||
-	((wk1 = (double *)malloc(64 * nmax * sizeof(double))) == NULL) ||
-	((wk2 = (double *)malloc(64 * nmax * sizeof(double))) == NULL)) {
-	if (data) (void)free(data);
-	if (wk1) (void)free(wk1);
+    if ((data = (double *)malloc(nmax * sizeof(double))) == NULL) {
 	fclose(ifile);
         error("insufficient memory");
     }
 
     while (fscanf(ifile, "%lf", &data[npts]) == 1) {
-        if (++npts >= nmax) {	/* double the size of the input buffers */
+        if (++npts >= nmax) {	/* double the size of the input buffer */
 	    long nmaxt = nmax << 1;
-	    double *datat = NULL, *w1t = NULL, *w2t = NULL;
+	    double *datat = NULL;
 
 	    if ((long)(nmaxt * sizeof(double)) < nmax) {
 		fprintf(stderr,
@@ -575,20 +540,6 @@ long input( )
 	        break;
 	    }
 	    data = datat;
-	    if ((w1t = (double *)realloc(wk1,64*nmaxt*sizeof(double)))==NULL) {
-		fprintf(stderr,
-		      "%s: insufficient memory, truncating input at row %ld\n",
-			pname, npts);
-	        break;
-	    }
-	    wk1 = w1t;
-	    if ((w2t = (double *)realloc(wk2,64*nmaxt*sizeof(double)))==NULL) {
-		fprintf(stderr,
-		      "%s: insufficient memory, truncating input at row %ld\n",
-			pname, npts);
-	        break;
-	    }
-	    wk2 = w2t;
 	    nmax = nmaxt;
 	}
     }
@@ -0,0 +1,555 @@
+/* file: spectrogram.c	WFDB contributors	18 October 2026
+
+-------------------------------------------------------------------------------
+spectrogram: Short-time power spectra of signals in a WFDB record
+Copyright (C) 2026 WFDB contributors
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author by e-mail (wfdb@physionet.org) or postal mail
+(MIT Room E25-505A, Cambridge, MA 02139 USA).  For updates to this software,
+please visit PhysioNet (http://www.physionet.org/).
+_______________________________________________________________________________
+
+This program reads one or more signals of a WFDB record directly (without the
+text conversion needed to use fft with rdsamp), and computes the power spectra
+of a series of (possibly overlapping) frames of each signal.  Each frame of n
+samples is multiplied by a window and transformed using segfft (see
+spectrum.c);  the frames begin every hop samples.  The samples are read in a
+buffer that holds one batch of frames, so that records of any length can be
+processed.
+
+The power in each frequency bin is scaled so that the sum of the powers of
+all bins of a frame is approximately the mean square of the samples in the
+frame (in squared physical units).  The powers can be written as text (the
+default), as a matrix of 32-bit floating point numbers, or as band powers in a
+new WFDB record, with one signal for each combination of input signal and
+frequency band.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <wfdb/wfdb.h>
+#include "spectrum.h"
+
+#define BATCH	16	/* frames per batch for each thread */
+#define DBGAIN	100.0	/* adu per dB in output records */
+
+static char *pname;
+static int *sig, nsig;		/* input signals */
+static int nband;		/* number of frequency bands */
+static int *blo, *bhi;		/* bins blo[i] ... bhi[i]-1 are in band i */
+static double *flo, *fhi;	/* band i is flo[i] <= f < fhi[i] Hz */
+static int dflag;		/* if non-zero, text and binary output in dB */
+
+static char *prog_name(char *s);
+static void help(void);
+static void putfloats(double *v, int n, FILE *f);
+static void bandpower(double *pw, int nb, double *bp);
+
+int main(int argc, char *argv[])
+{
+    char *bname = NULL, *orec = NULL, *p, *record = NULL, *tstring = NULL,
+	*wname = "Hanning";
+    double *bp, *buf, freq, *im, *pw, *re, scale, *win, wss, *x;
+    int i, ib = 0, is = 0, j, hop = 0, n = 256, nb, nbatch, nf, nosig,
+	nthreads = 1, nvals, s, vflag = 0, zflag = 0;
+    long avail, cap, f, k, nframes = 0L, skip = 0L;
+    FILE *bfile = NULL;
+    struct fftplan *plan;
+    winfn w;
+    WFDB_Sample *v, *vo = NULL;
+    WFDB_Siginfo *si, *so = NULL;
+    WFDB_Time from = 0L, t, to = 0L;
+
+    pname = prog_name(argv[0]);
+
+    /* Interpret command-line options. */
+    for (i = 1; i < argc; i++) {
+	if (*argv[i] == '-') switch (*(argv[i]+1)) {
+	  case 'b':	/* binary output file name follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: output file name must follow -b\n",
+			      pname);
+		exit(1);
+	    }
+	    bname = argv[i];
+	    break;
+	  case 'B':	/* band limits follow */
+	    ib = i+1;	/* index of first argument containing a band limit */
+	    while (i+1 < argc && *argv[i+1] != '-')
+		i++;
+	    if ((nband = (i + 1 - ib)/2) < 1 || (i + 1 - ib) % 2) {
+		(void)fprintf(stderr,
+			  "%s: pairs of band limits (in Hz) must follow -B\n",
+			      pname);
+		exit(1);
+	    }
+	    break;
+	  case 'd':	/* express powers in dB */
+	    dflag = 1;
+	    break;
+	  case 'f':	/* starting time follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: starting time must follow -f\n",
+			      pname);
+		exit(1);
+	    }
+	    from = i;
+	    break;
+	  case 'h':	/* print usage summary and quit */
+	    help();
+	    exit(0);
+	    break;
+	  case 'i':	/* hop size follows */
+	    if (++i >= argc || (hop = atoi(argv[i])) < 1) {
+		(void)fprintf(stderr,
+		     "%s: interval between frames (> 0) must follow -i\n",
+			      pname);
+		exit(1);
+	    }
+	    break;
+	  case 'j':	/* number of threads follows */
+	    if (++i >= argc || (nthreads = atoi(argv[i])) < 1) {
+		(void)fprintf(stderr, "%s: number of threads must follow -j\n",
+			      pname);
+		exit(1);
+	    }
+#ifdef NOPTHREADS
+	    nthreads = 1;
+#else
+	    if (nthreads > MAXTHREADS) nthreads = MAXTHREADS;
+#endif
+	    break;
+	  case 'n':	/* frame length follows */
+	    if (++i >= argc || (n = atoi(argv[i])) < 2) {
+		(void)fprintf(stderr, "%s: frame length (> 1) must follow -n\n",
+			      pname);
+		exit(1);
+	    }
+	    break;
+	  case 'o':	/* output record name follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: output record name must follow -o\n",
+			      pname);
+		exit(1);
+	    }
+	    orec = argv[i];
+	    break;
+	  case 'r':	/* input record name follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: input record name must follow -r\n",
+			      pname);
+		exit(1);
+	    }
+	    record = argv[i];
+	    break;
+	  case 's':	/* signal list follows */
+	    is = i+1;	/* index of first argument containing a signal */
+	    while (i+1 < argc && *argv[i+1] != '-')
+		i++;
+	    if ((nsig = i + 1 - is) == 0) {
+		(void)fprintf(stderr, "%s: signal list must follow -s\n",
+			      pname);
+		exit(1);
+	    }
+	    break;
+	  case 't':	/* ending time follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: end time must follow -t\n", pname);
+		exit(1);
+	    }
+	    to = i;
+	    break;
+	  case 'v':	/* print a summary of the output on stderr */
+	    vflag = 1;
+	    break;
+	  case 'w':	/* window name follows */
+	    if (++i >= argc) {
+		(void)fprintf(stderr, "%s: window name must follow -w\n",
+			      pname);
+		exit(1);
+	    }
+	    wname = argv[i];
+	    break;
+	  case 'z':	/* subtract the mean of each frame */
+	    zflag = 1;
+	    break;
+	  default:
+	    (void)fprintf(stderr, "%s: unrecognized option %s\n",
+			  pname, argv[i]);
+	    exit(1);
+	}
+	else {
+	    (void)fprintf(stderr, "%s: unrecognized argument %s\n",
+			  pname, argv[i]);
+	    exit(1);
+	}
+    }
+    if (record == NULL) {
+	help();
+	exit(1);
+    }
+    if ((w = win_lookup(wname)) == NULL) {
+	(void)fprintf(stderr, "%s: unrecognized window %s\n", pname, wname);
+	exit(1);
+    }
+    if (hop == 0) hop = (n > 2) ? n/2 : 1;
+
+    /* Open the input signals.  Invalid samples are replaced by the previous
+       valid samples. */
+    setgvmode(WFDB_GVPAD);
+    if ((s = isigopen(record, NULL, 0)) <= 0) exit(2);
+    SUALLOC(v, s, sizeof(WFDB_Sample));
+    SUALLOC(si, s, sizeof(WFDB_Siginfo));
+    if ((s = isigopen(record, si, s)) <= 0)
+	exit(2);
+    for (i = 0; i < s; i++)
+	if (si[i].gain == 0.0) si[i].gain = WFDB_DEFGAIN;
+    if (nsig) {
+	SUALLOC(sig, nsig, sizeof(int));
+	for (i = 0; i < nsig; i++)
+	    if ((sig[i] = findsig(argv[is+i])) < 0) {
+		(void)fprintf(stderr, "%s: can't read signal '%s'\n", pname,
+			      argv[is+i]);
+		exit(2);
+	    }
+    }
+    else {
+	SUALLOC(sig, nsig = s, sizeof(int));
+	for (i = 0; i < nsig; i++)
+	    sig[i] = i;
+    }
+    freq = sampfreq(NULL);
+    if (from > 0L && (from = strtim(argv[from])) < 0L)
+	from = -from;
+    if (isigsettime(from) < 0)
+	exit(2);
+    if (to > 0L && (to = strtim(argv[to])) < 0L)
+	to = -to;
+    if (to > 0L && to < from + n) {
+	(void)fprintf(stderr, "%s: the interval is shorter than one frame\n",
+		      pname);
+	exit(1);
+    }
+
+    /* Find the frequency bins in each band.  If no bands were specified,
+       there is one band containing all of the bins. */
+    nb = n/2 + 1;
+    if (nband == 0) nband = 1;
+    SUALLOC(flo, nband, sizeof(double));
+    SUALLOC(fhi, nband, sizeof(double));
+    SUALLOC(blo, nband, sizeof(int));
+    SUALLOC(bhi, nband, sizeof(int));
+    for (i = 0; i < nband; i++) {
+	if (ib) {
+	    flo[i] = atof(argv[ib + 2*i]);
+	    fhi[i] = atof(argv[ib + 2*i + 1]);
+	}
+	else {
+	    flo[i] = 0.0;
+	    fhi[i] = freq;
+	}
+	for (blo[i] = 0; blo[i] < nb && blo[i]*freq/n < flo[i]; blo[i]++)
+	    ;
+	for (bhi[i] = blo[i]; bhi[i] < nb && bhi[i]*freq/n < fhi[i]; bhi[i]++)
+	    ;
+	if (bhi[i] <= blo[i]) {
+	    (void)fprintf(stderr,
+	       "%s: band %g-%g Hz contains no frequency bins (%g Hz apart)\n",
+			  pname, flo[i], fhi[i], freq/n);
+	    exit(1);
+	}
+    }
+
+    /* Prepare the outputs. */
+    if (bname) {
+	if (strcmp(bname, "-") == 0)
+	    bfile = stdout;
+	else if ((bfile = fopen(bname, "wb")) == NULL) {
+	    (void)fprintf(stderr, "%s: can't write %s\n", pname, bname);
+	    exit(3);
+	}
+    }
+    if (orec) {
+	nosig = nsig * nband;
+	SUALLOC(so, nosig, sizeof(WFDB_Siginfo));
+	SUALLOC(vo, nosig, sizeof(WFDB_Sample));
+	SUALLOC(p, strlen(orec) + 5, 1);
+	(void)sprintf(p, "%s.dat", orec);
+	for (s = 0; s < nsig; s++)
+	    for (i = 0; i < nband; i++) {
+		WFDB_Siginfo *o = &so[s*nband + i];
+		char *d = si[sig[s]].desc, tdesc[16];
+
+		if (d == NULL || *d == '\0') {
+		    (void)sprintf(tdesc, "sig %d", sig[s]);
+		    d = tdesc;
+		}
+		o->fname = p;
+		SUALLOC(o->desc, strlen(d) + 48, 1);
+		if (ib)
+		    (void)sprintf(o->desc, "%s power %g-%g Hz", d, flo[i],
+				  fhi[i]);
+		else
+		    (void)sprintf(o->desc, "%s power", d);
+		o->units = "dB";
+		o->gain = DBGAIN;
+		o->group = 0;
+		o->fmt = 16;
+		o->spf = 1;
+		o->bsize = 0;
+		o->adcres = 16;
+		o->adczero = 0;
+		o->baseline = 0;
+	    }
+
+	/* Find the base time of the output record before changing the
+	   sampling frequency. */
+	p = mstimstr(-from);
+	if (*p == '[') {
+	    SSTRCPY(tstring, p + 1);
+	    if ((p = strchr(tstring, ']')) != NULL)
+		*p = 0;
+	}
+	if (osigfopen(so, nosig) < nosig)
+	    exit(2);
+	if (setsampfreq(freq/hop) < 0)
+	    exit(2);
+	if (tstring) setbasetime(tstring);
+    }
+
+    /* Allocate the buffers.  The sample buffer holds the samples (in
+       physical units, with the samples of each frame interleaved) needed for
+       one batch of frames. */
+    nbatch = BATCH * nthreads;
+    cap = (nbatch-1)*(long)hop + n;
+    nvals = nsig * (ib ? nband : nb);
+    SUALLOC(buf, cap * nsig, sizeof(double));
+    SUALLOC(x, (size_t)nbatch * nsig * n, sizeof(double));
+    SUALLOC(re, (size_t)nbatch * nsig * nb, sizeof(double));
+    SUALLOC(im, (size_t)nbatch * nsig * nb, sizeof(double));
+    SUALLOC(pw, (size_t)nbatch * nsig * nb, sizeof(double));
+    SUALLOC(bp, nsig * nband, sizeof(double));
+    if ((plan = fftplan(n)) == NULL || (win = win_table(w, n, NULL)) == NULL) {
+	(void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	exit(2);
+    }
+    for (i = 0, wss = 0.0; i < n; i++)
+	wss += win[i]*win[i];
+    scale = 1.0/(n*wss);
+
+    for (avail = 0L, t = from; ; ) {
+	/* Fill the buffer, skipping any samples between frames. */
+	while (avail < cap && (to == 0L || t < to) && getvec(v) >= 0) {
+	    t++;
+	    if (skip > 0L) {
+		skip--;
+		continue;
+	    }
+	    for (s = 0; s < nsig; s++)
+		buf[avail*nsig + s] = (v[sig[s]] - si[sig[s]].baseline) /
+		    si[sig[s]].gain;
+	    avail++;
+	}
+	if (avail < n) break;
+	if ((nf = (avail - n)/hop + 1) > nbatch) nf = nbatch;
+
+	/* Transform the frames of this batch. */
+	for (f = 0; f < nf; f++)
+	    for (s = 0; s < nsig; s++) {
+		double *xs = x + (f*nsig + s)*n, *bs = buf + f*hop*nsig + s,
+		    mean = 0.0;
+
+		for (j = 0; j < n; j++)
+		    mean += xs[j] = bs[j*nsig];
+		if (zflag)
+		    for (j = 0, mean /= n; j < n; j++)
+			xs[j] -= mean;
+	    }
+	if (segfft(plan, x, nf*nsig, win, re, im, nthreads) < 0) {
+	    (void)fprintf(stderr, "%s: insufficient memory\n", pname);
+	    exit(2);
+	}
+
+	/* Compute and write the one-sided power spectra. */
+	for (k = 0; k < nf*nsig*nb; k++) {
+	    j = k % nb;
+	    pw[k] = (re[k]*re[k] + im[k]*im[k]) * scale;
+	    if (j > 0 && 2*j < n) pw[k] *= 2.0;
+	}
+	for (f = 0; f < nf; f++, nframes++) {
+	    double *pf = pw + f*nsig*nb;
+
+	    bandpower(pf, nb, bp);
+	    if (bfile)
+		putfloats(ib ? bp : pf, nvals, bfile);
+	    if (orec) {
+		for (i = 0; i < nsig*nband; i++) {
+		    double y = (bp[i] > 0.0) ? 10.0*log10(bp[i])*DBGAIN :
+			-32767.0;
+
+		    if (y > 32767.0) y = 32767.0;
+		    else if (y < -32767.0) y = -32767.0;
+		    vo[i] = (WFDB_Sample)floor(y + 0.5);
+		}
+		if (putvec(vo) < 0) exit(2);
+	    }
+	    if (bfile == NULL && orec == NULL) {
+		double tf = (from + nframes*hop)/freq;
+
+		if (ib) {	/* one line per frame */
+		    (void)printf("%g", tf);
+		    for (i = 0; i < nsig*nband; i++)
+			(void)printf("\t%g", dflag ? 10.0*log10(bp[i]) : bp[i]);
+		    (void)printf("\n");
+		}
+		else {		/* one line per frequency, as lomb -w */
+		    for (j = 0; j < nb; j++) {
+			(void)printf("%g\t%g", tf, j*freq/n);
+			for (s = 0; s < nsig; s++) {
+			    double y = pf[s*nb + j];
+
+			    (void)printf("\t%g", dflag ? 10.0*log10(y) : y);
+			}
+			(void)printf("\n");
+		    }
+		    (void)printf("\n");
+		}
+	    }
+	}
+
+	/* Discard the samples that are not needed for the next batch. */
+	if ((k = (long)nf*hop) < avail) {
+	    memmove(buf, buf + k*nsig, (avail - k)*nsig*sizeof(double));
+	    avail -= k;
+	}
+	else {
+	    skip = k - avail;
+	    avail = 0L;
+	}
+    }
+
+    if (bfile && bfile != stdout)
+	(void)fclose(bfile);
+    if (vflag)
+	(void)fprintf(stderr,
+	    "%s: %ld frames of %d samples at intervals of %d samples (%g s);"
+	    " %d bins at intervals of %g Hz\n", pname, nframes, n, hop,
+		      hop/freq, nb, freq/n);
+    if (nframes == 0L)
+	(void)fprintf(stderr, "%s: the input is shorter than one frame\n",
+		      pname);
+    if (orec) (void)newheader(orec);
+    wfdbquit();
+    exit(nframes > 0L ? 0 : 2);
+}
+
+/* bandpower sums the powers of the nb bins of each signal (of the spectra
+   in pw) in each band, and stores the sums in bp (nband values per
+   signal). */
+static void bandpower(double *pw, int nb, double *bp)
+{
+    int i, j, s;
+
+    for (s = 0; s < nsig; s++, pw += nb)
+	for (i = 0; i < nband; i++) {
+	    double sum = 0.0;
+
+	    for (j = blo[i]; j < bhi[i]; j++)
+		sum += pw[j];
+	    *bp++ = sum;
+	}
+}
+
+/* putfloats writes n values as 32-bit IEEE 754 numbers, least significant
+   byte first (regardless of the byte order of the host), so that the output
+   can be read on any machine. */
+static void putfloats(double *v, int n, FILE *f)
+{
+    static int swap = -1;
+    unsigned char b[4], c;
+    float y;
+    int i;
+
+    if (swap < 0) {	/* swap bytes if the host is big-endian */
+	unsigned int one = 1;
+
+	swap = (*(unsigned char *)&one == 0);
+    }
+    for (i = 0; i < n; i++) {
+	y = (float)(dflag ? 10.0*log10(v[i]) : v[i]);
+	memcpy(b, &y, 4);
+	if (swap) {
+	    c = b[0]; b[0] = b[3]; b[3] = c;
+	    c = b[1]; b[1] = b[2]; b[2] = c;
+	}
+	(void)fwrite(b, 1, 4, f);
+    }
+}
+
+static char *prog_name(char *s)
+{
+    char *p = s + strlen(s);
+
+#ifdef MSDOS
+    while (p >= s && *p != '\\' && *p != ':') {
+	if (*p == '.')
+	    *p = '\0';		/* strip off extension */
+	if ('A' <= *p && *p <= 'Z')
+	    *p += 'a' - 'A';	/* convert to lower case */
+	p--;
+    }
+#else
+    while (p >= s && *p != '/')
+	p--;
+#endif
+    return (p+1);
+}
+
+static char *help_strings[] = {
+ "usage: %s -r RECORD [OPTIONS ...]\n",
+ "where RECORD specifies the input, and OPTIONS may include any of:",
+" -b FILE       write the spectra (or band powers) to FILE as 32-bit",
+"                little-endian floats, one frame per row ('-': stdout)",
+" -B LO HI ...  compute the power in each band from LO to HI Hz",
+" -d            express powers in dB (text and binary output)",
+" -f TIME       begin at specified time",
+" -h            print this usage summary",
+" -i HOP        begin frames every HOP samples (default: half of LEN)",
+" -j N          use up to N threads",
+" -n LEN        use frames of LEN samples (default: 256)",
+" -o RECORD     write the band powers (in dB) as signals of a new RECORD",
+" -r RECORD     read signals from RECORD",
+" -s SIGNAL ... analyze only the specified signals (default: all)",
+" -t TIME       stop at specified time (default: end of record)",
+" -v            print the number and size of the frames on stderr",
+" -w WINDOW     apply the named window to each frame (default: Hanning)",
+"                WINDOW may be Bartlett, Blackman, Blackman-Harris, Hamming,",
+"                Hanning, Parzen, Square, or Welch",
+" -z            subtract the mean of each frame before transforming it",
+"Unless -b or -o is used, the spectra are written to the standard output as",
+"text.",
+NULL
+};
+
+static void help(void)
+{
+    int i;
+
+    (void)fprintf(stderr, help_strings[0], pname);
+    for (i = 1; help_strings[i] != NULL; i++)
+	(void)fprintf(stderr, "%s\n", help_strings[i]);
+}
@@ -0,0 +1,1207 @@
+/* file: spectrum.c	WFDB contributors	18 October 2026
+
+-------------------------------------------------------------------------------
+spectrum: Spectral analysis functions shared by the PSD applications
+Copyright (C) 2026 WFDB contributors
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author by e-mail (wfdb@physionet.org) or postal mail
+(MIT Room E25-505A, Cambridge, MA 02139 USA).  For updates to this software,
+please visit PhysioNet (http://www.physionet.org/).
+_______________________________________________________________________________
+
+This file contains the FFT, cross-spectral, window, periodogram, and maximum
+entropy functions used by fft and the other PSD applications;  see spectrum.h for a summary.
+
+The complex transform is a Stockham (self-sorting) mixed-radix FFT.  If n is
+factored as f[0] f[1] ... , pass q combines l = f[0] ... f[q-1] point
+transforms of each of the n/l interleaved subsequences of the input into
+l*f[q] point transforms, alternating between the caller's arrays and the
+workspace.  Real transforms of even length are computed as complex transforms
+of half the length.  Bluestein's algorithm rewrites a transform of length n as
+a circular convolution of length m (a power of two no smaller than 2n-1) with
+a "chirp";  the transform of the chirp is computed when the plan is made.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifndef NOPTHREADS
+#include <pthread.h>
+#endif
+#include "spectrum.h"
+
+#ifdef i386
+#define strcasecmp strcmp
+#endif
+#define PI	M_PI	/* pi to machine precision, defined in math.h */
+#define TWOPI	(2.0*PI)
+
+struct fftplan {
+    int n;			/* transform length */
+    int nf;			/* number of factors of n */
+    int f[32];			/* factors of n (unused if bp != NULL) */
+    double *wr, *wi;		/* twiddle factors, exp(-2 pi i k/n) */
+    struct fftplan *half;	/* plan for n/2-point transforms, if n is even
+				   and the plan was made by fftplan */
+    struct fftplan *bp;		/* plan for Bluestein convolutions, or NULL */
+    double *cr, *ci;		/* Bluestein chirp, exp(-pi i k^2/n) */
+    double *br, *bi;		/* transform of the chirp filter, divided by
+				   bp->n */
+    long ncwork;		/* workspace length needed by cfft */
+    long nwork;			/* workspace length needed by any transform */
+    struct fftplan *next;	/* next plan in the cache */
+};
+
+struct wintab {
+    winfn w;			/* window function */
+    int n;			/* window length */
+    double *c;			/* coefficients */
+    double sum;			/* sum of coefficients */
+    struct wintab *next;	/* next window in the cache */
+};
+
+static struct fftplan *plans;	/* plans made so far */
+static struct wintab *windows;	/* window tables made so far */
+#ifndef NOPTHREADS
+static pthread_mutex_t cachelock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK()		pthread_mutex_lock(&cachelock)
+#define UNLOCK()	pthread_mutex_unlock(&cachelock)
+#else
+#define LOCK()
+#define UNLOCK()
+#endif
+
+static struct fftplan *cplan(int n);
+static void stockham(struct fftplan *p, double *re, double *im, double *work);
+static void bluestein(struct fftplan *p, double *re, double *im, double *work);
+
+/* fftplan returns a plan for n-point transforms, or NULL if n < 1 or if
+   there is not enough memory. */
+struct fftplan *fftplan(int n)
+{
+    struct fftplan *p;
+
+    if (n < 1) return (NULL);
+    LOCK();
+    if ((p = cplan(n)) && n % 2 == 0 && p->half == NULL &&
+	(p->half = cplan(n/2)) == NULL)
+	p = NULL;
+    if (p) {
+	p->nwork = (n % 2 == 0) ? n + p->half->ncwork : 2L*n + p->ncwork;
+	if (p->nwork < p->ncwork) p->nwork = p->ncwork;
+    }
+    UNLOCK();
+    return (p);
+}
+
+/* fftwork allocates a workspace for transforms using plan p;  the caller
+   should free it when it is no longer needed. */
+double *fftwork(struct fftplan *p)
+{
+    return ((double *)malloc(p->nwork * sizeof(double)));
+}
+
+int fftlen(struct fftplan *p)
+{
+    return (p->n);
+}
+
+/* cplan finds or makes a plan for complex n-point transforms.  The caller
+   must hold the cache lock. */
+static struct fftplan *cplan(int n)
+{
+    double *work;
+    int i, m;
+    struct fftplan *p;
+
+    for (p = plans; p; p = p->next)
+	if (p->n == n) return (p);
+    if ((p = (struct fftplan *)calloc(1, sizeof(struct fftplan))) == NULL)
+	return (NULL);
+    p->n = n;
+    if ((p->wr = (double *)malloc(n * sizeof(double))) == NULL ||
+	(p->wi = (double *)malloc(n * sizeof(double))) == NULL)
+	goto nomem;
+    for (i = 0; i < n; i++) {
+	p->wr[i] = cos(TWOPI*i/n);
+	p->wi[i] = -sin(TWOPI*i/n);
+    }
+
+    /* Factor n, using radix 4 where possible. */
+    for (m = n; m % 4 == 0; m /= 4)
+	p->f[p->nf++] = 4;
+    if (m % 2 == 0) {
+	p->f[p->nf++] = 2;
+	m /= 2;
+    }
+    for (i = 3; i <= MAXRADIX && m > 1; i += 2)
+	while (m % i == 0) {
+	    p->f[p->nf++] = i;
+	    m /= i;
+	}
+    p->ncwork = 2L*n;
+
+    if (m > 1) {	/* n has a large prime factor -- use Bluestein */
+	for (m = 1; m < 2*n - 1; m <<= 1)
+	    ;
+	if ((p->bp = cplan(m)) == NULL ||
+	    (p->cr = (double *)malloc(n * sizeof(double))) == NULL ||
+	    (p->ci = (double *)malloc(n * sizeof(double))) == NULL ||
+	    (p->br = (double *)calloc(m, sizeof(double))) == NULL ||
+	    (p->bi = (double *)calloc(m, sizeof(double))) == NULL ||
+	    (work = (double *)malloc(2L * m * sizeof(double))) == NULL)
+	    goto nomem;
+	for (i = 0; i < n; i++) {
+	    /* Reduce k^2 modulo 2n to keep the angle small. */
+	    double a = PI * (double)(((long long)i*i) % (2LL*n)) / n;
+
+	    p->cr[i] = cos(a);
+	    p->ci[i] = -sin(a);
+	}
+	p->br[0] = p->cr[0]/m;
+	p->bi[0] = -p->ci[0]/m;
+	for (i = 1; i < n; i++) {
+	    p->br[i] = p->br[m-i] = p->cr[i]/m;
+	    p->bi[i] = p->bi[m-i] = -p->ci[i]/m;
+	}
+	stockham(p->bp, p->br, p->bi, work);
+	free(work);
+	p->ncwork = 4L*m;
+    }
+    p->nwork = p->ncwork;
+    p->next = plans;
+    plans = p;
+    return (p);
+
+ nomem:
+    free(p->wr); free(p->wi);
+    free(p->cr); free(p->ci);
+    free(p->br); free(p->bi);
+    free(p);
+    return (NULL);
+}
+
+/* cfft replaces re and im with their forward (or, if inverse is non-zero,
+   inverse) transform. */
+void cfft(struct fftplan *p, double *re, double *im, int inverse, double *work)
+{
+    if (inverse) {	/* swapping real and imaginary parts of the input and
+			   output turns a forward transform into an inverse */
+	double *t = re;
+
+	re = im;
+	im = t;
+    }
+    if (p->bp) bluestein(p, re, im, work);
+    else stockham(p, re, im, work);
+}
+
+/* The pass functions perform one pass of the Stockham FFT, from (ar, ai) to
+   (br, bi), combining the l-point transforms of the subsequences into
+   l*f-point transforms;  m is n/(l*f).  Element k of the j'th component of
+   the r'th subsequence is ar[j*m*f + r*m + k], and the results for component
+   j + l*s go to br[(j + l*s)*m + k].  The twiddle factor for subsequence r
+   of component j is exp(-2 pi i j r/(l*f)), or w[j*r*m]. */
+
+static void pass2(int l, int m, double *ar, double *ai, double *br, double *bi,
+		  double *wr, double *wi)
+{
+    double tr, ti, w1r, w1i, *x0r, *x0i, *x1r, *x1i, *y0r, *y0i, *y1r, *y1i;
+    int j, k;
+
+    for (j = 0; j < l; j++) {
+	w1r = wr[j*m]; w1i = wi[j*m];
+	x0r = ar + 2*j*m; x0i = ai + 2*j*m; x1r = x0r + m; x1i = x0i + m;
+	y0r = br + j*m; y0i = bi + j*m; y1r = y0r + l*m; y1i = y0i + l*m;
+	for (k = 0; k < m; k++) {
+	    tr = x1r[k]*w1r - x1i[k]*w1i;
+	    ti = x1r[k]*w1i + x1i[k]*w1r;
+	    y0r[k] = x0r[k] + tr; y0i[k] = x0i[k] + ti;
+	    y1r[k] = x0r[k] - tr; y1i[k] = x0i[k] - ti;
+	}
+    }
+}
+
+static void pass3(int l, int m, double *ar, double *ai, double *br, double *bi,
+		  double *wr, double *wi)
+{
+    static const double s = 0.86602540378443864676;	/* sin(2 pi/3) */
+    double dr, di, hr, hi, tr, ti, u1r, u1i, u2r, u2i, w1r, w1i, w2r, w2i;
+    double *xr, *xi, *yr, *yi;
+    int j, k;
+
+    for (j = 0; j < l; j++) {
+	w1r = wr[j*m]; w1i = wi[j*m];
+	w2r = wr[2*j*m]; w2i = wi[2*j*m];
+	xr = ar + 3*j*m; xi = ai + 3*j*m;
+	yr = br + j*m; yi = bi + j*m;
+	for (k = 0; k < m; k++) {
+	    u1r = xr[k+m]*w1r - xi[k+m]*w1i;
+	    u1i = xr[k+m]*w1i + xi[k+m]*w1r;
+	    u2r = xr[k+2*m]*w2r - xi[k+2*m]*w2i;
+	    u2i = xr[k+2*m]*w2i + xi[k+2*m]*w2r;
+	    tr = u1r + u2r; ti = u1i + u2i;
+	    dr = s*(u1r - u2r); di = s*(u1i - u2i);
+	    hr = xr[k] - 0.5*tr; hi = xi[k] - 0.5*ti;
+	    yr[k] = xr[k] + tr; yi[k] = xi[k] + ti;
+	    yr[k+l*m] = hr + di; yi[k+l*m] = hi - dr;
+	    yr[k+2*l*m] = hr - di; yi[k+2*l*m] = hi + dr;
+	}
+    }
+}
+
+static void pass4(int l, int m, double *ar, double *ai, double *br, double *bi,
+		  double *wr, double *wi)
+{
+    double w1r, w1i, w2r, w2i, w3r, w3i, u1r, u1i, u2r, u2i, u3r, u3i;
+    double ar0, ai0, br0, bi0, cr0, ci0, dr0, di0, *xr, *xi, *yr, *yi;
+    int j, k, lm = l*m;
+
+    for (j = 0; j < l; j++) {
+	w1r = wr[j*m]; w1i = wi[j*m];
+	w2r = wr[2*j*m]; w2i = wi[2*j*m];
+	w3r = wr[3*j*m]; w3i = wi[3*j*m];
+	xr = ar + 4*j*m; xi = ai + 4*j*m;
+	yr = br + j*m; yi = bi + j*m;
+	for (k = 0; k < m; k++) {
+	    u1r = xr[k+m]*w1r - xi[k+m]*w1i;
+	    u1i = xr[k+m]*w1i + xi[k+m]*w1r;
+	    u2r = xr[k+2*m]*w2r - xi[k+2*m]*w2i;
+	    u2i = xr[k+2*m]*w2i + xi[k+2*m]*w2r;
+	    u3r = xr[k+3*m]*w3r - xi[k+3*m]*w3i;
+	    u3i = xr[k+3*m]*w3i + xi[k+3*m]*w3r;
+	    ar0 = xr[k] + u2r; ai0 = xi[k] + u2i;
+	    br0 = xr[k] - u2r; bi0 = xi[k] - u2i;
+	    cr0 = u1r + u3r; ci0 = u1i + u3i;
+	    dr0 = u1r - u3r; di0 = u1i - u3i;
+	    yr[k] = ar0 + cr0; yi[k] = ai0 + ci0;
+	    yr[k+lm] = br0 + di0; yi[k+lm] = bi0 - dr0;
+	    yr[k+2*lm] = ar0 - cr0; yi[k+2*lm] = ai0 - ci0;
+	    yr[k+3*lm] = br0 - di0; yi[k+3*lm] = bi0 + dr0;
+	}
+    }
+}
+
+/* passg handles any odd radix f (up to MAXRADIX) by direct summation. */
+static void passg(int f, int l, int m, double *ar, double *ai, double *br,
+		  double *bi, double *wr, double *wi)
+{
+    double ur[MAXRADIX], ui[MAXRADIX], sr, si, *xr, *xi;
+    int j, k, lm = l*m, q, r, s;
+
+    for (j = 0; j < l; j++) {
+	xr = ar + f*j*m; xi = ai + f*j*m;
+	for (k = 0; k < m; k++) {
+	    ur[0] = xr[k]; ui[0] = xi[k];
+	    for (r = 1; r < f; r++) {
+		double vr = xr[k+r*m], vi = xi[k+r*m];
+		double tr = wr[j*r*m], ti = wi[j*r*m];
+
+		ur[r] = vr*tr - vi*ti;
+		ui[r] = vr*ti + vi*tr;
+	    }
+	    for (s = 0; s < f; s++) {
+		sr = ur[0]; si = ui[0];
+		for (r = 1, q = s; r < f; r++) {
+		    /* exp(-2 pi i s r/f) is w[((s*r) % f) * l*m] */
+		    sr += ur[r]*wr[q*lm] - ui[r]*wi[q*lm];
+		    si += ur[r]*wi[q*lm] + ui[r]*wr[q*lm];
+		    if ((q += s) >= f) q -= f;
+		}
+		br[(j + l*s)*m + k] = sr;
+		bi[(j + l*s)*m + k] = si;
+	    }
+	}
+    }
+}
+
+static void stockham(struct fftplan *p, double *re, double *im, double *work)
+{
+    double *ar = re, *ai = im, *br = work, *bi = work + p->n, *t;
+    int f, l, m, q;
+
+    for (l = 1, m = p->n, q = 0; q < p->nf; q++, l *= f) {
+	f = p->f[q];
+	m /= f;
+	switch (f) {
+	  case 2: pass2(l, m, ar, ai, br, bi, p->wr, p->wi); break;
+	  case 3: pass3(l, m, ar, ai, br, bi, p->wr, p->wi); break;
+	  case 4: pass4(l, m, ar, ai, br, bi, p->wr, p->wi); break;
+	  default: passg(f, l, m, ar, ai, br, bi, p->wr, p->wi); break;
+	}
+	t = ar; ar = br; br = t;
+	t = ai; ai = bi; bi = t;
+    }
+    if (ar != re) {
+	memcpy(re, ar, p->n * sizeof(double));
+	memcpy(im, ai, p->n * sizeof(double));
+    }
+}
+
+static void bluestein(struct fftplan *p, double *re, double *im, double *work)
+{
+    double t, *ar = work, *ai, *w;
+    int i, m = p->bp->n, n = p->n;
+
+    ai = ar + m;
+    w = ai + m;
+    for (i = 0; i < n; i++) {
+	ar[i] = re[i]*p->cr[i] - im[i]*p->ci[i];
+	ai[i] = re[i]*p->ci[i] + im[i]*p->cr[i];
+    }
+    for ( ; i < m; i++)
+	ar[i] = ai[i] = 0.0;
+    stockham(p->bp, ar, ai, w);
+    for (i = 0; i < m; i++) {
+	t = ar[i]*p->br[i] - ai[i]*p->bi[i];
+	ai[i] = ar[i]*p->bi[i] + ai[i]*p->br[i];
+	ar[i] = t;
+    }
+    stockham(p->bp, ai, ar, w);		/* inverse transform */
+    for (i = 0; i < n; i++) {
+	re[i] = ar[i]*p->cr[i] - ai[i]*p->ci[i];
+	im[i] = ar[i]*p->ci[i] + ai[i]*p->cr[i];
+    }
+}
+
+/* rfft stores the n/2 + 1 non-negative frequency components of the forward
+   transform of the real series x in re and im. */
+void rfft(struct fftplan *p, double *x, double *re, double *im, double *work)
+{
+    double dr, di, er, ei, qr, qi, *zr, *zi;
+    int k, n = p->n, h = n/2;
+
+    if (n % 2 == 0) {	/* transform x[2t] + i x[2t+1], then separate */
+	zr = work;
+	zi = work + h;
+	for (k = 0; k < h; k++) {
+	    zr[k] = x[2*k];
+	    zi[k] = x[2*k+1];
+	}
+	cfft(p->half, zr, zi, 0, work + n);
+	re[0] = zr[0] + zi[0];
+	re[h] = zr[0] - zi[0];
+	im[0] = im[h] = 0.0;
+	for (k = 1; k < h; k++) {
+	    er = 0.5*(zr[k] + zr[h-k]); ei = 0.5*(zi[k] - zi[h-k]);
+	    qr = 0.5*(zi[k] + zi[h-k]); qi = -0.5*(zr[k] - zr[h-k]);
+	    dr = p->wr[k]*qr - p->wi[k]*qi;
+	    di = p->wr[k]*qi + p->wi[k]*qr;
+	    re[k] = er + dr;
+	    im[k] = ei + di;
+	}
+    }
+    else {
+	zr = work;
+	zi = work + n;
+	for (k = 0; k < n; k++) {
+	    zr[k] = x[k];
+	    zi[k] = 0.0;
+	}
+	cfft(p, zr, zi, 0, work + 2*n);
+	for (k = 0; k <= h; k++) {
+	    re[k] = zr[k];
+	    im[k] = zi[k];
+	}
+    }
+}
+
+/* rifft stores the inverse transform of the n/2 + 1 non-negative frequency
+   components in re and im (the others being their complex conjugates) in x. */
+void rifft(struct fftplan *p, double *re, double *im, double *x, double *work)
+{
+    double dr, di, er, ei, qr, qi, *zr, *zi;
+    int k, n = p->n, h = n/2;
+
+    if (n % 2 == 0) {
+	zr = work;
+	zi = work + h;
+	for (k = 0; k < h; k++) {
+	    er = 0.5*(re[k] + re[h-k]); ei = 0.5*(im[k] - im[h-k]);
+	    dr = 0.5*(re[k] - re[h-k]); di = 0.5*(im[k] + im[h-k]);
+	    qr = dr*p->wr[k] + di*p->wi[k];
+	    qi = di*p->wr[k] - dr*p->wi[k];
+	    zr[k] = er - qi;
+	    zi[k] = ei + qr;
+	}
+	cfft(p->half, zr, zi, 1, work + n);
+	for (k = 0; k < h; k++) {
+	    x[2*k] = 2.0*zr[k];
+	    x[2*k+1] = 2.0*zi[k];
+	}
+    }
+    else {
+	zr = work;
+	zi = work + n;
+	zr[0] = re[0];
+	zi[0] = im[0];
+	for (k = 1; k <= h; k++) {
+	    zr[k] = zr[n-k] = re[k];
+	    zi[k] = im[k];
+	    zi[n-k] = -im[k];
+	}
+	cfft(p, zr, zi, 1, work + 2*n);
+	for (k = 0; k < n; k++)
+	    x[k] = zr[k];
+    }
+}
+
+/* segfft transforms nseg real segments of n samples each (where n is the
+   plan's transform length), stored consecutively in x, using up to nthreads
+   threads.  If win is not NULL, the segments are multiplied by it in place
+   before they are transformed.  The n/2 + 1 components of the transform of
+   segment k are stored beginning at re + k*(n/2 + 1) and im + k*(n/2 + 1).
+   segfft returns 0, or -1 if there is not enough memory. */
+
+struct segjob {
+    struct fftplan *p;
+    double *x, *win, *re, *im;
+    long first, last;		/* segments to be transformed */
+    int err;
+};
+
+static void *segrun(void *arg)
+{
+    struct segjob *job = (struct segjob *)arg;
+    double *work, *x;
+    int i, n = job->p->n, nb = n/2 + 1;
+    long k;
+
+    if ((work = fftwork(job->p)) == NULL) {
+	job->err = 1;
+	return (NULL);
+    }
+    for (k = job->first; k < job->last; k++) {
+	x = job->x + k*n;
+	if (job->win)
+	    for (i = 0; i < n; i++)
+		x[i] *= job->win[i];
+	rfft(job->p, x, job->re + k*nb, job->im + k*nb, work);
+    }
+    free(work);
+    return (NULL);
+}
+
+int segfft(struct fftplan *p, double *x, long nseg, double *win, double *re,
+	   double *im, int nthreads)
+{
+    int i, nj;
+    struct segjob job[MAXTHREADS];
+#ifndef NOPTHREADS
+    pthread_t tid[MAXTHREADS];
+    int started[MAXTHREADS];
+#endif
+
+    if ((nj = nthreads) > MAXTHREADS) nj = MAXTHREADS;
+    if (nj > nseg) nj = nseg;
+    if (nj < 1) nj = 1;
+    for (i = 0; i < nj; i++) {
+	job[i].p = p;
+	job[i].x = x;
+	job[i].win = win;
+	job[i].re = re;
+	job[i].im = im;
+	job[i].first = nseg * i / nj;
+	job[i].last = nseg * (i+1) / nj;
+	job[i].err = 0;
+    }
+#ifndef NOPTHREADS
+    for (i = 1; i < nj; i++)
+	started[i] = pthread_create(&tid[i], NULL, segrun, &job[i]) == 0;
+    segrun(&job[0]);
+    for (i = 1; i < nj; i++) {
+	if (started[i]) pthread_join(tid[i], NULL);
+	else segrun(&job[i]);
+    }
+#else
+    for (i = 0; i < nj; i++)
+	segrun(&job[i]);
+#endif
+    for (i = 0; i < nj; i++)
+	if (job[i].err) return (-1);
+    return (0);
+}
+
+/* csdacc adds the auto- and cross-spectra of nseg segments of nch channels to
+   the accumulated cross-spectral matrix.  The nb transform components of
+   channel c of segment s (as computed by segfft) begin at re + (s*nch + c)*nb
+   and im + (s*nch + c)*nb.  For each pair of channels i <= j, the sum over the
+   segments of X_i conj(X_j) is added to gre + q*nb and gim + q*nb, where
+   q = CSDPAIR(i, j, nch) (so that the pairs are stored in the row order of the
+   upper triangle of the matrix, including its diagonal).  The frequency
+   components are divided among up to nthreads threads;  since each component
+   is accumulated over the segments in order by one thread, the results do
+   not depend on the number of threads. */
+
+struct csdjob {
+    double *re, *im, *gre, *gim;
+    long nseg;
+    int nch, nb, first, last;	/* components first ... last-1 */
+};
+
+static void *csdrun(void *arg)
+{
+    struct csdjob *job = (struct csdjob *)arg;
+    double *gi, *gr, *xi, *xr, *yi, *yr;
+    int i, j, k, nb = job->nb, nch = job->nch;
+    long s;
+
+    for (i = 0; i < nch; i++)
+	for (j = i; j < nch; j++) {
+	    gr = job->gre + CSDPAIR(i, j, nch)*nb;
+	    gi = job->gim + CSDPAIR(i, j, nch)*nb;
+	    for (s = 0; s < job->nseg; s++) {
+		xr = job->re + (s*nch + i)*nb;
+		xi = job->im + (s*nch + i)*nb;
+		yr = job->re + (s*nch + j)*nb;
+		yi = job->im + (s*nch + j)*nb;
+		for (k = job->first; k < job->last; k++) {
+		    gr[k] += xr[k]*yr[k] + xi[k]*yi[k];
+		    gi[k] += xi[k]*yr[k] - xr[k]*yi[k];
+		}
+	    }
+	}
+    return (NULL);
+}
+
+void csdacc(double *re, double *im, long nseg, int nch, int nb, double *gre,
+	    double *gim, int nthreads)
+{
+    int i, nj;
+    struct csdjob job[MAXTHREADS];
+#ifndef NOPTHREADS
+    pthread_t tid[MAXTHREADS];
+    int started[MAXTHREADS];
+#endif
+
+    if ((nj = nthreads) > MAXTHREADS) nj = MAXTHREADS;
+    if (nj > nb) nj = nb;
+    if (nj < 1) nj = 1;
+    for (i = 0; i < nj; i++) {
+	job[i].re = re;
+	job[i].im = im;
+	job[i].gre = gre;
+	job[i].gim = gim;
+	job[i].nseg = nseg;
+	job[i].nch = nch;
+	job[i].nb = nb;
+	job[i].first = nb * i / nj;
+	job[i].last = nb * (i+1) / nj;
+    }
+#ifndef NOPTHREADS
+    for (i = 1; i < nj; i++)
+	started[i] = pthread_create(&tid[i], NULL, csdrun, &job[i]) == 0;
+    csdrun(&job[0]);
+    for (i = 1; i < nj; i++) {
+	if (started[i]) pthread_join(tid[i], NULL);
+	else csdrun(&job[i]);
+    }
+#else
+    for (i = 0; i < nj; i++)
+	csdrun(&job[i]);
+#endif
+}
+
+/* lombwin computes Lomb periodograms of nwin windows of the unevenly sampled
+   series y (with sample times t, in ascending order), using the fast
+   algorithm of Press and Rybicki (Astrophysical J. 338:277-280, 1989) as
+   presented in Numerical Recipes in C (2nd ed., pp. 580-582).  Window k
+   contains the count[k] samples beginning with sample first[k], and spans no
+   more than span time units.  The nout periodogram values for window k,
+   at frequencies (j+1)/(span*ofac) for j = 0, ..., nout-1, are stored in
+   pw[k*nout + j]:
+
+       pw = ((sum of (y-ymean) cos w(t-tau))^2 / sum of cos^2 w(t-tau) +
+	     (sum of (y-ymean) sin w(t-tau))^2 / sum of sin^2 w(t-tau)) / 2
+
+   The sums are computed using FFTs of the samples and of their weights,
+   extirpolated onto a grid of ndim points, where ndim is at least 8*MACC
+   times nout.  All windows share one FFT plan;  each thread has its own
+   workspace, reused for each of its windows.  Windows with fewer than two
+   samples yield zeroes.  lombwin returns 0, or -1 if there is not enough
+   memory. */
+
+#define MACC	4	/* number of grid points per extirpolated sample */
+
+struct lombjob {
+    struct fftplan *p;
+    double *t, *y, *pw, span, ofac;
+    long *first, *count, firstwin, lastwin;
+    int nout, err;
+};
+
+/* extirpolate adds v to yy[0 ... n-1] at the (generally fractional) position
+   x, spreading it over the m nearest grid points (Numerical Recipes' spread).
+*/
+static void extirpolate(double v, double *yy, long n, double x, int m)
+{
+    static long nfac[11] = { 1, 1, 2, 6, 24, 120, 720, 5040, 40320, 362880,
+			     3628800 };
+    double fac;
+    long ihi, ilo, ix, j, nden;
+
+    if ((ix = (long)x) == x) yy[ix] += v;
+    else {
+	if ((ilo = (long)(x - 0.5*m + 1.0)) < 0) ilo = 0;
+	if (ilo > n - m) ilo = n - m;
+	ihi = ilo + m - 1;
+	nden = nfac[m-1];
+	for (j = ilo, fac = 1.0; j <= ihi; j++) fac *= x - j;
+	yy[ihi] += v*fac/(nden*(x - ihi));
+	for (j = ihi-1; j >= ilo; j--) {
+	    nden = (nden/(j + 1 - ilo))*(j - ihi);
+	    yy[j] += v*fac/(nden*(x - j));
+	}
+    }
+}
+
+static void *lombrun(void *arg)
+{
+    struct lombjob *job = (struct lombjob *)arg;
+    double ck, ckk, cterm, cwt, den, fac, hc2wt, hs2wt, hypo, sterm, swt, tmin,
+	*t, *y, *pw, ymean, *wk1, *wk2, *r1, *i1, *r2, *i2, *work;
+    long j, k, n, ndim = fftlen(job->p);
+
+    wk1 = (double *)malloc(2*ndim * sizeof(double));
+    r1 = (double *)malloc(2*(ndim/2 + 1) * sizeof(double));
+    r2 = (double *)malloc(2*(ndim/2 + 1) * sizeof(double));
+    work = fftwork(job->p);
+    if (wk1 == NULL || r1 == NULL || r2 == NULL || work == NULL) {
+	free(wk1); free(r1); free(r2); free(work);
+	job->err = 1;
+	return (NULL);
+    }
+    wk2 = wk1 + ndim;
+    i1 = r1 + ndim/2 + 1;
+    i2 = r2 + ndim/2 + 1;
+    fac = ndim/(job->span*job->ofac);
+    for (k = job->firstwin; k < job->lastwin; k++) {
+	t = job->t + job->first[k];
+	y = job->y + job->first[k];
+	n = job->count[k];
+	pw = job->pw + k*job->nout;
+	if (n < 2) {
+	    for (j = 0; j < job->nout; j++)
+		pw[j] = 0.0;
+	    continue;
+	}
+	for (j = 0, ymean = 0.0; j < n; j++)
+	    ymean += y[j];
+	ymean /= n;
+	for (j = 0, tmin = t[0]; j < n; j++)
+	    if (t[j] < tmin) tmin = t[j];
+	for (j = 0; j < ndim; j++)
+	    wk1[j] = wk2[j] = 0.0;
+	for (j = 0; j < n; j++) {
+	    ck = (t[j] - tmin)*fac;
+	    while (ck >= ndim) ck -= ndim;
+	    ckk = 2.0*ck;
+	    while (ckk >= ndim) ckk -= ndim;
+	    extirpolate(y[j] - ymean, wk1, ndim, ck, MACC);
+	    extirpolate(1.0, wk2, ndim, ckk, MACC);
+	}
+	rfft(job->p, wk1, r1, i1, work);
+	rfft(job->p, wk2, r2, i2, work);
+	for (j = 1; j <= job->nout; j++) {
+	    hypo = sqrt(r2[j]*r2[j] + i2[j]*i2[j]);
+	    hc2wt = 0.5*r2[j]/hypo;
+	    hs2wt = 0.5*i2[j]/hypo;
+	    cwt = sqrt(0.5 + hc2wt);
+	    swt = sqrt(0.5 - hc2wt);
+	    if (hs2wt <= 0.0) swt = -swt;
+	    den = 0.5*n + hc2wt*r2[j] + hs2wt*i2[j];
+	    cterm = cwt*r1[j] + swt*i1[j];
+	    sterm = cwt*i1[j] - swt*r1[j];
+	    pw[j-1] = 0.5*(cterm*cterm/den + sterm*sterm/(n - den));
+	}
+    }
+    free(wk1);
+    free(r1);
+    free(r2);
+    free(work);
+    return (NULL);
+}
+
+int lombwin(double *t, double *y, long *first, long *count, long nwin,
+	    double span, double ofac, int nout, double *pw, int nthreads)
+{
+    int i, nj;
+    long ndim;
+    struct fftplan *p;
+    struct lombjob job[MAXTHREADS];
+#ifndef NOPTHREADS
+    pthread_t tid[MAXTHREADS];
+    int started[MAXTHREADS];
+#endif
+
+    for (ndim = 64; ndim < 2L*MACC*nout; ndim <<= 1)
+	;
+    if ((p = fftplan(2*ndim)) == NULL) return (-1);
+    if ((nj = nthreads) > MAXTHREADS) nj = MAXTHREADS;
+    if (nj > nwin) nj = nwin;
+    if (nj < 1) nj = 1;
+    for (i = 0; i < nj; i++) {
+	job[i].p = p;
+	job[i].t = t;
+	job[i].y = y;
+	job[i].pw = pw;
+	job[i].span = span;
+	job[i].ofac = ofac;
+	job[i].first = first;
+	job[i].count = count;
+	job[i].firstwin = nwin * i / nj;
+	job[i].lastwin = nwin * (i+1) / nj;
+	job[i].nout = nout;
+	job[i].err = 0;
+    }
+#ifndef NOPTHREADS
+    for (i = 1; i < nj; i++)
+	started[i] = pthread_create(&tid[i], NULL, lombrun, &job[i]) == 0;
+    lombrun(&job[0]);
+    for (i = 1; i < nj; i++) {
+	if (started[i]) pthread_join(tid[i], NULL);
+	else lombrun(&job[i]);
+    }
+#else
+    for (i = 0; i < nj; i++)
+	lombrun(&job[i]);
+#endif
+    for (i = 0; i < nj; i++)
+	if (job[i].err) return (-1);
+    return (0);
+}
+
+/* burg fits all-pole (autoregressive) models of orders 1 through m to a
+   series of n samples using Burg's method.  It needs only the lagged products
+   c[j] (the sum of x[i]*x[i+j] over the series, for j = 0, ..., m), and the
+   first and last m+2 samples (head[0 ... m+1] and tail[0 ... m+1], where
+   tail[m+1] is the last sample), so that once the lagged products are known,
+   the cost of the fit does not depend on n.  This is the recursion of Vos ("A
+   fast implementation of Burg's method", 2013);  it yields the same models as
+   memcof in Numerical Recipes in C (2nd ed., pp. 568-569).  m must be less
+   than n - 1.
+
+   If crit is MEM_FIXED, the order of the model is m.  Otherwise, burg chooses
+   the order k (0 <= k <= m) that minimizes the criterion, computed from the
+   prediction error power E(k) of each model as it is fitted:
+	MEM_AIC:  n ln E(k) + 2 k		(Akaike's information criterion)
+	MEM_FPE:  E(k) (n + k + 1)/(n - k - 1)	(final prediction error)
+	MEM_MDL:  n ln E(k) + k ln n		(minimum description length)
+   The coefficients of the chosen model are stored in cof[0 ... k-1] (the
+   prediction of x[i] is the sum of cof[j]*x[i-j-1]) and its prediction error
+   power in *pm.  work must have room for 3*(m+3) doubles.  burg returns the
+   order of the chosen model. */
+
+static double mcrit(int crit, double e, long n, int k)
+{
+    switch (crit) {
+      case MEM_AIC: return (n*log(e) + 2.0*k);
+      case MEM_FPE: return (e*(n + k + 1)/(n - k - 1));
+      case MEM_MDL: return (n*log(e) + k*log((double)n));
+      default:	    return (0.0);
+    }
+}
+
+int burg(double *c, double *head, double *tail, long n, int m, int crit,
+	 double *cof, double *pm, double *work)
+{
+    double best, den, e, mu, num, s, t, u, v, *a = work, *g = work + m + 3,
+	*r = work + 2*(m + 3);
+    int i, k, order = 0;
+
+    a[0] = 1.0;
+    *pm = e = c[0]/n;
+    if (m < 1) return (0);
+    best = mcrit(crit, e, n, 0);
+    g[0] = 2.0*c[0] - head[0]*head[0] - tail[m+1]*tail[m+1];
+    g[1] = r[0] = 2.0*c[1];
+    for (k = 0; k < m; k++) {
+	/* The order k model is a[0 ... k], and g = Q [a 0], where Q is the sum
+	   of the (k+2)-square autocorrelation matrix of the series and its
+	   reversal.  The reflection coefficient is -([0 Ja].g)/([a 0].g),
+	   where Ja is a reversed. */
+	for (i = 0, num = den = 0.0; i <= k; i++) {
+	    num += a[k-i]*g[i+1];
+	    den += a[i]*g[i];
+	}
+	mu = (den > 0.0) ? -num/den : 0.0;
+	e *= 1.0 - mu*mu;
+	a[k+1] = 0.0;
+	for (i = 0; 2*i <= k+1; i++) {
+	    s = a[i];
+	    t = a[k+1-i];
+	    a[i] = s + mu*t;
+	    if (2*i != k+1) a[k+1-i] = t + mu*s;
+	}
+	if (crit == MEM_FIXED ? k+1 == m : mcrit(crit, e, n, k+1) < best) {
+	    if (crit != MEM_FIXED) best = mcrit(crit, e, n, k+1);
+	    for (i = 0; i <= k; i++)
+		cof[i] = -a[i+1];
+	    *pm = e;
+	    order = k+1;
+	}
+	if (k+1 == m) break;
+
+	/* Update r (Q's new last column, less the end corrections) and g. */
+	for (i = k+1; i > 0; i--)
+	    r[i] = r[i-1] - head[i-1]*head[k+1] - tail[m-k]*tail[m+2-i];
+	r[0] = 2.0*c[k+2];
+	for (i = 0, u = v = 0.0; i <= k+1; i++) {
+	    u += head[k+1-i]*a[i];
+	    v += tail[m-k+i]*a[i];
+	}
+	for (i = 0; 2*i <= k+1; i++) {
+	    s = g[i];
+	    t = g[k+1-i];
+	    g[i] = s + mu*t;
+	    if (2*i != k+1) g[k+1-i] = t + mu*s;
+	}
+	for (i = 0, s = 0.0; i <= k+1; i++) {
+	    g[i] -= head[k+1-i]*u + tail[m-k+i]*v;
+	    s += a[i]*r[i];
+	}
+	g[k+2] = s;
+    }
+    return (order);
+}
+
+/* memwin computes maximum entropy (all-pole model) spectral estimates for nwin
+   windows of len samples each of the evenly sampled series x;  window k begins
+   with x[k*step].  Each window is zero-meaned if detrend is 1, or zero-meaned
+   and detrended if detrend is 2, and then multiplied by w if w is not NULL,
+   before a model is fitted to it by burg (with maximum order m, and order
+   selection criterion crit).  The estimates
+	pm / |1 - sum of cof[i] exp(-2 pi i f (i+1))|^2
+   at f = j/(2*(nfreq-1)) (for j = 0, ..., nfreq-1, where f = 1 is the sampling
+   frequency) are stored in pw[k*nfreq + j], and the order of the model is
+   stored in order[k] if order is not NULL.  The estimates are evaluated using
+   FFTs of length 2*(nfreq-1) (nfreq must be at least 2).
+
+   Each thread handles a run of consecutive windows.  If the windows overlap
+   and they are neither detrended nor multiplied by a window function, the
+   lagged products for each window after the first in a run are obtained from
+   those of the previous window, by subtracting the products of samples that
+   have left the window and adding those of samples that have entered it, so
+   that the cost of each window is proportional to step rather than len.
+   memwin returns 0, or -1 if there is not enough memory. */
+
+struct memjob {
+    struct fftplan *p;
+    double *x, *wtab, *pw;
+    long len, step, firstwin, lastwin;
+    int m, crit, detrend, nfreq, *order, err;
+};
+
+static void *memrun(void *arg)
+{
+    struct memjob *job = (struct memjob *)arg;
+    double a, b, d, fs, ls, pm, sh = 0.0, ss = 0.0, tt, *bw, *c, *cof, *cs,
+	*head, *hb, *im, *pw, *re, *s, *tail, *work, *xw = NULL;
+    int i, incr, j, k, L, m = job->m, order;
+    long len = job->len, step = job->step, w;
+
+    incr = job->wtab == NULL && job->detrend < 2 && step < len;
+    L = fftlen(job->p);
+    c = (double *)malloc((2*(m+1) + 2*(m+2) + 3*(m+3) + (m+1) + L +
+			  2*(L/2 + 1)) * sizeof(double));
+    if (!incr) xw = (double *)malloc(len * sizeof(double));
+    work = fftwork(job->p);
+    if (c == NULL || (!incr && xw == NULL) || work == NULL) {
+	free(c); free(xw); free(work);
+	job->err = 1;
+	return (NULL);
+    }
+    cs = c + m + 1;
+    hb = cs + m + 1;
+    bw = hb + 2*(m+2);
+    cof = bw + 3*(m+3);
+    re = cof + m + 1;	/* re[0 ... L-1] is also the input to rfft */
+    im = re + L;
+    for (w = job->firstwin; w < job->lastwin; w++) {
+	s = job->x + w*step;
+	if (incr) {
+	    /* Accumulate the lagged products of x - sh, where sh is the mean of
+	       the first window in the run (to limit roundoff error). */
+	    if (w == job->firstwin) {
+		for (i = 0, sh = 0.0; i < len; i++)
+		    sh += s[i];
+		sh /= len;
+		for (j = 0, ss = 0.0; j < len; j++)
+		    ss += s[j] - sh;
+		for (k = 0; k <= m; k++)
+		    for (j = 0, cs[k] = 0.0; j < len - k; j++)
+			cs[k] += (s[j] - sh)*(s[j+k] - sh);
+	    }
+	    else {
+		double *o = s - step;	/* start of the previous window */
+
+		for (k = 0; k <= m; k++) {
+		    for (j = 0; j < step && j < len - k; j++)
+			cs[k] -= (o[j] - sh)*(o[j+k] - sh);
+		    for (j = (len - step - k > 0) ? len - step - k : 0;
+			 j < len - k; j++)
+			cs[k] += (s[j] - sh)*(s[j+k] - sh);
+		}
+		for (j = 0; j < step; j++)
+		    ss += s[len-step+j] - o[j];
+	    }
+
+	    /* Adjust the lagged products for the offset d of the window's mean
+	       (or of zero, if it is not to be zero-meaned) from sh. */
+	    d = job->detrend ? ss/len : -sh;
+	    for (k = 0, fs = ls = ss; k <= m; k++) {
+		if (k > 0) {
+		    fs -= s[len-k] - sh;
+		    ls -= s[k-1] - sh;
+		}
+		c[k] = cs[k] - d*(fs + ls) + (len - k)*d*d;
+	    }
+	    for (i = 0; i < m+2; i++) {
+		hb[i] = s[i] - sh - d;
+		hb[m+2+i] = s[len-m-2+i] - sh - d;
+	    }
+	    head = hb;
+	    tail = hb + m + 2;
+	}
+	else {
+	    for (i = 0; i < len; i++)
+		xw[i] = s[i];
+	    if (job->detrend) {
+		for (i = 0, a = 0.0; i < len; i++)
+		    a += xw[i];
+		a /= len;
+		for (i = 0; i < len; i++)
+		    xw[i] -= a;
+	    }
+	    if (job->detrend == 2) {	/* subtract the least-squares line */
+		for (i = 0, a = b = 0.0; i < len; i++) {
+		    tt = i - 0.5*(len - 1);
+		    a += tt*xw[i];
+		    b += tt*tt;
+		}
+		for (i = 0, a /= b; i < len; i++)
+		    xw[i] -= a*(i - 0.5*(len - 1));
+	    }
+	    if (job->wtab)
+		for (i = 0; i < len; i++)
+		    xw[i] *= job->wtab[i];
+	    for (k = 0; k <= m; k++)
+		for (j = 0, c[k] = 0.0; j < len - k; j++)
+		    c[k] += xw[j]*xw[j+k];
+	    head = xw;
+	    tail = xw + len - m - 2;
+	}
+	order = burg(c, head, tail, len, m, job->crit, cof, &pm, bw);
+	if (job->order) job->order[w] = order;
+
+	/* Evaluate the spectrum from the transform of [1 -cof[0] -cof[1] ...]
+	   (wrapped modulo L if it is longer than L). */
+	for (i = 0; i < L; i++)
+	    re[i] = 0.0;
+	re[0] = 1.0;
+	for (i = 0; i < order; i++)
+	    re[(i+1) % L] -= cof[i];
+	rfft(job->p, re, re, im, work);
+	pw = job->pw + w*job->nfreq;
+	for (j = 0; j < job->nfreq; j++)
+	    pw[j] = pm/(re[j]*re[j] + im[j]*im[j]);
+    }
+    free(c);
+    free(xw);
+    free(work);
+    return (NULL);
+}
+
+int memwin(double *x, long len, long step, long nwin, int m, int crit,
+	   int detrend, winfn w, int nfreq, double *pw, int *order,
+	   int nthreads)
+{
+    int i, nj;
+    double *wtab = NULL;
+    struct fftplan *p;
+    struct memjob job[MAXTHREADS];
+#ifndef NOPTHREADS
+    pthread_t tid[MAXTHREADS];
+    int started[MAXTHREADS];
+#endif
+
+    if ((p = fftplan(2*(nfreq - 1))) == NULL ||
+	(w && (wtab = win_table(w, len, NULL)) == NULL))
+	return (-1);
+    if ((nj = nthreads) > MAXTHREADS) nj = MAXTHREADS;
+    if (nj > nwin) nj = nwin;
+    if (nj < 1) nj = 1;
+    for (i = 0; i < nj; i++) {
+	job[i].p = p;
+	job[i].x = x;
+	job[i].wtab = wtab;
+	job[i].pw = pw;
+	job[i].len = len;
+	job[i].step = step;
+	job[i].firstwin = nwin * i / nj;
+	job[i].lastwin = nwin * (i+1) / nj;
+	job[i].m = m;
+	job[i].crit = crit;
+	job[i].detrend = detrend;
+	job[i].nfreq = nfreq;
+	job[i].order = order;
+	job[i].err = 0;
+    }
+#ifndef NOPTHREADS
+    for (i = 1; i < nj; i++)
+	started[i] = pthread_create(&tid[i], NULL, memrun, &job[i]) == 0;
+    memrun(&job[0]);
+    for (i = 1; i < nj; i++) {
+	if (started[i]) pthread_join(tid[i], NULL);
+	else memrun(&job[i]);
+    }
+#else
+    for (i = 0; i < nj; i++)
+	memrun(&job[i]);
+#endif
+    for (i = 0; i < nj; i++)
+	if (job[i].err) return (-1);
+    return (0);
+}
+
+/* See Oppenheim & Schafer, Digital Signal Processing, p. 241 (1st ed.) */
+double win_bartlett(int j, int n)
+{
+    double a = 2.0/(n-1), w;
+
+    if ((w = j*a) > 1.0) w = 2.0 - w;
+    return (w);
+}
+
+/* See Oppenheim & Schafer, Digital Signal Processing, p. 242 (1st ed.) */
+double win_blackman(int j, int n)
+{
+    double a = 2.0*PI/(n-1);
+
+    return (0.42 - 0.5*cos(a*j) + 0.08*cos(2*a*j));
+}
+
+/* See Harris, F.J., "On the use of windows for harmonic analysis with the
+   discrete Fourier transform", Proc. IEEE, Jan. 1978 */
+double win_blackman_harris(int j, int n)
+{
+    double a = 2.0*PI/(n-1);
+
+    return (0.35875 - 0.48829*cos(a*j) + 0.14128*cos(2*a*j) -
+	    0.01168*cos(3*a*j));
+}
+
+/* See Oppenheim & Schafer, Digital Signal Processing, p. 242 (1st ed.) */
+double win_hamming(int j, int n)
+{
+    double a = 2.0*PI/(n-1);
+
+    return (0.54 - 0.46*cos(a*j));
+}
+
+/* See Oppenheim & Schafer, Digital Signal Processing, p. 242 (1st ed.)
+   The second edition of Numerical Recipes calls this the "Hann" window. */
+double win_hanning(int j, int n)
+{
+    double a = 2.0*PI/(n-1);
+
+    return (0.5 - 0.5*cos(a*j));
+}
+
+/* See Press, Flannery, Teukolsky, & Vetterling, Numerical Recipes in C,
+   p. 442 (1st ed.) */
+double win_parzen(int j, int n)
+{
+    double a = (n-1)/2.0, w;
+
+    if ((w = (j-a)/(a+1)) > 0.0) w = 1 - w;
+    else w = 1 + w;
+    return (w);
+}
+
+/* See any of the above references. */
+double win_square(int j, int n)
+{
+    return (1.0);
+}
+
+/* See Press, Flannery, Teukolsky, & Vetterling, Numerical Recipes in C,
+   p. 442 (1st ed.) or p. 554 (2nd ed.) */
+double win_welch(int j, int n)
+{
+    double a = (n-1)/2.0, w;
+
+    w = (j-a)/(a+1);
+    return (1 - w*w);
+}
+
+/* win_lookup returns the window function with the given name, or NULL if the
+   name is not recognized. */
+winfn win_lookup(char *name)
+{
+    if (strcasecmp(name, "Bartlett") == 0)
+	return (win_bartlett);
+    else if (strcasecmp(name, "Blackman") == 0)
+	return (win_blackman);
+    else if (strcasecmp(name, "Blackman-Harris") == 0)
+	return (win_blackman_harris);
+    else if (strcasecmp(name, "Hamming") == 0)
+	return (win_hamming);
+    /* Numerical Recipes 2nd ed. calls Hanning window "Hann window" */
+    else if (strcasecmp(name, "Hann") == 0 ||
+	     strcasecmp(name, "Hanning") == 0)
+	return (win_hanning);
+    else if (strcasecmp(name, "Parzen") == 0)
+	return (win_parzen);
+    else if (strcasecmp(name, "Square") == 0 ||
+	     strcasecmp(name, "Rectangular") == 0 ||
+	     strcasecmp(name, "Dirichlet") == 0)
+	return (win_square);
+    else if (strcasecmp(name, "Welch") == 0)
+	return (win_welch);
+    return (NULL);
+}
+
+/* win_table returns the n coefficients of window w (computed once and kept
+   for reuse), and stores their sum in *sum if sum is not NULL.  It returns
+   NULL if there is not enough memory. */
+double *win_table(winfn w, int n, double *sum)
+{
+    int j;
+    struct wintab *t;
+
+    LOCK();
+    for (t = windows; t; t = t->next)
+	if (t->w == w && t->n == n) break;
+    if (t == NULL && (t = (struct wintab *)malloc(sizeof(struct wintab)))) {
+	if ((t->c = (double *)malloc(n * sizeof(double))) == NULL) {
+	    free(t);
+	    t = NULL;
+	}
+	else {
+	    t->w = w;
+	    t->n = n;
+	    for (j = 0, t->sum = 0.0; j < n; j++)
+		t->sum += t->c[j] = (*w)(j, n);
+	    t->next = windows;
+	    windows = t;
+	}
+    }
+    UNLOCK();
+    if (t == NULL) return (NULL);
+    if (sum) *sum = t->sum;
+    return (t->c);
+}
@@ -0,0 +1,99 @@
+/* file: spectrum.h	WFDB contributors	18 October 2026
+Spectral analysis functions shared by the PSD applications
+
+-------------------------------------------------------------------------------
+Copyright (C) 2026 WFDB contributors
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author by e-mail (wfdb@physionet.org) or postal mail
+(MIT Room E25-505A, Cambridge, MA 02139 USA).  For updates to this software,
+please visit PhysioNet (http://www.physionet.org/).
+_______________________________________________________________________________
+
+These functions compute discrete Fourier transforms of any length in double
+precision.  A plan (obtained from fftplan) holds the factors and twiddle
+factors for one transform length;  plans are created once and kept for reuse,
+and they are never modified after they have been created, so that several
+threads can use the same plan at once, each with its own workspace (obtained
+from fftwork).  Lengths with no prime factors larger than MAXRADIX are
+transformed using a mixed-radix (4, 2, 3, and odd prime) Stockham algorithm;
+other lengths are transformed using Bluestein's algorithm, as convolutions
+computed using power-of-two transforms.
+
+All transforms are unnormalized.  The forward transform of x is
+    X[k] = sum over t of x[t] exp(-2 pi i k t / n)
+and the inverse transform has the opposite sign in the exponent, so that
+transforming and inverse transforming a series multiplies it by n.  Real
+transforms yield (or take) the n/2 + 1 non-negative frequency components
+(n/2 is rounded down if n is odd).
+
+segfft transforms many segments at once, and csdacc accumulates the auto- and
+cross-spectra of several channels from the transforms of their segments.
+lombwin computes Lomb periodograms of unevenly sampled series, in many
+(possibly overlapping) windows at once, using these FFTs.  burg fits all-pole
+models (with optional selection of the model order) from lagged products, and
+memwin uses it to compute maximum entropy spectral estimates of many windows
+at once.
+*/
+
+#define MAXRADIX	64	/* largest prime factor transformed directly */
+#define MAXTHREADS	16	/* maximum number of threads used by segfft,
+				   csdacc, lombwin, and memwin */
+
+/* Index of the cross-spectrum of channels i and j (i <= j, of n) in the
+   accumulators used by csdacc */
+#define CSDPAIR(i, j, n)	((i)*(n) - (i)*((i)-1)/2 + (j) - (i))
+
+/* Model order selection criteria for burg and memwin */
+#define MEM_FIXED	0	/* use the maximum order */
+#define MEM_AIC		1	/* Akaike's information criterion */
+#define MEM_FPE		2	/* final prediction error */
+#define MEM_MDL		3	/* minimum description length */
+
+struct fftplan;
+
+/* A window function returns the weight for sample j of an n-point segment. */
+typedef double (*winfn)(int j, int n);
+
+extern struct fftplan *fftplan(int n);
+extern double *fftwork(struct fftplan *p);
+extern void cfft(struct fftplan *p, double *re, double *im, int inverse,
+		 double *work);
+extern void rfft(struct fftplan *p, double *x, double *re, double *im,
+		 double *work);
+extern void rifft(struct fftplan *p, double *re, double *im, double *x,
+		  double *work);
+extern int fftlen(struct fftplan *p);
+extern int segfft(struct fftplan *p, double *x, long nseg, double *win,
+		  double *re, double *im, int nthreads);
+extern void csdacc(double *re, double *im, long nseg, int nch, int nb,
+		   double *gre, double *gim, int nthreads);
+extern int lombwin(double *t, double *y, long *first, long *count, long nwin,
+		   double span, double ofac, int nout, double *pw, int nthreads);
+extern int burg(double *c, double *head, double *tail, long n, int m, int crit,
+		double *cof, double *pm, double *work);
+extern int memwin(double *x, long len, long step, long nwin, int m, int crit,
+		  int detrend, winfn w, int nfreq, double *pw, int *order,
+		  int nthreads);
+
+extern double win_bartlett(int j, int n);
+extern double win_blackman(int j, int n);
+extern double win_blackman_harris(int j, int n);
+extern double win_hamming(int j, int n);
+extern double win_hanning(int j, int n);
+extern double win_parzen(int j, int n);
+extern double win_square(int j, int n);
+extern double win_welch(int j, int n);
+extern winfn win_lookup(char *name);
+extern double *win_table(winfn w, int n, double *sum);
@@ -1,5 +1,5 @@
 # file: Makefile.tpl		G. Moody	31 May 2000
-#				Last revised:	24 April 2020
+#				Last revised:	18 October 2026
 # Change the settings below as appropriate for your setup.
 
 # Choose directories in which to install WAVE and its ancillary files by
@@ -32,11 +32,11 @@ RESDIR = $(WFDBROOT)/lib/X11/app-defaults
 # It should not be necessary to modify anything below this line.
 # -----------------------------------------------------------------------------
 
-HFILES = wave.h bitmaps.h xvwave.h
+HFILES = wave.h annstore.h bitmaps.h xvwave.h
 CFILES = wave.c init.c mainpan.c modepan.c helppan.c logpan.c annpan.c edit.c \
- grid.c sig.c annot.c analyze.c scope.c search.c xvwave.c help.c
+ grid.c sig.c annot.c annstore.c analyze.c scope.c search.c xvwave.c help.c
 OFILES = wave.o init.o mainpan.o modepan.o helppan.o logpan.o annpan.o edit.o \
- grid.o sig.o annot.o analyze.o scope.o search.o xvwave.o $(HELPOBJ)
+ grid.o sig.o annot.o annstore.o analyze.o scope.o search.o xvwave.o $(HELPOBJ)
 HELPFILES = analysis.hlp buttons.hlp editing.hlp intro.hlp log.hlp news.hlp \
  printing.hlp resource.hlp
 OTHERFILES = wave.hl0 wave.info demo.txt Wave.res wavemenu.def Makefile
@@ -152,8 +152,10 @@ search.o:	wave.h xvwave.h search.c
 	$(CC) -c $(WCFLAGS) search.c
 sig.o:		wave.h xvwave.h sig.c
 	$(CC) -c $(WCFLAGS) sig.c
-annot.o:	wave.h xvwave.h annot.c
+annot.o:	wave.h annstore.h xvwave.h annot.c
 	$(CC) -c $(WCFLAGS) -DWAVEVERSION=\"$(WAVEVERSION)\" annot.c
+annstore.o:	annstore.h annstore.c
+	$(CC) -c $(WCFLAGS) annstore.c
 analyze.o:    	analyze.c
 	$(CC) -c $(WCFLAGS) -DMENUDIR=\"$(MENUDIR)\" analyze.c
 scope.o:	wave.h xvwave.h scope.c
@@ -1,5 +1,5 @@
 /* file: annot.c	G. Moody	  1 May 1990
-			Last revised:    24 April 2020
+			Last revised:  18 October 2026
 Annotation list handling and display functions for WAVE
 
 -------------------------------------------------------------------------------
@@ -34,11 +34,17 @@ _______________________________________________________________________________
 
 void set_frame_title();
 
+/* The annotations are kept in `store' (see annstore.h), which indexes them
+   and also maintains the links between them. */
+static struct annstore store;
+
 struct ap *get_ap()
 {
     struct ap *a;
 
-    if ((a = (struct ap *)malloc(sizeof(struct ap))) == NULL) {
+    if ((a = (struct ap *)malloc(sizeof(struct ap))) != NULL)
+	a->jx = 0L;
+    else {
 #ifdef NOTICE
 	Xv_notice notice = xv_create((Frame)frame, NOTICE,
 				     XV_SHOW, TRUE,
@@ -55,6 +61,29 @@ struct ap *get_ap()
     return (a);
 }
 
+/* Copy_aux() returns a copy of an aux string, or NULL if there is not enough
+   memory.  The copy is freed by annot_init. */
+unsigned char *copy_aux(aux)
+unsigned char *aux;
+{
+    return (annstore_auxdup(&store, aux));
+}
+
+/* Touch_annotation() must be called before an annotation is changed in place,
+   so that post_changes can determine if there is anything to be saved. */
+void touch_annotation(a)
+struct ap *a;
+{
+    annstore_touch(&store, a);
+}
+
+/* Reset ap_start and ap_end after the store has been changed. */
+static void set_ends()
+{
+    ap_start = annstore_at(&store, 0L);
+    ap_end = annstore_at(&store, store.n - 1);
+}
+
 int annotations;	/* non-zero if there are annotations to be shown */
 time_t tupdate;		/* time of last update to annotation file */
 
@@ -67,7 +96,6 @@ time_t tupdate;		/* time of last update to annotation file */
 
 annot_init()
 {
-    char *p;
     struct ap *a;
 
     /* If any annotation editing has been performed, bring the output file
@@ -85,10 +113,11 @@ annot_init()
     if (frame) xv_set(frame, FRAME_BUSY, TRUE, NULL);
     while (ap_end) {
 	a = ap_end->previous;
-	if (ap_end->this.aux) free(ap_end->this.aux);
 	free(ap_end);
 	ap_end = a;
     }
+    annstore_reset(&store);
+    ap_start = NULL;
 
     /* Check that the annotator name, if any, is legal. */
     if (nann > 0 && badname(af.name)) {
@@ -134,47 +163,46 @@ annot_init()
     }
     if (getgvmode() & WFDB_HIGHRES) setafreq(freq);
     else setafreq(0.);
-    if ((ap_start = annp = scope_annp = a = get_ap()) == NULL ||
-	getann(0, &(a->this))) {
+    if ((a = get_ap()) == NULL || getann(0, &(a->this))) {
+	if (a) free(a);
+	annp = scope_annp = NULL;
 	(void)annopen(record, NULL, 0);
 	if (frame) xv_set(frame, FRAME_BUSY, FALSE, NULL);
 	return (annotations = 0);
     }
 
-    /* Read annotations into memory, constructing a doubly-linked list on the
-       fly. */
+    /* Read annotations into memory, appending them to the store. */
     do {
-	a->next = NULL;
-	a->previous = ap_end;
-	if (ap_end) ap_end->next = a;
-	ap_end = a;
 	/* Copy the aux string, if any (since the aux pointer returned by
 	   getann points to static memory that may be overwritten).  Return 1
 	   if we run out of memory. */
-	if (a->this.aux) {
-	    if ((p = (char *)calloc(*(a->this.aux)+2, 1)) == NULL) {
-		if (frame)
-		    xv_set(frame, FRAME_BUSY, FALSE, NULL);
-		if (frame) {
+	if ((a->this.aux &&
+	     (a->this.aux = copy_aux(a->this.aux)) == NULL) ||
+	    annstore_append(&store, a) < 0) {
+	    free(a);
+	    set_ends();
+	    annp = scope_annp = ap_start;
+	    if (frame)
+		xv_set(frame, FRAME_BUSY, FALSE, NULL);
+	    if (frame) {
 #ifdef NOTICE
-		    Xv_notice notice = xv_create((Frame)frame, NOTICE,
-						 XV_SHOW, TRUE,
+		Xv_notice notice = xv_create((Frame)frame, NOTICE,
+					     XV_SHOW, TRUE,
 #else
-		    (void)notice_prompt((Frame)frame, (Event *)NULL,
+		(void)notice_prompt((Frame)frame, (Event *)NULL,
 #endif
-		      NOTICE_MESSAGE_STRINGS,
-		      "Error in allocating memory for aux string\n", 0,
-		      NOTICE_BUTTON_YES, "Continue", 0);
+		  NOTICE_MESSAGE_STRINGS,
+		  "Error in allocating memory for annotations\n", 0,
+		  NOTICE_BUTTON_YES, "Continue", 0);
 #ifdef NOTICE
-		    xv_destroy_safe(notice);
+		xv_destroy_safe(notice);
 #endif
-		}
-		return (annotations = 1);
 	    }
-	    memcpy(p, a->this.aux, *(a->this.aux)+1);
-	    a->this.aux = p;
+	    return (annotations = 1);
 	}
     } while ((a = get_ap()) && getann(0, &(a->this)) == 0);
+    set_ends();
+    annp = scope_annp = ap_start;
 
     /* Return 1 if we ran out of memory while reading the annotation file. */
     if (a == NULL) {
@@ -495,34 +523,7 @@ struct ap *locate_annotation(t, s)
 WFDB_Time t;
 int s;
 {
-    /* First, find out which of ap_start, annp, and ap_end is nearest t. */
-    if (annp == NULL) {
-	if (ap_start == NULL) return (NULL);
-	annp = ap_start;
-    }
-    if (annp->this.time < t) {
-	if (ap_end == NULL || ap_end->this.time < t)
-	    /* no annotations follow t */
-	    return (annp = NULL);
-	if (t - annp->this.time > ap_end->this.time - t)
-	    annp = ap_end;	/* closer to end than to previous position */
-    }
-    else {
-	if (t < ap_start->this.time) {	/* no annotations precede t */
-	    annp = ap_start;
-	    return (NULL);
-	}
-	if (t - ap_start->this.time < annp->this.time - t)
-	    annp = ap_start;
-    }
-
-    /* Traverse the list to find the annotation at time t and signal s, or its
-       successor. */
-    while (annp->this.time >= t && annp->previous)
-	annp = annp->previous;
-    while ((annp && annp->this.time < t) ||
-	   (annp->this.time == t && annp->this.chan < s))
-	annp = annp->next;
+    annp = annstore_at(&store, annstore_find(&store, t, s));
     if (annp == NULL || annp->this.time != t || annp->this.chan != s)
 	return (NULL);
     else
@@ -573,6 +574,7 @@ int s;
 #endif
 		return;
 	    }
+	    touch_annotation(annp);
 	    annp->this.anntyp ^= 0x80;		/* MSB of anntyp is "phantom"
 						   marker */
 	    check_post_update();
@@ -587,24 +589,17 @@ int s;
 		end_analysis_time = -1L; reset_stop(); break;
 	      default: break;
 	    }
-	    /* Remove the annotation from the list by reconstructing the
-	       links around it, free its memory allocation, and reset annp. */
-	    if (a->previous) (a->previous)->next = a->next;
-	    else ap_start = a->next;
-	    if (a->next) {
-		annp = a->next;
-		(a->next)->previous = a->previous;
-	    }
-	    else annp = ap_end = a->previous;
-	    if (a->this.aux) free(a->this.aux);
+	    /* Remove the annotation from the store, free its memory allocation,
+	       and reset annp. */
+	    annp = a->next ? a->next : a->previous;
+	    annstore_remove(&store, a);
+	    set_ends();
 	    free(a);
 	}
     }
 }
 
-/* This function moves the annotation pointed to by `a' to a new time `t'.
-   Note that the links from `a' must be valid or NULL when this function is
-   called. */
+/* This function moves the annotation pointed to by `a' to a new time `t'. */
 void move_annotation(a, t)
 struct ap *a;
 WFDB_Time t;
@@ -625,45 +620,50 @@ WFDB_Time t;
 #endif
 	return;
     }
-    /* Remove the annotation from the list by reconstructing the links
-       around it. */
-    if (a->previous) (a->previous)->next = a->next;
-    else ap_start = a->next;
-    if (a->next) (a->next)->previous = a->previous;
-    else ap_end = a->previous;
-
-    /* Adjust the time. */
+    /* Remove the annotation from the store, adjust the time, and reinsert
+       it.  (Make sure that annp doesn't point to `a' first.) */
+    if (annp == a) annp = NULL;
+    annstore_remove(&store, a);
+    set_ends();
     a->this.time = t;
-
-    /* Reinsert the annotation into the list.  (Make sure that annp doesn't
-       point to `a' first.) */
-    annp = a->next;
     (void)insert_annotation(a);
 }
 
 /* This function is used by insert_annotation (below) to insert the annotation
-   pointed to by `a' into the annotation list before the annotation pointed to
-   by `annp'. */
-static void do_insertion(a)
+   pointed to by `a' into the store, before the annotation pointed to by
+   `annp' (i.e., the first one that follows it). */
+static int do_insertion(a)
 struct ap *a;
 {
-    if (annp == NULL) {		/* append to end of annotation list */
-	a->next = NULL;
-	a->previous = ap_end;
-	if (ap_end == NULL) {	/* annotation list is empty */
-	    ap_start = annp = ap_end = a; annotations = 1; }
-	else {
-	    ap_end->next = a;
-	    annp = ap_end = a;
-	}
-    }
-    else {			/* insert before annp */
-	a->next = annp;    
-	a->previous = annp->previous;
-	annp->previous = a;
-	if (a->previous) (a->previous)->next = a;
-	else ap_start = a;
+    if (annstore_insert(&store, annstore_find(&store, a->this.time,
+					      a->this.chan), a) < 0) {
+#ifdef NOTICE
+	Xv_notice notice = xv_create((Frame)frame, NOTICE,
+				     XV_SHOW, TRUE,
+#else
+	(void)notice_prompt((Frame)frame, (Event *)NULL,
+#endif
+		      NOTICE_MESSAGE_STRINGS,
+		      "Error in allocating memory for annotations\n", 0,
+		      NOTICE_BUTTON_YES, "Continue", 0);
+#ifdef NOTICE
+	xv_destroy_safe(notice);
+#endif
+	return (-1);
     }
+    set_ends();
+    if (annp == NULL) annp = a;	/* appended to the end of the store */
+    annotations = 1;
+    return (0);
+}
+
+/* This function restores the order of the store after the time or `chan' field
+   of the annotation pointed to by `a' has been changed in place. */
+static void rekey(a)
+struct ap *a;
+{
+    annstore_rekey(&store, a);
+    set_ends();
 }
 
 /* This function inserts the annotation pointed to by `a' into the annotation
@@ -672,6 +672,8 @@ struct ap *a;
 void insert_annotation(a)
 struct ap *a;
 {
+    int inserted = 0;
+
     if (accept_edit == 0 && a->this.anntyp <= ACMAX) {
 #ifdef NOTICE
 	Xv_notice notice = xv_create((Frame)frame, NOTICE,
@@ -692,7 +694,7 @@ struct ap *a;
 	/* annp points to an existing annotation that must be replaced. */
 	if (accept_edit || annp->this.anntyp > ACMAX) {
 	    /* overwrite annotation or marker at annp */
-	    if (annp->this.aux) free(annp->this.aux);
+	    touch_annotation(annp);
 	    annp->this = a->this;
 	}
 	else {
@@ -706,7 +708,7 @@ struct ap *a;
 	}
     }
     else
-	do_insertion(a);
+	inserted = (do_insertion(a) == 0);
     if (a->this.anntyp <= ACMAX)
 	check_post_update();
     else {
@@ -738,6 +740,7 @@ struct ap *a;
 	  default:
 	    break;
 	}
+	if (inserted) rekey(a);
     }
 }
 
@@ -829,17 +832,25 @@ void change_annotations()
     (void)locate_annotation(begin_analysis_time, -128);
     a = annp;
     while (a && a->this.time < end_analysis_time) {
+	struct ap *next = a->next;
+
 	if (a->this.anntyp <= ACMAX) {		/* leave markers alone */
+	    touch_annotation(a);
 	    if (ann_template.anntyp == NOTQRS)
 		a->this.anntyp ^= 0x80;		/* see delete_annotation() */
 	    else {
 		WFDB_Time t = a->this.time;
 		a->this = ann_template;
 		a->this.time = t;
+		/* Copy the aux string, if any (the template's aux pointer
+		   points to static memory), and move the annotation if its
+		   `chan' field has been changed. */
+		if (a->this.aux) a->this.aux = copy_aux(a->this.aux);
+		rekey(a);
 	    }
 	    ++changes;
 	}
-	a = a->next;
+	a = next;
     }
     check_post_update();
     set_frame_title();
@@ -866,6 +877,9 @@ void change_annotations()
    original annotation file if it is in the current directory and you open the
    same annotator more than once.
 
+   Nothing is written if the edits made since the previous save have been
+   undone, or if they have affected only markers (which are not saved).
+
    If the "save" operation succeeds, the function returns 1;  if it fails for
    any reason, it returns 0.
  */
@@ -873,10 +887,20 @@ void change_annotations()
 int post_changes()
 {
     int result;
+    long i;
     struct ap *a;
 
     if (changes <= 0) return (1);
 
+    /* If the edits since the last save have been undone, or if they have
+       affected only markers, there is nothing to be written. */
+    if (!annstore_changed(&store)) {
+	annstore_commit(&store);
+	changes = 0;
+	tupdate = time((time_t *)NULL);
+	return (1);
+    }
+
     /* If there was no annotator name specified, use the name by which this
        program was invoked for this purpose. */
     if (af.name == NULL) {
@@ -966,12 +990,11 @@ int post_changes()
 	}
     }
     af.stat = (af.stat == WFDB_AHA_WRITE) ? WFDB_AHA_READ : WFDB_READ;
-    a = ap_start;
 
     /* Write the annotation list to the output file.  This might take a while
        .... */
     xv_set(frame, FRAME_BUSY, TRUE, NULL);
-    while (a) {
+    for (i = 0L; a = annstore_at(&store, i); i++) {
 	if (isann(a->this.anntyp) && putann(0, &(a->this))) {
 	    /* An error from putann is most likely to be the result of file
 	       space exhaustion.  Warn the user and try again later. */
@@ -1006,12 +1029,12 @@ int post_changes()
 		exit(1);
 	    }
 	}
-	a = a->next;
     }
     if (getgvmode() & WFDB_HIGHRES) setafreq(freq);
     else setafreq(0.);
     (void)annopen(record, NULL, 0);	/* force flush and close of output */
 
+    annstore_commit(&store);
     changes = 0;
     xv_set(frame, FRAME_BUSY, FALSE, NULL);
 
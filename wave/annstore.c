@@ -0,0 +1,396 @@
+/* file: annstore.c	WFDB contributors	18 October 2026
+Indexed annotation store for WAVE
+
+-------------------------------------------------------------------------------
+WAVE: Waveform analyzer, viewer, and editor
+Copyright (C) 2026 WFDB contributors
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author by e-mail (wfdb@physionet.org) or postal mail
+(MIT Room E25-505A, Cambridge, MA 02139 USA).  For updates to this software,
+please visit PhysioNet (http://www.physionet.org/).
+_______________________________________________________________________________
+
+See annstore.h for an overview.  The index is a `gap buffer':  the annotations
+are kept in order in an array, except that there is a gap of unused entries at
+the position of the most recent insertion or removal.  Inserting or removing
+an annotation moves only the entries between the old and new positions of the
+gap, so that a sequence of edits within a small region of the record (the
+usual case in WAVE) costs little more than a sequence of list operations,
+while annotations can be located anywhere in the record by binary search.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <wfdb/wfdb.h>
+#include <wfdb/ecgcodes.h>
+#include "annstore.h"
+
+/* Aux strings are copied into blocks of at least AUXBLOCK bytes, which are
+   freed only when the store is reset. */
+#define AUXBLOCK	65536
+
+struct auxblock {
+    struct auxblock *next;
+    size_t size, used;
+    unsigned char data[1];
+};
+
+/* Return true if A is a legal annotation code (as for isann(), defined in
+   <wfdb/ecgmap.h>, which also defines tables that are not needed here). */
+#define ISANN(A)	(0 < (A) && (A) <= ACMAX)
+
+/* Return the annotation at position i of the index, ignoring the gap. */
+#define AT(S, I)	((I) < (S)->gap ? (S)->ix[I] : \
+			 (S)->ix[(I) + (S)->size - (S)->n])
+
+/* Return true if annotation a belongs before annotation b. */
+#define BEFORE(A, B)	((A)->this.time < (B)->this.time || \
+			 ((A)->this.time == (B)->this.time && \
+			  (A)->this.chan < (B)->this.chan))
+
+/* Free the index, the aux arena, and the journal.  (The annotations themselves
+   belong to the caller.) */
+void annstore_reset(s)
+struct annstore *s;
+{
+    struct auxblock *b;
+
+    while (b = s->arena) {
+	s->arena = b->next;
+	free(b);
+    }
+    if (s->ix) free(s->ix);
+    if (s->journal) free(s->journal);
+    s->ix = NULL;
+    s->journal = NULL;
+    s->n = s->size = s->gap = s->nedits = s->maxedits = 0L;
+}
+
+/* Move the gap to position i. */
+static void move_gap(s, i)
+struct annstore *s;
+long i;
+{
+    long len = s->size - s->n;
+
+    if (i < s->gap)
+	memmove(s->ix + i + len, s->ix + i, (s->gap - i) * sizeof(struct ap *));
+    else if (i > s->gap)
+	memmove(s->ix + s->gap, s->ix + s->gap + len,
+		(i - s->gap) * sizeof(struct ap *));
+    s->gap = i;
+}
+
+/* Make room for at least one more annotation in the index.  This function
+   returns 0 if successful, or -1 if memory is exhausted. */
+static int grow(s)
+struct annstore *s;
+{
+    long size;
+    struct ap **ix;
+
+    if (s->n < s->size) return (0);
+    size = s->size ? 2*s->size : 1024L;
+    if ((ix = realloc(s->ix, size * sizeof(struct ap *))) == NULL)
+	return (-1);
+    /* The gap is empty, since the index is full;  move the entries that
+       follow it to the end of the enlarged index. */
+    memmove(ix + s->gap + size - s->size, ix + s->gap,
+	    (s->size - s->gap) * sizeof(struct ap *));
+    s->ix = ix;
+    s->size = size;
+    return (0);
+}
+
+/* Insert annotation a at position i of the index, and link it with its
+   neighbors. */
+static int link_ap(s, i, a)
+struct annstore *s;
+long i;
+struct ap *a;
+{
+    if (grow(s) < 0) return (-1);
+    a->previous = (i > 0) ? AT(s, i-1) : NULL;
+    a->next = (i < s->n) ? AT(s, i) : NULL;
+    if (a->previous) (a->previous)->next = a;
+    if (a->next) (a->next)->previous = a;
+    move_gap(s, i);
+    s->ix[s->gap++] = a;
+    s->n++;
+    return (0);
+}
+
+/* Find the position of annotation a in the index, or return -1 if it is not
+   there. */
+static long scan(s, a)
+struct annstore *s;
+struct ap *a;
+{
+    long i;
+
+    for (i = annstore_find(s, a->this.time, a->this.chan);
+	 i < s->n && AT(s, i)->this.time == a->this.time; i++)
+	if (AT(s, i) == a) return (i);
+    return (-1L);
+}
+
+static long position(s, a)
+struct annstore *s;
+struct ap *a;
+{
+    long i;
+
+    if ((i = scan(s, a)) >= 0L) return (i);
+    /* The key of `a' has been changed since it was inserted (as when the
+       `chan' field of an attached annotation is changed while it is being
+       dragged).  Its predecessor is most likely still where it belongs. */
+    if (a->previous == NULL) i = 0L;
+    else if ((i = scan(s, a->previous)) >= 0L) i++;
+    if (i >= 0L && i < s->n && AT(s, i) == a) return (i);
+    for (i = 0L; i < s->n; i++)
+	if (AT(s, i) == a) return (i);
+    return (-1L);
+}
+
+/* Remove annotation a from the index, and link its neighbors. */
+static void unlink_ap(s, a)
+struct annstore *s;
+struct ap *a;
+{
+    long i;
+
+    if ((i = position(s, a)) < 0L) return;
+    if (a->previous) (a->previous)->next = a->next;
+    if (a->next) (a->next)->previous = a->previous;
+    move_gap(s, i+1);
+    s->gap--;
+    s->n--;
+}
+
+/* Return the journal entry for annotation a, or NULL if it has none. */
+static struct annedit *entry(s, a)
+struct annstore *s;
+struct ap *a;
+{
+    if (a->jx > 0L && a->jx <= s->nedits && s->journal[a->jx-1].a == a)
+	return (&s->journal[a->jx-1]);
+    return (NULL);
+}
+
+/* Add a journal entry for annotation a. */
+static void record_edit(s, a, op)
+struct annstore *s;
+struct ap *a;
+int op;
+{
+    struct annedit *e;
+
+    if (s->maxedits < 0L) return;
+    if (s->nedits >= s->maxedits) {
+	long max = s->maxedits ? 2*s->maxedits : 256L;
+
+	if ((e = realloc(s->journal, max * sizeof(struct annedit))) == NULL) {
+	    /* Without a journal entry, annstore_changed must assume the worst
+	       (see below). */
+	    s->maxedits = -1L;
+	    return;
+	}
+	s->journal = e;
+	s->maxedits = max;
+    }
+    e = &s->journal[s->nedits++];
+    e->a = a;
+    e->op = op;
+    e->was = a->this;
+    a->jx = s->nedits;
+}
+
+/* Append annotation a to the index without recording an edit (used while
+   reading an annotation file).  This function returns 0 if successful, or -1
+   if memory is exhausted. */
+int annstore_append(s, a)
+struct annstore *s;
+struct ap *a;
+{
+    a->jx = 0L;
+    return (link_ap(s, s->n, a));
+}
+
+/* Return the position of the first annotation that is not earlier than time
+   t and signal chan, or the number of annotations if there is none. */
+long annstore_find(s, t, chan)
+struct annstore *s;
+WFDB_Time t;
+int chan;
+{
+    long lo = 0L, hi = s->n, mid;
+    struct ap *a;
+
+    while (lo < hi) {
+	mid = lo + (hi - lo)/2;
+	a = AT(s, mid);
+	if (a->this.time < t || (a->this.time == t && a->this.chan < chan))
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return (lo);
+}
+
+/* Return the annotation at position i, or NULL if there is none. */
+struct ap *annstore_at(s, i)
+struct annstore *s;
+long i;
+{
+    return ((0L <= i && i < s->n) ? AT(s, i) : NULL);
+}
+
+/* Insert annotation a at position i (normally, as returned by annstore_find)
+   and record the insertion.  This function returns 0 if successful, or -1 if
+   memory is exhausted. */
+int annstore_insert(s, i, a)
+struct annstore *s;
+long i;
+struct ap *a;
+{
+    struct annedit *e;
+
+    if (link_ap(s, i, a) < 0) return (-1);
+    if (e = entry(s, a))
+	e->op = (e->op == AS_UNDONE) ? AS_INSERTED : AS_CHANGED;
+    else
+	record_edit(s, a, AS_INSERTED);
+    return (0);
+}
+
+/* Remove annotation a and record the removal.  The caller may then free a, or
+   reinsert it. */
+void annstore_remove(s, a)
+struct annstore *s;
+struct ap *a;
+{
+    struct annedit *e;
+
+    unlink_ap(s, a);
+    if (e = entry(s, a))
+	e->op = (e->op == AS_INSERTED) ? AS_UNDONE : AS_REMOVED;
+    else
+	record_edit(s, a, AS_REMOVED);
+}
+
+/* Move annotation a to its proper place in the index if its time or `chan'
+   field has been changed. */
+void annstore_rekey(s, a)
+struct annstore *s;
+struct ap *a;
+{
+    if ((a->previous && BEFORE(a, a->previous)) ||
+	(a->next && BEFORE(a->next, a))) {
+	unlink_ap(s, a);
+	(void)link_ap(s, annstore_find(s, a->this.time, a->this.chan), a);
+    }
+}
+
+/* Record that annotation a is about to be changed in place. */
+void annstore_touch(s, a)
+struct annstore *s;
+struct ap *a;
+{
+    if (entry(s, a) == NULL)
+	record_edit(s, a, AS_CHANGED);
+}
+
+/* Return true if annotations a and b would be written differently. */
+static int differ(a, b)
+struct WFDB_ann *a, *b;
+{
+    if (!ISANN(a->anntyp) && !ISANN(b->anntyp)) return (0);
+    if (a->time != b->time || a->anntyp != b->anntyp ||
+	a->subtyp != b->subtyp || a->chan != b->chan || a->num != b->num)
+	return (1);
+    if (a->aux == NULL || b->aux == NULL) return (a->aux != b->aux);
+    return (memcmp(a->aux, b->aux, *(a->aux)+1) != 0);
+}
+
+/* Return true if the annotations that would be written to an annotation file
+   may differ from those that would have been written at the time of the last
+   commit (if all of the edits since then have been undone, or have affected
+   only markers, there is nothing to write). */
+int annstore_changed(s)
+struct annstore *s;
+{
+    long i;
+    struct annedit *e;
+
+    if (s->maxedits < 0L) return (1);	/* the journal is incomplete */
+    for (i = 0L, e = s->journal; i < s->nedits; i++, e++) {
+	switch (e->op) {
+	  case AS_INSERTED:
+	    if (ISANN(e->a->this.anntyp)) return (1);
+	    break;
+	  case AS_REMOVED:
+	    if (ISANN(e->was.anntyp)) return (1);
+	    break;
+	  case AS_CHANGED:
+	    if (differ(&e->was, &e->a->this)) return (1);
+	    break;
+	}
+    }
+    return (0);
+}
+
+/* Empty the journal (after the annotations have been saved). */
+void annstore_commit(s)
+struct annstore *s;
+{
+    long i;
+    struct annedit *e;
+
+    /* Annotations that were removed may have been freed since, so only those
+       still in the index are reset. */
+    for (i = 0L, e = s->journal; i < s->nedits; i++, e++)
+	if (e->op == AS_INSERTED || e->op == AS_CHANGED)
+	    e->a->jx = 0L;
+    s->nedits = 0L;
+    if (s->maxedits < 0L) s->maxedits = 0L;
+}
+
+/* Return a copy of an aux string in the arena, or NULL if memory is
+   exhausted.  As for the calloc'd copies that WAVE used previously, the copy
+   is null-terminated. */
+unsigned char *annstore_auxdup(s, aux)
+struct annstore *s;
+unsigned char *aux;
+{
+    size_t len = *aux + 2;
+    unsigned char *p;
+    struct auxblock *b = s->arena;
+
+    if (b == NULL || b->size - b->used < len) {
+	size_t size = (len > AUXBLOCK) ? len : AUXBLOCK;
+
+	if ((b = malloc(sizeof(struct auxblock) + size)) == NULL)
+	    return (NULL);
+	b->next = s->arena;
+	b->size = size;
+	b->used = 0;
+	s->arena = b;
+    }
+    p = b->data + b->used;
+    b->used += len;
+    memcpy(p, aux, len-1);
+    p[len-1] = '\0';
+    return (p);
+}
@@ -0,0 +1,89 @@
+/* file: annstore.h	WFDB contributors	18 October 2026
+Indexed annotation store for WAVE
+
+-------------------------------------------------------------------------------
+WAVE: Waveform analyzer, viewer, and editor
+Copyright (C) 2026 WFDB contributors
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; either version 2 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, see <http://www.gnu.org/licenses/>.
+
+You may contact the author by e-mail (wfdb@physionet.org) or postal mail
+(MIT Room E25-505A, Cambridge, MA 02139 USA).  For updates to this software,
+please visit PhysioNet (http://www.physionet.org/).
+_______________________________________________________________________________
+
+The annotation store keeps WAVE's annotations in an index (an array of
+pointers in time and `chan' order, with a movable gap so that edits near the
+same place are cheap), which can be searched in O(log n) time.  The `ap'
+structures are also linked in the same order, so that the rest of WAVE can
+walk through them.  Aux strings are kept in an arena that is released all at
+once, and edits are recorded in a journal, so that WAVE can tell whether the
+annotations differ from those most recently saved.
+
+This header and annstore.c depend only on the WFDB library, so that the store
+can be compiled and tested without XView.
+*/
+
+struct ap {
+    struct WFDB_ann this;
+    struct ap *previous, *next;
+    long jx;		/* 1 + index of this annotation's journal entry, or 0 */
+};
+
+struct annedit {	/* journal entry */
+    struct ap *a;	/* the annotation that was edited */
+    int op;		/* AS_INSERTED, AS_CHANGED, AS_REMOVED, or AS_UNDONE */
+    struct WFDB_ann was;/* its contents before it was first edited */
+};
+
+/* Journal operations.  An annotation that is removed and reinserted (as when
+   it is moved) is simply AS_CHANGED;  one that is inserted and then removed
+   is AS_UNDONE. */
+#define AS_INSERTED	1
+#define AS_CHANGED	2
+#define AS_REMOVED	3
+#define AS_UNDONE	4
+
+struct auxblock;	/* defined in annstore.c */
+
+struct annstore {
+    struct ap **ix;	/* the index;  the gap is ix[gap] ... ix[gap+size-n-1] */
+    long n;		/* number of annotations in the index */
+    long size;		/* number of pointers allocated for ix */
+    long gap;		/* position of the gap */
+    struct auxblock *arena;	/* aux string arena */
+    struct annedit *journal;	/* edits since the last commit */
+    long nedits;	/* number of journal entries */
+    long maxedits;	/* number of journal entries allocated */
+};
+
+#if defined(__STDC__) || defined(__cplusplus) || defined(c_plusplus)
+extern void annstore_reset(struct annstore *s);
+extern int annstore_append(struct annstore *s, struct ap *a);
+extern long annstore_find(struct annstore *s, WFDB_Time t, int chan);
+extern struct ap *annstore_at(struct annstore *s, long i);
+extern int annstore_insert(struct annstore *s, long i, struct ap *a);
+extern void annstore_remove(struct annstore *s, struct ap *a);
+extern void annstore_rekey(struct annstore *s, struct ap *a);
+extern void annstore_touch(struct annstore *s, struct ap *a);
+extern int annstore_changed(struct annstore *s);
+extern void annstore_commit(struct annstore *s);
+extern unsigned char *annstore_auxdup(struct annstore *s, unsigned char *aux);
+#else
+extern void annstore_reset(), annstore_remove(), annstore_rekey(),
+    annstore_touch(), annstore_commit();
+extern int annstore_append(), annstore_insert(), annstore_changed();
+extern long annstore_find();
+extern struct ap *annstore_at();
+extern unsigned char *annstore_auxdup();
+#endif
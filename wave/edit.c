@@ -1,5 +1,5 @@
 /* file: edit.c		G. Moody	 1 May 1990
-               		Last revised:	27 April 2020
+               		Last revised:	18 October 2026
 Annotation-editing functions for WAVE
 
 -------------------------------------------------------------------------------
@@ -773,7 +773,7 @@ Notify_arg arg;
 		    if (a->this.aux) {
 			char *p;
 
-			if ((p = (char *)calloc(*(a->this.aux)+2,1)) == NULL) {
+			if ((p = (char *)copy_aux(a->this.aux)) == NULL) {
 #ifdef NOTICE
 			    Xv_notice notice = xv_create((Frame)frame, NOTICE,
 							 XV_SHOW, TRUE,
@@ -790,7 +790,6 @@ Notify_arg arg;
 #endif
 			    return;
 			}
-			memcpy(p, a->this.aux, *(a->this.aux)+1);
 			a->this.aux = p;
 		    }
 		    insert_annotation(a);
@@ -799,6 +798,7 @@ Notify_arg arg;
 		    attach_ann(a);
 		}
 		else {
+		    touch_annotation(annp);
 		    annp->this.chan--;
 		    check_post_update();
 		}
@@ -877,7 +877,7 @@ Notify_arg arg;
 		    if (a->this.aux) {
 			char *p;
 
-			if ((p = (char *)calloc(*(a->this.aux)+2,1)) == NULL) {
+			if ((p = (char *)copy_aux(a->this.aux)) == NULL) {
 #ifdef NOTICE
 			    Xv_notice notice = xv_create((Frame)frame, NOTICE,
 							 XV_SHOW, TRUE,
@@ -894,7 +894,6 @@ Notify_arg arg;
 #endif
 			    return;
 			}
-			memcpy(p, a->this.aux, *(a->this.aux)+1);
 			a->this.aux = p;
 		    }
 		    insert_annotation(a);
@@ -903,6 +902,7 @@ Notify_arg arg;
 		    attach_ann(a);
 		}
 		else {
+		    touch_annotation(annp);
 		    annp->this.chan++;
 		    check_post_update();
 		}
@@ -1186,7 +1186,7 @@ Notify_arg arg;
 		if (a->this.aux) {
 		    char *p;
 
-		    if ((p = (char *)calloc(*(a->this.aux)+2, 1)) == NULL) {
+		    if ((p = (char *)copy_aux(a->this.aux)) == NULL) {
 #ifdef NOTICE
 			Xv_notice notice = xv_create((Frame)frame, NOTICE,
 						     XV_SHOW, TRUE,
@@ -1405,7 +1405,10 @@ Notify_arg arg;
 	    ii = (imin >= 0 && sig_mode) ? siglist[imin] : imin;
 	    if (imin >= 0 && ann_template.chan != ii) {
 		set_ann_chan(ann_template.chan = ii);
-		if (attached) attached->this.chan = ii;
+		if (attached) {
+		    touch_annotation(attached);
+		    attached->this.chan = ii;
+		}
 	    }
 	    bar(x, imin >= 0 ? base[(unsigned)imin] + mmy(2) : abase, 1);
 	}
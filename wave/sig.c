@@ -1,5 +1,5 @@
 /* file: sig.c		G. Moody	 27 April 1990
-			Last revised:	 24 April 2020
+			Last revised:	18 October 2026
 Signal display functions for WAVE
 
 -------------------------------------------------------------------------------
@@ -306,14 +306,21 @@ static struct display_list *get_display_list()
 specified by its argument.  If such a list (with the correct duration) is
 found in the cache, it can be returned immediately.  Otherwise, the function
 reads the requested segment and determines the pixel ordinates of the
-vertices of the polylines for each signal. */
+vertices of the polylines for each signal.  If there are at least ENVMIN
+samples per pixel, the ordinates are taken from the envelopes of the signals
+(the ranges of their samples in each pixel column) obtained from getenvelope,
+which can summarize long segments without reading all of their samples. */
+
+#define ENVMIN	16
 
 struct display_list *find_display_list(fdl_time)
 WFDB_Time fdl_time;
 {
-    int c, i, j, x, x0, y, ymax, ymin;
+    int c, i, j, n = 0, x, x0, y, ymax, ymin;
     struct display_list *lp;
     XPoint *tp;
+    static int envlen;
+    static WFDB_Envelope *env;
 
     if (fdl_time < 0L) fdl_time = -fdl_time;
     /* If the requested display list is in the cache, return it at once. */
@@ -345,9 +352,43 @@ WFDB_Time fdl_time;
 	    lp->vlist[c][0].y = v0[c]*vscale[c];
     }
 
+    /* If there are many samples per pixel, use the envelopes.  As below, the
+       ordinate of each pixel column is the extreme of its envelope farther
+       from the ordinate of the previous column. */
+    if (nsamp >= ENVMIN * canvas_width) {
+	if (canvas_width * nsig > envlen) {
+	    if ((env = realloc(env, canvas_width * nsig *
+			       sizeof(WFDB_Envelope))) == NULL)
+		envlen = 0;
+	    else
+		envlen = canvas_width * nsig;
+	}
+	if (env && (n = getenvelope(fdl_time, fdl_time + nsamp, canvas_width,
+				    env)) < 0)
+	    n = 0;
+    }
+    if (n > 0) {
+	for (x = 1; x < n; x++) {
+	    for (c = 0; c < nsig; c++) {
+		WFDB_Envelope *e = &env[x*nsig + c];
+
+		if ((vvalid[c] = (e->nvalid > 0))) {
+		    if (e->max - v0[c] > v0[c] - e->min)
+			v0[c] = e->max;
+		    else
+			v0[c] = e->min;
+		    lp->vlist[c][x].y = v0[c]*vscale[c];
+		}
+		else
+		    lp->vlist[c][x].y = -1 << 15;
+	    }
+	}
+	i = n;
+    }
+
     /* If there are more than canvas_width samples to be shown, compress the
        data. */
-    if (nsamp > canvas_width) {
+    else if (nsamp > canvas_width) {
 	for (i = 1, x0 = 0; i < nsamp && getvec(v) > 0; i++) {
 	    for (c = 0, vvalid[c] = 0; c < nsig; c++) {
 		if (v[c] != WFDB_INVALID_SAMPLE) {
@@ -1,5 +1,5 @@
 /* file: wave.h		G. Moody	26 April 1990
-               		Last revised:   24 April 2020
+               		Last revised:  18 October 2026
 Constants, macros, global variables, and function prototypes for WAVE
 
 -------------------------------------------------------------------------------
@@ -256,16 +256,15 @@ COMMON struct WFDB_ann ann_template;
 COMMON struct WFDB_ann search_template;
 COMMON int search_mask;
 
-/* The annotation list is built from `ap' structures; ap_start and ap_end
+/* The annotation list is built from `ap' structures (defined in annstore.h),
+   which are indexed by the annotation store in annot.c; ap_start and ap_end
    point to the first and last annotations in the list, and annp is a
    general-use pointer that usually points to an annotation in the current
    region of interest.  During editing, `attached' points to the annotation
    that is to be changed, if any. `scope_annp' points to the annotation
-   associated with the waveform most recently drawn in the scope window. */
-struct ap {
-    struct WFDB_ann this;
-    struct ap *previous, *next;
-};
+   associated with the waveform most recently drawn in the scope window.  The
+   annotations may be changed in place only after calling touch_annotation. */
+#include "annstore.h"
 COMMON struct ap *ap_start, *ap_end, *annp, *attached, *scope_annp;
 
 /* Function prototypes for ANSI C and C++ compilers.  If you attempt to compile
@@ -317,6 +316,8 @@ extern void do_disp(void);			/* in signal.c */
 extern void clear_cache(void);			/* in signal.c */
 extern int sigy(int sig, int x);		/* in signal.c */
 extern struct ap *get_ap(void);			/* in annot.c */
+extern unsigned char *copy_aux(unsigned char *aux); /* in annot.c */
+extern void touch_annotation(struct ap *a);	/* in annot.c */
 extern int annot_init(void);			/* in annot.c */
 extern WFDB_Time next_match(struct WFDB_ann *template,/* in annot.c */
 			    int mask);
@@ -365,6 +366,7 @@ extern int record_init(), annot_init(), post_changes(), initialize_graphics(),
     sigy(), in_siglist();
 extern WFDB_Time next_match(), previous_match(), wstrtim();
 extern struct ap *get_ap(), *locate_annotation();
+extern unsigned char *copy_aux();
 extern void set_baselines(), calibrate(), set_record_item(), set_annot_item(),
     set_start_time(), set_end_time(), set_find_item(), show_search_template(),
     create_mode_popup(), show_mode(),
@@ -376,6 +378,7 @@ extern void set_baselines(), calibrate(), set_record_item(), set_annot_item(),
     clear_cache(), show_annotations(), clear_annotation_display(),
     delete_annotation(), move_annotation(), insert_annotation(),
     change_annotations(), check_post_update(), set_frame_title(),
+    touch_annotation(),
     analyze_proc(), reset_start(), reset_stop(), reset_maxsig(),
     reset_siglist(), open_url(), do_command(), set_signal_choice(),
     set_siglist_from_string(), add_signal_choice(), delete_signal_choice(),
@@ -156,6 +156,7 @@ power spectrum estimation, and many others.
 %{_bindir}/hrlomb
 %{_bindir}/hrmem
 %{_bindir}/hrplot
+%{_bindir}/hrreport
 %{_bindir}/ihr
 %{_bindir}/log10
 %{_bindir}/lomb
@@ -187,11 +188,13 @@ power spectrum estimation, and many others.
 %{_bindir}/setwfdb
 %{_bindir}/sigamp
 %{_bindir}/sigavg
+%{_bindir}/sigenv
 %{_bindir}/signame
 %{_bindir}/signum
 %{_bindir}/skewedit
 %{_bindir}/snip
 %{_bindir}/sortann
+%{_bindir}/spectrogram
 %{_bindir}/sqrs
 %{_bindir}/sqrs125
 %{_bindir}/sumann
@@ -1,5 +1,5 @@
 # file: Makefile.tpl		G. Moody	  22 August 2010
-#				Last revised:	   24 April 2020
+#				Last revised:	 18 October 2026
 #
 # This section of the Makefile should not need to be changed.
 
@@ -45,6 +45,9 @@ listing:
 
 # Rules for compiling WFDB-XML applications that require non-standard options
 
+annxml$(EXEEXT):		annxml.c
+	$(CC) $(CFLAGS) annxml.c -o $@ $(LDFLAGS) -lpthread
+
 xmlann$(EXEEXT):		xmlann.c xmlproc.h
 	$(CC) $(CFLAGS) xmlann.c -o $@ $(LDFLAGS) -lexpat
 
@@ -1,5 +1,5 @@
 /* file: annxml.c	G. Moody	28 June 2010
-                 	Last revised:	27 April 2020
+                 	Last revised:	18 October 2026
 
 -------------------------------------------------------------------------------
 heaxml: Convert a WFDB annotation file to XML format
@@ -22,10 +22,19 @@ You may contact the author by e-mail (wfdb@physionet.org) or postal mail
 please visit PhysioNet (http://www.physionet.org/).
 _______________________________________________________________________________
 
+
+Annotations are read in batches of up to CHUNKLEN per thread, formatted into
+memory (in parallel, if the -j option is used), and written in order, so that
+annxml needs a fixed amount of memory however long the annotation file is.
 */
 
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef NOPTHREADS
+#include <pthread.h>
+#endif
 #include <wfdb/wfdb.h>
 #include <wfdb/ecgcodes.h>
 
@@ -35,33 +44,71 @@ _______________________________________________________________________________
  "<!DOCTYPE wfdbannotationset PUBLIC \"-//PhysioNet//DTD WFDB 1.0//EN\"" \
  " \"http://physionet.org/physiobank/database/XML/wfdb.dtd\">\n"
 
+#define CHUNKLEN   65536	/* annotations formatted by each thread at once */
+#define MAXTHREADS 16	/* maximum number of threads used to format output */
+
+/* A chunk contains a batch of annotations (with copies of their aux strings)
+   and the XML text generated from them. */
+struct chunk {
+  WFDB_Annotation *a;	/* annotations */
+  long n;		/* number of annotations in a */
+  size_t *auxoff;	/* offsets of aux strings in aux */
+  char *aux;		/* aux strings */
+  size_t auxlen, auxsize;
+  char *obuf;		/* XML text */
+  size_t olen, osize;
+};
+
 /* Function prototypes */
 static char *token(char *p);
 static void output_xml(FILE *ofile, char *tag, char *p);
 static void process_start(char *tstring);
 static void process_anntab(void);
-static void process_annotation(void);
+static int read_chunk(struct chunk *c);
+static void *format_chunk(void *arg);
+static char *putint(char *p, WFDB_Time n);
+static char *putxml(char *p, char *tag, char *s);
 static char *prog_name(char *s);
 
 /* Global variables (minimized) */
 static int nsig;
 static FILE *ofile;
-static WFDB_Annotation annot;
 static WFDB_Frequency sfreq;
 static long anncount[ACMAX+1];
+static char *mnemonic[ACMAX+1];
 
 int main(int argc, char *argv[])
 {
-  char *annotator, *ofname, *p, *pname, *record;
+  char *annotator = NULL, *ofname, *p, *pname, *record = NULL;
+  int done = 0, i, n, njobs = 1;
+  struct chunk c[MAXTHREADS];
   WFDB_Anninfo ai;
+#ifndef NOPTHREADS
+  pthread_t tid[MAXTHREADS];
+  int started[MAXTHREADS];
+#endif
 
   pname = prog_name(argv[0]);
-  if (argc < 3) {
-    (void)fprintf(stderr, "usage: %s RECORD ANNOTATOR\n", pname);
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-j") == 0) {
+      if (++i >= argc || (njobs = atoi(argv[i])) < 1) {
+	(void)fprintf(stderr, "%s: number of threads must follow -j\n",
+		      pname);
+	exit(1);
+      }
+      if (njobs > MAXTHREADS) njobs = MAXTHREADS;
+    }
+    else if (record == NULL) record = argv[i];
+    else if (annotator == NULL) annotator = argv[i];
+    else {
+      (void)fprintf(stderr, "%s: unrecognized argument %s\n", pname, argv[i]);
+      exit(1);
+    }
+  }
+  if (annotator == NULL) {
+    (void)fprintf(stderr, "usage: %s [ -j N ] RECORD ANNOTATOR\n", pname);
     exit(1);
   }
-  record = argv[1];
-  annotator = argv[2];
 
   /* Discover the number of signals defined in the header. */
   if ((nsig = isigopen(record, NULL, 0)) < 0) exit(2);
@@ -73,6 +120,11 @@ int main(int argc, char *argv[])
   if (annopen(record, &ai, 1) < 0)
     exit(3);
 
+  /* Save the mnemonics (which may have been redefined by modification labels
+     in the annotation file) for use by format_chunk. */
+  for (i = 0; i <= ACMAX; i++)
+    mnemonic[i] = annstr(i);
+
   /* The name of the output file is of the form 'RECORD.ANNOTATOR.xml'.  Any
      directory separators (/) in the record name are replaced by hyphens (-)
      in the output file name, so that the output file is always written into
@@ -97,8 +149,30 @@ int main(int argc, char *argv[])
   (void)fprintf(ofile, "<samplingfrequency>%.12g</samplingfrequency>\n",
 		sfreq);
 
-  while (getann(0, &annot) >= 0)
-    process_annotation();
+  /* Convert the annotations in batches of up to njobs chunks.  Each chunk
+     after the first is formatted in a thread of its own. */
+  memset(c, 0, sizeof(c));
+  while (!done) {
+    for (n = 0; n < njobs && !done; n++)
+      done = read_chunk(&c[n]);
+#ifndef NOPTHREADS
+    for (i = 1; i < n; i++)
+      started[i] = pthread_create(&tid[i], NULL, format_chunk, &c[i]) == 0;
+    format_chunk(&c[0]);
+    for (i = 1; i < n; i++) {
+      if (started[i]) pthread_join(tid[i], NULL);
+      else format_chunk(&c[i]);
+    }
+#else
+    for (i = 0; i < n; i++)
+      format_chunk(&c[i]);
+#endif
+    for (i = 0; i < n; i++)
+      if (fwrite(c[i].obuf, 1, c[i].olen, ofile) != c[i].olen) {
+	fprintf(stderr, "%s: error writing %s\n", pname, ofname);
+	exit(4);
+      }
+  }
 
   process_anntab();
 
@@ -183,17 +257,120 @@ static void process_anntab(void)
   fprintf(ofile, "</anntab>");
 }
 
-static void process_annotation(void)
+/* Read up to CHUNKLEN annotations into c, and return 1 if the end of the
+   annotation file was reached, or 0 otherwise. */
+static int read_chunk(struct chunk *c)
+{
+  size_t len;
+  WFDB_Annotation *a;
+
+  if (c->a == NULL) {
+    SUALLOC(c->a, CHUNKLEN, sizeof(WFDB_Annotation));
+    SUALLOC(c->auxoff, CHUNKLEN, sizeof(size_t));
+  }
+  c->n = 0;
+  c->auxlen = 0;
+  while (c->n < CHUNKLEN) {
+    a = &c->a[c->n];
+    if (getann(0, a) < 0)
+      return (1);
+    anncount[a->anntyp]++;
+    /* The aux string belongs to the WFDB library, and is overwritten by the
+       next call to getann, so it must be copied. */
+    if (a->aux) {
+      len = strlen((char *)a->aux+1) + 1;
+      if (c->auxlen + len > c->auxsize) {
+	c->auxsize = c->auxsize ? 2*c->auxsize : 65536;
+	SREALLOC(c->aux, c->auxsize, 1);
+      }
+      memcpy(c->aux + c->auxlen, a->aux+1, len);
+      c->auxoff[c->n] = c->auxlen;
+      c->auxlen += len;
+    }
+    c->n++;
+  }
+  return (0);
+}
+
+/* Generate the XML text for the annotations in c (the argument). */
+static void *format_chunk(void *arg)
 {
-  fprintf(ofile, "<annotation><time>%"WFDB_Pd_TIME"</time>"
-	  "<anncode>%s</anncode>",
-	  annot.time, annstr(annot.anntyp));
-  if (annot.subtyp) fprintf(ofile, "<subtype>%d</subtype>", annot.subtyp);
-  if (annot.chan) fprintf(ofile, "<chan>%d</chan>", annot.chan);
-  if (annot.num) fprintf(ofile, "<num>%d</num>", annot.num);
-  if (annot.aux) output_xml(ofile, "aux", annot.aux+1);
-  fprintf(ofile, "</annotation>\n");
-  anncount[annot.anntyp]++;
+  char *p, *aux;
+  long i;
+  size_t need;
+  struct chunk *c = arg;
+  WFDB_Annotation *a;
+
+  c->olen = 0;
+  for (i = 0; i < c->n; i++) {
+    a = &c->a[i];
+    aux = a->aux ? c->aux + c->auxoff[i] : NULL;
+    /* Each character of the aux string may expand to as many as 6 in XML. */
+    need = 256 + strlen(mnemonic[a->anntyp]) + (aux ? 6*strlen(aux) : 0);
+    if (c->olen + need > c->osize) {
+      c->osize = c->osize ? 2*c->osize : 1 << 22;
+      if (c->osize < c->olen + need) c->osize = c->olen + need;
+      SREALLOC(c->obuf, c->osize, 1);
+    }
+    p = c->obuf + c->olen;
+    memcpy(p, "<annotation><time>", 18); p += 18;
+    p = putint(p, a->time);
+    memcpy(p, "</time>", 7); p += 7;
+    p += sprintf(p, "<anncode>%s</anncode>", mnemonic[a->anntyp]);
+    if (a->subtyp) {
+      memcpy(p, "<subtype>", 9); p += 9;
+      p = putint(p, a->subtyp);
+      memcpy(p, "</subtype>", 10); p += 10;
+    }
+    if (a->chan) {
+      memcpy(p, "<chan>", 6); p += 6;
+      p = putint(p, a->chan);
+      memcpy(p, "</chan>", 7); p += 7;
+    }
+    if (a->num) {
+      memcpy(p, "<num>", 5); p += 5;
+      p = putint(p, a->num);
+      memcpy(p, "</num>", 6); p += 6;
+    }
+    if (aux) p = putxml(p, "aux", aux);
+    memcpy(p, "</annotation>\n", 14); p += 14;
+    c->olen = p - c->obuf;
+  }
+  return (NULL);
+}
+
+/* Write n in decimal at p, and return a pointer to the next character. */
+static char *putint(char *p, WFDB_Time n)
+{
+  char buf[24], *q = buf + sizeof(buf);
+  unsigned long long u = n < 0 ? -(unsigned long long)n : n;
+
+  do {
+    *--q = '0' + u % 10;
+  } while (u /= 10);
+  if (n < 0) *--q = '-';
+  while (q < buf + sizeof(buf))
+    *p++ = *q++;
+  return (p);
+}
+
+/* As output_xml, but write to memory at p, and return a pointer to the next
+   character. */
+static char *putxml(char *p, char *tag, char *s)
+{
+  p += sprintf(p, "<%s>", tag);
+  for ( ; *s; s++) {
+    switch (*s) {
+    case '<': memcpy(p, "&lt;", 4); p += 4; break;
+    case '>': memcpy(p, "&gt;", 4); p += 4; break;
+    case '&': memcpy(p, "&amp;", 5); p += 5; break;
+    case '"': memcpy(p, "&quot;", 6); p += 6; break;
+    case '\'': memcpy(p, "&apos;", 6); p += 6; break;
+    default: *p++ = *s; break;
+    }
+  }
+  p += sprintf(p, "</%s>", tag);
+  return (p);
 }
 
 static char *prog_name(char *s)
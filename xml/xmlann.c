@@ -1,5 +1,5 @@
 /* file: xmlann.c	G. Moody	22 August 2010
-			Last revised:	11 December 2017
+			Last revised:	18 October 2026
 -------------------------------------------------------------------------------
 xmlann: Convert a WFDB-XML file to a WFDB-compatible annotation file
 Copyright (C) 2010 George B. Moody
@@ -31,6 +31,7 @@ file and include sampling frequency/length/start attributes in it.
 Define and handle new annotation dur and url items.  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <wfdb/wfdb.h>
 #include "xmlproc.h"	/* provides main(), process(), DATALEN, qflag, vflag */
@@ -39,6 +40,8 @@ Define and handle new annotation dur and url items.  */
 static char *content;
 static int depth;
 static int plen;
+static int csize;
+static size_t dlen;	/* length of the element path in data */
 static int output_not_open;
 static WFDB_Anninfo ai;
 static WFDB_Annotation a;
@@ -49,8 +52,15 @@ static double sps;
 void XMLCALL start(void *data, const char *el, const char **attr)
 {
   int i;
+  size_t len = strlen(el);
 
-  sprintf(data + strlen(data), "/%s", el);
+  if (dlen + len + 2 > DATALEN) {
+      fprintf(stderr, "Malformed input: elements nested too deeply\n");
+      exit(1);
+  }
+  ((char *)data)[dlen] = '/';
+  memcpy((char *)data + dlen + 1, el, len + 1);
+  dlen += len + 1;
   if (vflag) {
       printf("\n%s", (char *) data);
       for (i = 0; attr[i]; i += 2)
@@ -81,27 +91,28 @@ void XMLCALL start(void *data, const char *el, const char **attr)
   depth++;
 }
 
+/* The content of each element is collected in a buffer that is reused (and
+   enlarged if necessary) for each element, rather than allocated anew. */
 void XMLCALL middle(void *data, const char *el, int len)
 {
     if (plen == 0) {	/* not in the same element as last time */
         if (len == 1 && *el == '\n')
 	    return;  /* ignore newlines outside of tags */
-	SALLOC(content, plen = len + 1, sizeof(char));
-	strncpy(content, el, len);
+	plen = 1;
     }
-    else {
-	SREALLOC(content, plen + len, sizeof(char));
-	strncpy(content + plen - 1, el, len);
-	plen += len;
-  }
+    if (plen + len > csize) {
+	csize = 2*(plen + len) + 256;
+	SREALLOC(content, csize, sizeof(char));
+    }
+    memcpy(content + plen - 1, el, len);
+    plen += len;
+    content[plen - 1] = '\0';
     if (vflag) { printf("\t|%s|", content); fflush(stdout); }
 }
 
 void XMLCALL end(void *data, const char *el)
 {
-  char *p;
   int i;
-  long t;
 
   depth--;
   if (depth == 0) {
@@ -132,23 +143,19 @@ void XMLCALL end(void *data, const char *el)
       a.aux = NULL;
   }
   else if (strcmp("/wfdbannotationset/annotation/time", data) == 0) {
-      sscanf(content, "%ld", &t);
-      a.time = t;
+      a.time = strtoll(content, NULL, 10);
   }
   else if (strcmp("/wfdbannotationset/annotation/anncode", data) == 0) {
       a.anntyp = strann(content);
   }
   else if (strcmp("/wfdbannotationset/annotation/subtype", data) == 0) {
-      sscanf(content, "%d", &i);
-      a.subtyp = i;
+      a.subtyp = strtol(content, NULL, 10);
   }
   else if (strcmp("/wfdbannotationset/annotation/chan", data) == 0) {
-      sscanf(content, "%d", &i);
-      a.chan = i;
+      a.chan = strtol(content, NULL, 10);
   }
   else if (strcmp("/wfdbannotationset/annotation/num", data) == 0) {
-      sscanf(content, "%d", &i);
-      a.num = i;
+      a.num = strtol(content, NULL, 10);
   }
   else if (strcmp("/wfdbannotationset/annotation/aux", data) == 0) {
       static char auxbuf[256];
@@ -161,15 +168,15 @@ void XMLCALL end(void *data, const char *el)
   }
 
   plen = 0;
-  for (p = data + strlen(data) - 1; p > (char *)data; p--)
-      if (*p == '/') { *p = '\0'; break; }
+  dlen -= strlen(el) + 1;
+  ((char *)data)[dlen] = '\0';
   if (vflag) { printf("."); fflush(stdout); }
 }
 
 void cleanup(void)
 {
-    content = NULL;
     depth = plen = output_not_open = 0;
+    dlen = 0;
     ai.name = NULL;
     a.anntyp = a.subtyp = a.chan = a.num = 0;
     a.aux = record = rec = NULL;
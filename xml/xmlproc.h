@@ -1,5 +1,5 @@
 /* file: xmlproc.h	G. Moody	28 June 2010
-                 	Last revised:	27 April 2020
+                 	Last revised:	18 October 2026
 -------------------------------------------------------------------------------
 xmlproc: Common XML processing functions for WFDB XML tools
 Copyright (C) 2010 George B. Moody
@@ -90,12 +90,15 @@ int main(int argc, char **argv)
 #define XML_FMT_INT_MOD "l"
 #endif
 
-#define BUFLEN		8192
+#define BUFLEN		65536
 
+/* The input is read directly into buffers supplied by the parser, BUFLEN
+   bytes at a time, so that memory use is independent of the input size. */
 void process(FILE *ifile)
 {
     int done = 0, len;
-    static char buf[BUFLEN], userdata[DATALEN];
+    static char userdata[DATALEN];
+    void *buf;
     XML_Parser p = XML_ParserCreate(NULL);
       
     if (! p) {
@@ -108,6 +111,10 @@ void process(FILE *ifile)
     XML_SetCharacterDataHandler(p, middle);
 
     do {
+	if ((buf = XML_GetBuffer(p, BUFLEN)) == NULL) {
+	    fprintf(stderr, "Couldn't allocate memory for parser\n");
+	    exit(2);
+	}
 	len = (int)fread(buf, 1, BUFLEN, ifile);
 	if (ferror(ifile)) {
 	    fprintf(stderr, "Read error\n");
@@ -115,7 +122,7 @@ void process(FILE *ifile)
 	}
 	done = feof(ifile);
 
-	if (XML_Parse(p, buf, len, done) == XML_STATUS_ERROR) {
+	if (XML_ParseBuffer(p, len, done) == XML_STATUS_ERROR) {
 	    fprintf(stderr, "Parse error at line %" XML_FMT_INT_MOD "u:\n%s\n",
 		    XML_GetCurrentLineNumber(p),
 		    XML_ErrorString(XML_GetErrorCode(p)));